@@ -0,0 +1,1197 @@
+/* Filename:  benchmark.cpp
+ * Date:      10/19/2026
+ * Purpose:   Timings for the indexer's data structures on synthetic
+ *            documents, so changes can be measured away from file I/O.
+ * To compile: g++ -O2 -pthread -o benchmark benchmark.cpp posting.cpp
+ *                 controlbytes.cpp termtable.cpp globalhashtable.cpp
+ *                 concurrentglobalhashtable.cpp outputwriter.cpp
+ *                 sorteddict.cpp termtrie.cpp blockpost.cpp postingcodec.cpp
+ *                 impactquantizer.cpp queryengine.cpp docstore.cpp
+ *                 forwardindex.cpp hottier.cpp segment.cpp
+ *                 ratelimiter.cpp
+ * To run:    ./benchmark concurrent [NumDocs]
+ *                posting NumDocs documents from 1 to 64 threads into
+ *                the ConcurrentGlobalHashTable, and into a
+ *                GlobalHashTable behind one mutex for comparison
+ *            ./benchmark output [NumPostings]
+ *                writing post lines with ofstream and with OutputWriter
+ *            ./benchmark fuzzy [NumTerms]
+ *                fuzzy trie lookups, one and two edits, over a vocabulary
+ *                of NumTerms random words
+ *            ./benchmark codec IndexDirname
+ *                every posting codec on the DocIds of an index's bpost:
+ *                bits per DocId, compression and decoding speed
+ *            ./benchmark impacts IndexDirname [NumQueries]
+ *                how far rankings move when an index's float weights
+ *                are quantized to 8- and 16-bit impacts, linear and log
+ *            ./benchmark batch IndexDirname [NumQueries [MaxThreads]]
+ *                ranking random queries one at a time and as a batch
+ *            ./benchmark snippets IndexDirname [NumQueries]
+ *                reading documents from an index's docs and making a
+ *                snippet for each result of random queries
+ *            ./benchmark forward IndexDirname [NumDocs]
+ *                reading random documents' term vectors from fwd, and
+ *                rebuilding them from bpost's lists instead
+ *            ./benchmark hot IndexDirname [NumQueries] [MB]
+ *                skewed random queries with every list cold, with the
+ *                hot tier once it has seen them, and with a new engine
+ *                whose hot tier starts from the first one's profile
+ *            ./benchmark live [NumDocs] [Seconds]
+ *                adding documents to a memory segment flushed every
+ *                Seconds and compacted, as invert --segments does, while one engine
+ *                searches it in the same process and another picks up
+ *                the flushed segments: how soon a document is found
+ *            ./benchmark compact [NumDocs] [MB]
+ *                query latency over many small segments while they are
+ *                merged, with no compaction, unlimited compaction and
+ *                compaction held to MB megabytes a second
+*/
+
+#include <fcntl.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "globalhashtable.h"
+#include "concurrentglobalhashtable.h"
+#include "blockpost.h"
+#include "docstore.h"
+#include "forwardindex.h"
+#include "impactquantizer.h"
+#include "outputwriter.h"
+#include "postingcodec.h"
+#include "queryengine.h"
+#include "segment.h"
+#include "termtrie.h"
+
+#define BENCH_VOCABULARY 40000     // distinct words in the synthetic corpus
+#define BENCH_WORDS_PER_DOC 100    // words posted per document
+#define BENCH_MAX_THREADS 64
+#define BENCH_FUZZY_QUERIES 2000
+#define BENCH_FUZZY_CHECKS 20     // queries also checked by brute force
+#define BENCH_CODEC_SECONDS 0.5   // the least time spent decoding with each codec
+#define BENCH_IMPACT_TOP 10       // the ranks compared with float scoring
+#define BENCH_IMPACT_WORDS 3      // the most words in a query
+#define BENCH_BATCH_WORDS 4       // the most words in a batch query
+#define BENCH_FORWARD_REBUILDS 10 // documents rebuilt from bpost, as feedback would
+#define BENCH_LIVE_RATE 20000     // documents a second the live writer adds
+#define BENCH_LIVE_SAMPLES 200    // documents looked for through the flushed segments
+#define BENCH_COMPACT_SEGMENTS 256 // small segments written before compaction starts
+#define BENCH_COMPACT_QUERIES 500 // queries timed with no compaction
+
+using namespace std;
+
+struct BenchDoc   // one document's words, as TransferData would send them
+{
+   vector<string> tokens;
+   vector<float> rtfs;
+};
+
+/* Name:  MakeDocuments
+ * Parameters:  NumDocs: how many documents to make
+ *              Docs: receives them
+ * Purpose:     build documents whose words follow a Zipf-like law, so a
+ *              few words are in most documents (and contend for the same
+ *              postings list) and most are rare
+ * Returns:     nothing
+*/
+static void MakeDocuments(const int NumDocs, vector<BenchDoc> &Docs)
+{
+mt19937 Random(7);
+vector<string> Vocabulary;
+vector<double> Weights;
+char Word[16];
+
+   for (int i = 0; i < BENCH_VOCABULARY; i++)
+   {
+      snprintf(Word, sizeof(Word), "w%dx%d", i, (i * 7919) % 997);
+      Vocabulary.push_back(Word);
+      Weights.push_back(1.0 / (i + 1));
+   }
+   discrete_distribution<int> Zipf(Weights.begin(), Weights.end());
+
+   Docs.resize(NumDocs);
+   for (int d = 0; d < NumDocs; d++)
+   {
+      vector<bool> Seen(BENCH_VOCABULARY, false);
+      while (Docs[d].tokens.size() < BENCH_WORDS_PER_DOC)
+      {
+         int w = Zipf(Random);
+         if (!Seen[w])
+         {
+            Seen[w] = true;
+            Docs[d].tokens.push_back(Vocabulary[w]);
+            Docs[d].rtfs.push_back(1.0 / BENCH_WORDS_PER_DOC);
+         }
+      }
+   }
+}
+
+static double SecondsSince(const chrono::steady_clock::time_point Start)
+{
+   return chrono::duration<double>(chrono::steady_clock::now() - Start).count();
+}
+
+/* Name:  PostConcurrent
+ * Parameters:  Docs: the documents
+ *              NumThreads: the threads to post with
+ * Purpose:     time posting every document into a shared
+ *              ConcurrentGlobalHashTable, thread t taking documents
+ *              t, t + NumThreads, ...
+ * Returns:     the seconds taken
+*/
+static double PostConcurrent(const vector<BenchDoc> &Docs, const int NumThreads)
+{
+ConcurrentGlobalHashTable GlobalHT(BENCH_VOCABULARY);
+vector<thread> Threads;
+chrono::steady_clock::time_point Start = chrono::steady_clock::now();
+
+   for (int t = 0; t < NumThreads; t++)
+      Threads.push_back(thread([&, t]()
+      {
+         for (unsigned long d = t; d < Docs.size(); d += NumThreads)
+            for (unsigned long k = 0; k < Docs[d].tokens.size(); k++)
+               GlobalHT.Insert(Docs[d].tokens[k], d + 1, Docs[d].rtfs[k], k);
+      }));
+   for (int t = 0; t < NumThreads; t++)
+      Threads[t].join();
+   return SecondsSince(Start);
+}
+
+/* Name:  PostLocked
+ * Parameters:  Docs: the documents
+ *              NumThreads: the threads to post with
+ * Purpose:     the same, into a GlobalHashTable with one mutex held for
+ *              each document's transfer
+ * Returns:     the seconds taken
+*/
+static double PostLocked(const vector<BenchDoc> &Docs, const int NumThreads)
+{
+TermTable Terms(BENCH_VOCABULARY);
+GlobalHashTable GlobalHT(BENCH_VOCABULARY, Terms);
+mutex Lock;
+vector<thread> Threads;
+chrono::steady_clock::time_point Start = chrono::steady_clock::now();
+
+   for (int t = 0; t < NumThreads; t++)
+      Threads.push_back(thread([&, t]()
+      {
+         for (unsigned long d = t; d < Docs.size(); d += NumThreads)
+         {
+            lock_guard<mutex> Guard(Lock);
+            for (unsigned long k = 0; k < Docs[d].tokens.size(); k++)
+               GlobalHT.Insert(Docs[d].tokens[k], d + 1, Docs[d].rtfs[k]);
+         }
+      }));
+   for (int t = 0; t < NumThreads; t++)
+      Threads[t].join();
+   return SecondsSince(Start);
+}
+
+/* Name:  BenchConcurrent
+ * Parameters:  NumDocs: the size of the synthetic corpus
+ * Purpose:     print postings per second for 1 to 64 threads, for both
+ *              tables, and the speedup over one thread
+ * Returns:     nothing
+*/
+static void BenchConcurrent(const int NumDocs)
+{
+vector<BenchDoc> Docs;
+double Postings = NumDocs * (double) BENCH_WORDS_PER_DOC;
+double Concurrent1 = 0.0;
+double Locked1 = 0.0;
+
+   MakeDocuments(NumDocs, Docs);
+   cout << NumDocs << " documents, " << (long) Postings << " postings, "
+        << thread::hardware_concurrency() << " hardware threads" << endl;
+   cout << "threads    concurrent Mpost/s  speedup      locked Mpost/s  speedup" << endl;
+   for (int Threads = 1; Threads <= BENCH_MAX_THREADS; Threads *= 2)
+   {
+      double Concurrent = PostConcurrent(Docs, Threads);
+      double Locked = PostLocked(Docs, Threads);
+      if (Threads == 1)
+      {
+         Concurrent1 = Concurrent;
+         Locked1 = Locked;
+      }
+      cout << setw(7) << Threads << fixed << setprecision(2)
+           << setw(22) << Postings / Concurrent / 1e6 << setw(9) << Concurrent1 / Concurrent
+           << setw(20) << Postings / Locked / 1e6 << setw(9) << Locked1 / Locked << endl;
+   }
+}
+
+/* Name:  BenchOutput
+ * Parameters:  NumPostings: how many post lines to write
+ * Purpose:     print the MB/s of writing post lines through ofstream,
+ *              as PrintDictPost used to, and through OutputWriter, and
+ *              check that the two files are the same
+ * Returns:     nothing
+*/
+static void BenchOutput(const long NumPostings)
+{
+mt19937 Random(11);
+uniform_real_distribution<float> Weight(0.0001, 0.2);
+vector<Posting> Postings;
+const char *StreamFilename = "bench_stream.txt";
+const char *WriterFilename = "bench_writer.txt";
+chrono::steady_clock::time_point Start;
+double StreamSeconds;
+double WriterSeconds;
+off_t Bytes;
+int Fd;
+
+   for (long i = 0; i < NumPostings; i++)
+      Postings.push_back(Posting(i % 9999 + 1, Weight(Random)));
+
+   Start = chrono::steady_clock::now();
+   {
+      ofstream Post(StreamFilename);
+      for (long i = 0; i < NumPostings; i++)
+         Postings[i].Print(Post, 4321.5);
+   }
+   StreamSeconds = SecondsSince(Start);
+
+   Start = chrono::steady_clock::now();
+   if ((Fd = open(WriterFilename, O_WRONLY | O_CREAT | O_TRUNC, 0644)) < 0)
+   {
+      perror(WriterFilename);
+      return;
+   }
+   {
+      OutputWriter Post(Fd);
+      for (long i = 0; i < NumPostings; i++)
+         Postings[i].Write(Post, 4321.5);
+   }
+   close(Fd);
+   WriterSeconds = SecondsSince(Start);
+
+   ifstream Stream(StreamFilename);
+   ifstream Writer(WriterFilename);
+   string StreamText((istreambuf_iterator<char>(Stream)), istreambuf_iterator<char>());
+   string WriterText((istreambuf_iterator<char>(Writer)), istreambuf_iterator<char>());
+   Bytes = StreamText.size();
+   unlink(StreamFilename);
+   unlink(WriterFilename);
+
+   cout << NumPostings << " postings, " << Bytes << " bytes, output "
+        << (StreamText == WriterText ? "identical" : "DIFFERS") << endl;
+   cout << fixed << setprecision(1)
+        << "ofstream      " << setw(8) << Bytes / StreamSeconds / 1e6 << " MB/s" << endl
+        << "OutputWriter  " << setw(8) << Bytes / WriterSeconds / 1e6 << " MB/s" << endl;
+}
+
+// The edit distance between two words, the plain way
+static int EditDistance(const string_view a, const string_view b)
+{
+vector<int> Row(b.length() + 1);
+vector<int> Next(b.length() + 1);
+
+   for (unsigned long j = 0; j <= b.length(); j++)
+      Row[j] = j;
+   for (unsigned long i = 1; i <= a.length(); i++)
+   {
+      Next[0] = i;
+      for (unsigned long j = 1; j <= b.length(); j++)
+         Next[j] = min(min(Row[j], Next[j - 1]) + 1, Row[j - 1] + (a[i - 1] != b[j - 1]));
+      Row.swap(Next);
+   }
+   return Row[b.length()];
+}
+
+/* Name:  BenchFuzzy
+ * Parameters:  NumTerms: the size of the vocabulary
+ * Purpose:     build a trie of random words, then time Fuzzy on words
+ *              made by one or two random edits of vocabulary words,
+ *              printing the median, 99th percentile and worst times;
+ *              the first few queries are checked against every term
+ * Returns:     nothing
+*/
+static void BenchFuzzy(const int NumTerms)
+{
+mt19937 Random(13);
+uniform_int_distribution<int> Length(3, 12);
+uniform_int_distribution<int> Letter('a', 'z');
+vector<string> Words;
+vector<string_view> Terms;
+vector<TrieEntry> Entries;
+vector<TrieMatch> Matches;
+TermTrie Trie;
+bool Correct = true;
+long Found = 0;
+
+   for (int i = 0; i < NumTerms; i++)
+   {
+      string Word(Length(Random), ' ');
+      for (unsigned long k = 0; k < Word.length(); k++)
+         Word[k] = Letter(Random);
+      Words.push_back(Word);
+   }
+   sort(Words.begin(), Words.end());
+   Words.erase(unique(Words.begin(), Words.end()), Words.end());
+   for (unsigned long i = 0; i < Words.size(); i++)
+   {
+      Terms.push_back(Words[i]);
+      Entries.push_back(TrieEntry{(int) (Random() % 1000) + 1, i});
+   }
+   Trie.Build(Terms, Entries);
+   cout << Words.size() << " terms" << endl;
+   cout << "edits   median us     p99 us   worst us   matches/query" << endl;
+
+   for (int Edits = 1; Edits <= 2; Edits++)
+   {
+      vector<double> Times;
+      Found = 0;
+      for (int q = 0; q < BENCH_FUZZY_QUERIES; q++)
+      {
+         string Query = Words[Random() % Words.size()];
+         for (int e = 0; e < Edits; e++)
+         {
+            unsigned long At = Random() % (Query.length() + 1);
+            switch (Random() % 3)
+            {
+               case 0:  Query.insert(At, 1, (char) Letter(Random));  break;
+               case 1:  if (At < Query.length()) Query.erase(At, 1);  break;
+               default: if (At < Query.length()) Query[At] = Letter(Random);  break;
+            }
+         }
+
+         Matches.clear();
+         chrono::steady_clock::time_point Start = chrono::steady_clock::now();
+         Trie.Fuzzy(Query, Edits, Matches);
+         Times.push_back(SecondsSince(Start) * 1e6);
+         Found += Matches.size();
+
+         if (q < BENCH_FUZZY_CHECKS)
+         {
+            unsigned long Expected = 0;
+            for (unsigned long i = 0; i < Words.size(); i++)
+               if (EditDistance(Query, Words[i]) <= Edits)
+                  Expected++;
+            Correct = Correct && Expected == Matches.size();
+            for (unsigned long m = 0; m < Matches.size(); m++)
+               Correct = Correct && EditDistance(Query, Matches[m].term) == Matches[m].distance &&
+                         (m == 0 || Matches[m - 1].entry.numdocs >= Matches[m].entry.numdocs);
+         }
+      }
+      sort(Times.begin(), Times.end());
+      cout << setw(5) << Edits << fixed << setprecision(1)
+           << setw(12) << Times[Times.size() / 2]
+           << setw(11) << Times[Times.size() * 99 / 100]
+           << setw(11) << Times.back()
+           << setw(16) << (double) Found / BENCH_FUZZY_QUERIES << endl;
+   }
+   cout << "matches " << (Correct ? "agree" : "DISAGREE") << " with brute force" << endl;
+}
+
+/* Name:  BenchCodec
+ * Parameters:  IndexDirname: an index directory with trie and bpost
+ * Purpose:     read every list's DocIds back from bpost, then pack all
+ *              of them with each codec in turn, and with the codec bpost
+ *              chose for each list, printing the bits per DocId, the
+ *              ratio to plain 4-byte DocIds and the DocIds decoded per
+ *              nanosecond; every decode is checked against the DocIds
+ * Returns:     nothing
+*/
+static void BenchCodec(const string IndexDirname)
+{
+TermTrie Trie;
+BlockPost Post;
+PostingCursor Cursor;
+vector<TrieMatch> Entries;
+vector< vector<int> > Lists;
+int ListsChosen[CODEC_COUNT];
+int DocIds[CODEC_BLOCK_POSTINGS];
+long NumPostings = 0;
+bool Correct = true;
+
+   if (!Trie.Read(IndexDirname + "/trie") || !Post.Open(IndexDirname + "/bpost"))
+   {
+      cerr << "Unable to read " << IndexDirname << "/trie and " << IndexDirname << "/bpost" << endl;
+      return;
+   }
+   Trie.Prefix("", Entries);
+   for (unsigned long e = 0; e < Entries.size(); e++)
+      if (Post.GetCursor(Entries[e].entry, Cursor))
+      {
+         Lists.push_back(vector<int>());
+         for (; Cursor.GetDocId() != CURSOR_END; Cursor.Next())
+            Lists.back().push_back(Cursor.GetDocId());
+         NumPostings += Lists.back().size();
+      }
+   memset(ListsChosen, 0, sizeof(ListsChosen));
+   for (unsigned long l = 0; l < Lists.size(); l++)
+      ListsChosen[PostingCodec::Choose(Lists[l].size(), Lists[l].back())]++;
+
+   cout << Lists.size() << " lists, " << NumPostings << " DocIds" << endl;
+   cout << "codec          lists   bits/DocId   ratio   DocIds/ns" << endl;
+   for (int c = 0; c <= CODEC_COUNT; c++)
+   {
+      vector<char> Packed;
+      int Passes = 0;
+      double Seconds;
+
+      // c == CODEC_COUNT packs each list as bpost does
+      for (unsigned long l = 0; l < Lists.size(); l++)
+      {
+         CodecType Codec = (c == CODEC_COUNT ? PostingCodec::Choose(Lists[l].size(), Lists[l].back())
+                                             : (CodecType) c);
+         for (unsigned long First = 0; First < Lists[l].size(); First += CODEC_BLOCK_POSTINGS)
+            PostingCodec::Encode(Codec, &Lists[l][First],
+                                 min((unsigned long) CODEC_BLOCK_POSTINGS, Lists[l].size() - First),
+                                 First == 0 ? 0 : Lists[l][First - 1], Packed);
+      }
+
+      chrono::steady_clock::time_point Start = chrono::steady_clock::now();
+      do
+      {
+         const char *In = Packed.data();
+         for (unsigned long l = 0; l < Lists.size(); l++)
+         {
+            CodecType Codec = (c == CODEC_COUNT ? PostingCodec::Choose(Lists[l].size(), Lists[l].back())
+                                                : (CodecType) c);
+            int Previous = 0;
+            for (unsigned long First = 0; First < Lists[l].size(); First += CODEC_BLOCK_POSTINGS)
+            {
+               int Count = min((unsigned long) CODEC_BLOCK_POSTINGS, Lists[l].size() - First);
+               In = PostingCodec::Decode(Codec, In, Count, Previous, DocIds);
+               Previous = DocIds[Count - 1];
+               if (Passes == 0)
+                  Correct = Correct && equal(DocIds, DocIds + Count, Lists[l].begin() + First);
+            }
+         }
+         Passes++;
+         Seconds = SecondsSince(Start);
+      } while (Seconds < BENCH_CODEC_SECONDS);
+
+      cout << left << setw(13) << (c == CODEC_COUNT ? "chosen" : PostingCodec::GetName((CodecType) c))
+           << right << setw(7) << (c == CODEC_COUNT ? (long) Lists.size() : (long) ListsChosen[c])
+           << fixed << setprecision(2)
+           << setw(13) << 8.0 * Packed.size() / NumPostings
+           << setw(8) << 4.0 * NumPostings / Packed.size()
+           << setw(12) << NumPostings * Passes / (Seconds * 1e9) << endl;
+   }
+   cout << "decoded DocIds " << (Correct ? "agree" : "DISAGREE") << " with bpost" << endl;
+}
+
+// The best BENCH_IMPACT_TOP DocIds by score, ties to the lower DocId
+static vector<int> TopDocs(const vector<float> &Scores, const vector<int> &Touched)
+{
+vector<int> Docs(Touched);
+unsigned long Count = min((unsigned long) BENCH_IMPACT_TOP, Docs.size());
+
+   partial_sort(Docs.begin(), Docs.begin() + Count, Docs.end(), [&](int a, int b)
+   {
+      if (Scores[a] != Scores[b])
+         return Scores[a] > Scores[b];
+      return a < b;
+   });
+   Docs.resize(Count);
+   return Docs;
+}
+
+/* Name:  BenchImpacts
+ * Parameters:  IndexDirname: an index directory with trie and a bpost
+ *                            of float weights
+ *              NumQueries: random queries of 1 to BENCH_IMPACT_WORDS
+ *                          words to rank
+ * Purpose:     rank each query as query does, with the float weights and
+ *              with the weights each kind of impact would turn them
+ *              into, printing the largest relative weight error, how
+ *              much of the float top BENCH_IMPACT_TOP each keeps, and
+ *              how often it keeps it in the same order
+ * Returns:     nothing
+*/
+static void BenchImpacts(const string IndexDirname, const int NumQueries)
+{
+const int Bits[4] = {IMPACT_BITS_SMALL, IMPACT_BITS_SMALL, IMPACT_BITS_LARGE, IMPACT_BITS_LARGE};
+const bool Logarithmic[4] = {false, true, false, true};
+mt19937 Random(17);
+TermTrie Trie;
+BlockPost Post;
+PostingCursor Cursor;
+vector<TrieMatch> Entries;
+vector< vector<int> > Lists;
+vector< vector<float> > Weights;
+vector< vector<int> > Queries;
+float Low = 0.0;
+float High = 0.0;
+int NumDocs = 0;
+
+   if (!Trie.Read(IndexDirname + "/trie") || !Post.Open(IndexDirname + "/bpost") ||
+       Post.GetImpactBits() != IMPACT_FLOAT)
+   {
+      cerr << "Unable to read " << IndexDirname << "/trie and a float " << IndexDirname << "/bpost" << endl;
+      return;
+   }
+   Trie.Prefix("", Entries);
+   for (unsigned long e = 0; e < Entries.size(); e++)
+      if (Post.GetCursor(Entries[e].entry, Cursor))
+      {
+         Lists.push_back(vector<int>());
+         Weights.push_back(vector<float>());
+         for (; Cursor.GetDocId() != CURSOR_END; Cursor.Next())
+         {
+            Lists.back().push_back(Cursor.GetDocId());
+            Weights.back().push_back(Cursor.Score());
+            if (Low == 0.0 || (Cursor.Score() > 0.0 && Cursor.Score() < Low))
+               Low = Cursor.Score();
+            High = max(High, Cursor.Score());
+            NumDocs = max(NumDocs, Cursor.GetDocId());
+         }
+      }
+   if (Lists.empty())
+      return;
+   for (int q = 0; q < NumQueries; q++)
+   {
+      Queries.push_back(vector<int>(Random() % BENCH_IMPACT_WORDS + 1));
+      for (unsigned long w = 0; w < Queries.back().size(); w++)
+         Queries.back()[w] = Random() % Lists.size();
+   }
+
+   cout << Lists.size() << " lists, " << NumQueries << " queries, weights "
+        << Low << " .. " << High << endl;
+   cout << "impacts   bytes   max error   top " << BENCH_IMPACT_TOP << " kept   same order" << endl;
+   for (int i = 0; i < 4; i++)
+   {
+      ImpactQuantizer Quantizer(Bits[i], Logarithmic[i], Low, High);
+      vector<float> Exact(NumDocs + 1, 0.0);
+      vector<float> Quantized(NumDocs + 1, 0.0);
+      vector<int> Touched;
+      double MaxError = 0.0;
+      long Kept = 0;
+      long Compared = 0;
+      int SameOrder = 0;
+
+      for (unsigned long l = 0; l < Lists.size(); l++)
+         for (unsigned long k = 0; k < Lists[l].size(); k++)
+         {
+            float Weight = Weights[l][k];
+            MaxError = max(MaxError, fabs(Quantizer.Dequantize(Quantizer.Quantize(Weight)) - Weight) / (double) Weight);
+         }
+
+      for (int q = 0; q < NumQueries; q++)
+      {
+         for (unsigned long w = 0; w < Queries[q].size(); w++)
+         {
+            int l = Queries[q][w];
+            for (unsigned long k = 0; k < Lists[l].size(); k++)
+            {
+               int DocId = Lists[l][k];
+               if (Exact[DocId] == 0.0)
+                  Touched.push_back(DocId);
+               Exact[DocId] += Weights[l][k];
+               Quantized[DocId] += Quantizer.Dequantize(Quantizer.Quantize(Weights[l][k]));
+            }
+         }
+         vector<int> ExactTop = TopDocs(Exact, Touched);
+         vector<int> QuantizedTop = TopDocs(Quantized, Touched);
+         for (unsigned long r = 0; r < ExactTop.size(); r++)
+            Kept += (find(QuantizedTop.begin(), QuantizedTop.end(), ExactTop[r]) != QuantizedTop.end());
+         Compared += ExactTop.size();
+         SameOrder += (ExactTop == QuantizedTop);
+         for (unsigned long k = 0; k < Touched.size(); k++)
+            Exact[Touched[k]] = Quantized[Touched[k]] = 0.0;
+         Touched.clear();
+      }
+
+      cout << setw(2) << Bits[i] << (Logarithmic[i] ? " log   " : " linear")
+           << setw(6) << Bits[i] / 8 << fixed << setprecision(2)
+           << setw(11) << 100.0 * MaxError << "%"
+           << setw(12) << 100.0 * Kept / Compared << "%"
+           << setw(12) << 100.0 * SameOrder / NumQueries << "%" << endl;
+   }
+}
+
+/* Name:  BenchBatch
+ * Parameters:  IndexDirname: an index directory query can search
+ *              NumQueries: random queries of 1 to BENCH_BATCH_WORDS
+ *                          words, common terms more likely than rare
+ *              MaxThreads: the most threads to run SearchBatch on
+ * Purpose:     print queries per second ranking them one at a time
+ *              with Search, and with SearchBatch on 1, 2, 4 ... up to
+ *              MaxThreads threads, and whether the batches' results
+ *              agree
+ * Returns:     nothing
+*/
+static void BenchBatch(const string IndexDirname, const int NumQueries, const unsigned int MaxThreads)
+{
+mt19937 Random(19);
+QueryEngine Engine(IndexDirname);
+vector<TrieMatch> Entries;
+vector<string> Queries;
+vector< vector<QueryResult> > Single(NumQueries);
+vector< vector<QueryResult> > Batch;
+unsigned int Cores = max(1u, thread::hardware_concurrency());
+double Seconds;
+
+   if (!Engine.IsOpen())
+      return;
+   Engine.ExpandTerm("*", Entries);
+   if (Entries.empty())
+      return;
+   sort(Entries.begin(), Entries.end(), [](const TrieMatch &a, const TrieMatch &b)
+   {
+      return a.entry.numdocs > b.entry.numdocs;
+   });
+   for (int q = 0; q < NumQueries; q++)
+   {
+      string Query;
+      for (int w = Random() % BENCH_BATCH_WORDS; w >= 0; w--)
+         Query += (Query.empty() ? "" : " ") + Entries[Random() % (Random() % Entries.size() + 1)].term;
+      Queries.push_back(Query);
+   }
+
+   chrono::steady_clock::time_point Start = chrono::steady_clock::now();
+   for (int q = 0; q < NumQueries; q++)
+      Engine.Search(Queries[q], BENCH_IMPACT_TOP, Single[q]);
+   Seconds = SecondsSince(Start);
+   cout << NumQueries << " queries over " << Engine.GetNumDocs() << " documents, "
+        << Cores << " hardware threads" << endl;
+   cout << "mode              queries/s  speedup   same results" << endl;
+   cout << left << setw(16) << "one at a time" << right << fixed << setprecision(0)
+        << setw(11) << NumQueries / Seconds << setprecision(2) << setw(9) << 1.0 << endl;
+
+   for (unsigned int Threads = 1; Threads <= MaxThreads; Threads = (Threads < MaxThreads ? min(Threads * 2, MaxThreads) : Threads + 1))
+   {
+      int Same = 0;
+      Start = chrono::steady_clock::now();
+      Engine.SearchBatch(Queries, BENCH_IMPACT_TOP, Threads, Batch);
+      double BatchSeconds = SecondsSince(Start);
+      for (int q = 0; q < NumQueries; q++)
+      {
+         bool Agree = (Batch[q].size() == Single[q].size());
+         for (unsigned long r = 0; Agree && r < Batch[q].size(); r++)
+            Agree = (Batch[q][r].docid == Single[q][r].docid);
+         Same += Agree;
+      }
+      cout << left << setw(16) << ("batch, " + to_string(Threads) + " thr") << right << setprecision(0)
+           << setw(11) << NumQueries / BatchSeconds << setprecision(2)
+           << setw(9) << Seconds / BatchSeconds
+           << setw(14) << 100.0 * Same / NumQueries << "%" << endl;
+   }
+}
+
+/* Name:  BenchSnippets
+ * Parameters:  IndexDirname: an index directory made with --docstore
+ *              NumQueries: random queries of 1 to BENCH_BATCH_WORDS
+ *                          words, common terms more likely than rare
+ * Purpose:     print how well docs compressed, the time to read every
+ *              document in random order, and the time to make a
+ *              snippet for each of the queries' top results
+ * Returns:     nothing
+*/
+static void BenchSnippets(const string IndexDirname, const int NumQueries)
+{
+mt19937 Random(23);
+QueryEngine Engine(IndexDirname);
+DocStore Docs;
+vector<TrieMatch> Entries;
+vector<QueryResult> Results;
+vector<int> Order;
+string Text;
+string Snippet;
+unsigned long TextBytes = 0;
+long Snippets = 0;
+double Slowest = 0.0;
+double Seconds;
+
+   if (!Engine.IsOpen() || !Docs.Open(IndexDirname + "/docs"))
+   {
+      cerr << "Unable to read the index and " << IndexDirname << "/docs" << endl;
+      return;
+   }
+   for (int d = 1; d <= Docs.GetNumDocs(); d++)
+      Order.push_back(d);
+   shuffle(Order.begin(), Order.end(), Random);
+   chrono::steady_clock::time_point Start = chrono::steady_clock::now();
+   for (unsigned long d = 0; d < Order.size(); d++)
+   {
+      Docs.Get(Order[d], Text);
+      TextBytes += Text.length();
+   }
+   Seconds = SecondsSince(Start);
+   cout << Docs.GetNumDocs() << " documents, " << fixed << setprecision(1)
+        << TextBytes / 1048576.0 << " MB of text in " << Docs.GetLength() / 1048576.0
+        << " MB (" << setprecision(2) << (double) TextBytes / Docs.GetLength() << "x)" << endl;
+   cout << "random reads: " << 1e6 * Seconds / max((unsigned long) 1, Order.size()) << " us a document" << endl;
+
+   Engine.ExpandTerm("*", Entries);
+   if (Entries.empty())
+      return;
+   sort(Entries.begin(), Entries.end(), [](const TrieMatch &a, const TrieMatch &b)
+   {
+      return a.entry.numdocs > b.entry.numdocs;
+   });
+   Seconds = 0.0;
+   for (int q = 0; q < NumQueries; q++)
+   {
+      string Query;
+      for (int w = Random() % BENCH_BATCH_WORDS; w >= 0; w--)
+         Query += (Query.empty() ? "" : " ") + Entries[Random() % (Random() % Entries.size() + 1)].term;
+      Engine.Search(Query, BENCH_IMPACT_TOP, Results);
+      for (unsigned long r = 0; r < Results.size(); r++)
+      {
+         Start = chrono::steady_clock::now();
+         Engine.GetSnippet(Results[r].docid, Query, Snippet);
+         double Took = SecondsSince(Start);
+         Seconds += Took;
+         Slowest = max(Slowest, Took);
+         Snippets++;
+      }
+   }
+   cout << "snippets: " << Snippets << ", " << 1e6 * Seconds / max(1l, Snippets)
+        << " us each, slowest " << 1e6 * Slowest << " us" << endl;
+}
+
+/* Name:  BenchForward
+ * Parameters:  IndexDirname: an index directory made with --forward,
+ *                            with bpost
+ *              NumDocs: random documents to read from fwd
+ * Purpose:     print fwd's size beside post's and bpost's, the time to
+ *              read a document's vector from fwd, the time to rebuild
+ *              BENCH_FORWARD_REBUILDS vectors by advancing a cursor on
+ *              every list to each document in turn, whether the two
+ *              agree, and the time of more-like-this searches
+ * Returns:     nothing
+*/
+static void BenchForward(const string IndexDirname, const int NumDocs)
+{
+mt19937 Random(29);
+QueryEngine Engine(IndexDirname);
+ForwardIndex Forward;
+BlockPost Blocks;
+TermTrie Trie;
+vector<TrieMatch> Entries;
+vector<int> Sample;
+vector<int> TermIds;
+vector<float> Weights;
+vector< vector<int> > Rebuilt(BENCH_FORWARD_REBUILDS);
+vector<QueryResult> Results;
+long NumTerms = 0;
+int Same = 0;
+struct stat Info;
+double Seconds;
+
+   if (!Engine.IsOpen() || !Forward.Open(IndexDirname + "/fwd") || !Blocks.Open(IndexDirname + "/bpost") ||
+       !Trie.Read(IndexDirname + "/trie") || Forward.GetNumDocs() == 0)
+   {
+      cerr << "Unable to read " << IndexDirname << "/fwd, bpost and trie" << endl;
+      return;
+   }
+   cout << Forward.GetNumDocs() << " documents, " << Forward.GetNumTerms() << " terms" << endl;
+   cout << fixed << setprecision(1) << "fwd " << Forward.GetLength() / 1048576.0 << " MB";
+   if (stat((IndexDirname + "/post").c_str(), &Info) == 0)
+      cout << ", post " << Info.st_size / 1048576.0 << " MB";
+   if (stat((IndexDirname + "/bpost").c_str(), &Info) == 0)
+      cout << ", bpost " << Info.st_size / 1048576.0 << " MB";
+   cout << endl;
+
+   for (int d = 0; d < NumDocs; d++)
+      Sample.push_back(Random() % Forward.GetNumDocs() + 1);
+   chrono::steady_clock::time_point Start = chrono::steady_clock::now();
+   for (int d = 0; d < NumDocs; d++)
+   {
+      Forward.Get(Sample[d], TermIds, Weights);
+      NumTerms += TermIds.size();
+   }
+   Seconds = SecondsSince(Start);
+   cout << setprecision(2) << "fwd:   " << 1e6 * Seconds / max(1, NumDocs) << " us a document, "
+        << setprecision(1) << (double) NumTerms / max(1, NumDocs) << " terms each" << endl;
+
+   // every list is searched for the sample, in DocId order
+   Sample.resize(min(NumDocs, BENCH_FORWARD_REBUILDS));
+   sort(Sample.begin(), Sample.end());
+   Trie.Prefix("", Entries);
+   sort(Entries.begin(), Entries.end(), [](const TrieMatch &a, const TrieMatch &b)
+   {
+      return a.entry.start < b.entry.start;
+   });
+   Start = chrono::steady_clock::now();
+   for (unsigned long e = 0; e < Entries.size(); e++)
+   {
+      PostingCursor Cursor;
+      if (!Blocks.GetCursor(Entries[e].entry, Cursor))
+         continue;
+      for (unsigned long d = 0; d < Sample.size() && Cursor.AdvanceTo(Sample[d]); d++)
+         if (Cursor.GetDocId() == Sample[d])
+            Rebuilt[d].push_back(e);
+   }
+   Seconds = SecondsSince(Start);
+   for (unsigned long d = 0; d < Sample.size(); d++)
+   {
+      Forward.Get(Sample[d], TermIds, Weights);
+      Same += (TermIds == Rebuilt[d]);
+   }
+   cout << setprecision(2) << "bpost: " << 1e6 * Seconds / max((unsigned long) 1, Sample.size())
+        << " us a document, " << Same << " of " << Sample.size() << " the same as fwd" << endl;
+
+   Start = chrono::steady_clock::now();
+   for (unsigned long d = 0; d < Sample.size(); d++)
+      Engine.MoreLikeThis(Sample[d], BENCH_IMPACT_TOP, Results);
+   Seconds = SecondsSince(Start);
+   cout << "more like this: " << 1e6 * Seconds / max((unsigned long) 1, Sample.size()) << " us a search" << endl;
+}
+
+/* Name:  BenchHot
+ * Parameters:  IndexDirname: an index directory
+ *              NumQueries: random queries of 1 to BENCH_BATCH_WORDS
+ *                          words, common terms more likely than rare
+ *              MaxMB: the hot tier's budget
+ * Purpose:     print the queries per second with no hot tier; with one
+ *              after a first round has been counted and rebalanced;
+ *              and, for a second engine, on its first round after
+ *              loading the first one's saved profile.  Each is checked
+ *              against the cold results.
+ * Returns:     nothing
+*/
+static void BenchHot(const string IndexDirname, const int NumQueries, const long MaxMB)
+{
+mt19937 Random(31);
+QueryEngine Cold(IndexDirname);
+vector<TrieMatch> Entries;
+vector<string> Queries;
+vector< vector<QueryResult> > Expected(NumQueries);
+vector<QueryResult> Results;
+string Profile = IndexDirname + "/hotprofile.bench";
+double Seconds;
+
+   if (!Cold.IsOpen())
+      return;
+   Cold.ExpandTerm("*", Entries);
+   if (Entries.empty())
+      return;
+   sort(Entries.begin(), Entries.end(), [](const TrieMatch &a, const TrieMatch &b)
+   {
+      return a.entry.numdocs > b.entry.numdocs;
+   });
+   for (int q = 0; q < NumQueries; q++)
+   {
+      string Query;
+      for (int w = Random() % BENCH_BATCH_WORDS; w >= 0; w--)
+         Query += (Query.empty() ? "" : " ") + Entries[Random() % (Random() % Entries.size() + 1)].term;
+      Queries.push_back(Query);
+   }
+
+   chrono::steady_clock::time_point Start = chrono::steady_clock::now();
+   for (int q = 0; q < NumQueries; q++)
+      Cold.Search(Queries[q], BENCH_IMPACT_TOP, Expected[q]);
+   Seconds = SecondsSince(Start);
+   cout << NumQueries << " queries over " << Cold.GetNumDocs() << " documents, " << MaxMB << " MB hot" << endl;
+   cout << "mode                 queries/s  speedup   same results" << endl;
+   cout << left << setw(19) << "cold" << right << fixed << setprecision(0)
+        << setw(11) << NumQueries / Seconds << setprecision(2) << setw(9) << 1.0 << endl;
+
+   for (int Round = 0; Round < 2; Round++)
+   {
+      QueryEngine Engine(IndexDirname);
+      Engine.StartHotTier(MaxMB * 1048576);
+      if (Round == 0)
+      {
+         for (int q = 0; q < NumQueries; q++)
+            Engine.Search(Queries[q], BENCH_IMPACT_TOP, Results);
+         Engine.GetHotTier().Rebalance();
+      }
+      else
+         Engine.GetHotTier().LoadProfile(Profile);
+
+      int Same = 0;
+      Start = chrono::steady_clock::now();
+      for (int q = 0; q < NumQueries; q++)
+      {
+         Engine.Search(Queries[q], BENCH_IMPACT_TOP, Results);
+         bool Agree = (Results.size() == Expected[q].size());
+         for (unsigned long r = 0; Agree && r < Results.size(); r++)
+            Agree = (Results[r].docid == Expected[q][r].docid && Results[r].score == Expected[q][r].score);
+         Same += Agree;
+      }
+      double HotSeconds = SecondsSince(Start);
+      cout << left << setw(19) << (Round == 0 ? "hot, counted" : "hot, from profile") << right
+           << setprecision(0) << setw(11) << NumQueries / HotSeconds << setprecision(2)
+           << setw(9) << Seconds / HotSeconds
+           << setw(14) << 100.0 * Same / NumQueries << "%" << endl;
+      Engine.GetHotTier().PrintReport();
+      if (Round == 0)
+         Engine.GetHotTier().SaveProfile(Profile);
+   }
+   unlink(Profile.c_str());
+}
+
+/* Name:  BenchLive
+ * Parameters:  NumDocs: how many documents to add
+ *              Seconds: the longest a document waits to be flushed
+ * Purpose:     time adding synthetic documents, each with a term of its
+ *              own, to a memory segment on its own, then add them again
+ *              at BENCH_LIVE_RATE a second on a writer thread while the
+ *              main thread looks for them: the newest document through
+ *              an engine sharing the memory segment, and sampled ones
+ *              through an engine that only sees the flushed segments.
+ *              Reports how long after being added each is found.
+ * Returns:     nothing
+*/
+static void BenchLive(const int NumDocs, const int Seconds)
+{
+vector<BenchDoc> Docs;
+string Dirname = "benchlive." + to_string(getpid());
+vector<double> Added(NumDocs + 1, 0.0);   // by DocId, when it was added
+atomic<int> Count(0);
+vector<QueryResult> Results;
+vector<double> Near;
+vector<double> Far;
+vector<string_view> Terms;
+int Missed = 0;
+int Generations;
+double Rate;
+
+   MakeDocuments(NumDocs, Docs);
+   for (int d = 0; d < NumDocs; d++)
+   {
+      Docs[d].tokens.push_back("live" + to_string(d + 1));
+      Docs[d].rtfs.push_back(1.0 / BENCH_WORDS_PER_DOC);
+   }
+   mkdir(Dirname.c_str(), 0755);
+
+   {
+   MemorySegment Alone(Dirname + "/alone", Seconds);
+   chrono::steady_clock::time_point Start = chrono::steady_clock::now();
+   for (int d = 0; d < NumDocs; d++)
+   {
+      Terms.assign(Docs[d].tokens.begin(), Docs[d].tokens.end());
+      Alone.Add(d + 1, "doc" + to_string(d + 1), Terms, Docs[d].rtfs);
+   }
+   Alone.Flush();
+   Rate = NumDocs / SecondsSince(Start);
+   Generations = Alone.GetGeneration();
+   }
+   Segment::Remove(Dirname + "/alone");
+   cout << NumDocs << " documents, flushed every " << Seconds << " s or " << SEGMENT_MAX_DOCS << " documents" << endl;
+   cout << "added alone:        " << fixed << setprecision(0) << Rate << " documents/s, "
+        << Generations << " segments flushed" << endl;
+
+   {
+   MemorySegment Live(Dirname + "/segments", Seconds);
+   QueryEngine Shared(Dirname);
+   QueryEngine Other(Dirname);
+   int Step = max(1, NumDocs / BENCH_LIVE_SAMPLES);
+   int Last = 0;
+   chrono::steady_clock::time_point Start = chrono::steady_clock::now();
+
+   Live.StartCompaction(SEGMENT_COMPACT_MB * 1048576);
+   Shared.SetLiveSegment(&Live);
+   thread Writer([&]()
+   {
+      vector<string_view> Words;
+      for (int d = 0; d < NumDocs; d++)
+      {
+         while (SecondsSince(Start) < d * 1.0 / BENCH_LIVE_RATE)
+            this_thread::sleep_for(chrono::microseconds(50));
+         Words.assign(Docs[d].tokens.begin(), Docs[d].tokens.end());
+         Live.Add(d + 1, "doc" + to_string(d + 1), Words, Docs[d].rtfs);
+         Added[d + 1] = SecondsSince(Start);
+         Count.store(d + 1, memory_order_release);
+      }
+      Live.Flush();
+   });
+
+   for (int Next = Step; Next <= NumDocs; )
+   {
+      int Newest = Count.load(memory_order_acquire);
+      if (Newest > Last)
+      {
+         Shared.Search("live" + to_string(Newest), 1, Results);
+         if (!Results.empty() && Results[0].docid == Newest)
+            Near.push_back(SecondsSince(Start) - Added[Newest]);
+         else
+            Missed++;
+         Last = Newest;
+      }
+      if (Newest < Next)
+      {
+         this_thread::yield();
+         continue;
+      }
+      Other.Refresh();
+      Other.Search("live" + to_string(Next), 1, Results);
+      if (!Results.empty() && Results[0].docid == Next)
+      {
+         Far.push_back(SecondsSince(Start) - Added[Next]);
+         Next += Step;
+      }
+      else
+         this_thread::sleep_for(chrono::microseconds(200));
+   }
+   Writer.join();
+   Generations = Live.GetGeneration();
+   }
+   Segment::Remove(Dirname + "/segments");
+   rmdir(Dirname.c_str());
+
+   sort(Near.begin(), Near.end());
+   sort(Far.begin(), Far.end());
+   cout << left << setw(20) << "added at " + to_string(BENCH_LIVE_RATE) + "/s:" << right
+        << Generations << " segments flushed or merged" << endl;
+   cout << "found in process:   " << Near.size() << " newest documents, " << Missed << " missed, median "
+        << setprecision(1) << (Near.empty() ? 0.0 : 1e6 * Near[Near.size() / 2]) << " us, worst "
+        << (Near.empty() ? 0.0 : 1e6 * Near.back()) << " us after being added" << endl;
+   cout << "found once flushed: " << Far.size() << " sampled documents, median " << setprecision(3)
+        << (Far.empty() ? 0.0 : Far[Far.size() / 2]) << " s, worst "
+        << (Far.empty() ? 0.0 : Far.back()) << " s after being added" << endl;
+}
+
+/* Name:  BenchCompact
+ * Parameters:  NumDocs: how many documents to index
+ *              MaxMB: the limit for the rate-limited run
+ * Purpose:     flush synthetic documents as BENCH_COMPACT_SEGMENTS small
+ *              segments, then time random queries against them (each
+ *              query refreshing the segments first) with no
+ *              compaction, and while compaction merges them with no
+ *              limit and with MaxMB megabytes a second.  Reports the
+ *              median and 99th percentile query time, how long the
+ *              merging took, how many segments it left, and whether
+ *              the merged segments rank the queries as the small ones
+ *              did.
+ * Returns:     nothing
+*/
+static void BenchCompact(const int NumDocs, const long MaxMB)
+{
+mt19937 Random(37);
+vector<BenchDoc> Docs;
+vector<string> Queries;
+vector<string_view> Terms;
+vector<QueryResult> Results;
+vector< vector<QueryResult> > Expected;   // with no compaction
+string Dirname = "benchcompact." + to_string(getpid());
+int PerSegment = max(1, NumDocs / BENCH_COMPACT_SEGMENTS);
+int Target = NumDocs;
+
+   MakeDocuments(NumDocs, Docs);
+   for (int q = 0; q < BENCH_COMPACT_QUERIES; q++)
+   {
+      const BenchDoc &Doc = Docs[Random() % NumDocs];
+      string Query;
+      for (int w = Random() % BENCH_IMPACT_WORDS; w >= 0; w--)
+         Query += (Query.empty() ? "" : " ") + Doc.tokens[Random() % Doc.tokens.size()];
+      Queries.push_back(Query);
+   }
+   mkdir(Dirname.c_str(), 0755);
+   cout << NumDocs << " documents in " << (NumDocs + PerSegment - 1) / PerSegment << " segments" << endl;
+   cout << "compaction        merging s   segments   median us   p99 us   same results" << endl;
+
+   for (int Mode = 0; Mode < 3; Mode++)
+   {
+      vector<double> Latencies;
+      double Seconds = 0.0;
+      int Left;
+      int Same = 0;
+      {
+      MemorySegment Writer(Dirname + "/segments", 3600);
+      for (int d = 0; d < NumDocs; d++)
+      {
+         Terms.assign(Docs[d].tokens.begin(), Docs[d].tokens.end());
+         Writer.Add(d + 1, "doc" + to_string(d + 1), Terms, Docs[d].rtfs);
+         if ((d + 1) % PerSegment == 0)
+            Writer.Flush();
+      }
+      Writer.Flush();
+      QueryEngine Engine(Dirname);
+
+      chrono::steady_clock::time_point Start = chrono::steady_clock::now();
+      if (Mode > 0)
+         Writer.StartCompaction(Mode == 1 ? 0 : MaxMB * 1048576);
+      int Generation = Writer.GetGeneration();
+      chrono::steady_clock::time_point Changed = Start;
+      Left = Engine.Refresh();
+      for (int q = 0; Mode == 0 ? q < BENCH_COMPACT_QUERIES
+                                : Left > Target || SecondsSince(Changed) < 2.0 * SEGMENT_COMPACT_MS / 1000; q++)
+      {
+         chrono::steady_clock::time_point Asked = chrono::steady_clock::now();
+         Left = Engine.Refresh();
+         Engine.Search(Queries[q % Queries.size()], BENCH_IMPACT_TOP, Results);
+         Latencies.push_back(SecondsSince(Asked));
+         if (Mode == 0)
+            Expected.push_back(Results);
+         if (Writer.GetGeneration() != Generation)
+         {
+            Generation = Writer.GetGeneration();
+            Changed = chrono::steady_clock::now();
+            Seconds = chrono::duration<double>(Changed - Start).count();
+         }
+      }
+      for (int q = 0; q < BENCH_COMPACT_QUERIES; q++)
+      {
+         Engine.Search(Queries[q], BENCH_IMPACT_TOP, Results);
+         bool Agree = (Results.size() == Expected[q].size());
+         for (unsigned long r = 0; Agree && r < Results.size(); r++)
+            Agree = (Results[r].docid == Expected[q][r].docid && Results[r].score == Expected[q][r].score);
+         Same += Agree;
+      }
+      }
+      Segment::Remove(Dirname + "/segments");
+      if (Mode == 1)
+         Target = Left;   // the limited run merges as far
+
+      sort(Latencies.begin(), Latencies.end());
+      cout << left << setw(18) << (Mode == 0 ? "none" : Mode == 1 ? "unlimited" : to_string(MaxMB) + " MB/s")
+           << right << fixed << setprecision(2) << setw(9) << Seconds << setw(11) << Left
+           << setprecision(0) << setw(12) << 1e6 * Latencies[Latencies.size() / 2]
+           << setw(9) << 1e6 * Latencies[Latencies.size() * 99 / 100]
+           << setprecision(2) << setw(14) << 100.0 * Same / BENCH_COMPACT_QUERIES << "%" << endl;
+   }
+   rmdir(Dirname.c_str());
+}
+
+int main(int argc, char **argv)
+{
+   if (argc >= 2 && strcmp(argv[1], "concurrent") == 0)
+      BenchConcurrent(argc >= 3 ? atoi(argv[2]) : 20000);
+   else if (argc >= 2 && strcmp(argv[1], "output") == 0)
+      BenchOutput(argc >= 3 ? atol(argv[2]) : 10000000);
+   else if (argc >= 2 && strcmp(argv[1], "fuzzy") == 0)
+      BenchFuzzy(argc >= 3 ? atoi(argv[2]) : 1000000);
+   else if (argc == 3 && strcmp(argv[1], "codec") == 0)
+      BenchCodec(argv[2]);
+   else if (argc >= 3 && strcmp(argv[1], "impacts") == 0)
+      BenchImpacts(argv[2], argc >= 4 ? atoi(argv[3]) : 10000);
+   else if (argc >= 3 && strcmp(argv[1], "batch") == 0)
+      BenchBatch(argv[2], argc >= 4 ? atoi(argv[3]) : 20000,
+                 argc >= 5 ? atoi(argv[4]) : max(4u, thread::hardware_concurrency()));
+   else if (argc >= 3 && strcmp(argv[1], "snippets") == 0)
+      BenchSnippets(argv[2], argc >= 4 ? atoi(argv[3]) : 2000);
+   else if (argc >= 3 && strcmp(argv[1], "forward") == 0)
+      BenchForward(argv[2], argc >= 4 ? atoi(argv[3]) : 100000);
+   else if (argc >= 3 && strcmp(argv[1], "hot") == 0)
+      BenchHot(argv[2], argc >= 4 ? atoi(argv[3]) : 20000, argc >= 5 ? atol(argv[4]) : 64);
+   else if (argc >= 2 && strcmp(argv[1], "live") == 0)
+      BenchLive(argc >= 3 ? atoi(argv[2]) : 60000, argc >= 4 ? atoi(argv[3]) : 1);
+   else if (argc >= 2 && strcmp(argv[1], "compact") == 0)
+      BenchCompact(argc >= 3 ? atoi(argv[2]) : 200000, argc >= 4 ? atol(argv[3]) : SEGMENT_COMPACT_MB);
+   else
+   {
+      fprintf (stderr, "Usage: %s concurrent [NumDocs]\n", argv[0]);
+      fprintf (stderr, "       %s output [NumPostings]\n", argv[0]);
+      fprintf (stderr, "       %s fuzzy [NumTerms]\n", argv[0]);
+      fprintf (stderr, "       %s codec IndexDirname\n", argv[0]);
+      fprintf (stderr, "       %s impacts IndexDirname [NumQueries]\n", argv[0]);
+      fprintf (stderr, "       %s batch IndexDirname [NumQueries [MaxThreads]]\n", argv[0]);
+      fprintf (stderr, "       %s snippets IndexDirname [NumQueries]\n", argv[0]);
+      fprintf (stderr, "       %s forward IndexDirname [NumDocs]\n", argv[0]);
+      fprintf (stderr, "       %s hot IndexDirname [NumQueries] [MB]\n", argv[0]);
+      fprintf (stderr, "       %s live [NumDocs] [Seconds]\n", argv[0]);
+      fprintf (stderr, "       %s compact [NumDocs] [MB]\n", argv[0]);
+      return (1);
+   }
+   return (0);
+}
@@ -0,0 +1,437 @@
+/* Filename:  blockpost.cpp
+ * Date:      10/19/2026
+ * Purpose:   The implementation file for the blocked postings file and
+ *            its cursors.
+*/
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <iostream>
+#include <vector>
+
+#include "blockpost.h"
+#include "outputwriter.h"
+
+using namespace std;
+
+// Read a number of the given type from anywhere in the file
+template <class T>
+static T GetRaw(const char *Where)
+{
+T Value;
+
+   memcpy(&Value, Where, sizeof(T));
+   return Value;
+}
+
+/*-------------------------- PostingCursor --------------------------------*/
+
+/* Name:  PostingCursor
+ * Parameters:  none
+ * Purpose:     an empty cursor, already at its end, until
+ *              BlockPost::GetCursor points it at a list
+ * Returns:     nothing
+*/
+PostingCursor::PostingCursor()
+{
+   skips = NULL;
+   blocks = NULL;
+   numblocks = 0;
+   codec = CODEC_VBYTE;
+   impactbytes = sizeof(float);
+   impacts = NULL;
+   numdocs = 0;
+   decoded = 0;
+   Finish();
+}
+
+int PostingCursor::GetDocId() const
+{
+   return docids[position];
+}
+
+float PostingCursor::Score() const
+{
+   return weights[position];
+}
+
+int PostingCursor::GetNumDocs() const
+{
+   return numdocs;
+}
+
+unsigned int PostingCursor::GetBlocksDecoded() const
+{
+   return decoded;
+}
+
+/* Name:  Next
+ * Parameters:  none
+ * Purpose:     move to the next posting, decoding the next block when
+ *              this one runs out
+ * Returns:     false once there are no more postings
+*/
+bool PostingCursor::Next()
+{
+   if (docids[position] == CURSOR_END)
+      return false;
+   if (++position < count)
+      return true;
+   if (block + 1 < numblocks)
+   {
+      Decode(block + 1);
+      return true;
+   }
+   Finish();
+   return false;
+}
+
+/* Name:  AdvanceTo
+ * Parameters:  DocId: the DocId wanted
+ * Purpose:     move to the first posting at or after DocId.  The skip
+ *              table says which later block can hold it, so the blocks
+ *              in between are never decoded.
+ * Returns:     false if every posting left is before DocId
+*/
+bool PostingCursor::AdvanceTo(const int DocId)
+{
+unsigned int Low;
+unsigned int High;
+
+   if (docids[position] >= DocId)
+      return docids[position] != CURSOR_END;
+
+   if (docids[count - 1] < DocId)
+   {
+      // the first block whose last DocId reaches DocId
+      Low = block + 1;
+      High = numblocks;
+      while (Low < High)
+      {
+         unsigned int Middle = (Low + High) / 2;
+         if (GetRaw<int>(skips + Middle * BPOST_SKIP_LENGTH) < DocId)
+            Low = Middle + 1;
+         else
+            High = Middle;
+      }
+      if (Low == numblocks)
+      {
+         Finish();
+         return false;
+      }
+      Decode(Low);
+   }
+
+   position = lower_bound(docids + position, docids + count, DocId) - docids;
+   return true;
+}
+
+/* Name:  Decode
+ * Parameters:  Block: the block of the list to decode
+ * Purpose:     unpack a block's weights and DocIds and stand on its first
+ * Returns:     nothing
+*/
+void PostingCursor::Decode(const unsigned int Block)
+{
+const char *Where = blocks + GetRaw<unsigned int>(skips + Block * BPOST_SKIP_LENGTH + 4);
+int DocId = (Block == 0 ? 0 : GetRaw<int>(skips + (Block - 1) * BPOST_SKIP_LENGTH));
+
+   block = Block;
+   count = min(numdocs - (int) Block * BPOST_BLOCK_POSTINGS, BPOST_BLOCK_POSTINGS);
+   if (impactbytes == sizeof(float))
+      memcpy(weights, Where, count * sizeof(float));
+   else if (impactbytes == 1)
+      for (int k = 0; k < count; k++)
+         weights[k] = impacts[(unsigned char) Where[k]];
+   else
+      for (int k = 0; k < count; k++)
+         weights[k] = impacts[GetRaw<unsigned short>(Where + 2 * k)];
+   PostingCodec::Decode(codec, Where + count * impactbytes, count, DocId, docids);
+   position = 0;
+   decoded++;
+}
+
+// Stand past the last posting
+void PostingCursor::Finish()
+{
+   block = numblocks;
+   count = 1;
+   position = 0;
+   docids[0] = CURSOR_END;
+   weights[0] = 0.0;
+}
+
+/*-------------------------- BlockPost ------------------------------------*/
+
+BlockPost::BlockPost()
+{
+   data = NULL;
+   length = 0;
+   directory = NULL;
+   numlists = 0;
+   impactbits = IMPACT_FLOAT;
+}
+
+BlockPost::~BlockPost()
+{
+   if (data != NULL)
+      munmap(data, length);
+}
+
+/* Name:  Open
+ * Parameters:  Filename: a bpost file made by Build
+ * Purpose:     map the file; nothing is read until a cursor needs it.
+ *              With impacts, the weight of every impact is worked out
+ *              once here, so a cursor only looks them up.
+ * Returns:     false if it is missing or not a bpost file
+*/
+bool BlockPost::Open(const string Filename)
+{
+struct stat Info;
+void *Map;
+int Fd;
+
+   if ((Fd = open(Filename.c_str(), O_RDONLY)) < 0)
+      return false;
+   if (fstat(Fd, &Info) != 0 || Info.st_size < BPOST_HEADER_LENGTH ||
+       (Map = mmap(NULL, Info.st_size, PROT_READ, MAP_SHARED, Fd, 0)) == MAP_FAILED)
+   {
+      close(Fd);
+      return false;
+   }
+   close(Fd);
+
+   data = (char *) Map;
+   length = Info.st_size;
+   numlists = GetRaw<unsigned int>(data + BPOST_MAGIC_LENGTH);
+   unsigned long Offset = GetRaw<unsigned long>(data + BPOST_MAGIC_LENGTH + 8);
+   if (memcmp(data, BPOST_MAGIC, BPOST_MAGIC_LENGTH) != 0 ||
+       GetRaw<unsigned int>(data + BPOST_MAGIC_LENGTH + 4) != BPOST_BLOCK_POSTINGS ||
+       Offset + (unsigned long) numlists * BPOST_DIRECTORY_LENGTH != length ||
+       (GetRaw<int>(data + BPOST_MAGIC_LENGTH + 16) != IMPACT_FLOAT &&
+        GetRaw<int>(data + BPOST_MAGIC_LENGTH + 16) != IMPACT_BITS_SMALL &&
+        GetRaw<int>(data + BPOST_MAGIC_LENGTH + 16) != IMPACT_BITS_LARGE))
+   {
+      munmap(data, length);
+      data = NULL;
+      return false;
+   }
+   directory = data + Offset;
+
+   impactbits = GetRaw<int>(data + BPOST_MAGIC_LENGTH + 16);
+   impacts.clear();
+   if (impactbits != IMPACT_FLOAT)
+   {
+      ImpactQuantizer Quantizer(impactbits, GetRaw<int>(data + BPOST_MAGIC_LENGTH + 20) != 0,
+                                GetRaw<float>(data + BPOST_MAGIC_LENGTH + 24),
+                                GetRaw<float>(data + BPOST_MAGIC_LENGTH + 28));
+      for (unsigned int i = 0; i <= Quantizer.GetMaxImpact(); i++)
+         impacts.push_back(Quantizer.Dequantize(i));
+   }
+   return true;
+}
+
+bool BlockPost::IsOpen() const
+{
+   return data != NULL;
+}
+
+int BlockPost::GetImpactBits() const
+{
+   return impactbits;
+}
+
+/* Name:  GetCursor
+ * Parameters:  Entry: a term's dictionary entry
+ *              Cursor: receives a cursor on the term's first posting
+ * Purpose:     find the term's list (by its first line in post) and
+ *              decode its first block
+ * Returns:     false if bpost has no such list
+*/
+bool BlockPost::GetCursor(const TrieEntry &Entry, PostingCursor &Cursor) const
+{
+unsigned int Low = 0;
+unsigned int High = numlists;
+
+   while (Low < High)
+   {
+      unsigned int Middle = (Low + High) / 2;
+      if (GetRaw<unsigned long>(directory + Middle * BPOST_DIRECTORY_LENGTH) < Entry.start)
+         Low = Middle + 1;
+      else
+         High = Middle;
+   }
+   const char *List = directory + Low * BPOST_DIRECTORY_LENGTH;
+   if (Low == numlists || GetRaw<unsigned long>(List) != Entry.start ||
+       GetRaw<int>(List + 8) != Entry.numdocs || Entry.numdocs <= 0 ||
+       GetRaw<unsigned int>(List + 24) >= CODEC_COUNT)
+   {
+      Cursor = PostingCursor();
+      return false;
+   }
+
+   Cursor.numdocs = Entry.numdocs;
+   Cursor.numblocks = GetRaw<unsigned int>(List + 12);
+   Cursor.codec = (CodecType) GetRaw<unsigned int>(List + 24);
+   Cursor.impactbytes = impactbits / 8;
+   Cursor.impacts = impacts.data();
+   Cursor.skips = data + GetRaw<unsigned long>(List + 16);
+   Cursor.blocks = Cursor.skips + Cursor.numblocks * BPOST_SKIP_LENGTH;
+   Cursor.decoded = 0;
+   Cursor.Decode(0);
+   return true;
+}
+
+/* Name:  Build
+ * Parameters:  IndexDirname: an index directory with post and trie
+ *              ImpactBits: IMPACT_FLOAT, or the bits of each impact
+ *              LogImpacts: space the impacts' steps logarithmically
+ * Purpose:     write bpost from post, cutting it into lists where the
+ *              trie's entries say each term's postings start, and
+ *              packing each list with the codec its length calls for.
+ *              For impacts, a first read of post finds the lowest and
+ *              highest weight, which set the scale for every list.
+ * Returns:     false if the files could not be read or written
+*/
+bool BlockPost::Build(const string IndexDirname, const int ImpactBits, const bool LogImpacts)
+{
+string Filename = IndexDirname + "/bpost";
+FILE *Post = fopen((IndexDirname + "/post").c_str(), "r");
+TermTrie Trie;
+vector<TrieMatch> Entries;
+vector<char> List;
+unsigned long Offset = BPOST_HEADER_LENGTH;
+unsigned long Line = 0;
+unsigned int NumLists = 0;
+unsigned int BlockPostings = BPOST_BLOCK_POSTINGS;
+int ImpactBytes = ImpactBits / 8;
+int Logarithmic = LogImpacts;
+float Low = 0.0;
+float High = 0.0;
+char Text[64];
+bool Written = true;
+int Fd;
+
+   if (Post == NULL || !Trie.Read(IndexDirname + "/trie"))
+   {
+      if (Post != NULL)
+         fclose(Post);
+      return false;
+   }
+   if ((Fd = open(Filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644)) < 0)
+   {
+      perror(Filename.c_str());
+      fclose(Post);
+      return false;
+   }
+
+   for (bool First = true; ImpactBits != IMPACT_FLOAT && fgets(Text, sizeof(Text), Post) != NULL; )
+   {
+      char *End;
+      strtol(Text, &End, 10);
+      float Weight = strtof(End, NULL);
+      if (Weight > 0.0 && (First || Weight < Low))
+         Low = Weight;
+      if (Weight > 0.0 && (First || Weight > High))
+         High = Weight;
+      First = First && Weight <= 0.0;
+   }
+   rewind(Post);
+   ImpactQuantizer Quantizer(ImpactBits == IMPACT_FLOAT ? IMPACT_BITS_SMALL : ImpactBits, LogImpacts, Low, High);
+
+   // every term with postings, in post order
+   Trie.Numbered(Entries);
+
+   {
+   OutputWriter Out(Fd);
+   OutputWriter Directory;
+
+   memset(Text, 0, sizeof(Text));
+   Out.Put(string_view(BPOST_MAGIC, BPOST_MAGIC_LENGTH));
+   Out.Put(string_view(Text, BPOST_HEADER_LENGTH - BPOST_MAGIC_LENGTH));  // filled in at the end
+
+   for (unsigned long e = 0; Written && e < Entries.size(); e++)
+   {
+      const TrieEntry &Entry = Entries[e].entry;
+      unsigned int NumBlocks = (Entry.numdocs + BPOST_BLOCK_POSTINGS - 1) / BPOST_BLOCK_POSTINGS;
+      vector<int> DocIds(max(Entry.numdocs, 0));
+      vector<float> Weights(max(Entry.numdocs, 0));
+      unsigned int Codec;
+      unsigned int Unused = 0;
+      int Previous = 0;
+
+      if (Entry.numdocs <= 0)
+         continue;
+      while (Line < Entry.start && fgets(Text, sizeof(Text), Post) != NULL)
+         Line++;
+      for (int k = 0; Written && k < Entry.numdocs; k++, Line++)
+      {
+         char *End;
+         if (fgets(Text, sizeof(Text), Post) == NULL)
+         {
+            cerr << IndexDirname << "/post is shorter than the dictionary says." << endl;
+            Written = false;
+            break;
+         }
+         DocIds[k] = strtol(Text, &End, 10);
+         Weights[k] = strtof(End, NULL);
+      }
+
+      // the skip table, then the blocks
+      Codec = PostingCodec::Choose(Entry.numdocs, DocIds[Entry.numdocs - 1]);
+      List.assign(NumBlocks * BPOST_SKIP_LENGTH, 0);
+      for (unsigned int b = 0; b < NumBlocks; b++)
+      {
+         int First = b * BPOST_BLOCK_POSTINGS;
+         int Count = min(Entry.numdocs - First, BPOST_BLOCK_POSTINGS);
+         unsigned int BlockOffset = List.size() - NumBlocks * BPOST_SKIP_LENGTH;
+
+         memcpy(List.data() + b * BPOST_SKIP_LENGTH, &DocIds[First + Count - 1], 4);
+         memcpy(List.data() + b * BPOST_SKIP_LENGTH + 4, &BlockOffset, 4);
+         if (ImpactBits == IMPACT_FLOAT)
+            List.insert(List.end(), (const char *) &Weights[First], (const char *) &Weights[First + Count]);
+         else
+            for (int k = First; k < First + Count; k++)
+            {
+               unsigned short Impact = Quantizer.Quantize(Weights[k]);
+               List.insert(List.end(), (const char *) &Impact, (const char *) &Impact + ImpactBytes);
+            }
+         PostingCodec::Encode((CodecType) Codec, &DocIds[First], Count, Previous, List);
+         Previous = DocIds[First + Count - 1];
+      }
+
+      Directory.Put(string_view((const char *) &Entry.start, 8));
+      Directory.Put(string_view((const char *) &Entry.numdocs, 4));
+      Directory.Put(string_view((const char *) &NumBlocks, 4));
+      Directory.Put(string_view((const char *) &Offset, 8));
+      Directory.Put(string_view((const char *) &Codec, 4));
+      Directory.Put(string_view((const char *) &Unused, 4));
+      Out.Put(string_view(List.data(), List.size()));
+      Offset += List.size();
+      NumLists++;
+   }
+
+   Written = Written && Out.Flush() && Directory.WriteAt(Fd, Offset);
+   }   // the writer is done with Fd here
+   fclose(Post);
+
+   Written = Written && pwrite(Fd, &NumLists, 4, BPOST_MAGIC_LENGTH) == 4 &&
+             pwrite(Fd, &BlockPostings, 4, BPOST_MAGIC_LENGTH + 4) == 4 &&
+             pwrite(Fd, &Offset, 8, BPOST_MAGIC_LENGTH + 8) == 8 &&
+             pwrite(Fd, &ImpactBits, 4, BPOST_MAGIC_LENGTH + 16) == 4 &&
+             pwrite(Fd, &Logarithmic, 4, BPOST_MAGIC_LENGTH + 20) == 4 &&
+             pwrite(Fd, &Low, 4, BPOST_MAGIC_LENGTH + 24) == 4 &&
+             pwrite(Fd, &High, 4, BPOST_MAGIC_LENGTH + 28) == 4;
+   if (close(Fd) != 0 || !Written)
+   {
+      perror(Filename.c_str());
+      return false;
+   }
+   return true;
+}
@@ -0,0 +1,95 @@
+/* Filename:  blockpost.h
+ * Date:      10/19/26
+ * Purpose:   The header file for the blocked postings file, bpost, and
+ *            the cursors that read it.  bpost holds the same postings
+ *            as post, list by list in post order, in blocks of
+ *            BPOST_BLOCK_POSTINGS: a block is its weights (4-byte
+ *            floats, or 1- or 2-byte impacts on one global scale; see
+ *            impactquantizer.h) then its DocIds, packed by the list's
+ *            codec (see postingcodec.h) from the last DocId of the
+ *            block before.
+ *            Each list starts with a skip table giving every block's
+ *            last DocId and offset, so a cursor can jump to the block
+ *            holding a DocId and decode nothing else; the file is
+ *            memory-mapped, so blocks never reached are never read
+ *            from disk.
+ *
+ *            "BPOST003", numlists (4), block postings (4),
+ *            directory offset (8), impact bits (4), log impacts (4),
+ *            lowest and highest weight (4-byte floats)
+ *            list:       (lastdocid (4), block offset (4))*  block*
+ *            directory:  (start (8), numdocs (4), numblocks (4),
+ *                         list offset (8), codec (4), unused (4))*
+ *                        in start order
+*/
+
+#ifndef BLOCKPOST_H
+#define BLOCKPOST_H
+
+#include <limits.h>
+#include <string>
+#include <vector>
+
+#include "impactquantizer.h"
+#include "postingcodec.h"
+#include "termtrie.h"
+
+#define BPOST_MAGIC "BPOST003"
+#define BPOST_MAGIC_LENGTH 8
+#define BPOST_HEADER_LENGTH 40
+#define BPOST_BLOCK_POSTINGS CODEC_BLOCK_POSTINGS
+#define BPOST_SKIP_LENGTH 8
+#define BPOST_DIRECTORY_LENGTH 32
+#define CURSOR_END INT_MAX         // GetDocId once a cursor is used up
+
+using namespace std;
+
+class PostingCursor {
+public:
+   PostingCursor();
+   int GetDocId () const;           // the current posting, or CURSOR_END
+   float Score () const;            // its weight, as in post
+   bool Next ();                    // false once past the last posting
+   bool AdvanceTo (const int DocId);   // to the first posting >= DocId
+   int GetNumDocs () const;
+   unsigned int GetBlocksDecoded () const;
+private:
+   friend class BlockPost;
+   void Decode (const unsigned int Block);
+   void Finish ();
+   const char *skips;               // the list's skip table
+   const char *blocks;              // and its first block
+   unsigned int numblocks;
+   CodecType codec;                 // how the DocIds are packed
+   int impactbytes;                 // each weight's size: 1, 2 or 4 (float)
+   const float *impacts;            // the weight of each impact
+   int numdocs;
+   unsigned int block;              // the block decoded
+   int count;                       // postings in it
+   int position;                    // the current one
+   int docids[BPOST_BLOCK_POSTINGS];
+   float weights[BPOST_BLOCK_POSTINGS];
+   unsigned int decoded;            // blocks decoded so far
+};
+
+class BlockPost {
+public:
+   BlockPost();
+   ~BlockPost();
+   bool Open (const string Filename);
+   bool IsOpen () const;
+   bool GetCursor (const TrieEntry &Entry, PostingCursor &Cursor) const;
+   int GetImpactBits () const;      // IMPACT_FLOAT if weights are floats
+   static bool Build (const string IndexDirname, const int ImpactBits,
+                      const bool LogImpacts);   // bpost from post and trie
+private:
+   BlockPost (const BlockPost& bp);
+   char *data;                      // the whole file, mapped
+   unsigned long length;
+   const char *directory;
+   unsigned int numlists;
+   int impactbits;
+   vector<float> impacts;           // the weight of each impact
+};
+
+#endif
@@ -0,0 +1,143 @@
+/* Filename:  checkpointer.cpp
+ * Date:      10/19/2026
+ * Purpose:   The implementation file for indexing checkpoints.
+*/
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+
+#include "checkpointer.h"
+
+using namespace std;
+
+/*-------------------------- Constructors/Destructors ----------------------*/
+
+/* Name:  Checkpointer
+ * Parameters:  GlobalHT: the table to save
+ *              Filename: the checkpoint file
+ *              Interval: the documents between checkpoints
+ * Purpose:     set up checkpoints; nothing is written yet
+ * Returns:     nothing
+*/
+Checkpointer::Checkpointer(const GlobalHashTable &GlobalHT, const string Filename, const int Interval)
+   : globalht(GlobalHT), filename(Filename), tempfilename(Filename + ".tmp")
+{
+   interval = Interval;
+   child = 0;
+   written = 0;
+   skipped = 0;
+   longeststall = 0.0;
+}
+
+/* Name:  ~Checkpointer
+ * Parameters:  none
+ * Purpose:     never leave a child behind
+ * Returns:     nothing
+*/
+Checkpointer::~Checkpointer()
+{
+   Reap(true);
+}
+
+/*-------------------------- Accessors ------------------------------------*/
+
+/* Name:  Posted
+ * Parameters:  DocId: the document just posted, in DocId order
+ * Purpose:     on every interval'th document, fork a child to write a
+ *              checkpoint of the table as it is now.  Everything the
+ *              child needs is opened and allocated here first.
+ * Returns:     nothing
+*/
+void Checkpointer::Posted(const int DocId)
+{
+chrono::steady_clock::time_point Start;
+double Stall;
+pid_t Pid;
+int Fd;
+
+   if (interval <= 0 || DocId % interval != 0)
+      return;
+   if (!Reap(false))
+   {
+      skipped++;
+      return;
+   }
+
+   Start = chrono::steady_clock::now();
+   if ((Fd = open(tempfilename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644)) < 0)
+   {
+      perror(tempfilename.c_str());
+      return;
+   }
+   {
+   OutputWriter Out(Fd);
+   cout.flush();   // or the child's copy of the buffer is written twice
+   if ((Pid = fork()) == 0)
+   {
+      // the child: write beside the checkpoint, then replace it whole
+      if (!globalht.Save(Out, DocId) || fsync(Fd) != 0 || close(Fd) != 0 ||
+          rename(tempfilename.c_str(), filename.c_str()) != 0)
+         _exit(1);
+      _exit(0);
+   }
+   }   // the parent's writer is empty; nothing is written here
+   close(Fd);
+   if (Pid < 0)
+   {
+      perror("fork");
+      return;
+   }
+
+   child = Pid;
+   Stall = chrono::duration<double>(chrono::steady_clock::now() - Start).count();
+   if (Stall > longeststall)
+      longeststall = Stall;
+}
+
+/* Name:  Finish
+ * Parameters:  none
+ * Purpose:     wait for a checkpoint still being written, then report
+ * Returns:     nothing
+*/
+void Checkpointer::Finish()
+{
+   Reap(true);
+   cout << "Checkpoints: " << written << " written, " << skipped
+        << " skipped, longest stall " << fixed << setprecision(1)
+        << longeststall * 1000.0 << " ms" << endl;
+}
+
+/*-------------------------- Private Functions ----------------------------*/
+
+/* Name:  Reap
+ * Parameters:  Wait: whether to wait for a running child
+ * Purpose:     collect the child writing the last checkpoint, if done
+ * Returns:     true if no child is running now
+*/
+bool Checkpointer::Reap(const bool Wait)
+{
+int Status;
+pid_t Done;
+
+   if (child == 0)
+      return true;
+   do
+   {
+      Done = waitpid(child, &Status, Wait ? 0 : WNOHANG);
+   } while (Done < 0 && errno == EINTR);
+   if (Done == 0)
+      return false;
+
+   if (Done == child && WIFEXITED(Status) && WEXITSTATUS(Status) == 0)
+      written++;
+   else
+      cerr << "Writing the checkpoint " << filename << " failed." << endl;
+   child = 0;
+   return true;
+}
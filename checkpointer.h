@@ -0,0 +1,50 @@
+/* Filename:  checkpointer.h
+ * Date:      10/19/26
+ * Purpose:   The header file for periodic checkpoints of a long
+ *            indexing run.  Every interval documents the inverter
+ *            calls Posted; the process forks and the child, holding a
+ *            copy-on-write snapshot of the global table, writes it with
+ *            GlobalHashTable::Save to a temporary file and renames it
+ *            over the checkpoint, so the last complete checkpoint is
+ *            never lost.  Indexing only waits for fork itself.  If the
+ *            previous child is still writing, that checkpoint is
+ *            skipped rather than waited for.
+ *
+ *            Tokenizer threads keep running across the fork, and only
+ *            the forking thread exists in the child, so a lock one of
+ *            them held (malloc's among them) stays held there.  The
+ *            parent therefore opens the file and makes the writer and
+ *            its buffer; the child only fills the buffer and calls
+ *            write, fsync, close, rename and _exit.
+*/
+
+#ifndef CHECKPOINTER_H
+#define CHECKPOINTER_H
+
+#include <sys/types.h>
+#include <string>
+
+#include "globalhashtable.h"
+
+using namespace std;
+
+class Checkpointer {
+public:
+   Checkpointer(const GlobalHashTable &GlobalHT, const string Filename, const int Interval);
+   ~Checkpointer();
+   void Posted (const int DocId);   // document DocId and all before it are in
+   void Finish ();                  // wait for the last checkpoint
+private:
+   Checkpointer (const Checkpointer& cp);
+   bool Reap (const bool Wait);     // true once no child is running
+   const GlobalHashTable &globalht;
+   string filename;
+   string tempfilename;             // written, then renamed over filename
+   int interval;
+   pid_t child;                     // the child writing, or 0
+   int written;                     // checkpoints completed
+   int skipped;                     // not started, the last still running
+   double longeststall;             // the slowest fork, in seconds
+};
+
+#endif
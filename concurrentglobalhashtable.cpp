@@ -0,0 +1,315 @@
+/* Filename:  concurrentglobalhashtable.cpp
+ * Date:      10/19/2026
+ * Purpose:   The implementation file for the concurrent global hash table.
+*/
+
+#include <assert.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <math.h>
+#include <string.h>
+#include <unistd.h>
+#include <algorithm>
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <thread>
+
+#include "concurrentglobalhashtable.h"
+#include "controlbytes.h"
+#include "outputwriter.h"
+#include "termtrie.h"
+
+#define DICT_TOKEN_LENGTH 115
+#define DICT_NUMBER_LENGTH 5
+
+using namespace std;
+/*-------------------------- Constructors/Destructors ----------------------*/
+
+/* Name:  ConcurrentGlobalHashTable
+ * Parameters:  NumTokens: the number of tokens expected
+ * Purpose:     allocate a hashtable for an expected number of tokens,
+ *              every slot empty
+ * Returns:     nothing
+*/
+ConcurrentGlobalHashTable::ConcurrentGlobalHashTable(const unsigned long NumTokens)
+{
+   size = NumTokens * 3;   // we want the hash table to be 2/3 empty
+   if((hashtable = new TermSlot[size]) == NULL)
+      cout << "Out of memory at ConcurrentGlobalHashTable::ConcurrentGlobalHashTable(unsigned long)" << endl;
+   assert( hashtable != 0 );
+   if((stripes = new Stripe[CONCURRENT_LOCK_STRIPES]) == NULL)
+      cout << "Out of memory at ConcurrentGlobalHashTable::ConcurrentGlobalHashTable(unsigned long)" << endl;
+   assert( stripes != 0 );
+
+   for (unsigned long i=0; i < size; i++)
+   {
+      hashtable[i].state.store(SLOT_EMPTY, memory_order_relaxed);
+      hashtable[i].token = NULL;
+      hashtable[i].length = 0;
+      hashtable[i].numdocs = 0;
+      hashtable[i].firstdoc = INT_MAX;
+      hashtable[i].firstrank = 0;
+   }
+   used = 0;
+   collisions = 0;
+}
+
+/* Name:  ~ConcurrentGlobalHashTable
+ * Parameters:  none
+ * Purpose:     deallocate a hash table
+ * Returns:     nothing
+*/
+ConcurrentGlobalHashTable::~ConcurrentGlobalHashTable()
+{
+   for (unsigned long i=0; i < size; i++)
+      delete [] hashtable[i].token;
+   delete [] hashtable;
+   delete [] stripes;
+}
+
+/*-------------------------- Accessors ------------------------------------*/
+
+/* Name:  PrintDictPost
+ * Parameters:  DictFilename, PostFilename: the files to write
+ *              NumDocs: the number of documents indexed
+ * Purpose:     print dict and post in the format GlobalHashTable uses.
+ *              Threads claim slots in whatever order they get there, so
+ *              the words are first laid out again, by linear probing in
+ *              the order a serial run would have inserted them, and
+ *              each word's postings are sorted by DocId; the files are
+ *              the same as a single-threaded run's.  Call it only once
+ *              every inserting thread has finished.
+ * Returns:     nothing
+*/
+void ConcurrentGlobalHashTable::PrintDictPost(const string DictFilename, const string PostFilename, const int NumDocs)
+{
+   unsigned long Start = 0;
+   int DictFd;
+   int PostFd;
+   vector<unsigned long> Layout;   // output slot -> our slot
+
+   LayOut(Layout);
+   DictFd = open(DictFilename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+   PostFd = open(PostFilename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+   if (DictFd < 0 || PostFd < 0)
+   {
+      perror(DictFd < 0 ? DictFilename.c_str() : PostFilename.c_str());
+      if (DictFd >= 0)
+         close(DictFd);
+      if (PostFd >= 0)
+         close(PostFd);
+      return;
+   }
+
+   {
+   OutputWriter Dict(DictFd);
+   OutputWriter Post(PostFd);
+
+   for ( unsigned long j=0; j < size; j++ )
+   {
+      if (Layout[j] != size)
+      {
+          TermSlot &Slot = hashtable[Layout[j]];
+          Dict.PutRight(string_view(Slot.token, Slot.length), DICT_TOKEN_LENGTH);
+          Dict.Put(' ');
+          Dict.PutInt(Slot.numdocs, DICT_NUMBER_LENGTH);
+          Dict.Put(' ');
+          Dict.PutInt(Start, DICT_NUMBER_LENGTH);
+          Dict.Put('\n');
+
+          sort(Slot.postings.begin(), Slot.postings.end(),
+               [](const Posting &a, const Posting &b) { return a.GetDocId() < b.GetDocId(); });
+          float IDF = 1 + log((NumDocs * 1.0) / (Slot.numdocs * 1.0));
+          for (unsigned long k=0; k < Slot.postings.size(); k++)
+             Slot.postings[k].Write(Post, IDF * 1000.0);
+          Start = Start + Slot.numdocs;
+      }
+      else
+      {
+         Dict.PutRight("null", DICT_TOKEN_LENGTH);
+         Dict.Put(' ');
+         Dict.PutRight("-1", DICT_NUMBER_LENGTH);
+         Dict.Put(' ');
+         Dict.PutRight("-1", DICT_NUMBER_LENGTH);
+         Dict.Put('\n');
+      }
+   }
+   }   // the writers flush here
+
+   close(DictFd);
+   close(PostFd);
+   cout << "Collisions: " << collisions << ", Used: " << used
+        <<  ", Lookups: " << 0 << endl;
+}
+
+/* Name:  PrintTrie
+ * Parameters:  TrieFilename: the file to write
+ * Purpose:     save a term trie (see termtrie.h) that finds each word's
+ *              entry, with its first line in post as PrintDictPost
+ *              numbers them, so the index has the same trie (and so
+ *              bpost) as a serial run's
+ * Returns:     nothing
+*/
+void ConcurrentGlobalHashTable::PrintTrie(const string TrieFilename) const
+{
+   unsigned long Start = 0;
+   vector<unsigned long> Layout;
+   vector<unsigned long> Words;
+   vector<unsigned long> Starts(size, 0);
+   vector<string_view> Terms;
+   vector<TrieEntry> Entries;
+   TermTrie Trie;
+
+   LayOut(Layout);
+   for (unsigned long j=0; j < size; j++)
+      if (Layout[j] != size)
+      {
+         Words.push_back(Layout[j]);
+         Starts[Layout[j]] = Start;
+         Start = Start + hashtable[Layout[j]].numdocs;
+      }
+
+   // the trie is built from the words in sorted order
+   sort(Words.begin(), Words.end(), [&](unsigned long a, unsigned long b)
+   {
+      return string_view(hashtable[a].token, hashtable[a].length) <
+             string_view(hashtable[b].token, hashtable[b].length);
+   });
+   for (unsigned long k=0; k < Words.size(); k++)
+   {
+      Terms.push_back(string_view(hashtable[Words[k]].token, hashtable[Words[k]].length));
+      Entries.push_back(TrieEntry{hashtable[Words[k]].numdocs, Starts[Words[k]]});
+   }
+   Trie.Build(Terms, Entries);
+   if (!Trie.Write(TrieFilename))
+      perror(TrieFilename.c_str());
+}
+
+/* Name: Insert
+ * Parameter:
+ * 		Token : The word to be stored
+ * 		DocId: The document whose data is being inserted
+ * 		RTF: the word's relative frequency in that document
+ * 		Rank: the word's place in the document's TransferData order,
+ * 		      which with DocId says where a serial run puts it
+ * Purpose: 	insert or add a word with its frequency count.  Any number
+ * 		of threads may insert at once.
+ * Return:	nothing
+*/
+void ConcurrentGlobalHashTable::Insert (const string_view Token, const int DocId, const float RTF,
+                                        const unsigned int Rank)
+{
+unsigned long Index;
+
+ if (used.load(memory_order_relaxed) >= size ||
+     (Index = Find(Token, ControlBytes::Hash(Token))) == size)
+    cerr << "The global hashtable is full; cannot insert.\n";
+ else
+ {
+    TermSlot &Slot = hashtable[Index];
+    lock_guard<mutex> Guard(stripes[Index & (CONCURRENT_LOCK_STRIPES - 1)].lock);
+
+    (Slot.numdocs)++;
+    if (DocId < Slot.firstdoc || (DocId == Slot.firstdoc && Rank < Slot.firstrank))
+    {
+       Slot.firstdoc = DocId;
+       Slot.firstrank = Rank;
+    }
+    Slot.postings.push_back(Posting(DocId, RTF));
+ }
+}
+
+/* Name: GetUsage
+ * Parameters:	None
+ * Purpose:	return the table statistics (there is no lookup count)
+ * Return:	nothing
+*/
+void ConcurrentGlobalHashTable::GetUsage(int &Used, int &Collisions, int &Lookups) const
+{
+   Used = used;
+   Collisions = collisions;
+   Lookups = 0;
+}
+
+/*-------------------------- Private Functions ----------------------------*/
+
+/* Name:  Find
+ * Parameters:  Token: the word to be located
+ *              Hash: its hash
+ * Purpose:     return the slot holding the word, claiming the first
+ *              empty slot on its probe path if it is new.  A slot that
+ *              another thread has claimed but not yet filled in is
+ *              waited on, since it may hold this very word.
+ * Returns:     the word's slot, or size if the table is full
+*/
+unsigned long ConcurrentGlobalHashTable::Find (const string_view Token, const unsigned long Hash)
+{
+unsigned long Index = Hash % size;
+unsigned char State;
+
+   for (unsigned long Probes = 0; Probes < size; Probes++)
+   {
+      TermSlot &Slot = hashtable[Index];
+      State = Slot.state.load(memory_order_acquire);
+      if (State == SLOT_EMPTY &&
+          Slot.state.compare_exchange_strong(State, SLOT_CLAIMED, memory_order_acquire))
+      {
+         if((Slot.token = new char[Token.length()]) == NULL)
+            cout << "Out of memory at ConcurrentGlobalHashTable::Find()" << endl;
+         assert( Slot.token != 0 );
+         memcpy(Slot.token, Token.data(), Token.length());
+         Slot.length = Token.length();
+         Slot.hash = Hash;
+         Slot.state.store(SLOT_READY, memory_order_release);
+         used.fetch_add(1, memory_order_relaxed);
+         return Index;
+      }
+
+      while (State == SLOT_CLAIMED)
+      {
+         this_thread::yield();
+         State = Slot.state.load(memory_order_acquire);
+      }
+
+      if (Slot.hash == Hash && Slot.length == Token.length() &&
+          memcmp(Slot.token, Token.data(), Token.length()) == 0)
+         return Index;
+
+      collisions.fetch_add(1, memory_order_relaxed);
+      Index = (Index + 1) % size;
+   }
+   return size;
+}
+
+/* Name:  LayOut
+ * Parameters:  Layout: receives, for each slot of a serial run's table,
+ *                      our slot for the word there, or size
+ * Purpose:     place the words by linear probing in the order a serial
+ *              run would have inserted them: by the first document
+ *              that had each, then by its place in that document
+ * Returns:     nothing
+*/
+void ConcurrentGlobalHashTable::LayOut(vector<unsigned long> &Layout) const
+{
+   vector<unsigned long> Words;
+
+   Layout.assign(size, size);
+   for (unsigned long i=0; i < size; i++)
+      if (hashtable[i].state.load(memory_order_acquire) == SLOT_READY)
+         Words.push_back(i);
+
+   sort(Words.begin(), Words.end(), [&](unsigned long a, unsigned long b)
+   {
+      if (hashtable[a].firstdoc != hashtable[b].firstdoc)
+         return hashtable[a].firstdoc < hashtable[b].firstdoc;
+      return hashtable[a].firstrank < hashtable[b].firstrank;
+   });
+   for (unsigned long k=0; k < Words.size(); k++)
+   {
+      unsigned long j = hashtable[Words[k]].hash % size;
+      while (Layout[j] != size)
+         j = (j + 1) % size;
+      Layout[j] = Words[k];
+   }
+}
@@ -0,0 +1,64 @@
+/* Filename:  concurrentglobalhashtable.h
+ * Date:      10/19/26
+ * Purpose:   The header file for a global hash table of words, numdocs
+ *            and postings that many threads can insert into at once.
+ *            A new word claims its slot with a compare-and-swap, so
+ *            finding or adding a word takes no lock; appending to a
+ *            word's postings takes one of a set of striped locks.
+ *            Postings arrive in any order and are sorted by DocId, and
+ *            the words laid out as a serial run would place them, when
+ *            the dictionary and the trie are printed.
+*/
+
+#ifndef CONCURRENTGLOBALHASHTABLE_H
+#define CONCURRENTGLOBALHASHTABLE_H
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "posting.h"
+
+#define CONCURRENT_LOCK_STRIPES 256  // a power of 2
+
+using namespace std;
+
+class ConcurrentGlobalHashTable {
+public:
+   ConcurrentGlobalHashTable(const unsigned long NumTokens); // constructor of hashtable
+   ~ConcurrentGlobalHashTable();                 // destructor
+   void PrintDictPost (const string DictFilename, const string PostFilename, const int NumDocs);
+   void PrintTrie (const string TrieFilename) const;
+   void Insert (const string_view Token, const int DocId, const float RTF,
+                const unsigned int Rank);       // safe to call from any thread
+   void GetUsage (int &Used, int &Collisions, int &Lookups) const;
+private:
+   ConcurrentGlobalHashTable (const ConcurrentGlobalHashTable& ht);  // never copied
+   enum { SLOT_EMPTY, SLOT_CLAIMED, SLOT_READY };
+   struct TermSlot // the datatype stored in the hashtable
+   {
+      atomic<unsigned char> state;  // empty -> claimed -> ready, never back
+      unsigned long hash;
+      char *token;                  // set before the slot is ready
+      unsigned int length;
+      int numdocs;                  // the rest are guarded by the slot's stripe
+      int firstdoc;                 // where a serial run would first
+      unsigned int firstrank;       //    have inserted the word
+      vector<Posting> postings;
+   };
+   struct alignas(64) Stripe        // a lock on its own cache line
+   {
+      mutex lock;
+   };
+   unsigned long Find (const string_view Token, const unsigned long Hash);
+   void LayOut (vector<unsigned long> &Layout) const;
+   TermSlot *hashtable;             // the hashtable array itself
+   Stripe *stripes;                 // slot i is guarded by stripes[i % STRIPES]
+   unsigned long size;              // the hashtable size
+   atomic<unsigned long> used;
+   atomic<unsigned long> collisions;
+};
+
+#endif
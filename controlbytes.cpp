@@ -0,0 +1,168 @@
+/* Filename:  controlbytes.cpp
+ * Date:      10/19/2026
+ * Purpose:   The implementation file for the hashtable control bytes.
+*/
+
+#include <assert.h>
+#include <string.h>
+#include <iostream>
+
+#include "controlbytes.h"
+
+using namespace std;
+
+/*-------------------------- Constructors/Destructors ----------------------*/
+
+/* Name:  ControlBytes
+ * Parameters:  cb: the control bytes to copy
+ * Purpose:     copy the control bytes of a hashtable
+ * Returns:     nothing
+*/
+ControlBytes::ControlBytes( const ControlBytes &cb )
+{
+   size = cb.size;
+   if((ctrl = new unsigned char[size + CTRL_GROUP_WIDTH - 1]) == NULL)
+       cout << "Out of memory at ControlBytes::ControlBytes(const ControlBytes)" << endl;
+   assert( ctrl != 0 );
+   memcpy(ctrl, cb.ctrl, size + CTRL_GROUP_WIDTH - 1);
+}
+
+/* Name:  ControlBytes
+ * Parameters:  NumSlots: the number of slots in the hashtable
+ * Purpose:     allocate the control bytes, all slots empty.
+ *              The array carries 15 extra bytes mirroring the start
+ *              of the table so a group load never needs to wrap.
+ * Returns:     nothing
+*/
+ControlBytes::ControlBytes(const unsigned long NumSlots)
+{
+   size = NumSlots;
+   if((ctrl = new unsigned char[size + CTRL_GROUP_WIDTH - 1]) == NULL)
+      cout << "Out of memory at ControlBytes::ControlBytes(unsigned long)" << endl;
+   assert( ctrl != 0 );
+   Reset();
+}
+
+/* Name:  ~ControlBytes
+ * Parameters:  none
+ * Purpose:     deallocate the control bytes
+ * Returns:     nothing
+*/
+ControlBytes::~ControlBytes()
+{
+   delete [] ctrl;
+}
+
+/*-------------------------- Accessors ------------------------------------*/
+
+// Mark every slot empty
+void ControlBytes::Reset()
+{
+   memset(ctrl, CTRL_EMPTY, size + CTRL_GROUP_WIDTH - 1);
+}
+
+/* Name:  Resize
+ * Parameters:  NumSlots: the new number of slots
+ * Purpose:     reallocate the control bytes for a table that is being
+ *              rehashed; every slot starts out empty
+ * Returns:     nothing
+*/
+void ControlBytes::Resize(const unsigned long NumSlots)
+{
+   delete [] ctrl;
+   size = NumSlots;
+   if((ctrl = new unsigned char[size + CTRL_GROUP_WIDTH - 1]) == NULL)
+      cout << "Out of memory at ControlBytes::Resize(unsigned long)" << endl;
+   assert( ctrl != 0 );
+   Reset();
+}
+
+/* Name:  IsEmpty
+ * Parameters:  Index: the slot to check
+ * Purpose:     check whether a slot holds a key
+ * Returns:     true if the slot is free
+*/
+bool ControlBytes::IsEmpty(const unsigned long Index) const
+{
+   return (ctrl[Index] == CTRL_EMPTY);
+}
+
+/* Name:  Set
+ * Parameters:  Index: the slot that now holds a key
+ *              Hash: the full hash of that key
+ * Purpose:     record the key's tag in the slot (and its mirror)
+ * Returns:     nothing
+*/
+void ControlBytes::Set(const unsigned long Index, const unsigned long Hash)
+{
+unsigned char KeyTag = Tag(Hash);
+
+   ctrl[Index] = KeyTag;
+   for (unsigned long i = Index + size; i < size + CTRL_GROUP_WIDTH - 1; i += size)
+      ctrl[i] = KeyTag;
+}
+
+/* Name:  Clear
+ * Parameters:  Index: a slot that holds a key
+ * Purpose:     mark the slot empty again.  There are no tombstones, so
+ *              this is only safe when every used slot is being cleared,
+ *              e.g. to reset a table in time proportional to its keys.
+ * Returns:     nothing
+*/
+void ControlBytes::Clear(const unsigned long Index)
+{
+   ctrl[Index] = CTRL_EMPTY;
+   for (unsigned long i = Index + size; i < size + CTRL_GROUP_WIDTH - 1; i += size)
+      ctrl[i] = CTRL_EMPTY;
+}
+
+/* Name:  Hash
+ * Parameters:  Key: the string to hash
+ * Purpose:     the hash the tables have always used (sum * 31 + char);
+ *              the dict layout depends on it, so it must not change
+ * Returns:     the full hash value
+*/
+unsigned long ControlBytes::Hash(const string_view Key)
+{
+unsigned long hash = 0;
+
+   for (unsigned long i=0; i < Key.length(); i++)
+      hash = ((hash<<5)-hash) + Key[i];
+
+   return hash;
+}
+
+/* Name:  Tag
+ * Parameters:  Hash: the full hash of a key
+ * Purpose:     pick the 7 bits stored in the control byte.  The low bits
+ *              already select the slot, so take the top of a
+ *              multiplicative mix instead.
+ * Returns:     a tag in 0..127
+*/
+unsigned char ControlBytes::Tag(const unsigned long Hash)
+{
+   return (unsigned char)((Hash * 0x9E3779B97F4A7C15UL) >> 57);
+}
+
+/*-------------------------- Private Functions ----------------------------*/
+
+/* Name:  Match
+ * Parameters:  Index: the first slot of the group
+ *              Byte: the control byte to look for
+ * Purpose:     compare 16 control bytes against Byte at once
+ * Returns:     a bitmask with bit i set if slot Index+i holds Byte
+*/
+unsigned int ControlBytes::Match(const unsigned long Index, const unsigned char Byte) const
+{
+#ifdef __SSE2__
+   __m128i Group = _mm_loadu_si128((const __m128i *) (ctrl + Index));
+   return _mm_movemask_epi8(_mm_cmpeq_epi8(Group, _mm_set1_epi8((char) Byte)));
+#else
+unsigned int Mask = 0;
+
+   for (int i = 0; i < CTRL_GROUP_WIDTH; i++)
+      if (ctrl[Index + i] == Byte)
+         Mask |= 1u << i;
+   return Mask;
+#endif
+}
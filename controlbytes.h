@@ -0,0 +1,97 @@
+/* Filename:  controlbytes.h
+ * Date:      10/19/26
+ * Purpose:   The header file for the control byte array that drives
+ *            probing in the hashtables.  Each slot has one byte holding
+ *            7 bits of the key's hash (or EMPTY), so a probe matches
+ *            16 slots at once with SSE2 and the caller only compares
+ *            full keys on a tag match.
+ *            The probe sequence is plain linear probing from hash % size,
+ *            so slots end up exactly where the old string-compare loop
+ *            put them.
+*/
+
+#ifndef CONTROLBYTES_H
+#define CONTROLBYTES_H
+
+#include <string_view>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#define CTRL_EMPTY 0x80
+#define CTRL_GROUP_WIDTH 16
+
+using namespace std;
+
+class ControlBytes {
+public:
+   ControlBytes (const ControlBytes& cb);      // constructor for a copy
+   ControlBytes(const unsigned long NumSlots); // one control byte per slot
+   ~ControlBytes();                            // destructor
+   void Reset ();  // Mark every slot empty
+   void Resize (const unsigned long NumSlots);  // Reallocate, all slots empty
+   bool IsEmpty (const unsigned long Index) const;
+   void Set (const unsigned long Index, const unsigned long Hash);
+   void Clear (const unsigned long Index);  // only when emptying every used slot
+   template <class KeyEquals>
+   unsigned long Find (const unsigned long Hash, KeyEquals Equals,
+                       unsigned long &Collisions) const;
+   static unsigned long Hash (const string_view Key);
+   static unsigned char Tag (const unsigned long Hash);
+private:
+   unsigned int Match (const unsigned long Index, const unsigned char Byte) const;
+   unsigned char *ctrl;             // size bytes plus a mirrored group tail
+   unsigned long size;              // the number of slots
+};
+
+/* Name:  Find
+ * Parameters:  Hash: the full hash of the key to be located
+ *              Equals: called with a slot index whose tag matches,
+ *                      returns true if that slot holds the key
+ *              Collisions: incremented by the number of slots passed over
+ * Purpose:     return the index of the key in the table, or
+ *              the index of the free slot in which to store the key
+ * Returns:     index of the key's actual or desired location
+*/
+template <class KeyEquals>
+unsigned long ControlBytes::Find (const unsigned long Hash, KeyEquals Equals,
+                                  unsigned long &Collisions) const
+{
+unsigned long Start = Hash % size;
+unsigned long Index = Start;
+unsigned char KeyTag = Tag(Hash);
+unsigned int Matches;
+unsigned int Empties;
+unsigned long Found;
+
+   // Scan a group of 16 slots at a time.  The key, if present, lies
+   // before the first empty slot, so only tag matches ahead of it count.
+   for (;;)
+   {
+      Matches = Match(Index, KeyTag);
+      Empties = Match(Index, CTRL_EMPTY);
+      if (Empties != 0)
+         Matches &= (Empties & -Empties) - 1;
+
+      while (Matches != 0)
+      {
+         Found = (Index + __builtin_ctz(Matches)) % size;
+         if (Equals(Found))
+         {
+            Collisions += (Found + size - Start) % size;
+            return Found;
+         }
+         Matches &= Matches - 1;
+      }
+
+      if (Empties != 0)
+      {
+         Found = (Index + __builtin_ctz(Empties)) % size;
+         Collisions += (Found + size - Start) % size;
+         return Found;
+      }
+      Index = (Index + CTRL_GROUP_WIDTH) % size;
+   }
+}
+
+#endif
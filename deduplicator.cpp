@@ -0,0 +1,140 @@
+/* Filename:  deduplicator.cpp
+ * Date:      10/19/2026
+ * Purpose:   The implementation file for near-duplicate detection.
+*/
+
+#include <stdio.h>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+
+#include "deduplicator.h"
+#include "posting.h"
+
+using namespace std;
+
+/*-------------------------- Constructors/Destructors ----------------------*/
+
+/* Name:  Deduplicator
+ * Parameters:  none
+ * Purpose:     start with no documents seen
+ * Returns:     nothing
+*/
+Deduplicator::Deduplicator()
+{
+   postings = 0;
+   skipped = 0;
+   numduplicates = 0;
+}
+
+/*-------------------------- Accessors ------------------------------------*/
+
+/* Name:  Check
+ * Parameters:  DocId: the document, in DocId order
+ *              Signature: its SimHash
+ *              NumPostings: the postings it would add
+ * Purpose:     decide whether the document copies one kept before it,
+ *              choosing the closest (then the earliest) if several do;
+ *              otherwise keep it and file it under its bands.  A DocId
+ *              seen before, as in a second pass, gets the same answer
+ *              again.
+ * Returns:     the DocId of the document it copies, or 0 to post it
+*/
+int Deduplicator::Check(const int DocId, const unsigned long Signature, const unsigned long NumPostings)
+{
+int Copies = 0;
+int Closest = DEDUP_MAX_DISTANCE + 1;
+
+   if (DocId <= (int) copies.size())
+      return copies[DocId - 1];
+
+   if (NumPostings >= DEDUP_MIN_WORDS)
+      for (int b = 0; b < DEDUP_BANDS; b++)
+      {
+         unsigned int Band = (Signature >> (b * DEDUP_BAND_BITS)) & ((1UL << DEDUP_BAND_BITS) - 1);
+         auto Found = bands[b].find(Band);
+         if (Found == bands[b].end())
+            continue;
+         for (unsigned long k = 0; k < Found->second.size(); k++)
+         {
+            const Kept &Earlier = Found->second[k];
+            int Distance = __builtin_popcountl(Earlier.signature ^ Signature);
+            if (Distance < Closest || (Distance == Closest && Earlier.docid < Copies))
+            {
+               Closest = Distance;
+               Copies = Earlier.docid;
+            }
+         }
+      }
+
+   copies.resize(DocId, 0);
+   postings += NumPostings;
+   if (Copies != 0)
+   {
+      copies[DocId - 1] = Copies;
+      skipped += NumPostings;
+      numduplicates++;
+   }
+   else if (NumPostings >= DEDUP_MIN_WORDS)
+      for (int b = 0; b < DEDUP_BANDS; b++)
+      {
+         unsigned int Band = (Signature >> (b * DEDUP_BAND_BITS)) & ((1UL << DEDUP_BAND_BITS) - 1);
+         bands[b][Band].push_back(Kept{Signature, DocId});
+      }
+   return Copies;
+}
+
+int Deduplicator::GetNumDuplicates() const
+{
+   return numduplicates;
+}
+
+/* Name:  RewriteMap
+ * Parameters:  MapFilename: the map written while reading the documents
+ * Purpose:     add a tab and the DocId copied to each duplicate's line,
+ *              so the map still has one line per DocId
+ * Returns:     false if the map could not be rewritten
+*/
+bool Deduplicator::RewriteMap(const string MapFilename) const
+{
+string TempFilename = MapFilename + ".tmp";
+ifstream In(MapFilename.c_str());
+ofstream Out(TempFilename.c_str());
+string Line;
+
+   if (!In.is_open() || !Out.is_open())
+   {
+      cerr << "Unable to rewrite " << MapFilename << endl;
+      return false;
+   }
+   for (unsigned long k = 0; getline(In, Line); k++)
+   {
+      Out << Line;
+      if (k < copies.size() && copies[k] != 0)
+         Out << '\t' << copies[k];
+      Out << '\n';
+   }
+   In.close();
+   Out.close();
+   if (!Out || rename(TempFilename.c_str(), MapFilename.c_str()) != 0)
+   {
+      perror(MapFilename.c_str());
+      return false;
+   }
+   return true;
+}
+
+/* Name:  PrintReport
+ * Parameters:  none
+ * Purpose:     report how many documents were near-duplicates and the
+ *              postings (and post bytes, at POST_LINE_LENGTH a line)
+ *              that were not written for them
+ * Returns:     nothing
+*/
+void Deduplicator::PrintReport() const
+{
+   cout << "Near-duplicates: " << numduplicates << " of " << copies.size()
+        << " documents, " << skipped << " of " << postings << " postings skipped ("
+        << fixed << setprecision(1) << (postings > 0 ? 100.0 * skipped / postings : 0.0)
+        << "%), " << skipped * POST_LINE_LENGTH << " bytes of post saved" << endl;
+}
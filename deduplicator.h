@@ -0,0 +1,50 @@
+/* Filename:  deduplicator.h
+ * Date:      10/19/26
+ * Purpose:   The header file for near-duplicate detection.  Each
+ *            document arrives with the 64-bit SimHash of its word
+ *            counts (HashTable::SimHash).  The signatures of the
+ *            documents kept so far are filed under each of their
+ *            DEDUP_BANDS 16-bit bands; two signatures fewer than
+ *            DEDUP_BANDS bits apart agree on some band, so looking up
+ *            a new document's bands finds every earlier document
+ *            within DEDUP_MAX_DISTANCE bits of it.  Such a document is
+ *            a near-duplicate: it is not posted, and the map records
+ *            the DocId of the document it copies.
+*/
+
+#ifndef DEDUPLICATOR_H
+#define DEDUPLICATOR_H
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#define DEDUP_BANDS 4
+#define DEDUP_BAND_BITS 16
+#define DEDUP_MAX_DISTANCE 3       // must be less than DEDUP_BANDS
+#define DEDUP_MIN_WORDS 8          // shorter documents are always kept
+
+using namespace std;
+
+class Deduplicator {
+public:
+   Deduplicator();
+   int Check (const int DocId, const unsigned long Signature, const unsigned long NumPostings);
+   int GetNumDuplicates () const;
+   bool RewriteMap (const string MapFilename) const;
+   void PrintReport () const;
+private:
+   Deduplicator (const Deduplicator& dd);
+   struct Kept  // a document in the band index
+   {
+      unsigned long signature;
+      int docid;
+   };
+   vector<int> copies;              // by DocId - 1: the DocId copied, or 0
+   unordered_map<unsigned int, vector<Kept>> bands[DEDUP_BANDS];
+   unsigned long postings;          // postings of every document checked
+   unsigned long skipped;           // and of the duplicates among them
+   int numduplicates;
+};
+
+#endif
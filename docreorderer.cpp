@@ -0,0 +1,346 @@
+/* Filename:  docreorderer.cpp
+ * Date:      10/19/2026
+ * Purpose:   The implementation file for DocId reassignment.
+*/
+
+#include <fcntl.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <iterator>
+
+#include "docreorderer.h"
+#include "outputwriter.h"
+#include "posting.h"
+#include "termtrie.h"
+
+using namespace std;
+
+/*-------------------------- Constructors/Destructors ----------------------*/
+
+/* Name:  DocReorderer
+ * Parameters:  IndexDirname: the output directory of invert
+ * Purpose:     set up a reordering; nothing is read until Load
+ * Returns:     nothing
+*/
+DocReorderer::DocReorderer(const string IndexDirname) : dirname(IndexDirname)
+{
+   for (int i = 0; i < 3; i++)
+      reportbits[i][0] = reportbits[i][1] = 0.0;
+}
+
+/*-------------------------- Accessors ------------------------------------*/
+
+/* Name:  Load
+ * Parameters:  none
+ * Purpose:     read map and post, cut post into its terms' lists by the
+ *              trie's entries, and list the terms of every document
+ * Returns:     false if the index cannot be read or does not add up
+*/
+bool DocReorderer::Load()
+{
+ifstream Map((dirname + "/map").c_str());
+ifstream Post((dirname + "/post").c_str(), ios::binary);
+TermTrie Trie;
+vector<TrieMatch> Entries;
+string Line;
+unsigned long Expected = 0;
+
+   if (!Map.is_open() || !Post.is_open() || !Trie.Read(dirname + "/trie"))
+      return false;
+   while (getline(Map, Line))
+      maplines.push_back(Line);
+   post.assign(istreambuf_iterator<char>(Post), istreambuf_iterator<char>());
+   post.push_back('\0');
+
+   for (unsigned long i = 0; i + 1 < post.size(); )
+   {
+      char *End;
+      lines.push_back(i);
+      docids.push_back(strtol(post.data() + i, &End, 10));
+      if (docids.back() < 1 || docids.back() > (int) maplines.size())
+         return false;
+      while (i + 1 < post.size() && post[i] != '\n')
+         i++;
+      i++;
+   }
+   lines.push_back(post.size() - 1);
+
+   // the lists follow one another in post, in order of their first line
+   Trie.Prefix("", Entries);
+   sort(Entries.begin(), Entries.end(), [](const TrieMatch &a, const TrieMatch &b)
+   {
+      return a.entry.start < b.entry.start;
+   });
+   for (unsigned long e = 0; e < Entries.size(); e++)
+   {
+      if (Entries[e].entry.numdocs <= 0)
+         continue;
+      if (Entries[e].entry.start != Expected)
+         return false;
+      liststarts.push_back(Expected);
+      Expected += Entries[e].entry.numdocs;
+   }
+   if (Expected != docids.size())
+      return false;
+   liststarts.push_back(Expected);
+
+   // each document's terms, by counting then filling
+   docterms.assign(maplines.size() + 2, 0);
+   for (unsigned long k = 0; k < docids.size(); k++)
+      docterms[docids[k] + 1]++;
+   for (unsigned long d = 1; d < docterms.size(); d++)
+      docterms[d] += docterms[d - 1];
+   terms.resize(docids.size());
+   vector<unsigned long> Fill(docterms.begin(), docterms.end() - 1);
+   for (unsigned int l = 0; l + 1 < liststarts.size(); l++)
+      for (unsigned long k = liststarts[l]; k < liststarts[l + 1]; k++)
+         terms[Fill[docids[k]]++] = l;
+   return true;
+}
+
+/* Name:  Reorder
+ * Parameters:  none
+ * Purpose:     sort the documents by filename, then bisect; measure
+ *              the gaps of readdir, filename and bisection order
+ * Returns:     nothing
+*/
+void DocReorderer::Reorder()
+{
+int NumDocs = maplines.size();
+vector<int> NewIds(NumDocs + 1);
+
+   order.resize(NumDocs);
+   for (int d = 0; d < NumDocs; d++)
+      order[d] = d + 1;
+   for (int d = 1; d <= NumDocs; d++)
+      NewIds[d] = d;
+   Measure(NewIds, reportbits[0][0], reportbits[0][1]);
+
+   // filenames, without a near-duplicate's tab and DocId
+   stable_sort(order.begin(), order.end(), [&](int a, int b)
+   {
+      return maplines[a - 1].substr(0, maplines[a - 1].find('\t')) <
+             maplines[b - 1].substr(0, maplines[b - 1].find('\t'));
+   });
+   filenamerank.resize(NumDocs + 1);
+   for (int k = 0; k < NumDocs; k++)
+      NewIds[order[k]] = filenamerank[order[k]] = k + 1;
+   Measure(NewIds, reportbits[1][0], reportbits[1][1]);
+
+   left.assign(liststarts.size(), 0);
+   right.assign(liststarts.size(), 0);
+   logs.resize(NumDocs + 2);
+   logs[0] = 0.0;
+   for (int i = 1; i < NumDocs + 2; i++)
+      logs[i] = log2((double) i);
+   Bisect(order.data(), NumDocs);
+
+   for (int k = 0; k < NumDocs; k++)
+      NewIds[order[k]] = k + 1;
+   Measure(NewIds, reportbits[2][0], reportbits[2][1]);
+}
+
+/* Name:  PrintReport
+ * Parameters:  none
+ * Purpose:     print the bits per posting of each order, if the gaps
+ *              were stored Elias-gamma coded or as varints
+ * Returns:     nothing
+*/
+void DocReorderer::PrintReport() const
+{
+const char *Names[3] = {"readdir", "filename", "bisection"};
+
+   cout << "DocId order   gamma bits/posting  varint bits/posting" << endl;
+   for (int i = 0; i < 3; i++)
+      cout << std::left << setw(12) << Names[i] << std::right << fixed << setprecision(2)
+           << setw(20) << reportbits[i][0] << setw(21) << reportbits[i][1] << endl;
+}
+
+/* Name:  Rewrite
+ * Parameters:  none
+ * Purpose:     write map with each filename at its new DocId (and a
+ *              near-duplicate's DocId renumbered too), and post with
+ *              each list's lines renumbered and sorted again.  Only
+ *              the DocId field of a line changes; the weight text is
+ *              kept as it was.
+ * Returns:     false if a file could not be written
+*/
+bool DocReorderer::Rewrite()
+{
+vector<int> NewIds(maplines.size() + 1);
+vector< pair<int, unsigned long> > List;
+string MapFilename = dirname + "/map";
+string PostFilename = dirname + "/post";
+ofstream Map((MapFilename + ".tmp").c_str());
+int Fd;
+bool Written;
+
+   for (unsigned long k = 0; k < order.size(); k++)
+      NewIds[order[k]] = k + 1;
+
+   for (unsigned long k = 0; k < order.size(); k++)
+   {
+      const string &Line = maplines[order[k] - 1];
+      unsigned long Tab = Line.find('\t');
+      if (Tab == string::npos)
+         Map << Line << '\n';
+      else
+         Map << Line.substr(0, Tab) << '\t' << NewIds[atoi(Line.c_str() + Tab + 1)] << '\n';
+   }
+   Map.close();
+   if (!Map)
+      return false;
+
+   if ((Fd = open((PostFilename + ".tmp").c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644)) < 0)
+      return false;
+   {
+   OutputWriter Post(Fd);
+   for (unsigned long l = 0; l + 1 < liststarts.size(); l++)
+   {
+      List.clear();
+      for (unsigned long k = liststarts[l]; k < liststarts[l + 1]; k++)
+         List.push_back(make_pair(NewIds[docids[k]], k));
+      sort(List.begin(), List.end());
+      for (unsigned long i = 0; i < List.size(); i++)
+      {
+         char *End;
+         const char *Line = post.data() + lines[List[i].second];
+         strtol(Line, &End, 10);
+         Post.PutInt(List[i].first, POST_INT_LENGTH);
+         Post.Put(string_view(End, post.data() + lines[List[i].second + 1] - End));
+      }
+   }
+   Written = Post.Flush();
+   }
+   Written = (close(Fd) == 0) && Written;
+
+   return Written && rename((MapFilename + ".tmp").c_str(), MapFilename.c_str()) == 0 &&
+          rename((PostFilename + ".tmp").c_str(), PostFilename.c_str()) == 0;
+}
+
+/*-------------------------- Private Functions ----------------------------*/
+
+/* Name:  Bisect
+ * Parameters:  Docs: old DocIds, to be put in order in place
+ *              Count: how many
+ * Purpose:     split the documents in half and swap pairs across the
+ *              split while that lowers the cost of the gaps, then do
+ *              the same for each half.  A term with a documents in a
+ *              half of n costs about a * log2(n / (a + 1)) bits there;
+ *              a document's gain is what its terms would save if it
+ *              moved to the other half.  A leaf goes back to filename
+ *              order, which the swaps (sorted by gain) have lost.
+ * Returns:     nothing
+*/
+void DocReorderer::Bisect(int *Docs, const int Count)
+{
+int Half = Count / 2;
+int *Right = Docs + Half;
+int RightCount = Count - Half;
+vector< pair<float, int> > LeftGains(Half);
+vector< pair<float, int> > RightGains(RightCount);
+
+   if (Count <= BISECT_LEAF_DOCS)
+   {
+      sort(Docs, Docs + Count, [&](int a, int b) { return filenamerank[a] < filenamerank[b]; });
+      return;
+   }
+
+   float LeftLog = logs[Half];
+   float RightLog = logs[RightCount];
+   auto Cost = [&](const int a, const int b)
+   {
+      return a * (LeftLog - logs[a + 1]) + b * (RightLog - logs[b + 1]);
+   };
+
+   for (int Iteration = 0; Iteration < BISECT_ITERATIONS; Iteration++)
+   {
+      int Swaps = 0;
+
+      for (int i = 0; i < Half; i++)
+         for (unsigned long k = docterms[Docs[i]]; k < docterms[Docs[i] + 1]; k++)
+            left[terms[k]]++;
+      for (int i = 0; i < RightCount; i++)
+         for (unsigned long k = docterms[Right[i]]; k < docterms[Right[i] + 1]; k++)
+            right[terms[k]]++;
+
+      for (int i = 0; i < Half; i++)
+      {
+         float Gain = 0.0;
+         for (unsigned long k = docterms[Docs[i]]; k < docterms[Docs[i] + 1]; k++)
+         {
+            unsigned int t = terms[k];
+            Gain += Cost(left[t], right[t]) - Cost(left[t] - 1, right[t] + 1);
+         }
+         LeftGains[i] = make_pair(Gain, Docs[i]);
+      }
+      for (int i = 0; i < RightCount; i++)
+      {
+         float Gain = 0.0;
+         for (unsigned long k = docterms[Right[i]]; k < docterms[Right[i] + 1]; k++)
+         {
+            unsigned int t = terms[k];
+            Gain += Cost(left[t], right[t]) - Cost(left[t] + 1, right[t] - 1);
+         }
+         RightGains[i] = make_pair(Gain, Right[i]);
+      }
+
+      for (int i = 0; i < Count; i++)
+         for (unsigned long k = docterms[Docs[i]]; k < docterms[Docs[i] + 1]; k++)
+            left[terms[k]] = right[terms[k]] = 0;
+
+      // the best movers first; swap while a pair still gains
+      sort(LeftGains.begin(), LeftGains.end(), greater< pair<float, int> >());
+      sort(RightGains.begin(), RightGains.end(), greater< pair<float, int> >());
+      for (int i = 0; i < Half; i++)
+         Docs[i] = LeftGains[i].second;
+      for (int i = 0; i < RightCount; i++)
+         Right[i] = RightGains[i].second;
+      for (int i = 0; i < Half && i < RightCount && LeftGains[i].first + RightGains[i].first > 0.0; i++)
+      {
+         swap(Docs[i], Right[i]);
+         Swaps++;
+      }
+      if (Swaps == 0)
+         break;
+   }
+
+   Bisect(Docs, Half);
+   Bisect(Right, RightCount);
+}
+
+/* Name:  Measure
+ * Parameters:  NewIds: the DocId each old DocId would get
+ *              GammaBits, VarintBits: receive the bits per posting
+ * Purpose:     cost every list's DocId gaps in that order
+ * Returns:     nothing
+*/
+void DocReorderer::Measure(const vector<int> &NewIds, double &GammaBits, double &VarintBits) const
+{
+vector<int> List;
+double Gamma = 0.0;
+double Varint = 0.0;
+
+   for (unsigned long l = 0; l + 1 < liststarts.size(); l++)
+   {
+      List.clear();
+      for (unsigned long k = liststarts[l]; k < liststarts[l + 1]; k++)
+         List.push_back(NewIds[docids[k]]);
+      sort(List.begin(), List.end());
+      for (unsigned long i = 0; i < List.size(); i++)
+      {
+         unsigned int Gap = List[i] - (i == 0 ? 0 : List[i - 1]);
+         int Bits = (Gap == 0 ? 1 : 32 - __builtin_clz(Gap));
+         Gamma += 2 * Bits - 1;
+         Varint += 8 * ((Bits + 6) / 7);
+      }
+   }
+   GammaBits = (docids.empty() ? 0.0 : Gamma / docids.size());
+   VarintBits = (docids.empty() ? 0.0 : Varint / docids.size());
+}
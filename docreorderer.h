@@ -0,0 +1,59 @@
+/* Filename:  docreorderer.h
+ * Date:      10/19/26
+ * Purpose:   The header file for DocId reassignment.  DocIds come in
+ *            readdir order, which says nothing about content, so the
+ *            gaps between a term's DocIds are about as large as they
+ *            can be.  The reorderer reads a finished index (map, post
+ *            and the trie's list boundaries), orders the documents by
+ *            recursive graph bisection so that documents sharing terms
+ *            get nearby DocIds, and rewrites map and post to match.
+ *            Each term keeps its numdocs and its lines in post, so dict
+ *            and the trie stay as they are.
+ *
+ *            Bisection starts from the documents sorted by filename,
+ *            splits them in half and swaps the documents whose move
+ *            most lowers the estimated cost of the gaps (log2 of the
+ *            average gap per term in each half), then does the same in
+ *            each half down to BISECT_LEAF_DOCS documents.  A leaf's
+ *            documents are put back in filename order.
+*/
+
+#ifndef DOCREORDERER_H
+#define DOCREORDERER_H
+
+#include <string>
+#include <vector>
+
+#define BISECT_ITERATIONS 20       // swap rounds per split
+#define BISECT_LEAF_DOCS 16        // splits stop at this many documents
+
+using namespace std;
+
+class DocReorderer {
+public:
+   DocReorderer(const string IndexDirname);
+   bool Load ();                    // read map, post and the trie
+   void Reorder ();                 // choose the new DocIds
+   void PrintReport () const;       // bits per posting, old and new
+   bool Rewrite ();                 // write map and post in the new order
+private:
+   DocReorderer (const DocReorderer& dr);
+   void Bisect (int *Docs, const int Count);
+   void Measure (const vector<int> &NewIds, double &GammaBits, double &VarintBits) const;
+   string dirname;
+   vector<string> maplines;         // by old DocId - 1
+   vector<char> post;               // the whole post file
+   vector<unsigned long> lines;     // where each post line begins
+   vector<int> docids;              // each post line's old DocId
+   vector<unsigned long> liststarts;   // each term's first post line, in order
+   vector<unsigned long> docterms;  // per old DocId, where its terms begin
+   vector<unsigned int> terms;      // the terms (list numbers) of each document
+   vector<int> order;               // new DocId - 1 -> old DocId
+   vector<int> filenamerank;        // per old DocId, its place in filename order
+   vector<int> left;                // per term, its documents in each half
+   vector<int> right;
+   vector<float> logs;              // log2 of 0 .. numdocs + 1
+   double reportbits[3][2];         // readdir, filename, bisection x gamma, varint
+};
+
+#endif
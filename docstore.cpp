@@ -0,0 +1,423 @@
+/* Filename:  docstore.cpp
+ * Date:      10/19/2026
+ * Purpose:   The implementation file for the document store and its
+ *            block compressor.
+*/
+
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <iostream>
+#include <iomanip>
+
+#include "docstore.h"
+
+using namespace std;
+
+// Read a number of the given type from anywhere in the file
+template <class T>
+static T GetRaw(const char *Where)
+{
+T Value;
+
+   memcpy(&Value, Where, sizeof(T));
+   return Value;
+}
+
+// A length beyond a token's 15 goes on in bytes of 255 and a last byte
+static void PutExtra(vector<char> &Out, unsigned int Length)
+{
+   for (; Length >= 255; Length -= 255)
+      Out.push_back((char) 255);
+   Out.push_back((char) Length);
+}
+
+static bool GetExtra(const char *&In, const char *End, unsigned int &Length)
+{
+unsigned char Byte;
+
+   do
+   {
+      if (In >= End)
+         return false;
+      Byte = *In++;
+      Length += Byte;
+   } while (Byte == 255);
+   return true;
+}
+
+// One sequence: the token, the literals, then the match if there is one
+static void PutSequence(vector<char> &Out, const char *Literals, const unsigned int NumLiterals,
+                        const unsigned int Offset, const unsigned int MatchLength)
+{
+unsigned int Extra = (MatchLength > 0 ? MatchLength - DOCSTORE_MIN_MATCH : 0);
+
+   Out.push_back((char) ((min(NumLiterals, 15u) << 4) | min(Extra, 15u)));
+   if (NumLiterals >= 15)
+      PutExtra(Out, NumLiterals - 15);
+   Out.insert(Out.end(), Literals, Literals + NumLiterals);
+   if (MatchLength == 0)
+      return;
+   Out.push_back((char) (Offset & 0xff));
+   Out.push_back((char) (Offset >> 8));
+   if (Extra >= 15)
+      PutExtra(Out, Extra - 15);
+}
+
+/*-------------------------- Constructors/Destructors ----------------------*/
+
+/* Name:  DocStore
+ * Parameters:  none
+ * Purpose:     a store that is neither being written nor open
+ * Returns:     nothing
+*/
+DocStore::DocStore()
+{
+   fd = -1;
+   out = NULL;
+   offset = 0;
+   textbytes = 0;
+   data = NULL;
+   length = 0;
+   blockdirectory = NULL;
+   docdirectory = NULL;
+   cached = -1;
+   numdocs = 0;
+   numblocks = 0;
+}
+
+DocStore::~DocStore()
+{
+   delete out;
+   if (fd >= 0)
+      close(fd);
+   if (data != NULL)
+      munmap(data, length);
+}
+
+/*-------------------------- Accessors ------------------------------------*/
+
+/* Name:  Create
+ * Parameters:  Filename: the docs file to write
+ * Purpose:     start a new store; the header is filled in by Finish
+ * Returns:     false if the file could not be created
+*/
+bool DocStore::Create(const string Filename)
+{
+char Header[DOCSTORE_HEADER_LENGTH];
+
+   if ((fd = open(Filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644)) < 0)
+   {
+      perror(Filename.c_str());
+      return false;
+   }
+   filename = Filename;
+   out = new OutputWriter(fd);
+   memset(Header, 0, sizeof(Header));
+   memcpy(Header, DOCSTORE_MAGIC, DOCSTORE_MAGIC_LENGTH);
+   out->Put(string_view(Header, DOCSTORE_HEADER_LENGTH));
+   offset = DOCSTORE_HEADER_LENGTH;
+   return true;
+}
+
+/* Name:  Add
+ * Parameters:  DocId: the next document; any DocIds skipped are stored
+ *                     empty
+ *              Text: its tokens, separated by spaces
+ * Purpose:     add a document's text to the current block, packing
+ *              each block as it fills; a long document runs on into
+ *              the blocks after
+ * Returns:     nothing
+*/
+void DocStore::Add(const int DocId, const vector<char> &Text)
+{
+unsigned int Start;
+unsigned int Length;
+unsigned long Added = 0;
+
+   for (; numdocs < DocId; numdocs++)
+   {
+      Start = block.size();
+      Length = (numdocs == DocId - 1 ? Text.size() : 0);
+      docs.Put(string_view((const char *) &numblocks, 4));
+      docs.Put(string_view((const char *) &Start, 4));
+      docs.Put(string_view((const char *) &Length, 4));
+   }
+   while (Added < Text.size())
+   {
+      unsigned long Piece = min(Text.size() - Added, DOCSTORE_BLOCK_BYTES - block.size());
+      block.insert(block.end(), Text.begin() + Added, Text.begin() + Added + Piece);
+      Added += Piece;
+      if (block.size() == DOCSTORE_BLOCK_BYTES)
+         PackBlock();
+   }
+   textbytes += Text.size();
+}
+
+/* Name:  Finish
+ * Parameters:  none
+ * Purpose:     pack the last block, write the directory and the header,
+ *              and say how well the text compressed
+ * Returns:     false if the file could not be written
+*/
+bool DocStore::Finish()
+{
+bool Written;
+
+   if (out == NULL)
+      return false;
+   if (!block.empty())
+      PackBlock();
+   Written = out->Flush() && blocks.WriteAt(fd, offset) &&
+             docs.WriteAt(fd, offset + blocks.GetLength()) &&
+             pwrite(fd, &numdocs, 4, DOCSTORE_MAGIC_LENGTH) == 4 &&
+             pwrite(fd, &numblocks, 4, DOCSTORE_MAGIC_LENGTH + 4) == 4 &&
+             pwrite(fd, &offset, 8, DOCSTORE_MAGIC_LENGTH + 8) == 8;
+   delete out;
+   out = NULL;
+   if (close(fd) != 0 || !Written)
+   {
+      fd = -1;
+      perror(filename.c_str());
+      return false;
+   }
+   fd = -1;
+
+   cout << "Document store: " << numdocs << " documents, " << fixed << setprecision(1)
+        << textbytes / 1048576.0 << " MB of text in "
+        << (offset + blocks.GetLength() + docs.GetLength()) / 1048576.0 << " MB" << endl;
+   return true;
+}
+
+/* Name:  Open
+ * Parameters:  Filename: a docs file made by Create, Add and Finish
+ * Purpose:     map the file; blocks are decompressed only when read
+ * Returns:     false if it is missing or not a docs file
+*/
+bool DocStore::Open(const string Filename)
+{
+struct stat Info;
+void *Map;
+int Fd;
+unsigned long Offset;
+
+   if ((Fd = open(Filename.c_str(), O_RDONLY)) < 0)
+      return false;
+   if (fstat(Fd, &Info) != 0 || Info.st_size < DOCSTORE_HEADER_LENGTH ||
+       (Map = mmap(NULL, Info.st_size, PROT_READ, MAP_SHARED, Fd, 0)) == MAP_FAILED)
+   {
+      close(Fd);
+      return false;
+   }
+   close(Fd);
+
+   data = (char *) Map;
+   length = Info.st_size;
+   numdocs = GetRaw<int>(data + DOCSTORE_MAGIC_LENGTH);
+   numblocks = GetRaw<unsigned int>(data + DOCSTORE_MAGIC_LENGTH + 4);
+   Offset = GetRaw<unsigned long>(data + DOCSTORE_MAGIC_LENGTH + 8);
+   if (memcmp(data, DOCSTORE_MAGIC, DOCSTORE_MAGIC_LENGTH) != 0 || numdocs < 0 ||
+       Offset + (unsigned long) numblocks * DOCSTORE_BLOCK_LENGTH +
+       (unsigned long) numdocs * DOCSTORE_DOC_LENGTH != length)
+   {
+      munmap(data, length);
+      data = NULL;
+      numdocs = 0;
+      numblocks = 0;
+      return false;
+   }
+   blockdirectory = data + Offset;
+   docdirectory = blockdirectory + (unsigned long) numblocks * DOCSTORE_BLOCK_LENGTH;
+   cached = -1;
+   return true;
+}
+
+bool DocStore::IsOpen() const
+{
+   return data != NULL;
+}
+
+/* Name:  Get
+ * Parameters:  DocId: the document wanted
+ *              MaxBytes: the most of its text wanted
+ *              Text: receives its tokens, separated by spaces, up to
+ *                    MaxBytes of them
+ * Purpose:     copy the start of a document out of its blocks, which
+ *              are decompressed unless one is the block read last
+ * Returns:     false if there is no such document or a block is bad
+*/
+bool DocStore::Get(const int DocId, const unsigned long MaxBytes, string &Text)
+{
+const char *Entry;
+unsigned int Block;
+unsigned int Start;
+unsigned long Length;
+
+   Text.clear();
+   if (data == NULL || DocId < 1 || DocId > numdocs)
+      return false;
+   Entry = docdirectory + (unsigned long) (DocId - 1) * DOCSTORE_DOC_LENGTH;
+   Block = GetRaw<unsigned int>(Entry);
+   Start = GetRaw<unsigned int>(Entry + 4);
+   Length = min((unsigned long) GetRaw<unsigned int>(Entry + 8), MaxBytes);
+
+   for (; Text.length() < Length; Block++, Start = 0)
+   {
+      if (!LoadBlock(Block) || Start >= cache.size())
+         return false;
+      Text.append(cache.data() + Start, min(cache.size() - Start, Length - Text.length()));
+   }
+   return true;
+}
+
+bool DocStore::Get(const int DocId, string &Text)
+{
+   return Get(DocId, ULONG_MAX, Text);
+}
+
+int DocStore::GetNumDocs() const
+{
+   return numdocs;
+}
+
+unsigned long DocStore::GetLength() const
+{
+   return length;
+}
+
+/* Name:  Compress
+ * Parameters:  In: the text
+ *              Length: its bytes
+ *              Out: receives the sequences
+ * Purpose:     greedy LZ77: a table hashed on the next four bytes
+ *              remembers where each was last seen, and a match back
+ *              within 64K is taken for as long as it runs.  The last
+ *              sequence is literals alone, which is how the decoder
+ *              knows the text is done.
+ * Returns:     nothing
+*/
+void DocStore::Compress(const char *In, const unsigned int Length, vector<char> &Out)
+{
+vector<int> Table(1 << DOCSTORE_HASH_BITS, -1);
+unsigned int Anchor = 0;
+unsigned int i = 0;
+unsigned int Bytes;
+
+   Out.clear();
+   while (i + DOCSTORE_MIN_MATCH <= Length)
+   {
+      memcpy(&Bytes, In + i, 4);
+      unsigned int Hash = (Bytes * 2654435761u) >> (32 - DOCSTORE_HASH_BITS);
+      int Candidate = Table[Hash];
+      Table[Hash] = i;
+      if (Candidate >= 0 && i - Candidate <= 65535 && memcmp(In + Candidate, In + i, 4) == 0)
+      {
+         unsigned int Match = DOCSTORE_MIN_MATCH;
+         while (i + Match < Length && In[Candidate + Match] == In[i + Match])
+            Match++;
+         PutSequence(Out, In + Anchor, i - Anchor, i - Candidate, Match);
+         i += Match;
+         Anchor = i;
+      }
+      else
+         i++;
+   }
+   PutSequence(Out, In + Anchor, Length - Anchor, 0, 0);
+}
+
+/* Name:  Decompress
+ * Parameters:  In: sequences made by Compress
+ *              PackedLength: their bytes
+ *              Out: receives the text
+ *              Length: the bytes of text expected
+ * Purpose:     copy each sequence's literals, then its match from the
+ *              text already made (which may overlap what it makes)
+ * Returns:     false if the sequences are bad or do not make Length
+ *              bytes exactly
+*/
+bool DocStore::Decompress(const char *In, const unsigned int PackedLength,
+                          char *Out, const unsigned int Length)
+{
+const char *InEnd = In + PackedLength;
+char *Made = Out;
+char *OutEnd = Out + Length;
+
+   while (In < InEnd)
+   {
+      unsigned char Token = *In++;
+      unsigned int NumLiterals = Token >> 4;
+      unsigned int Match = Token & 15;
+      unsigned int Offset;
+
+      if (NumLiterals == 15 && !GetExtra(In, InEnd, NumLiterals))
+         return false;
+      if (NumLiterals > (unsigned long) (InEnd - In) || NumLiterals > (unsigned long) (OutEnd - Made))
+         return false;
+      memcpy(Made, In, NumLiterals);
+      In += NumLiterals;
+      Made += NumLiterals;
+      if (In == InEnd)
+         return Made == OutEnd;
+
+      if (InEnd - In < 2)
+         return false;
+      Offset = (unsigned char) In[0] | ((unsigned char) In[1] << 8);
+      In += 2;
+      if (Match == 15 && !GetExtra(In, InEnd, Match))
+         return false;
+      Match += DOCSTORE_MIN_MATCH;
+      if (Offset == 0 || Offset > (unsigned long) (Made - Out) || Match > (unsigned long) (OutEnd - Made))
+         return false;
+      if (Offset >= Match)
+         memcpy(Made, Made - Offset, Match);
+      else
+         for (unsigned int k = 0; k < Match; k++)
+            Made[k] = Made[(long) k - Offset];
+      Made += Match;
+   }
+   return false;
+}
+
+/*-------------------------- Private Functions ----------------------------*/
+
+// Compress the gathered text as the next block and note where it went
+void DocStore::PackBlock()
+{
+unsigned int Packed;
+unsigned int Length = block.size();
+
+   Compress(block.data(), Length, packed);
+   Packed = packed.size();
+   out->Put(string_view(packed.data(), packed.size()));
+   blocks.Put(string_view((const char *) &offset, 8));
+   blocks.Put(string_view((const char *) &Packed, 4));
+   blocks.Put(string_view((const char *) &Length, 4));
+   offset += Packed;
+   numblocks++;
+   block.clear();
+}
+
+// Decompress a block into the cache, unless it is there already
+bool DocStore::LoadBlock(const unsigned int Block)
+{
+const char *Entry = blockdirectory + (unsigned long) Block * DOCSTORE_BLOCK_LENGTH;
+unsigned long Offset;
+unsigned int Packed;
+
+   if ((int) Block == cached)
+      return true;
+   if (Block >= numblocks)
+      return false;
+   Offset = GetRaw<unsigned long>(Entry);
+   Packed = GetRaw<unsigned int>(Entry + 8);
+   cached = -1;
+   cache.resize(GetRaw<unsigned int>(Entry + 12));
+   if (Offset + Packed > length || !Decompress(data + Offset, Packed, cache.data(), cache.size()))
+      return false;
+   cached = Block;
+   return true;
+}
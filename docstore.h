@@ -0,0 +1,85 @@
+/* Filename:  docstore.h
+ * Date:      10/19/26
+ * Purpose:   The header file for the document store, docs: the text of
+ *            the tokens invert saw in each document, in DocId order, so
+ *            results can be shown without the original files.  The
+ *            text is cut into blocks of DOCSTORE_BLOCK_BYTES (a long
+ *            document running on over several) and each block is
+ *            compressed on its own: LZ77, in sequences laid out as LZ4
+ *            lays them out (a token byte of literal and match lengths,
+ *            the literals, a 2-byte offset).  Reading a short document
+ *            decompresses one block, and reading the start of a long
+ *            one only the blocks it needs.  The last block read is
+ *            kept, so the documents near it cost nothing more.
+ *
+ *            "DOCSTOR1", numdocs (4), numblocks (4),
+ *            directory offset (8)
+ *            block*
+ *            directory:  (block offset (8), packed length (4),
+ *                         length (4))* per block, then
+ *                        (block (4), start (4), length (4))* per
+ *                        document, in DocId order
+*/
+
+#ifndef DOCSTORE_H
+#define DOCSTORE_H
+
+#include <string>
+#include <vector>
+
+#include "outputwriter.h"
+
+#define DOCSTORE_MAGIC "DOCSTOR1"
+#define DOCSTORE_MAGIC_LENGTH 8
+#define DOCSTORE_HEADER_LENGTH 24
+#define DOCSTORE_BLOCK_LENGTH 16   // a block's directory entry
+#define DOCSTORE_DOC_LENGTH 12     // a document's directory entry
+#define DOCSTORE_BLOCK_BYTES 32768ul  // the text in a block
+#define DOCSTORE_MIN_MATCH 4       // the shortest repeat worth a match
+#define DOCSTORE_HASH_BITS 14      // the compressor's table of recent places
+
+using namespace std;
+
+class DocStore {
+public:
+   DocStore();
+   ~DocStore();
+   bool Create (const string Filename);   // to write with Add and Finish
+   void Add (const int DocId, const vector<char> &Text);
+   bool Finish ();                  // the last block and the directory
+   bool Open (const string Filename);     // to read with Get
+   bool IsOpen () const;
+   bool Get (const int DocId, string &Text);
+   bool Get (const int DocId, const unsigned long MaxBytes, string &Text);   // its start
+   int GetNumDocs () const;
+   unsigned long GetLength () const;      // the bytes of the file
+   static void Compress (const char *In, const unsigned int Length, vector<char> &Out);
+   static bool Decompress (const char *In, const unsigned int PackedLength,
+                           char *Out, const unsigned int Length);
+private:
+   DocStore (const DocStore& ds);
+   void PackBlock ();
+   bool LoadBlock (const unsigned int Block);
+   // writing
+   string filename;
+   int fd;
+   OutputWriter *out;               // the blocks, as they are packed
+   OutputWriter blocks;             // the directory, until Finish
+   OutputWriter docs;
+   vector<char> block;              // text not yet packed
+   vector<char> packed;
+   unsigned long offset;            // where the next block goes
+   unsigned long textbytes;         // text added
+   // reading
+   char *data;                      // the whole file, mapped
+   unsigned long length;
+   const char *blockdirectory;
+   const char *docdirectory;
+   int cached;                      // the block in cache, or -1
+   vector<char> cache;
+   // both
+   int numdocs;
+   unsigned int numblocks;
+};
+
+#endif
@@ -0,0 +1,272 @@
+/* Filename:  forwardindex.cpp
+ * Date:      10/19/2026
+ * Purpose:   The implementation file for the forward index.
+*/
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+
+#include "forwardindex.h"
+#include "outputwriter.h"
+#include "postingcodec.h"
+#include "termtrie.h"
+
+using namespace std;
+
+// Read a number of the given type from anywhere in the file
+template <class T>
+static T GetRaw(const char *Where)
+{
+T Value;
+
+   memcpy(&Value, Where, sizeof(T));
+   return Value;
+}
+
+/*-------------------------- Constructors/Destructors ----------------------*/
+
+ForwardIndex::ForwardIndex()
+{
+   data = NULL;
+   length = 0;
+   directory = NULL;
+   numdocs = 0;
+   numterms = 0;
+}
+
+ForwardIndex::~ForwardIndex()
+{
+   if (data != NULL)
+      munmap(data, length);
+}
+
+/*-------------------------- Accessors ------------------------------------*/
+
+/* Name:  Open
+ * Parameters:  Filename: a fwd file made by Build
+ * Purpose:     map the file and work out the weight of every impact
+ * Returns:     false if it is missing or not a fwd file
+*/
+bool ForwardIndex::Open(const string Filename)
+{
+struct stat Info;
+void *Map;
+int Fd;
+
+   if ((Fd = open(Filename.c_str(), O_RDONLY)) < 0)
+      return false;
+   if (fstat(Fd, &Info) != 0 || Info.st_size < FORWARD_HEADER_LENGTH ||
+       (Map = mmap(NULL, Info.st_size, PROT_READ, MAP_SHARED, Fd, 0)) == MAP_FAILED)
+   {
+      close(Fd);
+      return false;
+   }
+   close(Fd);
+
+   data = (char *) Map;
+   length = Info.st_size;
+   numdocs = GetRaw<int>(data + FORWARD_MAGIC_LENGTH);
+   numterms = GetRaw<unsigned int>(data + FORWARD_MAGIC_LENGTH + 4);
+   unsigned long Offset = GetRaw<unsigned long>(data + FORWARD_MAGIC_LENGTH + 8);
+   if (memcmp(data, FORWARD_MAGIC, FORWARD_MAGIC_LENGTH) != 0 || numdocs < 0 ||
+       Offset + (unsigned long) numdocs * FORWARD_DIRECTORY_LENGTH != length)
+   {
+      munmap(data, length);
+      data = NULL;
+      return false;
+   }
+   directory = data + Offset;
+
+   ImpactQuantizer Quantizer(FORWARD_IMPACT_BITS, true, GetRaw<float>(data + FORWARD_MAGIC_LENGTH + 16),
+                             GetRaw<float>(data + FORWARD_MAGIC_LENGTH + 20));
+   impacts.clear();
+   for (unsigned int i = 0; i <= Quantizer.GetMaxImpact(); i++)
+      impacts.push_back(Quantizer.Dequantize(i));
+   return true;
+}
+
+bool ForwardIndex::IsOpen() const
+{
+   return data != NULL;
+}
+
+/* Name:  Get
+ * Parameters:  DocId: a document
+ *              TermIds: receives its terms' ids, increasing
+ *              Weights: receives their weights, as in post to within
+ *                       the impact's step
+ * Purpose:     decode one document's record
+ * Returns:     false if the document is not in fwd
+*/
+bool ForwardIndex::Get(const int DocId, vector<int> &TermIds, vector<float> &Weights) const
+{
+   TermIds.clear();
+   Weights.clear();
+   if (data == NULL || DocId < 1 || DocId > numdocs)
+      return false;
+
+   const char *Entry = directory + (unsigned long) (DocId - 1) * FORWARD_DIRECTORY_LENGTH;
+   const char *Record = data + GetRaw<unsigned long>(Entry);
+   int Count = GetRaw<int>(Entry + 8);
+
+   TermIds.resize(Count);
+   Weights.resize(Count);
+   for (int k = 0; k < Count; k++)
+      Weights[k] = impacts[GetRaw<unsigned short>(Record + 2 * k)];
+   PostingCodec::Decode(CODEC_GROUP_VARINT, Record + 2 * Count, Count, -1, TermIds.data());
+   return true;
+}
+
+int ForwardIndex::GetNumDocs() const
+{
+   return numdocs;
+}
+
+unsigned int ForwardIndex::GetNumTerms() const
+{
+   return numterms;
+}
+
+unsigned long ForwardIndex::GetLength() const
+{
+   return length;
+}
+
+/* Name:  Build
+ * Parameters:  IndexDirname: an index directory with post, trie and map
+ * Purpose:     write fwd by turning post around.  A first read of post
+ *              counts each document's terms and finds the lowest and
+ *              highest weight; the second reads the lists in start
+ *              order, so each document's terms arrive by increasing id,
+ *              and drops every posting into its document's place.
+ * Returns:     false if the files could not be read or written
+*/
+bool ForwardIndex::Build(const string IndexDirname)
+{
+string Filename = IndexDirname + "/fwd";
+FILE *Post = fopen((IndexDirname + "/post").c_str(), "r");
+ifstream Map((IndexDirname + "/map").c_str());
+TermTrie Trie;
+vector<TrieMatch> Entries;
+vector<unsigned long> Starts;          // by DocId, its first posting below
+vector<int> TermIds;                   // every posting, by document
+vector<unsigned short> Impacts;
+vector<char> Record;
+unsigned long Offset = FORWARD_HEADER_LENGTH;
+unsigned long Line = 0;
+unsigned int NumTerms;
+int NumDocs = 0;
+float Low = 0.0;
+float High = 0.0;
+char Text[64];
+string MapLine;
+bool Written = true;
+int Fd;
+
+   if (Post == NULL || !Map.is_open() || !Trie.Read(IndexDirname + "/trie"))
+   {
+      if (Post != NULL)
+         fclose(Post);
+      return false;
+   }
+   while (getline(Map, MapLine))
+      NumDocs++;
+
+   Starts.assign(NumDocs + 2, 0);
+   for (bool First = true; fgets(Text, sizeof(Text), Post) != NULL; )
+   {
+      char *End;
+      int DocId = strtol(Text, &End, 10);
+      float Weight = strtof(End, NULL);
+      if (DocId >= 1 && DocId <= NumDocs)
+         Starts[DocId + 1]++;
+      if (Weight > 0.0 && (First || Weight < Low))
+         Low = Weight;
+      if (Weight > 0.0 && (First || Weight > High))
+         High = Weight;
+      First = First && Weight <= 0.0;
+   }
+   rewind(Post);
+   for (int d = 1; d <= NumDocs + 1; d++)
+      Starts[d] += Starts[d - 1];
+   TermIds.resize(Starts[NumDocs + 1]);
+   Impacts.resize(Starts[NumDocs + 1]);
+   ImpactQuantizer Quantizer(FORWARD_IMPACT_BITS, true, Low, High);
+
+   // every term with postings, in post order; its place is its id
+   Trie.Numbered(Entries);
+   NumTerms = Entries.size();
+
+   vector<unsigned long> Next(Starts);
+   for (unsigned long e = 0; Written && e < Entries.size(); e++)
+   {
+      const TrieEntry &Entry = Entries[e].entry;
+      while (Line < Entry.start && fgets(Text, sizeof(Text), Post) != NULL)
+         Line++;
+      for (int k = 0; k < Entry.numdocs; k++, Line++)
+      {
+         char *End;
+         if (fgets(Text, sizeof(Text), Post) == NULL)
+         {
+            cerr << IndexDirname << "/post is shorter than the dictionary says." << endl;
+            Written = false;
+            break;
+         }
+         int DocId = strtol(Text, &End, 10);
+         if (DocId < 1 || DocId > NumDocs)
+            continue;
+         TermIds[Next[DocId]] = e;
+         Impacts[Next[DocId]++] = Quantizer.Quantize(strtof(End, NULL));
+      }
+   }
+   fclose(Post);
+
+   if ((Fd = open(Filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644)) < 0)
+   {
+      perror(Filename.c_str());
+      return false;
+   }
+
+   {
+   OutputWriter Out(Fd);
+   OutputWriter Directory;
+
+   memset(Text, 0, sizeof(Text));
+   Out.Put(string_view(FORWARD_MAGIC, FORWARD_MAGIC_LENGTH));
+   Out.Put(string_view(Text, FORWARD_HEADER_LENGTH - FORWARD_MAGIC_LENGTH));  // filled in at the end
+
+   for (int d = 1; Written && d <= NumDocs; d++)
+   {
+      int Count = Next[d] - Starts[d];
+      const char *Weights = (const char *) (Impacts.data() + Starts[d]);
+      Record.assign(Weights, Weights + 2 * Count);
+      PostingCodec::Encode(CODEC_GROUP_VARINT, TermIds.data() + Starts[d], Count, -1, Record);
+      Directory.Put(string_view((const char *) &Offset, 8));
+      Directory.Put(string_view((const char *) &Count, 4));
+      Out.Put(string_view(Record.data(), Record.size()));
+      Offset += Record.size();
+   }
+
+   Written = Written && Out.Flush() && Directory.WriteAt(Fd, Offset);
+   }   // the writer is done with Fd here
+
+   Written = Written && pwrite(Fd, &NumDocs, 4, FORWARD_MAGIC_LENGTH) == 4 &&
+             pwrite(Fd, &NumTerms, 4, FORWARD_MAGIC_LENGTH + 4) == 4 &&
+             pwrite(Fd, &Offset, 8, FORWARD_MAGIC_LENGTH + 8) == 8 &&
+             pwrite(Fd, &Low, 4, FORWARD_MAGIC_LENGTH + 16) == 4 &&
+             pwrite(Fd, &High, 4, FORWARD_MAGIC_LENGTH + 20) == 4;
+   if (close(Fd) != 0 || !Written)
+   {
+      perror(Filename.c_str());
+      return false;
+   }
+   return true;
+}
@@ -0,0 +1,60 @@
+/* Filename:  forwardindex.h
+ * Date:      10/19/26
+ * Purpose:   The header file for the forward index, fwd: each document's
+ *            terms and their post weights, the transpose of post, so
+ *            relevance feedback and "more like this" can read a
+ *            document's vector at once instead of looking for it in
+ *            every list.  A term's id is its place among the trie's
+ *            terms with postings in start order, as bpost's
+ *            directory has them (see TermTrie::Numbered).
+ *            A document's record is its weights as 16-bit log impacts
+ *            on the global scale of post's lowest and highest weight
+ *            (see impactquantizer.h), then its term ids, increasing,
+ *            as group varint gaps (see postingcodec.h).
+ *
+ *            "FORWARD1", numdocs (4), numterms (4),
+ *            directory offset (8), lowest and highest weight
+ *            (4-byte floats)
+ *            record*
+ *            directory:  (record offset (8), numterms (4))* in DocId
+ *                        order, from DocId 1
+*/
+
+#ifndef FORWARDINDEX_H
+#define FORWARDINDEX_H
+
+#include <string>
+#include <vector>
+
+#include "impactquantizer.h"
+
+#define FORWARD_MAGIC "FORWARD1"
+#define FORWARD_MAGIC_LENGTH 8
+#define FORWARD_HEADER_LENGTH 32
+#define FORWARD_DIRECTORY_LENGTH 12
+#define FORWARD_IMPACT_BITS IMPACT_BITS_LARGE
+
+using namespace std;
+
+class ForwardIndex {
+public:
+   ForwardIndex();
+   ~ForwardIndex();
+   bool Open (const string Filename);
+   bool IsOpen () const;
+   bool Get (const int DocId, vector<int> &TermIds, vector<float> &Weights) const;
+   int GetNumDocs () const;
+   unsigned int GetNumTerms () const;
+   unsigned long GetLength () const;      // the bytes of the file
+   static bool Build (const string IndexDirname);   // fwd from post, trie and map
+private:
+   ForwardIndex (const ForwardIndex& fi);
+   char *data;                      // the whole file, mapped
+   unsigned long length;
+   const char *directory;
+   int numdocs;
+   unsigned int numterms;
+   vector<float> impacts;           // the weight of each impact
+};
+
+#endif
@@ -6,16 +6,35 @@
 */
 
 #include <assert.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
 #include <iostream>
 #include <fstream>
 #include <iomanip>
+#include <algorithm>
+#include <thread>
+#include <vector>
 
 #include "globalhashtable.h"
+#include "sorteddict.h"
+#include "termtrie.h"
 
 #define DICT_TOKEN_LENGTH 115
 #define DICT_NUMBER_LENGTH 5
+#define DUMP_RANGE_SLOTS 16384   // slots formatted by one thread at a time
 
 using namespace std;
+
+struct DumpRange  // one thread's share of a wave of PrintDictPost
+{
+   OutputWriter dict;               // the range's text, in memory
+   OutputWriter post;
+   off_t dictoffset;
+   off_t postoffset;
+};
+
 /*-------------------------- Constructors/Destructors ----------------------*/
 
 /* GlobalHashTable
@@ -26,37 +45,53 @@ using namespace std;
  *              by call-by-value parameter passing
  * Returns:     nothing
 */
-GlobalHashTable::GlobalHashTable( const GlobalHashTable &ht )
+GlobalHashTable::GlobalHashTable( const GlobalHashTable &ht ) : ctrl(ht.ctrl), terms(ht.terms)
 {
    size = ht.size;                    // set the size of the array
-   if((hashtable = new StringIntList[size]) == NULL)
+   if((hashtable = new TermIntList[size]) == NULL)
        cout << "Out of memory at GlobalHashTable::GlobalHashTable(const GlobalHashTable)" << endl;
    assert( hashtable != 0 );
 
    for (unsigned long i=0; i < size; i++)     // make a _copy_ of the array elements
    {
-      hashtable[i].token = ht.hashtable[i].token;
+      hashtable[i].termid = ht.hashtable[i].termid;
       hashtable[i].numdocs = ht.hashtable[i].numdocs;
       
       (hashtable[i].postings).Copy(ht.hashtable[i].postings);
    }
-   
+
+   // the copy is an ordinary one-pass table, with no runs of its own
+   inmemory = ht.inmemory;
+   countonly = false;
+   sorted = ht.sorted;
+   placed = NULL;
+   exact = NULL;
+   postmap = NULL;
+   postmapsize = 0;
 }
            
 /* Name:  GlobalHashTable
  * Author: seg
- * Parameters:  none
+ * Parameters:  NumTokens: the number of tokens expected
+ *              Terms: the term table that interns the tokens
  * Purpose:     allocate a hashtable for an expected number of token
  *              initializes all values to null (0)
  * Returns:     pointer to the created GlobalHashTable or 0 if out of memory
 */
-GlobalHashTable::GlobalHashTable(const unsigned long NumTokens)
+GlobalHashTable::GlobalHashTable(const unsigned long NumTokens, TermTable &Terms) : ctrl(NumTokens * 3), terms(Terms)
 {
    // allocate space for the table, init to null token
    size = NumTokens * 3;   // we want the hash table to be 2/3 empty
-   if((hashtable = new StringIntList[size]) == NULL)
+   if((hashtable = new TermIntList[size]) == NULL)
       cout << "Out of memory at GlobalHashTable::GlobalHashTable(unsigned long)" << endl;
    assert( hashtable != 0 );
+   inmemory = 0;
+   countonly = false;
+   sorted = false;
+   placed = NULL;
+   exact = NULL;
+   postmap = NULL;
+   postmapsize = 0;
    Reset();
 }
 
@@ -69,6 +104,12 @@ GlobalHashTable::GlobalHashTable(const unsigned long NumTokens)
 GlobalHashTable::~GlobalHashTable()
 {
    delete [] hashtable;
+   delete [] placed;
+   delete [] exact;
+   if (postmap != NULL)
+      munmap(postmap, postmapsize);
+   for (unsigned long r = 0; r < runs.size(); r++)
+      unlink(runs[r].c_str());
 }
 
 /*-------------------------- Accessors ------------------------------------*/
@@ -78,53 +119,135 @@ GlobalHashTable::~GlobalHashTable()
  * Author: seg
  * Parameters:  none
  * Purpose:     print the contents of the hash table to dict and post
- *              currently, only prints non-null entries
+ *              currently, only prints non-null entries.
+ *              The slots are cut into ranges that are formatted in
+ *              parallel into memory, a wave of one range per thread at
+ *              a time.  Each range's first posting number and its file
+ *              offsets are prefix sums over the ranges before it, so
+ *              every thread writes its text in place with pwrite and
+ *              the files are the same as printing one slot at a time.
+ *              After a spill the run files are read in slot order, so
+ *              the ranges are then formatted one at a time.
  * Returns:     nothing
 */
 void GlobalHashTable::PrintDictPost(const string DictFilename, const string PostFilename, const int NumDocs) const
 {
-   ofstream Dict;
-   ofstream Post;
-   unsigned long Start = 0;
-   
-   Dict.open(DictFilename.c_str());
-   Post.open(PostFilename.c_str());
+unsigned long NumRanges = (size + DUMP_RANGE_SLOTS - 1) / DUMP_RANGE_SLOTS;
+unsigned long NumThreads = max(1u, thread::hardware_concurrency());
+vector<unsigned long> Start(NumRanges + 1, 0);
+vector<DumpRange> Ranges(runs.empty() ? min(NumThreads, NumRanges) : 1);
+vector<RunReader> Runs;
+vector<thread> Threads;
+off_t DictOffset = 0;
+off_t PostOffset = 0;
+int DictFd;
+int PostFd = -1;
 
-   // Print out the non-zero contents of the hashtable
-   for ( unsigned long i=0; i < size; i++ )
-   {  
-      if ( !(hashtable[i].token == ""))
-      {
-          Dict << setw(DICT_TOKEN_LENGTH)  << hashtable[i].token   << " "
-               << setw(DICT_NUMBER_LENGTH) << hashtable[i].numdocs << " "
-               << setw(DICT_NUMBER_LENGTH) << Start                << endl;
-          float IDF = 1 + log((NumDocs * 1.0) / ((hashtable[i].postings).GetSize() * 1.0));
-          (hashtable[i].postings).Print(Post, IDF * 1000.0);
-           Start = Start + hashtable[i].numdocs;
-      }
-      else
+   if (sorted)
+   {
+      PrintSortedDictPost(DictFilename, PostFilename, NumDocs);
+      return;
+   }
+
+   OpenRuns(Runs);
+
+   // the postings in each range say where its dict numbering starts
+   for (unsigned long r = 0; r < NumRanges; r++)
+   {
+      Start[r + 1] = Start[r];
+      for (unsigned long i = r * DUMP_RANGE_SLOTS; i < min(size, (r + 1) * DUMP_RANGE_SLOTS); i++)
+         if (!ctrl.IsEmpty(i))
+            Start[r + 1] += hashtable[i].numdocs;
+   }
+
+   DictFd = open(DictFilename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+   if (DictFd < 0)
+      perror(DictFilename.c_str());
+   if (postmap == NULL && (PostFd = open(PostFilename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644)) < 0)
+      perror(PostFilename.c_str());
+
+   for (unsigned long First = 0; First < NumRanges; First += Ranges.size())
+   {
+      unsigned long Count = min(Ranges.size(), NumRanges - First);
+
+      for (unsigned long t = 0; t < Count; t++)
+         Threads.push_back(thread([&, t]()
+         {
+            unsigned long r = First + t;
+            FormatRange(r * DUMP_RANGE_SLOTS, min(size, (r + 1) * DUMP_RANGE_SLOTS),
+                        Start[r], NumDocs, Ranges[t].dict, Ranges[t].post, Runs);
+         }));
+      for (unsigned long t = 0; t < Count; t++)
+         Threads[t].join();
+      Threads.clear();
+
+      for (unsigned long t = 0; t < Count; t++)
       {
-         Dict << setw(DICT_TOKEN_LENGTH)  << "null" << " "
-              << setw(DICT_NUMBER_LENGTH) << "-1"   << " "
-              << setw(DICT_NUMBER_LENGTH) << "-1"   << endl;
+         Ranges[t].dictoffset = DictOffset;
+         Ranges[t].postoffset = PostOffset;
+         DictOffset += Ranges[t].dict.GetLength();
+         PostOffset += Ranges[t].post.GetLength();
       }
+
+      for (unsigned long t = 0; t < Count; t++)
+         Threads.push_back(thread([&, t]()
+         {
+            if (DictFd >= 0 && !Ranges[t].dict.WriteAt(DictFd, Ranges[t].dictoffset))
+               perror(DictFilename.c_str());
+            if (PostFd >= 0 && !Ranges[t].post.WriteAt(PostFd, Ranges[t].postoffset))
+               perror(PostFilename.c_str());
+         }));
+      for (unsigned long t = 0; t < Count; t++)
+         Threads[t].join();
+      Threads.clear();
    }
-   Dict.close();
-   Post.close();
+
+   for (unsigned long r = 0; r < Runs.size(); r++)
+      fclose(Runs[r].file);
+   if (DictFd >= 0)
+      close(DictFd);
+   if (PostFd >= 0)
+      close(PostFd);
+   if (postmap != NULL)
+      msync(postmap, postmapsize, MS_SYNC);
    cout << "Collisions: " << collisions << ", Used: " << used
         <<  ", Lookups: " << lookups << endl;
 }
 
+/* Name: Intern
+ * Parameter:
+ * 		Token : a word about to be posted for the first time
+ * Purpose: 	give the word an id in the global table's terms
+ * Return:	the term id
+*/
+unsigned int GlobalHashTable::Intern (const string_view Token)
+{
+   return terms.Intern(Token);
+}
+
 /* Name: Insert
- * Author: sgauch
  * Parameter:
  * 		Token : The target of context words to be stored
  * 		DocId: The document whose data is being inserted
  * 		TF: Total frequency count
+ * Purpose: 	intern the word, then insert it with its frequency count
+ * Return:	nothing
+*/
+void GlobalHashTable::Insert (const string_view Token, const int DocId, const float RTF)
+{
+   Insert(terms.Intern(Token), DocId, RTF);
+}
+
+/* Name: Insert
+ * Author: sgauch
+ * Parameter:
+ * 		TermId : The interned word to be stored
+ * 		DocId: The document whose data is being inserted
+ * 		TF: Total frequency count
  * Purpose: 	insert or add a word with its frequency count in hashtable
  * Return:	nothing
 */
-void GlobalHashTable::Insert (const string Token, const int DocId, const float RTF)
+void GlobalHashTable::Insert (const unsigned int TermId, const int DocId, const float RTF)
 {
 unsigned long Index;
 
@@ -132,13 +255,24 @@ unsigned long Index;
     cerr << "The global hashtable is full; cannot insert.\n";
  else
  {
-    Index = Find(Token);
+    Index = Find(TermId);
+
+    // in the second pass, every term already has its place
+    if (placed != NULL)
+    {
+       if (ctrl.IsEmpty(Index))
+          cerr << "Term " << terms.GetToken(TermId) << " changed between passes.\n";
+       else
+          Place(Index, DocId, RTF);
+       return;
+    }
 
     // If not already in the table, insert it
-    if (hashtable[Index].token == "")
+    if (ctrl.IsEmpty(Index))
     {
-       hashtable[Index].token = Token;
+       hashtable[Index].termid = TermId;
        hashtable[Index].numdocs = 1;
+       ctrl.Set(Index, terms.GetHash(TermId));
        used++;
     }
     // else do nothing
@@ -146,11 +280,303 @@ unsigned long Index;
        (hashtable[Index].numdocs)++;
 
    // finally, add docid and weight to list
-   Posting Temp(DocId, RTF);
-   (hashtable[Index].postings).AddToEnd(Temp);
+   if (!countonly)
+   {
+      Posting Temp(DocId, RTF);
+      (hashtable[Index].postings).AddToEnd(Temp);
+      inmemory++;
+   }
  }
 }
 
+/* Name: StartFirstPass
+ * Parameters:	none
+ * Purpose:	from now on, Insert only counts the documents per term
+ *		(numdocs, i.e. df) and keeps no postings
+ * Return:	nothing
+*/
+void GlobalHashTable::StartFirstPass()
+{
+   countonly = true;
+}
+
+/* Name: StartSecondPass
+ * Parameters:	PostFilename: the post file to write
+ *		NumDocs: the number of documents posted in the first
+ *			 pass, the N of the IDF
+ *		MaxDocId: the largest DocId, which is larger than NumDocs
+ *			  when near-duplicates were left out
+ * Purpose:	give each term an exactly sized run of postings, laid out
+ *		in the order PrintDictPost prints them.  If every
+ *		post line will be POST_LINE_LENGTH bytes (docids under
+ *		10000), the runs are in post itself, mapped into memory,
+ *		and Insert writes the finished lines in place; otherwise
+ *		they are one contiguous array of postings.
+ * Return:	nothing
+*/
+void GlobalHashTable::StartSecondPass(const string PostFilename, const int NumDocs, const int MaxDocId)
+{
+unsigned long Start = 0;
+vector<unsigned long> Order;
+int PostFd;
+
+   countonly = false;
+   if((placed = new PlacedList[size]) == NULL)
+      cout << "Out of memory at GlobalHashTable::StartSecondPass()" << endl;
+   assert( placed != 0 );
+
+   // the runs go in the order post is printed: by slot, or by term
+   PrintOrder(Order);
+
+   for (unsigned long k=0; k < Order.size(); k++)
+   {
+      unsigned long i = Order[k];
+      placed[i].start = Start;
+      placed[i].filled = 0;
+      // rounded exactly as PrintDictPost rounds it
+      float IDF = 1 + log((NumDocs * 1.0) / (hashtable[i].numdocs * 1.0));
+      placed[i].scale = IDF * 1000.0;
+      Start = Start + hashtable[i].numdocs;
+   }
+
+   // a DocId of 10000 or more takes a fifth digit; the weights, at most
+   // 1000 * (1 + log(NumDocs)), fit their ten places either way
+   if (MaxDocId < 10000 && Start > 0)
+   {
+      postmapsize = Start * POST_LINE_LENGTH;
+      PostFd = open(PostFilename.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+      if (PostFd < 0 || ftruncate(PostFd, postmapsize) != 0 ||
+          (postmap = (char *) mmap(NULL, postmapsize, PROT_READ | PROT_WRITE,
+                                   MAP_SHARED, PostFd, 0)) == MAP_FAILED)
+      {
+         perror(PostFilename.c_str());
+         postmap = NULL;
+      }
+      if (PostFd >= 0)
+         close(PostFd);
+   }
+
+   if (postmap == NULL)
+   {
+      if((exact = new Posting[Start]) == NULL)
+         cout << "Out of memory at GlobalHashTable::StartSecondPass()" << endl;
+      assert( exact != 0 );
+   }
+}
+
+/* Name: SortDictionary
+ * Parameters:	none
+ * Purpose:	from now on, PrintDictPost writes a sorted, front-coded
+ *		dictionary (see sorteddict.h) with post in the same term
+ *		order.  Call it before StartSecondPass.
+ * Return:	nothing
+*/
+void GlobalHashTable::SortDictionary()
+{
+   sorted = true;
+}
+
+/* Name: PrintTrie
+ * Parameters:	TrieFilename: the file to write
+ * Purpose:	save a term trie (see termtrie.h) that finds each term's
+ *		entry, with its first line in post as PrintDictPost
+ *		numbers them, for prefix, wildcard and range lookups
+ * Return:	nothing
+*/
+void GlobalHashTable::PrintTrie(const string TrieFilename) const
+{
+vector<unsigned long> Slots;
+vector<unsigned long> Starts(size, 0);
+vector<string_view> Terms;
+vector<TrieEntry> Entries;
+unsigned long Start = 0;
+TermTrie Trie;
+
+   // number the post lines in the order PrintDictPost writes them
+   SortedSlots(Slots);
+   for (unsigned long i=0; i < size; i++)
+      if (!ctrl.IsEmpty(i) && !sorted)
+      {
+         Starts[i] = Start;
+         Start = Start + hashtable[i].numdocs;
+      }
+   for (unsigned long k=0; k < Slots.size(); k++)
+   {
+      unsigned long i = Slots[k];
+      if (sorted)
+      {
+         Starts[i] = Start;
+         Start = Start + hashtable[i].numdocs;
+      }
+      Terms.push_back(terms.GetToken(hashtable[i].termid));
+      Entries.push_back(TrieEntry{hashtable[i].numdocs, Starts[i]});
+   }
+   Trie.Build(Terms, Entries);
+   if (!Trie.Write(TrieFilename))
+      perror(TrieFilename.c_str());
+}
+
+/* Name: Save
+ * Parameters:	Filename: the checkpoint file to write
+ *		NumDocs: the documents posted so far
+ * Purpose:	write a checkpoint (see below) to Filename and sync it
+ * Return:	false if the file could not be written
+*/
+bool GlobalHashTable::Save(const string Filename, const int NumDocs) const
+{
+int Fd;
+bool Written;
+
+   if ((Fd = open(Filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644)) < 0)
+      return false;
+   {
+   OutputWriter Out(Fd);
+   Written = Save(Out, NumDocs);
+   }
+   Written = (fsync(Fd) == 0) && Written;
+   return (close(Fd) == 0) && Written;
+}
+
+/* Name: Save
+ * Parameters:	Out: a writer on the checkpoint file, made by the caller
+ *		NumDocs: the documents posted so far
+ * Purpose:	write everything needed to carry on indexing after
+ *		document NumDocs: the terms in id order, then each used
+ *		slot with its term, numdocs and postings as they are in
+ *		memory.
+ *		"INVCKPT1", numdocs (4), size (8), collisions (8),
+ *		lookups (8), numterms (4), (length (4), term)*,
+ *		used (8), (slot (8), termid (4), numdocs (4), posting*)*,
+ *		"INVCKPT1" again, so a cut-off file is noticed.
+ *		It is meant to run in a forked child, so it allocates
+ *		nothing and only fills Out's buffer and writes it.
+ * Return:	false if the table cannot be saved or a write failed
+*/
+bool GlobalHashTable::Save(OutputWriter &Out, const int NumDocs) const
+{
+unsigned int NumTerms = terms.GetNumTerms();
+
+   if (countonly || placed != NULL || !runs.empty())
+      return false;
+
+   auto PutRaw = [&](const void *Data, const unsigned long Length)
+   {
+      Out.Put(string_view((const char *) Data, Length));
+   };
+
+   Out.Put(string_view(CHECKPOINT_MAGIC, CHECKPOINT_MAGIC_LENGTH));
+   PutRaw(&NumDocs, 4);
+   PutRaw(&size, 8);
+   PutRaw(&collisions, 8);
+   PutRaw(&lookups, 8);
+   PutRaw(&NumTerms, 4);
+   for (unsigned int t = 0; t < NumTerms; t++)
+   {
+      string_view Token = terms.GetToken(t);
+      unsigned int Length = Token.length();
+      PutRaw(&Length, 4);
+      Out.Put(Token);
+   }
+   PutRaw(&used, 8);
+   for (unsigned long i = 0; i < size; i++)
+      if (!ctrl.IsEmpty(i))
+      {
+         PutRaw(&i, 8);
+         PutRaw(&hashtable[i].termid, 4);
+         PutRaw(&hashtable[i].numdocs, 4);
+         hashtable[i].postings.WriteItems(Out);
+      }
+   Out.Put(string_view(CHECKPOINT_MAGIC, CHECKPOINT_MAGIC_LENGTH));
+   return Out.Flush();
+}
+
+/* Name: Load
+ * Parameters:	Filename: a checkpoint written by Save
+ *		NumDocs: receives the documents it covers
+ * Purpose:	fill an empty table, and its empty term table, from a
+ *		checkpoint, every term getting its old id and every word
+ *		its old slot, so the run goes on as if never stopped
+ * Return:	false if the file is missing, cut off or for a table of
+ *		another size
+*/
+bool GlobalHashTable::Load(const string Filename, int &NumDocs)
+{
+ifstream In(Filename.c_str(), ios::binary);
+char Magic[CHECKPOINT_MAGIC_LENGTH];
+string Token;
+vector<Posting> Postings;
+unsigned long Length;
+unsigned long Size;
+unsigned long Used;
+unsigned int NumTerms;
+bool Ok = true;
+
+   if (!In.is_open() || used != 0 || terms.GetNumTerms() != 0)
+      return false;
+
+   // read a piece at a time; only one term or one list is held at once
+   auto GetRaw = [&](void *Value, const unsigned long Bytes)
+   {
+      if (Ok && !In.read((char *) Value, Bytes))
+         Ok = false;
+   };
+
+   // a whole checkpoint ends with the magic too
+   In.seekg(0, ios::end);
+   Length = In.tellg();
+   if (!In || Length < 2 * CHECKPOINT_MAGIC_LENGTH)
+      return false;
+   In.seekg(Length - CHECKPOINT_MAGIC_LENGTH);
+   GetRaw(Magic, CHECKPOINT_MAGIC_LENGTH);
+   if (!Ok || memcmp(Magic, CHECKPOINT_MAGIC, CHECKPOINT_MAGIC_LENGTH) != 0)
+      return false;
+   In.seekg(0);
+   GetRaw(Magic, CHECKPOINT_MAGIC_LENGTH);
+   if (!Ok || memcmp(Magic, CHECKPOINT_MAGIC, CHECKPOINT_MAGIC_LENGTH) != 0)
+      return false;
+
+   GetRaw(&NumDocs, 4);
+   GetRaw(&Size, 8);
+   if (!Ok || Size != size)
+      return false;
+   GetRaw(&collisions, 8);
+   GetRaw(&lookups, 8);
+   GetRaw(&NumTerms, 4);
+   for (unsigned int t = 0; Ok && t < NumTerms; t++)
+   {
+      unsigned int TermLength = 0;
+      GetRaw(&TermLength, 4);
+      if (!Ok || TermLength > Length)
+         return false;
+      Token.resize(TermLength);
+      GetRaw(&Token[0], TermLength);
+      if (Ok)
+         terms.Intern(Token);
+   }
+   GetRaw(&Used, 8);
+
+   for (unsigned long k = 0; Ok && k < Used; k++)
+   {
+      unsigned long Index = size;
+      GetRaw(&Index, 8);
+      if (!Ok || Index >= size)
+         return false;
+      GetRaw(&hashtable[Index].termid, 4);
+      GetRaw(&hashtable[Index].numdocs, 4);
+      if (!Ok || hashtable[Index].termid >= NumTerms || hashtable[Index].numdocs < 0 ||
+          (unsigned long) hashtable[Index].numdocs * sizeof(Posting) > Length)
+         return false;
+      ctrl.Set(Index, terms.GetHash(hashtable[Index].termid));
+      Postings.resize(hashtable[Index].numdocs);
+      GetRaw(Postings.data(), Postings.size() * sizeof(Posting));
+      for (unsigned long d = 0; Ok && d < Postings.size(); d++)
+         hashtable[Index].postings.AddToEnd(Postings[d]);
+      inmemory += Postings.size();
+      used++;
+   }
+   return Ok && (unsigned long) In.tellg() + CHECKPOINT_MAGIC_LENGTH == Length;
+}
+
 /* Name: GetUsage
  * Author: S. Gauch
  * Parameters:	None
@@ -164,40 +590,329 @@ void GlobalHashTable::GetUsage(int &Used, int &Collisions, int &Lookups) const
    Lookups = lookups;
 }
 
+/* Name: GetMemory
+ * Parameters:	Slots: receives the bytes of the slots and control bytes
+ *		Postings: receives the bytes of the posting list nodes,
+ *		as the heap hands them out
+ * Purpose:	account for the table's memory
+ * Return:	nothing
+*/
+void GlobalHashTable::GetMemory(unsigned long &Slots, unsigned long &Postings) const
+{
+   Slots = size * (sizeof(TermIntList) + 1);
+   Postings = inmemory * List<Posting>::GetNodeBytes();
+}
+
+/* Name: Spill
+ * Parameters:	Filename: the run file to write
+ * Purpose:	write every posting held in memory to a run file and
+ *		free the lists; numdocs stays, so dict is unchanged.
+ *		The lists go in the order post is printed, as
+ *		(slot (8), count (4), posting*)*, so the print can read
+ *		every run alongside the table.
+ * Return:	false if the file could not be written (the postings
+ *		then stay in memory)
+*/
+bool GlobalHashTable::Spill(const string Filename)
+{
+vector<unsigned long> Order;
+int Fd;
+bool Written;
+
+   if (countonly || placed != NULL)
+      return false;
+   if ((Fd = open(Filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644)) < 0)
+   {
+      perror(Filename.c_str());
+      return false;
+   }
+
+   PrintOrder(Order);
+   {
+   OutputWriter Out(Fd);
+   for (unsigned long k = 0; k < Order.size(); k++)
+   {
+      unsigned long i = Order[k];
+      unsigned int Count = hashtable[i].postings.GetSize();
+      if (Count == 0)
+         continue;
+      Out.Put(string_view((const char *) &i, 8));
+      Out.Put(string_view((const char *) &Count, 4));
+      hashtable[i].postings.WriteItems(Out);
+   }
+   Written = Out.Flush();
+   }
+
+   if (close(Fd) != 0 || !Written)
+   {
+      perror(Filename.c_str());
+      unlink(Filename.c_str());
+      return false;
+   }
+   for (unsigned long k = 0; k < Order.size(); k++)
+      hashtable[Order[k]].postings.Clear();
+   inmemory = 0;
+   runs.push_back(Filename);
+   return true;
+}
+
+unsigned int GlobalHashTable::GetNumRuns() const
+{
+   return runs.size();
+}
+
 /*-------------------------- Private Functions ----------------------------*/
-/* Name:  Find
- * Author: seg
- * Parameters:  token: the word to be located
- * Purpose:     return the index of the word in the table, or
- *              the index of the free space in which to store the word
- * Returns:     index of the word's actual or desired location
+/* Name:  Place
+ * Parameters:  Index: the term's slot
+ *              DocId: The document whose data is being inserted
+ *              RTF: the term's relative frequency in that document
+ * Purpose:     second pass: store the posting in the term's next place
+ * Returns:     nothing
 */
-unsigned long GlobalHashTable::Find (const string Token) 
+void GlobalHashTable::Place (const unsigned long Index, const int DocId, const float RTF)
 {
-unsigned long hash = 0;
-unsigned long Index;
+PlacedList &Where = placed[Index];
+char Line[64];
+Posting Temp(DocId, RTF);
+
+   if (Where.filled >= hashtable[Index].numdocs)
+   {
+      cerr << "Term " << terms.GetToken(hashtable[Index].termid)
+           << " changed between passes.\n";
+      return;
+   }
+
+   if (postmap != NULL)
+   {
+      Temp.Format(Line, sizeof(Line), Where.scale);
+      memcpy(postmap + (Where.start + Where.filled) * POST_LINE_LENGTH, Line, POST_LINE_LENGTH);
+   }
+   else
+      exact[Where.start + Where.filled] = Temp;
+   Where.filled++;
+}
 
-   if (Token.size() != 0)
-      // add all the characters of the key together
-      for (int i=0; i < Token.length(); i++) {
-         //Sum = (Sum * 19) + Token[i];  // Mult sum by 19, add byte value of char
-         hash = ((hash<<5)-hash) + Token[i];
-	 hash = hash & hash;
+
+/* Name:  PrintSortedDictPost
+ * Parameters:  DictFilename, PostFilename: the files to write
+ *              NumDocs: the number of documents, for IDF
+ * Purpose:     write the terms in byte order as a front-coded
+ *              dictionary, and their postings to post in that order
+ * Returns:     nothing
+*/
+void GlobalHashTable::PrintSortedDictPost(const string DictFilename, const string PostFilename, const int NumDocs) const
+{
+vector<unsigned long> Slots;
+SortedDictWriter Dict(DictFilename);
+vector<RunReader> Runs;
+int PostFd = -1;
+
+   SortedSlots(Slots);
+   OpenRuns(Runs);
+   if (postmap == NULL && (PostFd = open(PostFilename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644)) < 0)
+      perror(PostFilename.c_str());
+
+   if (PostFd >= 0 || postmap != NULL)
+   {
+   OutputWriter Post(PostFd);
+
+   for (unsigned long k=0; k < Slots.size(); k++)
+   {
+      unsigned long i = Slots[k];
+      Dict.Add(terms.GetToken(hashtable[i].termid), hashtable[i].numdocs);
+      if (placed == NULL)
+      {
+         float IDF = 1 + log((NumDocs * 1.0) / (hashtable[i].numdocs * 1.0));
+         WriteRuns(i, Runs, Post, IDF * 1000.0);
+         (hashtable[i].postings).Write(Post, IDF * 1000.0);
       }
+      else
+      {
+         // two-pass: the postings are already grouped, or already in post
+         if (placed[i].filled != hashtable[i].numdocs)
+            cerr << "Term " << terms.GetToken(hashtable[i].termid)
+                 << " changed between passes.\n";
+         if (postmap == NULL)
+            for (int j=0; j < placed[i].filled; j++)
+               exact[placed[i].start + j].Write(Post, placed[i].scale);
+      }
+   }
+   }   // the writer flushes here
 
-   Index = hash % size;
+   for (unsigned long r = 0; r < Runs.size(); r++)
+      fclose(Runs[r].file);
+   if (!Dict.Close())
+      perror(DictFilename.c_str());
+   if (PostFd >= 0)
+      close(PostFd);
+   if (postmap != NULL)
+      msync(postmap, postmapsize, MS_SYNC);
+   cout << "Collisions: " << collisions << ", Used: " << used
+        <<  ", Lookups: " << lookups << endl;
+}
+
+/* Name:  SortedSlots
+ * Parameters:  Slots: receives the used slots
+ * Purpose:     list the used slots in byte order of their terms
+ * Returns:     nothing
+*/
+void GlobalHashTable::SortedSlots(vector<unsigned long> &Slots) const
+{
+   Slots.clear();
+   for (unsigned long i=0; i < size; i++)
+      if (!ctrl.IsEmpty(i))
+         Slots.push_back(i);
+   sort(Slots.begin(), Slots.end(), [&](unsigned long a, unsigned long b)
+   {
+      return terms.GetToken(hashtable[a].termid) < terms.GetToken(hashtable[b].termid);
+   });
+}
+
+/* Name:  PrintOrder
+ * Parameters:  Slots: receives the used slots
+ * Purpose:     list the used slots in the order post is printed: by
+ *              slot, or by term
+ * Returns:     nothing
+*/
+void GlobalHashTable::PrintOrder(vector<unsigned long> &Slots) const
+{
+   if (sorted)
+      SortedSlots(Slots);
+   else
+   {
+      Slots.clear();
+      for (unsigned long i=0; i < size; i++)
+         if (!ctrl.IsEmpty(i))
+            Slots.push_back(i);
+   }
+}
 
-   // Check to see if word is in that location
-   // If not there, do linear probing until word found
-   // or empty location found.
-   while (((hashtable[Index].token) != Token) &&
-          ((hashtable[Index].token) != "") ) 
+/* Name:  OpenRuns
+ * Parameters:  Runs: receives a reader on each run file, oldest first
+ * Purpose:     open the runs written by Spill for printing
+ * Returns:     nothing
+*/
+void GlobalHashTable::OpenRuns(vector<RunReader> &Runs) const
+{
+   for (unsigned long r = 0; r < runs.size(); r++)
    {
-      Index = (Index+1) % size;
-      collisions++;
+      RunReader Run;
+      if ((Run.file = fopen(runs[r].c_str(), "r")) == NULL)
+      {
+         perror(runs[r].c_str());
+         continue;
+      }
+      NextRunList(Run);
+      Runs.push_back(Run);
+   }
+}
+
+// Read the slot and count of a run's next list; slot is size at the end
+void GlobalHashTable::NextRunList(RunReader &Run) const
+{
+   if (fread(&Run.slot, 8, 1, Run.file) != 1 || fread(&Run.count, 4, 1, Run.file) != 1)
+      Run.slot = size;
+}
+
+/* Name:  WriteRuns
+ * Parameters:  Index: the slot being printed
+ *              Runs: the run readers, oldest first
+ *              Post: receives the postings
+ *              IDF: the weight scale, as for the list in memory
+ * Purpose:     print the slot's spilled postings, which come before
+ *              the ones still in memory, and move on each run that had
+ *              some
+ * Returns:     nothing
+*/
+void GlobalHashTable::WriteRuns(const unsigned long Index, vector<RunReader> &Runs, OutputWriter &Post,
+                                const float IDF) const
+{
+Posting Temp;
+
+   for (unsigned long r = 0; r < Runs.size(); r++)
+      if (Runs[r].slot == Index)
+      {
+         for (unsigned int k = 0; k < Runs[r].count; k++)
+            if (fread(&Temp, sizeof(Posting), 1, Runs[r].file) == 1)
+               Temp.Write(Post, IDF);
+         NextRunList(Runs[r]);
+      }
+}
+
+/* Name:  FormatRange
+ * Parameters:  First, Last: the slots to format, First up to Last
+ *              Start: the number of postings before slot First
+ *              NumDocs: the number of documents, for IDF
+ *              Dict, Post: receive the text for dict and post
+ *              Runs: the spilled runs, read in slot order, or none
+ * Purpose:     format part of the table exactly as the dict and post
+ *              lines have always been printed.  Nothing is added to
+ *              Post if post was written during a second pass.
+ * Returns:     nothing
+*/
+void GlobalHashTable::FormatRange(const unsigned long First, const unsigned long Last, unsigned long Start,
+                                  const int NumDocs, OutputWriter &Dict, OutputWriter &Post,
+                                  vector<RunReader> &Runs) const
+{
+   Dict.Clear();
+   Post.Clear();
+   for ( unsigned long i=First; i < Last; i++ )
+   {  
+      if ( !ctrl.IsEmpty(i))
+      {
+          Dict.PutRight(terms.GetToken(hashtable[i].termid), DICT_TOKEN_LENGTH);
+          Dict.Put(' ');
+          Dict.PutInt(hashtable[i].numdocs, DICT_NUMBER_LENGTH);
+          Dict.Put(' ');
+          Dict.PutInt(Start, DICT_NUMBER_LENGTH);
+          Dict.Put('\n');
+
+          if (placed == NULL)
+          {
+             // numdocs is the length of the postings list
+             float IDF = 1 + log((NumDocs * 1.0) / (hashtable[i].numdocs * 1.0));
+             WriteRuns(i, Runs, Post, IDF * 1000.0);
+             (hashtable[i].postings).Write(Post, IDF * 1000.0);
+          }
+          else
+          {
+             // two-pass: the postings are already grouped, or already in post
+             if (placed[i].filled != hashtable[i].numdocs)
+                cerr << "Term " << terms.GetToken(hashtable[i].termid)
+                     << " changed between passes.\n";
+             if (postmap == NULL)
+                for (int k=0; k < placed[i].filled; k++)
+                   exact[Start + k].Write(Post, placed[i].scale);
+          }
+           Start = Start + hashtable[i].numdocs;
+      }
+      else
+      {
+         Dict.PutRight("null", DICT_TOKEN_LENGTH);
+         Dict.Put(' ');
+         Dict.PutRight("-1", DICT_NUMBER_LENGTH);
+         Dict.Put(' ');
+         Dict.PutRight("-1", DICT_NUMBER_LENGTH);
+         Dict.Put('\n');
+      }
    }
-   
-   return Index;
+}
+
+/* Name:  Find
+ * Author: seg
+ * Parameters:  TermId: the interned word to be located
+ * Purpose:     return the index of the word in the table, or
+ *              the index of the free space in which to store the word
+ * Returns:     index of the word's actual or desired location
+*/
+unsigned long GlobalHashTable::Find (const unsigned int TermId) 
+{
+   // Linear probing from the word's stored hash (so the dict layout
+   // is the same as hashing the string), 16 control bytes at a time;
+   // ids are only compared when the 7-bit tag matches.
+   return ctrl.Find(terms.GetHash(TermId),
+                    [&](unsigned long Index) { return hashtable[Index].termid == TermId; },
+                    collisions);
 }
 
 // Make hashtable empty
@@ -210,7 +925,8 @@ void GlobalHashTable::Reset()
 
    for (unsigned long i=0; i < size; i++)
    {
-      hashtable[i].token = "";
+      hashtable[i].termid = TERM_NONE;
       hashtable[i].numdocs = 0;
    }
+   ctrl.Reset();
 }
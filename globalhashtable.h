@@ -2,36 +2,107 @@
  * Author:    Susan Gauch
  * Date:      10/15/14
  * Purpose:   The header file for a hash table of string + int + list. 
+ *            Terms are keyed by their TermTable id; the strings are
+ *            only looked up again when the dictionary is printed.
+ *            For two-pass indexing the first pass only counts numdocs;
+ *            the second writes each posting into an exactly sized
+ *            region for its term (in memory, or straight into post).
+ *            Normally dict is in slot order; SortDictionary switches to
+ *            a front-coded dictionary in term order, post to match.
+ *            Save and Load checkpoint the table (with the terms) so a
+ *            long run can be resumed.
+ *            Spill writes every list held in memory to a run file, in
+ *            the order post is printed, and empties the lists; the
+ *            print then appends each term's runs, oldest first, before
+ *            what is still in memory, so post comes out the same.
 */
 
+#ifndef GLOBALHASHTABLE_H
+#define GLOBALHASHTABLE_H
+
 #include "posting.h"
+#include "outputwriter.h"
 #include "template_taillist.h"
+#include "controlbytes.h"
+#include "termtable.h"
 #include <math.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+#define CHECKPOINT_MAGIC "INVCKPT1"
+#define CHECKPOINT_MAGIC_LENGTH 8
 
 using namespace std;
 
 class GlobalHashTable {
 public:
    GlobalHashTable (const GlobalHashTable& ht );       // constructor for a copy
-   GlobalHashTable(const unsigned long NumTokens);          // constructor of hashtable 
+   GlobalHashTable(const unsigned long NumTokens, TermTable &Terms); // constructor of hashtable 
    ~GlobalHashTable();                           // destructor
    void PrintDictPost (const string DictFilename, const string PostFilename, const int NumDocs) const;       
-   void Insert (const string Token, const int DocId, const float RTF); 
+   unsigned int Intern (const string_view Token);   // the id of Token in the table's terms
+   void Insert (const string_view Token, const int DocId, const float RTF); 
+   void Insert (const unsigned int TermId, const int DocId, const float RTF); 
    void Reset ();  // Clear out the hashtable data
+   void StartFirstPass ();   // count numdocs only, keep no postings
+   void StartSecondPass (const string PostFilename, const int NumDocs, const int MaxDocId);
+   void SortDictionary ();   // print a sorted, front-coded dict instead
+   void PrintTrie (const string TrieFilename) const;
+   bool Save (const string Filename, const int NumDocs) const;   // a checkpoint
+   bool Save (OutputWriter &Out, const int NumDocs) const;      // allocates nothing
+   bool Load (const string Filename, int &NumDocs);
    void GetUsage (int &Used, int &Collisions, int &Lookups) const;
+   void GetMemory (unsigned long &Slots, unsigned long &Postings) const;   // bytes held
+   bool Spill (const string Filename);   // move the postings to a run file
+   unsigned int GetNumRuns () const;
 protected:
-   struct StringIntList // the datatype stored in the hashtable
+   struct TermIntList // the datatype stored in the hashtable
    {
-      string token;
+      unsigned int termid;
       int numdocs;
       List <Posting> postings;
    };
-   unsigned long Find (const string Token); // the index of the token in the hashtable
+   struct PlacedList // where a term's postings go in the second pass
+   {
+      unsigned long start;          // the term's first line in post
+      int filled;                   // postings placed so far
+      float scale;                  // IDF * 1000, for writing post directly
+   };
+   struct RunReader // a run file being read back while printing
+   {
+      FILE *file;
+      unsigned long slot;           // the next slot it has postings for
+      unsigned int count;           // and how many
+   };
+   unsigned long Find (const unsigned int TermId); // the index of the token in the hashtable
+   void Place (const unsigned long Index, const int DocId, const float RTF);
+   void FormatRange (const unsigned long First, const unsigned long Last, unsigned long Start,
+                     const int NumDocs, OutputWriter &Dict, OutputWriter &Post,
+                     vector<RunReader> &Runs) const;
+   void PrintSortedDictPost (const string DictFilename, const string PostFilename, const int NumDocs) const;
+   void SortedSlots (vector<unsigned long> &Slots) const;
+   void PrintOrder (vector<unsigned long> &Slots) const;
+   void OpenRuns (vector<RunReader> &Runs) const;
+   void NextRunList (RunReader &Run) const;
+   void WriteRuns (const unsigned long Index, vector<RunReader> &Runs, OutputWriter &Post,
+                   const float IDF) const;
 private:
-   StringIntList *hashtable;        // the hashtable array itself
+   TermIntList *hashtable;          // the hashtable array itself
+   ControlBytes ctrl;               // one hash tag per slot, for probing
+   TermTable &terms;                // the strings and hashes behind the ids
    unsigned long size;              // the hashtable size
+   bool countonly;                  // in the first of two passes
+   bool sorted;                     // dict and post in term order
+   PlacedList *placed;              // per slot, in the second pass
+   Posting *exact;                  // every posting, grouped by term
+   char *postmap;                   // post, mapped, if lines are fixed width
+   unsigned long postmapsize;
+   unsigned long inmemory;          // postings in the lists
+   vector<string> runs;             // the run files, oldest first
    unsigned long used;
    unsigned long collisions;
    unsigned long lookups;
 };
 
+#endif
@@ -5,6 +5,8 @@ string  * Date:      2/11/2010
 */
 
 #include <assert.h>
+#include <algorithm>
+#include <math.h>
 #include <iostream>
 #include <fstream>
 
@@ -24,35 +26,49 @@ using namespace std;
  *              by call-by-value parameter passing
  * Returns:     nothing
 */
-HashTable::HashTable( const HashTable &ht )
+HashTable::HashTable( const HashTable &ht ) : ctrl(ht.ctrl), terms(ht.terms), global(ht.global)
 {
    size = ht.size;                    // set the size of the array
-   if((hashtable = new StringIntPair[size]) == NULL)
+   basesize = ht.basesize;
+   if((hashtable = new TermIntPair[size]) == NULL)
        cout << "Out of memory at HashTable::HashTable(const HashTable)" << endl;
    assert( hashtable != 0 );
+   if((occupied = new unsigned long[size]) == NULL)
+       cout << "Out of memory at HashTable::HashTable(const HashTable)" << endl;
+   assert( occupied != 0 );
 
    for (unsigned long i=0; i < size; i++)     // make a _copy_ of the array elements
    {
-      hashtable[i].key = ht.hashtable[i].key;
+      hashtable[i].termid = ht.hashtable[i].termid;
       hashtable[i].data = ht.hashtable[i].data;
    }
-   
+   used = ht.used;
+   collisions = ht.collisions;
+   lookups = ht.lookups;
+   for (unsigned long i=0; i < used; i++)
+      occupied[i] = ht.occupied[i];
 }
            
 /* Name:  HashTable
  * Author: seg
- * Parameters:  none
+ * Parameters:  NumKeys: the number of keys expected
+ *              Terms: the term table that interns the keys
  * Purpose:     allocate a hashtable for an expected number of keys
  *              initializes all values to null (0)
  * Returns:     pointer to the created HashTable or 0 if out of memory
 */
-HashTable::HashTable(const unsigned long NumKeys)
+HashTable::HashTable(const unsigned long NumKeys, TermTable &Terms) : ctrl(NumKeys * 3), terms(Terms)
 {
    // allocate space for the table, init to null key
    size = NumKeys * 3;   // we want the hash table to be 2/3 empty
-   if((hashtable = new StringIntPair[size]) == NULL)
+   basesize = size;
+   if((hashtable = new TermIntPair[size]) == NULL)
       cout << "Out of memory at HashTable::HashTable(unsigned long)" << endl;
    assert( hashtable != 0 );
+   if((occupied = new unsigned long[size]) == NULL)
+      cout << "Out of memory at HashTable::HashTable(unsigned long)" << endl;
+   assert( occupied != 0 );
+   used = 0;
    Reset();
 }
 
@@ -65,6 +81,7 @@ HashTable::HashTable(const unsigned long NumKeys)
 HashTable::~HashTable()
 {
    delete [] hashtable;
+   delete [] occupied;
 }
 
 /*-------------------------- Accessors ------------------------------------*/
@@ -77,16 +94,17 @@ HashTable::~HashTable()
  *              currently, only prints non-null entries
  * Returns:     nothing
 */
-void HashTable::Print(const char *filename) const
+void HashTable::Print(const char *filename)
 {
    ofstream fpout(filename); 
 
    // Print out the non-zero contents of the hashtable
-   for ( unsigned long i=0; i < size; i++ )
+   SortOccupied();
+   for ( unsigned long k=0; k < used; k++ )
    {  
-      if ( !(hashtable[i].key == ""))
-          fpout << hashtable[i].key << " "
-                << hashtable[i].data << endl;
+      unsigned long i = occupied[k];
+      fpout << terms.GetToken(hashtable[i].termid) << " "
+            << hashtable[i].data << endl;
    }
    fpout.close();
    cout << "Collisions: " << collisions << ", Used: " << used
@@ -100,27 +118,44 @@ void HashTable::Print(const char *filename) const
  * Purpose: Add a word to the hashtable, increment counter
  * Return:	nothing
 */
-void HashTable::Insert (const string Key)
+void HashTable::Insert (const string_view Key)
+{
+   Insert(terms.Intern(Key));
+}
+
+/* Name: Insert
+ * Parameter:
+ * 		TermId : The interned word to be counted
+ * Purpose: Add a word to the hashtable, increment counter
+ * Return:	nothing
+*/
+void HashTable::Insert (const unsigned int TermId)
 {
 unsigned long Index;
 
- if (used >= size)
-    cerr << "The hashtable is full; cannot insert.\n";
- else
- {
-    Index = Find(Key);
-
-    // If not already in the table, insert it
-    if (hashtable[Index].key == "")
-    {
-       hashtable[Index].key = Key;
-       hashtable[Index].data = 1;
-       used++;
-    }
-    // else increment count
-    else
-       (hashtable[Index].data)++;
- }
+   Index = Find(TermId);
+
+   // If not already in the table, insert it
+   if (ctrl.IsEmpty(Index))
+   {
+      // an unusually large document.  The table grows only when this
+      // word would take its last empty slot (a probe needs one to
+      // stop), so the words sit where the fixed-size table put them
+      // and reach the global table in the same order.
+      if (used + 1 >= size)
+      {
+         Grow();
+         Index = Find(TermId);
+      }
+      hashtable[Index].termid = TermId;
+      hashtable[Index].data = 1;
+      ctrl.Set(Index, terms.GetHash(TermId));
+      occupied[used] = Index;
+      used++;
+   }
+   // else increment count
+   else
+      (hashtable[Index].data)++;
 }
 /* Name: Insert
  * Author: sgauch
@@ -130,25 +165,43 @@ unsigned long Index;
  * Purpose: 	insert or add a word with its frequency count in hashtable
  * Return:	nothing
 */
-void HashTable::Insert (const string Key, const int Data)
+void HashTable::Insert (const string_view Key, const int Data)
+{
+   Insert(terms.Intern(Key), Data);
+}
+
+/* Name: Insert
+ * Parameter:
+ * 		TermId : The interned word to be stored
+ * 		frequency: Total frequency count
+ * Purpose: 	insert or add a word with its frequency count in hashtable
+ * Return:	nothing
+*/
+void HashTable::Insert (const unsigned int TermId, const int Data)
 {
 unsigned long Index;
 
- if (used >= size)
-    cerr << "The hashtable is full; cannot insert.\n";
- else
- {
-    Index = Find(Key);
-
-    // If not already in the table, insert it
-    if (hashtable[Index].key == "")
-    {
-       hashtable[Index].key = Key;
-       hashtable[Index].data = Data;
-       used++;
-    }
-    // else do nothing
- }
+   Index = Find(TermId);
+
+   // If not already in the table, insert it
+   if (ctrl.IsEmpty(Index))
+   {
+      // an unusually large document.  The table grows only when this
+      // word would take its last empty slot (a probe needs one to
+      // stop), so the words sit where the fixed-size table put them
+      // and reach the global table in the same order.
+      if (used + 1 >= size)
+      {
+         Grow();
+         Index = Find(TermId);
+      }
+      hashtable[Index].termid = TermId;
+      hashtable[Index].data = Data;
+      ctrl.Set(Index, terms.GetHash(TermId));
+      occupied[used] = Index;
+      used++;
+   }
+   // else do nothing
 }
 
 /* Name: GetData
@@ -157,18 +210,69 @@ unsigned long Index;
  * Purpose:	return the data or -1 if Key is not found
  * Return:	return an int 
 */
-int HashTable::GetData(const string Key)
+int HashTable::GetData(const string_view Key)
+{
+unsigned int TermId = terms.Find(Key);
+
+ // a word that was never interned cannot be in any table
+ if (TermId == TERM_NONE)
+ {
+    lookups++; 
+    return -1;
+ }
+ return GetData(TermId);
+}
+
+/* Name: GetData
+ * Parameters:	TermId: the interned word
+ * Purpose:	return the data or -1 if TermId is not found
+ * Return:	return an int 
+*/
+int HashTable::GetData(const unsigned int TermId)
 {
 unsigned long Index;
 
  lookups++; 
- Index = Find(Key);
- if (hashtable[Index].key == "")
+ Index = Find(TermId);
+ if (ctrl.IsEmpty(Index))
     return -1;
  else   
     return (hashtable[Index].data);
 }
 
+/* Name: SimHash
+ * Parameters:	None
+ * Purpose:	the 64-bit SimHash of the counts: bit b is set if the
+ *		words whose (mixed) hash has bit b set outweigh those where
+ *		it is clear, each word weighing 1 + log(count) so that a
+ *		few very common words do not decide every bit.  Documents
+ *		that share most of their words get signatures a few bits
+ *		apart.
+ * Return:	the signature
+*/
+unsigned long HashTable::SimHash() const
+{
+double Sums[64] = {0};
+unsigned long Signature = 0;
+
+   for ( unsigned long k=0; k < used; k++ )
+   {
+      unsigned long i = occupied[k];
+      double Weight = 1 + log(hashtable[i].data * 1.0);
+      // the string hash is weak in the high bits; spread it (splitmix64)
+      unsigned long Hash = terms.GetHash(hashtable[i].termid) + 0x9e3779b97f4a7c15UL;
+      Hash = (Hash ^ (Hash >> 30)) * 0xbf58476d1ce4e5b9UL;
+      Hash = (Hash ^ (Hash >> 27)) * 0x94d049bb133111ebUL;
+      Hash = Hash ^ (Hash >> 31);
+      for (int b = 0; b < 64; b++)
+         Sums[b] += ((Hash >> b) & 1) ? Weight : -Weight;
+   }
+   for (int b = 0; b < 64; b++)
+      if (Sums[b] > 0)
+         Signature |= 1UL << b;
+   return Signature;
+}
+
 /* Name: GetUsage
  * Author: S. Gauch
  * Parameters:	None
@@ -182,74 +286,208 @@ void HashTable::GetUsage(int &Used, int &Collisions, int &Lookups) const
    Lookups = lookups;
 }
 
+/* Name:  GetMemory
+ * Parameters:  none
+ * Purpose:     add up the slots, their control bytes and the list of
+ *              used slots, at the table's present size
+ * Returns:     the bytes held
+*/
+unsigned long HashTable::GetMemory() const
+{
+   return size * (sizeof(TermIntPair) + sizeof(unsigned long) + 1);
+}
 
 /*-------------------------- Private Functions ----------------------------*/
 /* Name:  Find
  * Author: seg
- * Parameters:  key: the word to be located
+ * Parameters:  TermId: the interned word to be located
  * Purpose:     return the index of the word in the table, or
  *              the index of the free space in which to store the word
  * Returns:     index of the word's actual or desired location
 */
-unsigned long HashTable::Find (const string Key) 
+unsigned long HashTable::Find (const unsigned int TermId) 
 {
-unsigned long hash = 0;
-unsigned long Index;
+   // Linear probing from the word's stored hash, 16 control bytes
+   // at a time; ids are only compared when the 7-bit tag matches.
+   return ctrl.Find(terms.GetHash(TermId),
+                    [&](unsigned long Index) { return hashtable[Index].termid == TermId; },
+                    collisions);
+}
 
-   if (Key.size() != 0)
-      // add all the characters of the key together
-      for (int i=0; i < Key.length(); i++) {
-         //Sum = (Sum * 19) + Key[i];  // Mult sum by 19, add byte value of char
-         hash = ((hash<<5)-hash) + Key[i];
-	 hash = hash & hash;
-      }
+/* Name:  Grow
+ * Parameters:  none
+ * Purpose:     double the table for a document with more distinct
+ *              words than expected, moving only the occupied slots
+ * Returns:     nothing
+*/
+void HashTable::Grow()
+{
+TermIntPair *OldTable = hashtable;
+unsigned long *OldOccupied = occupied;
+unsigned long Rehashed = 0;
+unsigned long Index;
 
-   Index = hash % size;
+   size = size * 2;
+   if((hashtable = new TermIntPair[size]) == NULL)
+      cout << "Out of memory at HashTable::Grow()" << endl;
+   assert( hashtable != 0 );
+   if((occupied = new unsigned long[size]) == NULL)
+      cout << "Out of memory at HashTable::Grow()" << endl;
+   assert( occupied != 0 );
+   ctrl.Resize(size);
 
-   // Check to see if word is in that location
-   // If not there, do linear probing until word found
-   // or empty location found.
-   while (((hashtable[Index].key) != Key) &&
-          ((hashtable[Index].key) != "") ) 
+   // the keys are distinct, so each goes into the first free slot
+   for (unsigned long k=0; k < used; k++)
    {
-      Index = (Index+1) % size;
-      collisions++;
+      TermIntPair Entry = OldTable[OldOccupied[k]];
+      unsigned long Hash = terms.GetHash(Entry.termid);
+      Index = ctrl.Find(Hash, [](unsigned long) { return false; }, Rehashed);
+      hashtable[Index] = Entry;
+      ctrl.Set(Index, Hash);
+      occupied[k] = Index;
    }
-   
-   return Index;
+   delete [] OldTable;
+   delete [] OldOccupied;
 }
 
-// Make hashtable empty
+/* Name:  Reset
+ * Parameters:  none
+ * Purpose:     make the hashtable empty, in time proportional to the
+ *              number of words it holds.  A table that grew for a large
+ *              document goes back to its original size.
+ * Returns:     nothing
+*/
 void HashTable::Reset()
 {
+   if (size != basesize)
+   {
+      size = basesize;
+      delete [] hashtable;
+      delete [] occupied;
+      if((hashtable = new TermIntPair[size]) == NULL)
+         cout << "Out of memory at HashTable::Reset()" << endl;
+      assert( hashtable != 0 );
+      if((occupied = new unsigned long[size]) == NULL)
+         cout << "Out of memory at HashTable::Reset()" << endl;
+      assert( occupied != 0 );
+      ctrl.Resize(size);
+   }
+   else
+   {
+      // only the control bytes say whether a slot is in use
+      for (unsigned long k=0; k < used; k++)
+         ctrl.Clear(occupied[k]);
+   }
+
    // initialize the hashtable
    used = 0;
    collisions = 0;
    lookups = 0;
-
-   for (unsigned long i=0; i < size; i++)
-   {
-      hashtable[i].key = "";
-      hashtable[i].data = 0;
-   }
 }
 
 /* Name:  TransferData
  * Author: seg
  * Parameters:  DocId - the document currently being processed 
  *              GlobalHT - the global ht to receive the data
- * Purpose:     copy the data from the local to the global ht
+ * Purpose:     copy the data from the local to the global ht.  A word
+ *              is interned in the global table's terms the first time
+ *              it is posted; after that its global id is remembered.
+ * Returns:     nothing
+*/
+void HashTable::TransferData(const int DocId, GlobalHashTable &GlobalHT)
+{
+unsigned int TermId;
+
+   if (global.size() < terms.GetNumTerms())
+      global.resize(terms.GetNumTerms(), TERM_NONE);
+
+   // Copy the contents of the hashtable, visiting only the used slots
+   // but in slot order, the order the global table has always seen
+   SortOccupied();
+   for ( unsigned long k=0; k < used; k++ )
+   {  
+      unsigned long i = occupied[k];
+      if (hashtable[i].data > LOW_FREQ_THRESHOLD)
+      {
+         float Normalized = (hashtable[i].data * (1.0)) / (used * (1.0));
+         TermId = hashtable[i].termid;
+         if (global[TermId] == TERM_NONE)
+            global[TermId] = GlobalHT.Intern(terms.GetToken(TermId));
+         GlobalHT.Insert(global[TermId], DocId, Normalized);
+      }
+   }
+}
+
+/* Name:  Recycle
+ * Parameters:  NumKept: how many of the first term ids to keep
+ * Purpose:     between documents, once the term table holds more than
+ *              HASHTABLE_RECYCLE_TERMS words, cut it back to its first
+ *              NumKept (the stopwords) and forget the global ids of the
+ *              words dropped, which get new ids if they are seen again
+ * Returns:     true if the term table was cut back
+*/
+bool HashTable::Recycle(const unsigned int NumKept)
+{
+   if (terms.GetNumTerms() <= HASHTABLE_RECYCLE_TERMS)
+      return false;
+   terms.Truncate(NumKept);
+   if (global.size() > NumKept)
+      global.resize(NumKept);
+   return true;
+}
+
+/* Name:  SortOccupied
+ * Parameters:  none
+ * Purpose:     sort the used slots into slot order, so walking them
+ *              meets the words as a walk over every slot would, in
+ *              O(distinct words) rather than O(size)
+ * Returns:     nothing
+*/
+void HashTable::SortOccupied()
+{
+   sort(occupied, occupied + used);
+}
+
+/* Name:  TransferData
+ * Parameters:  DocId - the document currently being processed 
+ *              Batch - the batch to receive the data
+ * Purpose:     copy the words to be posted, with their normalized
+ *              counts, into a batch for the inverter
+ * Returns:     nothing
+*/
+void HashTable::TransferData(const int DocId, TermBatch &Batch)
+{
+   Batch.docid = DocId;
+   SortOccupied();
+   for ( unsigned long k=0; k < used; k++ )
+   {  
+      unsigned long i = occupied[k];
+      if (hashtable[i].data > LOW_FREQ_THRESHOLD)
+      {
+         float Normalized = (hashtable[i].data * (1.0)) / (used * (1.0));
+         Batch.termids.push_back(hashtable[i].termid);
+         Batch.rtfs.push_back(Normalized);
+      }
+   }
+}
+
+/* Name:  TransferData
+ * Parameters:  DocId - the document currently being processed 
+ *              GlobalHT - the shared global ht to receive the data
+ * Purpose:     copy the data from the local to the global ht, which
+ *              other threads may be filling at the same time
  * Returns:     nothing
 */
-void HashTable::TransferData(const int DocId, GlobalHashTable &GlobalHT) const
+void HashTable::TransferData(const int DocId, ConcurrentGlobalHashTable &GlobalHT)
 {
-   // Copy the contents of the hashtable
-   for ( unsigned long i=0; i < size; i++ )
+   SortOccupied();
+   for ( unsigned long k=0; k < used; k++ )
    {  
-      if ( !(hashtable[i].key == "") && hashtable[i].data > LOW_FREQ_THRESHOLD)
+      unsigned long i = occupied[k];
+      if (hashtable[i].data > LOW_FREQ_THRESHOLD)
       {
          float Normalized = (hashtable[i].data * (1.0)) / (used * (1.0));
-         GlobalHT.Insert(hashtable[i].key, DocId, Normalized);
+         GlobalHT.Insert(terms.GetToken(hashtable[i].termid), DocId, Normalized, k);
       }
    }
 }
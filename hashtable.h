@@ -2,36 +2,67 @@
  * Author:    Susan Gauch
  * Date:      2/25/10
  * Purpose:   The header file for a hash table of strings and ints. 
+ *            The strings are interned in a TermTable; the table itself
+ *            counts by term id.  Only the words that get posted are
+ *            interned again in the global table's terms, and the local
+ *            term table is cut back now and then so the words that are
+ *            never posted do not pile up in it.
 */
 
+#ifndef HASHTABLE_H
+#define HASHTABLE_H
+
 #include "globalhashtable.h"
+#include "concurrentglobalhashtable.h"
+#include "controlbytes.h"
+#include "termbatch.h"
+#include <string_view>
+#include <vector>
+
+#define HASHTABLE_RECYCLE_TERMS 200000   // words held before the term table is cut back
 
 using namespace std;
 
 class HashTable {
 public:
    HashTable (const HashTable& ht );       // constructor for a copy
-   HashTable(const unsigned long NumKeys);          // constructor of hashtable 
+   HashTable(const unsigned long NumKeys, TermTable &Terms); // constructor of hashtable 
    ~HashTable();                           // destructor
-   void Print (const char *filename) const;       
-   void Insert (const string Key);   // new entry point for counting:wq
-   void Insert (const string Key, const int Data); 
+   void Print (const char *filename);       
+   void Insert (const string_view Key);   // new entry point for counting:wq
+   void Insert (const string_view Key, const int Data); 
+   void Insert (const unsigned int TermId);   // count an already interned term
+   void Insert (const unsigned int TermId, const int Data); 
    void Reset ();  // Clear out the hashtable data
-   void TransferData(const int DocId, GlobalHashTable &GlobalHT) const;
-   int GetData (const string Key); 
+   void TransferData(const int DocId, GlobalHashTable &GlobalHT);
+   void TransferData(const int DocId, TermBatch &Batch);
+   void TransferData(const int DocId, ConcurrentGlobalHashTable &GlobalHT);
+   bool Recycle (const unsigned int NumKept);   // cut the term table back between documents
+   int GetData (const string_view Key); 
+   int GetData (const unsigned int TermId); 
+   unsigned long SimHash () const;   // the signature of the counts, for dedup
    void GetUsage (int &Used, int &Collisions, int &Lookups) const;
+   unsigned long GetMemory () const;   // bytes held for the slots
 protected:
-   struct StringIntPair // the datatype stored in the hashtable`
+   struct TermIntPair // the datatype stored in the hashtable`
    {
-      string key;
+      unsigned int termid;
       int data;
    };
-   unsigned long Find (const string Key); // the index of the key in the hashtable
+   unsigned long Find (const unsigned int TermId); // the index of the key in the hashtable
+   void Grow ();   // double the table for a large document
+   void SortOccupied ();   // put the used slots in slot order
 private:
-   StringIntPair *hashtable;        // the hashtable array itself
+   TermIntPair *hashtable;          // the hashtable array itself
+   ControlBytes ctrl;               // one hash tag per slot, for probing
+   TermTable &terms;                // the strings and hashes behind the ids
+   vector<unsigned int> global;     // per term id, its id in the global table, or TERM_NONE
+   unsigned long *occupied;         // the used slots, sorted before they are walked
    unsigned long size;              // the hashtable size
+   unsigned long basesize;          // the size to return to on Reset
    unsigned long used;
    unsigned long collisions;
    unsigned long lookups;
 };
 
+#endif
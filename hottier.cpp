@@ -0,0 +1,334 @@
+/* Filename:  hottier.cpp
+ * Date:      10/19/2026
+ * Purpose:   The implementation file for the hot tier of the query
+ *            engine.
+*/
+
+#include <string.h>
+#include <sys/mman.h>
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <unordered_map>
+
+#include "hottier.h"
+
+using namespace std;
+
+/*-------------------------- HotSet ---------------------------------------*/
+
+HotSet::HotSet()
+{
+   region = NULL;
+   length = 0;
+   hugepages = false;
+}
+
+HotSet::~HotSet()
+{
+   if (region != NULL)
+      munmap(region, length);
+}
+
+/*-------------------------- Constructors/Destructors ----------------------*/
+
+/* Name:  HotTier
+ * Parameters:  none
+ * Purpose:     a tier with nothing hot and no thread, until Start
+ * Returns:     nothing
+*/
+HotTier::HotTier()
+{
+   maxbytes = 0;
+   reader = NULL;
+   source = NULL;
+   accesses = NULL;
+   hits = 0;
+   misses = 0;
+   stopping = false;
+}
+
+/* Name:  ~HotTier
+ * Parameters:  none
+ * Purpose:     stop the background thread and free the hot set
+ * Returns:     nothing
+*/
+HotTier::~HotTier()
+{
+   {
+   lock_guard<mutex> Lock(waiting);
+   stopping = true;
+   }
+   wake.notify_all();
+   if (background.joinable())
+      background.join();
+   delete [] accesses;
+}
+
+/*-------------------------- Accessors ------------------------------------*/
+
+/* Name:  Start
+ * Parameters:  Terms: every term with postings, in start order; a
+ *                     term's id is its place here
+ *              MaxBytes: the most memory the hot postings may take
+ *              Reader: reads a term's postings from the cold tier
+ *              Source: passed on to Reader
+ * Purpose:     start counting accesses, and the background thread that
+ *              rebalances the tiers
+ * Returns:     nothing
+*/
+void HotTier::Start(const vector<TrieMatch> &Terms, const unsigned long MaxBytes,
+                    const ColdReader Reader, const void *Source)
+{
+   if (IsStarted())
+      return;
+   terms = Terms;
+   maxbytes = MaxBytes;
+   reader = Reader;
+   source = Source;
+   accesses = new atomic<unsigned int>[terms.size()];
+   for (unsigned long t = 0; t < terms.size(); t++)
+      accesses[t] = 0;
+   history.assign(terms.size(), 0.0);
+   background = thread(&HotTier::Run, this);
+}
+
+bool HotTier::IsStarted() const
+{
+   return accesses != NULL;
+}
+
+/* Name:  Find
+ * Parameters:  Entry: a term's dictionary entry
+ *              List: receives the term's postings if it is hot
+ * Purpose:     count an access to the term and look for it in the hot
+ *              set.  List holds the set, so the postings stay put even
+ *              if the set is swapped out meanwhile.
+ * Returns:     false if the term is cold
+*/
+bool HotTier::Find(const TrieEntry &Entry, HotList &List)
+{
+int TermId = GetTermId(Entry);
+
+   if (TermId < 0)
+      return false;
+   accesses[TermId].fetch_add(1, memory_order_relaxed);
+   List.set = atomic_load(&current);
+   if (List.set == NULL || List.set->lists[TermId] < 0)
+   {
+      misses.fetch_add(1, memory_order_relaxed);
+      List.set.reset();
+      return false;
+   }
+
+   int Place = List.set->lists[TermId];
+   List.count = List.set->counts[Place];
+   List.docids = (const int *) (List.set->region + List.set->offsets[Place]);
+   List.weights = (const float *) (List.docids + List.count);
+   hits.fetch_add(1, memory_order_relaxed);
+   return true;
+}
+
+/* Name:  Rebalance
+ * Parameters:  none
+ * Purpose:     fold the accesses since the last pass into the halved
+ *              counts of the passes before, then fill the budget with
+ *              the terms counted most (at least HOT_MIN_ACCESSES),
+ *              skipping any too long for what is left.  If that is not
+ *              the hot set already, build the new one, copying the
+ *              lists that stay hot and reading the promoted ones from
+ *              the cold tier, and swap it in.
+ * Returns:     nothing
+*/
+void HotTier::Rebalance()
+{
+lock_guard<mutex> Lock(rebalancing);
+shared_ptr<const HotSet> Old = atomic_load(&current);
+vector<int> Order;
+vector<int> Chosen;
+vector<int> DocIds;
+vector<float> Weights;
+unsigned long Bytes = 0;
+void *Map = MAP_FAILED;
+
+   if (!IsStarted())
+      return;
+   for (unsigned long t = 0; t < terms.size(); t++)
+   {
+      history[t] = history[t] / 2 + accesses[t].exchange(0, memory_order_relaxed);
+      if (history[t] >= HOT_MIN_ACCESSES && terms[t].entry.numdocs > 0)
+         Order.push_back(t);
+   }
+   sort(Order.begin(), Order.end(), [&](int a, int b)
+   {
+      return history[a] != history[b] ? history[a] > history[b] : a < b;
+   });
+   for (unsigned long k = 0; k < Order.size(); k++)
+   {
+      unsigned long ListBytes = 8ul * terms[Order[k]].entry.numdocs;
+      if (Bytes + ListBytes <= maxbytes)
+      {
+         Chosen.push_back(Order[k]);
+         Bytes += ListBytes;
+      }
+   }
+   sort(Chosen.begin(), Chosen.end());
+   if ((Old == NULL && Chosen.empty()) || (Old != NULL && Old->ids == Chosen))
+      return;
+
+   HotSet *Set = new HotSet;
+   Set->lists.assign(terms.size(), -1);
+   Set->length = (Bytes + HOT_HUGE_PAGE - 1) / HOT_HUGE_PAGE * HOT_HUGE_PAGE;
+   if (Set->length > 0)
+   {
+#ifdef MAP_HUGETLB
+      Map = mmap(NULL, Set->length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+      Set->hugepages = (Map != MAP_FAILED);
+#endif
+      if (Map == MAP_FAILED)
+         Map = mmap(NULL, Set->length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      if (Map == MAP_FAILED)
+      {
+         cerr << "Unable to map " << Set->length << " bytes for the hot tier." << endl;
+         delete Set;
+         return;
+      }
+#ifdef MADV_HUGEPAGE
+      if (!Set->hugepages)
+         madvise(Map, Set->length, MADV_HUGEPAGE);
+#endif
+      Set->region = (char *) Map;
+   }
+
+   Bytes = 0;
+   for (unsigned long c = 0; c < Chosen.size(); c++)
+   {
+      int Id = Chosen[c];
+      int Count;
+      if (Old != NULL && Old->lists[Id] >= 0)
+      {
+         int Place = Old->lists[Id];
+         Count = Old->counts[Place];
+         memcpy(Set->region + Bytes, Old->region + Old->offsets[Place], 8ul * Count);
+      }
+      else
+      {
+         reader(source, terms[Id].entry, DocIds, Weights);
+         Count = min((int) DocIds.size(), terms[Id].entry.numdocs);
+         memcpy(Set->region + Bytes, DocIds.data(), 4ul * Count);
+         memcpy(Set->region + Bytes + 4ul * Count, Weights.data(), 4ul * Count);
+      }
+      Set->lists[Id] = Set->ids.size();
+      Set->ids.push_back(Id);
+      Set->offsets.push_back(Bytes);
+      Set->counts.push_back(Count);
+      Bytes += 8ul * Count;
+   }
+   atomic_store(&current, shared_ptr<const HotSet>(Set));
+}
+
+/* Name:  LoadProfile
+ * Parameters:  Filename: an access profile written by SaveProfile
+ * Purpose:     add the profile's counts to the terms still in the
+ *              index, then rebalance at once, so the hot set is built
+ *              before the first query
+ * Returns:     false if the file could not be read
+*/
+bool HotTier::LoadProfile(const string Filename)
+{
+ifstream Profile(Filename.c_str());
+unordered_map<string, int> Ids;
+string Term;
+double Count;
+
+   if (!IsStarted() || !Profile.is_open())
+      return false;
+   {
+   lock_guard<mutex> Lock(rebalancing);
+   for (unsigned long t = 0; t < terms.size(); t++)
+      Ids.emplace(terms[t].term, t);
+   while (Profile >> Term >> Count)
+   {
+      unordered_map<string, int>::const_iterator Found = Ids.find(Term);
+      if (Found != Ids.end() && Count > 0.0)
+         history[Found->second] += Count;
+   }
+   }
+   Rebalance();
+   return true;
+}
+
+/* Name:  SaveProfile
+ * Parameters:  Filename: the access profile to write
+ * Purpose:     write each counted term and its count (the decayed
+ *              counts plus the accesses since the last pass), a term a
+ *              line, by term rather than id so the profile still
+ *              applies once the index is rebuilt
+ * Returns:     false if the file could not be written
+*/
+bool HotTier::SaveProfile(const string Filename)
+{
+lock_guard<mutex> Lock(rebalancing);
+ofstream Profile(Filename.c_str());
+
+   if (!IsStarted() || !Profile.is_open())
+      return false;
+   for (unsigned long t = 0; t < terms.size(); t++)
+   {
+      double Count = history[t] + accesses[t].load(memory_order_relaxed);
+      if (Count > 0.0)
+         Profile << terms[t].term << " " << Count << "\n";
+   }
+   Profile.close();
+   return !Profile.fail();
+}
+
+/* Name:  PrintReport
+ * Parameters:  none
+ * Purpose:     print the hot set's size, whether it is on huge pages,
+ *              and how many lookups found their term hot
+ * Returns:     nothing
+*/
+void HotTier::PrintReport() const
+{
+shared_ptr<const HotSet> Set = atomic_load(&current);
+unsigned long Hits = hits.load();
+unsigned long Lookups = Hits + misses.load();
+unsigned long Bytes = 0;
+
+   if (Set != NULL)
+      for (unsigned long c = 0; c < Set->counts.size(); c++)
+         Bytes += 8ul * Set->counts[c];
+   cout << "Hot tier: " << (Set == NULL ? 0 : Set->ids.size()) << " of " << terms.size() << " terms, "
+        << fixed << setprecision(1) << Bytes / 1048576.0 << " of " << maxbytes / 1048576.0 << " MB"
+        << (Set != NULL && Set->hugepages ? " on huge pages" : "") << ", "
+        << (Lookups == 0 ? 0.0 : 100.0 * Hits / Lookups) << "% of " << Lookups << " lookups hot" << endl;
+}
+
+/*-------------------------- Private Functions ----------------------------*/
+
+// The term's place in start order, or -1
+int HotTier::GetTermId(const TrieEntry &Entry) const
+{
+vector<TrieMatch>::const_iterator Found = lower_bound(terms.begin(), terms.end(), Entry.start,
+   [](const TrieMatch &a, const unsigned long Start) { return a.entry.start < Start; });
+
+   if (Found == terms.end() || Found->entry.start != Entry.start || Entry.numdocs <= 0)
+      return -1;
+   return Found - terms.begin();
+}
+
+// The background thread: rebalance every HOT_REBALANCE_MS until stopped
+void HotTier::Run()
+{
+unique_lock<mutex> Lock(waiting);
+
+   while (!wake.wait_for(Lock, chrono::milliseconds(HOT_REBALANCE_MS), [this]() { return stopping; }))
+   {
+      Lock.unlock();
+      Rebalance();
+      Lock.lock();
+   }
+}
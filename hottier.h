@@ -0,0 +1,96 @@
+/* Filename:  hottier.h
+ * Date:      10/19/26
+ * Purpose:   The header file for the hot tier of the query engine: the
+ *            postings of the most searched terms, kept decoded (DocIds
+ *            and float weights, side by side) in one region of memory,
+ *            on huge pages where the system has them.  The rest stay
+ *            in the mapped bpost or post, the cold tier.  Every lookup
+ *            counts an access to its term; a background thread wakes
+ *            every HOT_REBALANCE_MS, halves the old counts and adds the
+ *            new ones, and fills the budget again with the terms
+ *            counted most, promoting and demoting terms by building a
+ *            new hot set (copying the lists that stay hot) and
+ *            swapping it in, so a query never waits for it.  The
+ *            counts can be saved as an access profile, by term, and
+ *            loaded at startup to build the hot set before the first
+ *            query.
+*/
+
+#ifndef HOTTIER_H
+#define HOTTIER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "termtrie.h"
+
+#define HOT_REBALANCE_MS 1000      // between the background thread's passes
+#define HOT_MIN_ACCESSES 2         // a term counted less is never promoted
+#define HOT_HUGE_PAGE 2097152ul    // the region is rounded up to this
+
+using namespace std;
+
+// Reads a term's postings from the cold tier
+typedef void (*ColdReader) (const void *Source, const TrieEntry &Entry, vector<int> &DocIds,
+                            vector<float> &Weights);
+
+struct HotSet  // the hot terms and the region holding their postings
+{
+   HotSet();
+   ~HotSet();
+   vector<int> lists;               // by term id, its place in offsets, or -1
+   vector<unsigned long> offsets;   // each hot list's DocIds in the region,
+                                    //    its weights just after them
+   vector<int> counts;              // and its number of postings
+   vector<int> ids;                 // and its term id
+   char *region;
+   unsigned long length;
+   bool hugepages;                  // explicit huge pages, not just advised
+};
+
+struct HotList  // a hot term's postings, valid while set is held
+{
+   shared_ptr<const HotSet> set;
+   const int *docids;
+   const float *weights;
+   int count;
+};
+
+class HotTier {
+public:
+   HotTier();
+   ~HotTier();
+   void Start (const vector<TrieMatch> &Terms, const unsigned long MaxBytes,
+               const ColdReader Reader, const void *Source);   // Terms in start order
+   bool IsStarted () const;
+   bool Find (const TrieEntry &Entry, HotList &List);   // counts the access
+   void Rebalance ();
+   bool LoadProfile (const string Filename);
+   bool SaveProfile (const string Filename);
+   void PrintReport () const;
+private:
+   HotTier (const HotTier& ht);
+   int GetTermId (const TrieEntry &Entry) const;
+   void Run ();
+   vector<TrieMatch> terms;         // by id, in start order
+   unsigned long maxbytes;
+   ColdReader reader;
+   const void *source;
+   atomic<unsigned int> *accesses;  // by id, since the last pass
+   vector<double> history;          // by id, decayed counts of the passes before
+   shared_ptr<const HotSet> current;
+   atomic<unsigned long> hits;
+   atomic<unsigned long> misses;
+   mutex rebalancing;               // one pass, or profile load or save, at a time
+   mutex waiting;
+   condition_variable wake;
+   bool stopping;
+   thread background;
+};
+
+#endif
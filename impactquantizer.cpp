@@ -0,0 +1,68 @@
+/* Filename:  impactquantizer.cpp
+ * Date:      10/19/2026
+ * Purpose:   The implementation file for impact quantization.
+*/
+
+#include <math.h>
+
+#include "impactquantizer.h"
+
+/* Name:  ImpactQuantizer
+ * Parameters:  Bits: IMPACT_BITS_SMALL or IMPACT_BITS_LARGE
+ *              Logarithmic: true for log steps, false for linear
+ *              Low, High: the smallest and largest weights to be stored
+ * Purpose:     set up the scale
+ * Returns:     nothing
+*/
+ImpactQuantizer::ImpactQuantizer(const int Bits, const bool Logarithmic, const float Low, const float High)
+{
+   logarithmic = Logarithmic;
+   low = (Low > 0.0 ? Low : 1.0);
+   high = (High > low ? High : low);
+   loglow = log(low);
+   logrange = log(high) - loglow;
+   maximpact = (1u << Bits) - 1;
+}
+
+/* Name:  Quantize
+ * Parameters:  Weight: a posting's weight
+ * Purpose:     round the weight to the nearest step of the scale; a
+ *              weight above 0 never becomes impact 0
+ * Returns:     the impact, 0 .. GetMaxImpact
+*/
+unsigned int ImpactQuantizer::Quantize(const float Weight) const
+{
+double Step;
+
+   if (Weight <= 0.0)
+      return 0;
+   if (logarithmic)
+      Step = 1.0 + (logrange > 0.0 ? (log(Weight) - loglow) / logrange * (maximpact - 1) : 0.0);
+   else
+      Step = Weight / high * maximpact;
+   Step = floor(Step + 0.5);
+   if (Step < 1.0)
+      return 1;
+   if (Step > maximpact)
+      return maximpact;
+   return (unsigned int) Step;
+}
+
+/* Name:  Dequantize
+ * Parameters:  Impact: an impact made by Quantize
+ * Purpose:     the weight in the middle of the impact's step
+ * Returns:     the weight
+*/
+float ImpactQuantizer::Dequantize(const unsigned int Impact) const
+{
+   if (Impact == 0)
+      return 0.0;
+   if (logarithmic)
+      return exp(loglow + (maximpact > 1 ? (double) (Impact - 1) / (maximpact - 1) : 0.0) * logrange);
+   return (double) Impact * high / maximpact;
+}
+
+unsigned int ImpactQuantizer::GetMaxImpact() const
+{
+   return maximpact;
+}
@@ -0,0 +1,37 @@
+/* Filename:  impactquantizer.h
+ * Date:      10/19/26
+ * Purpose:   The header file for impact quantization.  A posting's
+ *            weight (rtf * IDF * 1000) can be stored in bpost as an
+ *            integer impact of IMPACT_BITS_SMALL or IMPACT_BITS_LARGE
+ *            bits instead of a 4-byte float.  The scale is global: Low
+ *            and High are the smallest and largest weights in the
+ *            index, so equal impacts mean equal weights in every list.
+ *            Linear impacts split 0 .. High into equal steps; log
+ *            impacts split log(Low) .. log(High), keeping the same
+ *            relative error for small weights as for large ones.
+ *            Impact 0 is kept for a weight of 0.
+*/
+
+#ifndef IMPACTQUANTIZER_H
+#define IMPACTQUANTIZER_H
+
+#define IMPACT_FLOAT 32            // weights kept as 4-byte floats
+#define IMPACT_BITS_SMALL 8
+#define IMPACT_BITS_LARGE 16
+
+class ImpactQuantizer {
+public:
+   ImpactQuantizer(const int Bits, const bool Logarithmic, const float Low, const float High);
+   unsigned int Quantize (const float Weight) const;
+   float Dequantize (const unsigned int Impact) const;
+   unsigned int GetMaxImpact () const;
+private:
+   bool logarithmic;
+   float low;
+   float high;
+   double loglow;
+   double logrange;                 // log(high) - log(low)
+   unsigned int maximpact;          // 2^bits - 1
+};
+
+#endif
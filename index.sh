@@ -11,10 +11,21 @@ flex invert.lex
 
 echo "Done flexing."
 
-g++ -o invert posting.cpp globalhashtable.cpp hashtable.cpp lex.yy.c -lfl
+g++ -O2 -pthread -o invert posting.cpp controlbytes.cpp termtable.cpp globalhashtable.cpp hashtable.cpp concurrentglobalhashtable.cpp deduplicator.cpp checkpointer.cpp memoryaccount.cpp outputwriter.cpp sorteddict.cpp termtrie.cpp postingcodec.cpp impactquantizer.cpp docstore.cpp forwardindex.cpp blockpost.cpp docreorderer.cpp tokenizer.cpp inverter.cpp pipeline.cpp segment.cpp ratelimiter.cpp lex.yy.c
+
+g++ -O2 -pthread -o query query.cpp queryengine.cpp termtrie.cpp blockpost.cpp postingcodec.cpp impactquantizer.cpp docstore.cpp forwardindex.cpp hottier.cpp outputwriter.cpp segment.cpp ratelimiter.cpp
+
+g++ -O2 -pthread -o roundtrip roundtrip.cpp posting.cpp controlbytes.cpp termtable.cpp globalhashtable.cpp hashtable.cpp concurrentglobalhashtable.cpp deduplicator.cpp checkpointer.cpp memoryaccount.cpp outputwriter.cpp sorteddict.cpp termtrie.cpp postingcodec.cpp impactquantizer.cpp docstore.cpp forwardindex.cpp blockpost.cpp docreorderer.cpp tokenizer.cpp inverter.cpp pipeline.cpp segment.cpp ratelimiter.cpp hottier.cpp
 
 echo "Done compiling."
 
+# Check that what the indexer writes reads back the same
+if ! ./roundtrip
+then
+   echo "Round-trip checks failed."
+   exit 1
+fi
+
 time ./invert $1 $2
 
 # Add a slash to output directory if not already there
@@ -0,0 +1,161 @@
+/* Filename:  inverter.cpp
+ * Date:      10/19/2026
+ * Purpose:   The implementation file for the inverter.
+*/
+
+#include <string_view>
+
+#include "inverter.h"
+
+using namespace std;
+
+/*-------------------------- Constructors/Destructors ----------------------*/
+
+/* Name:  Inverter
+ * Parameters:  GlobalHT: the table that receives the postings
+ *              Terms: the term table behind GlobalHT
+ * Purpose:     set up an inverter with no tokenizers yet
+ * Returns:     nothing
+*/
+Inverter::Inverter(GlobalHashTable &GlobalHT, TermTable &Terms)
+   : globalht(GlobalHT), terms(Terms)
+{
+   dedup = NULL;
+   checkpoint = NULL;
+   memory = NULL;
+   docstore = NULL;
+   live = NULL;
+}
+
+/* Name:  ~Inverter
+ * Parameters:  none
+ * Purpose:     nothing to free
+ * Returns:     nothing
+*/
+Inverter::~Inverter()
+{
+}
+
+/*-------------------------- Accessors ------------------------------------*/
+
+/* Name:  AddSource
+ * Parameters:  none
+ * Purpose:     start an id translation table for a new tokenizer
+ * Returns:     the source number to put in that tokenizer's batches
+*/
+int Inverter::AddSource()
+{
+   translate.push_back(vector<unsigned int>());
+   return translate.size() - 1;
+}
+
+/* Name:  Add
+ * Parameters:  Batch: one document's words from a tokenizer
+ * Purpose:     intern the words the tokenizer has not sent before (all
+ *              of them again if its table was cut back), then post the
+ *              words unless the document is a near-duplicate, and give
+ *              the checkpointer and the memory account their chance.  A
+ *              document store gets every document's text, duplicate or
+ *              not, and a live segment its filename and the words
+ *              posted; the segments are then the index, so the
+ *              global table is left empty.  Batches must arrive in
+ *              DocId order.
+ * Returns:     nothing
+*/
+void Inverter::Add(const TermBatch &Batch)
+{
+vector<unsigned int> &Translate = translate[Batch.source];
+unsigned long Offset = 0;
+bool Posted;
+
+   if (Batch.restart)
+      Translate.clear();
+   for (unsigned long i = 0; i < Batch.newlengths.size(); i++)
+   {
+      if (Translate.size() <= Batch.newids[i])
+         Translate.resize(Batch.newids[i] + 1, TERM_NONE);
+      Translate[Batch.newids[i]] = terms.Intern(string_view(Batch.newterms.data() + Offset,
+                                                            Batch.newlengths[i]));
+      Offset += Batch.newlengths[i];
+   }
+
+   Posted = (dedup == NULL || dedup->Check(Batch.docid, Batch.signature, Batch.termids.size()) == 0);
+   if (Posted && live == NULL)
+      for (unsigned long i = 0; i < Batch.termids.size(); i++)
+         globalht.Insert(Translate[Batch.termids[i]], Batch.docid, Batch.rtfs[i]);
+   if (live != NULL)
+   {
+      liveterms.clear();
+      for (unsigned long i = 0; Posted && i < Batch.termids.size(); i++)
+         liveterms.push_back(terms.GetToken(Translate[Batch.termids[i]]));
+      live->Add(Batch.docid, Batch.filename, liveterms, Batch.rtfs);
+   }
+
+   if (docstore != NULL)
+      docstore->Add(Batch.docid, Batch.text);
+   if (checkpoint != NULL)
+      checkpoint->Posted(Batch.docid);
+   if (memory != NULL)
+      memory->Posted(Batch.docid, Batch.source, Batch.localmemory);
+}
+
+/* Name:  SetDeduplicator
+ * Parameters:  Dedup: decides which documents to leave out, or NULL
+ * Purpose:     turn near-duplicate detection on before indexing
+ * Returns:     nothing
+*/
+void Inverter::SetDeduplicator(Deduplicator *Dedup)
+{
+   dedup = Dedup;
+}
+
+bool Inverter::IsDeduplicating() const
+{
+   return dedup != NULL;
+}
+
+/* Name:  SetCheckpointer
+ * Parameters:  Checkpoint: told after each document is posted, or NULL
+ * Purpose:     turn periodic checkpoints on before indexing
+ * Returns:     nothing
+*/
+void Inverter::SetCheckpointer(Checkpointer *Checkpoint)
+{
+   checkpoint = Checkpoint;
+}
+
+/* Name:  SetMemoryAccount
+ * Parameters:  Account: told after each document is posted, or NULL
+ * Purpose:     turn memory accounting on before indexing
+ * Returns:     nothing
+*/
+void Inverter::SetMemoryAccount(MemoryAccount *Account)
+{
+   memory = Account;
+}
+
+/* Name:  SetDocStore
+ * Parameters:  Store: a store made with Create, or NULL
+ * Purpose:     store the documents' tokens as they are posted
+ * Returns:     nothing
+*/
+void Inverter::SetDocStore(DocStore *Store)
+{
+   docstore = Store;
+}
+
+bool Inverter::IsStoringText() const
+{
+   return docstore != NULL;
+}
+
+/* Name:  SetLiveSegment
+ * Parameters:  Live: the segment to add each document to, or NULL
+ * Purpose:     post the documents to segments, searchable as they are
+ *              posted, rather than to the global table
+ * Returns:     nothing
+*/
+void Inverter::SetLiveSegment(MemorySegment *Live)
+{
+   live = Live;
+}
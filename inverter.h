@@ -0,0 +1,56 @@
+/* Filename:  inverter.h
+ * Date:      10/19/26
+ * Purpose:   The header file for the inverter, the single owner of the
+ *            global hashtable.  It takes each document's TermBatch in
+ *            DocId order, maps the tokenizer's term ids to global ones
+ *            and posts the words.  With a Deduplicator it leaves out
+ *            the documents that are near-duplicates of earlier ones;
+ *            with a Checkpointer it checkpoints between documents, with
+ *            a MemoryAccount it accounts for (and limits) memory, with
+ *            a DocStore it stores each document's tokens, and with a
+ *            MemorySegment it posts to segments instead, each document
+ *            searchable at once.
+*/
+
+#ifndef INVERTER_H
+#define INVERTER_H
+
+#include <vector>
+
+#include "checkpointer.h"
+#include "deduplicator.h"
+#include "docstore.h"
+#include "globalhashtable.h"
+#include "memoryaccount.h"
+#include "segment.h"
+#include "termbatch.h"
+
+using namespace std;
+
+class Inverter {
+public:
+   Inverter(GlobalHashTable &GlobalHT, TermTable &Terms);
+   ~Inverter();
+   int AddSource ();   // register a tokenizer; returns its source number
+   void Add (const TermBatch &Batch);
+   void SetDeduplicator (Deduplicator *Dedup);
+   bool IsDeduplicating () const;   // the batches need signatures
+   void SetCheckpointer (Checkpointer *Checkpoint);
+   void SetMemoryAccount (MemoryAccount *Account);
+   void SetDocStore (DocStore *Store);
+   bool IsStoringText () const;     // the batches need the tokens
+   void SetLiveSegment (MemorySegment *Live);
+private:
+   Inverter (const Inverter& inv);
+   GlobalHashTable &globalht;
+   TermTable &terms;                // the global term ids
+   vector< vector<unsigned int> > translate;  // per source: its id -> global id
+   Deduplicator *dedup;             // or NULL to post every document
+   Checkpointer *checkpoint;        // told of each document, or NULL
+   MemoryAccount *memory;           // told of each document, or NULL
+   DocStore *docstore;              // given each document's tokens, or NULL
+   MemorySegment *live;             // given the postings instead, or NULL
+   vector<string_view> liveterms;   // the words of the document given it
+};
+
+#endif
@@ -0,0 +1,128 @@
+/* Filename:  memoryaccount.cpp
+ * Date:      10/19/2026
+ * Purpose:   The implementation file for memory accounting during the
+ *            index build.
+*/
+
+#include <iostream>
+#include <iomanip>
+
+#include "memoryaccount.h"
+
+using namespace std;
+
+/*-------------------------- Constructors/Destructors ----------------------*/
+
+/* Name:  MemoryAccount
+ * Parameters:  GlobalHT: the table to account for and spill
+ *              Terms: the global term table
+ *              MaxBytes: the limit, or 0 to only report
+ *              RunPrefix: where the run files go
+ * Purpose:     start an account with nothing measured
+ * Returns:     nothing
+*/
+MemoryAccount::MemoryAccount(GlobalHashTable &GlobalHT, const TermTable &Terms, const unsigned long MaxBytes,
+                             const string RunPrefix)
+   : globalht(GlobalHT), terms(Terms), runprefix(RunPrefix)
+{
+   maxbytes = MaxBytes;
+   for (int p = 0; p < MEMORY_PARTS; p++)
+      peak[p] = 0;
+   peaktotal = 0;
+   documents = 0;
+   warned = false;
+}
+
+/*-------------------------- Accessors ------------------------------------*/
+
+/* Name:  Posted
+ * Parameters:  DocId: the document just posted
+ *              Source: the tokenizer it came through
+ *              LocalBytes: that tokenizer's tables, from its batch
+ * Purpose:     measure; spill the postings if the total is over the
+ *              limit and they are worth a run, and print the parts
+ *              now and then
+ * Returns:     nothing
+*/
+void MemoryAccount::Posted(const int DocId, const int Source, const unsigned long LocalBytes)
+{
+unsigned long Bytes[MEMORY_PARTS];
+unsigned long Total;
+
+   if (Source >= (int) local.size())
+      local.resize(Source + 1, 0);
+   local[Source] = LocalBytes;
+   documents++;
+
+   Total = Measure(Bytes);
+   if (Total > peaktotal)
+   {
+      peaktotal = Total;
+      for (int p = 0; p < MEMORY_PARTS; p++)
+         peak[p] = Bytes[p];
+   }
+
+   if (maxbytes > 0 && Total > maxbytes
+       && Bytes[MEMORY_POSTINGS] >= maxbytes / MEMORY_MIN_RUN_SHARE)
+   {
+      string Filename = runprefix + "." + to_string(globalht.GetNumRuns());
+      if (globalht.Spill(Filename))
+      {
+         Print("Spilled " + Filename + " after document " + to_string(DocId), Bytes);
+         Total = Measure(Bytes);
+      }
+   }
+   if (maxbytes > 0 && Total - Bytes[MEMORY_POSTINGS] > maxbytes - maxbytes / MEMORY_MIN_RUN_SHARE
+       && !warned)
+   {
+      cerr << "The terms and tables leave too little of --max-memory for postings." << endl;
+      warned = true;
+   }
+
+   if (documents % MEMORY_REPORT_DOCS == 0)
+      Print("Memory after " + to_string(documents) + " documents", Bytes);
+}
+
+/* Name:  Finish
+ * Parameters:  none
+ * Purpose:     print the highest total seen and its parts, and how many
+ *              runs were spilled
+ * Returns:     nothing
+*/
+void MemoryAccount::Finish()
+{
+   Print("Memory peak", peak);
+   cout << "Runs spilled: " << globalht.GetNumRuns() << endl;
+}
+
+/*-------------------------- Private Functions ----------------------------*/
+
+// Fill in the parts; return their total
+unsigned long MemoryAccount::Measure(unsigned long Bytes[MEMORY_PARTS]) const
+{
+unsigned long Total = 0;
+
+   Bytes[MEMORY_TERMS] = terms.GetMemory();
+   globalht.GetMemory(Bytes[MEMORY_SLOTS], Bytes[MEMORY_POSTINGS]);
+   Bytes[MEMORY_LOCAL] = 0;
+   for (unsigned long s = 0; s < local.size(); s++)
+      Bytes[MEMORY_LOCAL] += local[s];
+   for (int p = 0; p < MEMORY_PARTS; p++)
+      Total += Bytes[p];
+   return Total;
+}
+
+// One line: what happened, then each part and the total in MB
+void MemoryAccount::Print(const string When, const unsigned long Bytes[MEMORY_PARTS]) const
+{
+const char *Names[MEMORY_PARTS] = {"terms", "slots", "postings", "local"};
+unsigned long Total = 0;
+
+   cout << When << ":" << fixed << setprecision(1);
+   for (int p = 0; p < MEMORY_PARTS; p++)
+   {
+      cout << (p == 0 ? " " : ", ") << Names[p] << " " << Bytes[p] / 1048576.0 << " MB";
+      Total += Bytes[p];
+   }
+   cout << ", total " << Total / 1048576.0 << " MB" << endl;
+}
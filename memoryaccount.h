@@ -0,0 +1,63 @@
+/* Filename:  memoryaccount.h
+ * Date:      10/19/26
+ * Purpose:   The header file for memory accounting during the index
+ *            build.  After each document the inverter calls Posted and
+ *            the account adds up, from the structures' own sizes, the
+ *            bytes held for term strings (the global term table),
+ *            global slots, posting list nodes and the tokenizers'
+ *            local tables (as each tokenizer last reported them in its
+ *            batch), printing them every MEMORY_REPORT_DOCS documents.
+ *            With a limit, once the total passes it the postings are
+ *            spilled to a run file (see GlobalHashTable::Spill), so
+ *            the build stays under the limit instead of growing until
+ *            the system kills it.  Only the postings can be spilled, and
+ *            only once they hold 1/MEMORY_MIN_RUN_SHARE of the limit, so
+ *            a limit too low for the rest warns once instead of writing
+ *            a tiny run after every document.
+*/
+
+#ifndef MEMORYACCOUNT_H
+#define MEMORYACCOUNT_H
+
+#include <string>
+#include <vector>
+
+#include "globalhashtable.h"
+#include "termtable.h"
+
+#define MEMORY_REPORT_DOCS 5000    // documents between live reports
+#define MEMORY_MIN_RUN_SHARE 4     // a run is at least 1/4 of the limit
+
+using namespace std;
+
+enum MemoryPart
+{
+   MEMORY_TERMS = 0,
+   MEMORY_SLOTS,
+   MEMORY_POSTINGS,
+   MEMORY_LOCAL,
+   MEMORY_PARTS
+};
+
+class MemoryAccount {
+public:
+   MemoryAccount(GlobalHashTable &GlobalHT, const TermTable &Terms, const unsigned long MaxBytes,
+                 const string RunPrefix);   // MaxBytes 0 for no limit
+   void Posted (const int DocId, const int Source, const unsigned long LocalBytes);
+   void Finish ();                  // print the peak and the runs
+private:
+   MemoryAccount (const MemoryAccount& ma);
+   unsigned long Measure (unsigned long Bytes[MEMORY_PARTS]) const;   // returns the total
+   void Print (const string When, const unsigned long Bytes[MEMORY_PARTS]) const;
+   GlobalHashTable &globalht;
+   const TermTable &terms;
+   unsigned long maxbytes;
+   string runprefix;                // runs are runprefix.0, runprefix.1, ...
+   vector<unsigned long> local;     // per tokenizer, its tables' bytes
+   unsigned long peak[MEMORY_PARTS];   // the parts when the total was highest
+   unsigned long peaktotal;
+   int documents;                   // documents posted
+   bool warned;                     // the limit is too low for the rest
+};
+
+#endif
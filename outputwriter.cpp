@@ -0,0 +1,225 @@
+/* Filename:  outputwriter.cpp
+ * Date:      10/19/2026
+ * Purpose:   The implementation file for the buffered output writer.
+*/
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <charconv>
+#include <iostream>
+
+#include "outputwriter.h"
+
+using namespace std;
+
+/*-------------------------- Constructors/Destructors ----------------------*/
+
+/* Name:  OutputWriter
+ * Parameters:  none
+ * Purpose:     a writer that keeps everything written to it in memory
+ * Returns:     nothing
+*/
+OutputWriter::OutputWriter()
+{
+   size = OUTPUT_BUFFER_SIZE;
+   if((buffer = new char[size]) == NULL)
+      cout << "Out of memory at OutputWriter::OutputWriter()" << endl;
+   assert( buffer != 0 );
+   length = 0;
+   fd = -1;
+   failed = false;
+}
+
+/* Name:  OutputWriter
+ * Parameters:  Fd: the open file to write to
+ * Purpose:     a writer that writes to Fd each time its buffer fills
+ * Returns:     nothing
+*/
+OutputWriter::OutputWriter(const int Fd)
+{
+   size = OUTPUT_BUFFER_SIZE;
+   if((buffer = new char[size]) == NULL)
+      cout << "Out of memory at OutputWriter::OutputWriter(int)" << endl;
+   assert( buffer != 0 );
+   length = 0;
+   fd = Fd;
+   failed = false;
+}
+
+/* Name:  ~OutputWriter
+ * Parameters:  none
+ * Purpose:     write out what is left, then free the buffer
+ * Returns:     nothing
+*/
+OutputWriter::~OutputWriter()
+{
+   Flush();
+   delete [] buffer;
+}
+
+/*-------------------------- Accessors ------------------------------------*/
+
+void OutputWriter::Put(const char Ch)
+{
+   Reserve(1);
+   buffer[length++] = Ch;
+}
+
+void OutputWriter::Put(const string_view Text)
+{
+   Reserve(Text.length());
+   memcpy(buffer + length, Text.data(), Text.length());
+   length += Text.length();
+}
+
+/* Name:  PutRight
+ * Parameters:  Text: the text to write
+ *              Width: the field width
+ * Purpose:     write Text right-justified in Width columns, as setw
+ *              does; longer text is written whole
+ * Returns:     nothing
+*/
+void OutputWriter::PutRight(const string_view Text, const int Width)
+{
+   Pad(Width - (int) Text.length());
+   Put(Text);
+}
+
+/* Name:  PutInt
+ * Parameters:  Value: the number to write
+ *              Width: the field width
+ * Purpose:     write an integer as << setw(Width) would
+ * Returns:     nothing
+*/
+void OutputWriter::PutInt(const long Value, const int Width)
+{
+char Digits[24];
+to_chars_result Result = to_chars(Digits, Digits + sizeof(Digits), Value);
+
+   PutRight(string_view(Digits, Result.ptr - Digits), Width);
+}
+
+/* Name:  PutFixed
+ * Parameters:  Value: the number to write
+ *              Width: the field width
+ *              Precision: the digits after the point
+ * Purpose:     write a number as << setw(Width) << fixed
+ *              << setprecision(Precision) would.  Both round the exact
+ *              binary value to nearest, ties to even.
+ * Returns:     nothing
+*/
+void OutputWriter::PutFixed(const double Value, const int Width, const int Precision)
+{
+char Digits[512];
+to_chars_result Result = to_chars(Digits, Digits + sizeof(Digits), Value,
+                                  chars_format::fixed, Precision);
+
+   if (Result.ec == errc())
+      PutRight(string_view(Digits, Result.ptr - Digits), Width);
+   else
+      PutRight(string_view(Digits, snprintf(Digits, sizeof(Digits), "%.*f", Precision, Value)), Width);
+}
+
+/* Name:  Flush
+ * Parameters:  none
+ * Purpose:     write the buffer to the file, if this writer has one
+ * Returns:     false if any write has failed
+*/
+bool OutputWriter::Flush()
+{
+unsigned long Written = 0;
+ssize_t Result;
+
+   if (fd < 0)
+      return !failed;
+
+   while (Written < length && !failed)
+   {
+      Result = write(fd, buffer + Written, length - Written);
+      if (Result <= 0)
+      {
+         perror("OutputWriter::Flush");
+         failed = true;
+      }
+      else
+         Written += Result;
+   }
+   length = 0;
+   return !failed;
+}
+
+// Throw away the collected text
+void OutputWriter::Clear()
+{
+   length = 0;
+}
+
+unsigned long OutputWriter::GetLength() const
+{
+   return length;
+}
+
+/* Name:  WriteAt
+ * Parameters:  Fd: the file to write to
+ *              Offset: where in the file the text goes
+ * Purpose:     pwrite the text collected in memory, however many calls
+ *              that takes
+ * Returns:     false if the write failed
+*/
+bool OutputWriter::WriteAt(const int Fd, const off_t Offset) const
+{
+unsigned long Written = 0;
+ssize_t Result;
+
+   while (Written < length)
+   {
+      Result = pwrite(Fd, buffer + Written, length - Written, Offset + Written);
+      if (Result <= 0)
+         return false;
+      Written += Result;
+   }
+   return true;
+}
+
+/*-------------------------- Private Functions ----------------------------*/
+
+/* Name:  Reserve
+ * Parameters:  Bytes: the bytes about to be written
+ * Purpose:     make room in the buffer: a file writer flushes, a memory
+ *              writer (or a string too long for any buffer) grows it
+ * Returns:     nothing
+*/
+void OutputWriter::Reserve(const unsigned long Bytes)
+{
+char *Larger;
+
+   if (length + Bytes <= size)
+      return;
+   if (fd >= 0)
+   {
+      Flush();
+      if (Bytes <= size)
+         return;
+   }
+
+   while (length + Bytes > size)
+      size = size * 2;
+   if((Larger = new char[size]) == NULL)
+      cout << "Out of memory at OutputWriter::Reserve()" << endl;
+   assert( Larger != 0 );
+   memcpy(Larger, buffer, length);
+   delete [] buffer;
+   buffer = Larger;
+}
+
+// Write Count spaces, if Count is positive
+void OutputWriter::Pad(const int Count)
+{
+   if (Count <= 0)
+      return;
+   Reserve(Count);
+   memset(buffer + length, ' ', Count);
+   length += Count;
+}
@@ -0,0 +1,48 @@
+/* Filename:  outputwriter.h
+ * Date:      10/19/26
+ * Purpose:   The header file for a buffered text writer for the index
+ *            files.  Numbers are converted with to_chars and padded by
+ *            hand to the same widths setw gives, into a large buffer
+ *            that is written out only when it fills, so the text is the
+ *            same as the ofstream output but without the per-line
+ *            manipulator and flush costs.  A writer either streams to
+ *            a file descriptor or collects its text in memory to be
+ *            written later at a known offset.
+*/
+
+#ifndef OUTPUTWRITER_H
+#define OUTPUTWRITER_H
+
+#include <sys/types.h>
+#include <string_view>
+
+#define OUTPUT_BUFFER_SIZE (1 << 20)
+
+using namespace std;
+
+class OutputWriter {
+public:
+   OutputWriter();                      // collect the text in memory
+   OutputWriter(const int Fd);          // write the text to Fd as it fills
+   ~OutputWriter();                     // flushes to Fd, if there is one
+   void Put (const char Ch);
+   void Put (const string_view Text);
+   void PutRight (const string_view Text, const int Width);   // as setw
+   void PutInt (const long Value, const int Width);
+   void PutFixed (const double Value, const int Width, const int Precision);
+   bool Flush ();                       // false if a write failed
+   void Clear ();
+   unsigned long GetLength () const;    // bytes collected, in memory
+   bool WriteAt (const int Fd, const off_t Offset) const;  // pwrite them
+private:
+   OutputWriter (const OutputWriter& ow);   // owns its buffer; never copied
+   void Reserve (const unsigned long Bytes);
+   void Pad (const int Count);
+   char *buffer;
+   unsigned long size;                  // the buffer size
+   unsigned long length;                // bytes in the buffer
+   int fd;                              // -1 when collecting in memory
+   bool failed;
+};
+
+#endif
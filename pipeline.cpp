@@ -0,0 +1,398 @@
+/* Filename:  pipeline.cpp
+ * Date:      10/19/2026
+ * Purpose:   The implementation file for the indexing stages.
+ *
+ *            reader --docs--> tokenizer i --batches--> inverter
+ *                   <-buffers--           <--batches--
+ *
+ *            Document i goes to tokenizer i % N and the inverter takes
+ *            the batches back in the same round-robin order, so every
+ *            queue has one producer and one consumer and the postings
+ *            go in by DocId exactly as in a single-threaded run.
+ *            Buffers and batches are pooled and go back on return
+ *            queues, so nothing is allocated per document once the
+ *            pool buffers have grown to fit.
+*/
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <thread>
+
+#include "pipeline.h"
+#include "template_spscqueue.h"
+#include "tokenizer.h"
+
+#define PIPELINE_QUEUE_DEPTH 16   // documents in flight per tokenizer
+
+using namespace std;
+
+/*-------------------------- DocumentSource -------------------------------*/
+
+/* Name:  DocumentSource
+ * Parameters:  InputDirPtr: the open input directory
+ *              InputDirname: its name
+ *              Map: the map file, one filename per DocId
+ * Purpose:     read the documents of a directory in readdir order
+ * Returns:     nothing
+*/
+DocumentSource::DocumentSource(DIR *InputDirPtr, const char *InputDirname, ofstream &Map)
+   : dirname(InputDirname), map(Map)
+{
+   dir = InputDirPtr;
+   writemap = true;
+   numdocs = 0;
+}
+
+/* Name:  Next
+ * Parameters:  Buffer: receives the next document's text
+ *              DocId: receives its DocId (1, 2, ...)
+ *              Filename: receives its name, as in the map
+ * Purpose:     read the next file, skipping the hidden ones that begin
+ *              with a dot, and write its name to the map.  As always,
+ *              a file that cannot be opened ends the run.
+ * Returns:     false when there are no more documents
+*/
+bool DocumentSource::Next(vector<char> &Buffer, int &DocId)
+{
+string Filename;
+
+   return Next(Buffer, DocId, Filename);
+}
+
+bool DocumentSource::Next(vector<char> &Buffer, int &DocId, string &Filename)
+{
+struct dirent* InputDirEntryPtr;
+string InFilename;
+
+   // skip over the hidden filenames that begin with dot
+   do
+   {
+      InputDirEntryPtr = readdir (dir);
+   } while ((InputDirEntryPtr != NULL) &&
+            (InputDirEntryPtr->d_name[0] == '.'));
+
+   if (InputDirEntryPtr == NULL)
+      return false;
+
+   Filename = InputDirEntryPtr->d_name;
+   if (writemap)
+      map << InputDirEntryPtr->d_name << '\n';  // write the filename to the map file
+   InFilename = dirname + "/" + InputDirEntryPtr->d_name;
+   if (!Tokenizer::ReadFile(InFilename.c_str(), Buffer))
+   {
+      perror(InFilename.c_str());
+      return false;
+   }
+
+   numdocs++;
+   DocId = numdocs;
+   return true;
+}
+
+/* Name:  Skip
+ * Parameters:  NumDocs: the documents a checkpoint already covers
+ *              Expected: the map from before the run stopped, which
+ *                        may have lost its last lines
+ * Purpose:     move past the first NumDocs documents without reading
+ *              them, writing their names to the map again.  The
+ *              directory must list them in the order it did before.
+ * Returns:     false if there are too few files or the order changed
+*/
+bool DocumentSource::Skip(const int NumDocs, const vector<string> &Expected)
+{
+struct dirent* InputDirEntryPtr;
+
+   while (numdocs < NumDocs)
+   {
+      do
+      {
+         InputDirEntryPtr = readdir (dir);
+      } while ((InputDirEntryPtr != NULL) &&
+               (InputDirEntryPtr->d_name[0] == '.'));
+
+      if (InputDirEntryPtr == NULL ||
+          (numdocs < (int) Expected.size() && Expected[numdocs] != InputDirEntryPtr->d_name))
+         return false;
+      if (writemap)
+         map << InputDirEntryPtr->d_name << '\n';
+      numdocs++;
+   }
+   return true;
+}
+
+/* Name:  Continue
+ * Parameters:  NumDocs: the documents already in the index
+ * Purpose:     hand out DocIds after those of the index being added
+ *              to, from the first file of the directory
+ * Returns:     nothing
+*/
+void DocumentSource::Continue(const int NumDocs)
+{
+   numdocs = NumDocs;
+}
+
+/* Name:  Rewind
+ * Parameters:  none
+ * Purpose:     go back to the first document for another pass; the
+ *              map was written the first time through
+ * Returns:     nothing
+*/
+void DocumentSource::Rewind()
+{
+   rewinddir(dir);
+   writemap = false;
+   numdocs = 0;
+}
+
+/* Name:  GetNumDocs
+ * Parameters:  none
+ * Purpose:     the number of documents read so far
+ * Returns:     the highest DocId handed out
+*/
+int DocumentSource::GetNumDocs() const
+{
+   return numdocs;
+}
+
+/*-------------------------- The pipeline ---------------------------------*/
+
+struct Document   // a pooled input buffer
+{
+   int docid;
+   string filename;
+   vector<char> text;
+};
+
+struct TokenizerLane  // everything belonging to one tokenizer thread
+{
+   SpscQueue<Document *> docs;      // reader -> tokenizer
+   SpscQueue<Document *> freedocs;  // tokenizer -> reader
+   SpscQueue<TermBatch *> batches;  // tokenizer -> inverter
+   SpscQueue<TermBatch *> freebatches; // inverter -> tokenizer
+   vector<Document> docpool;
+   vector<TermBatch> batchpool;
+   int source;
+   bool signatures;                 // the inverter wants SimHashes
+   bool text;                       // and the documents' tokens
+   double seconds;                  // how long the thread ran
+
+   TokenizerLane() : docs(PIPELINE_QUEUE_DEPTH), freedocs(PIPELINE_QUEUE_DEPTH),
+                     batches(PIPELINE_QUEUE_DEPTH), freebatches(PIPELINE_QUEUE_DEPTH),
+                     docpool(PIPELINE_QUEUE_DEPTH), batchpool(PIPELINE_QUEUE_DEPTH)
+   {
+      for (int i = 0; i < PIPELINE_QUEUE_DEPTH; i++)
+      {
+         freedocs.Push(&docpool[i]);
+         freebatches.Push(&batchpool[i]);
+      }
+      signatures = false;
+      text = false;
+      seconds = 0.0;
+   }
+};
+
+static double SecondsSince(const chrono::steady_clock::time_point Start)
+{
+   return chrono::duration<double>(chrono::steady_clock::now() - Start).count();
+}
+
+/* Name:  ReadStage
+ * Parameters:  Source: the documents
+ *              Lanes: the tokenizers, fed round-robin
+ *              Seconds: receives how long the stage ran
+ * Purpose:     the reader thread: fill pooled buffers with file text
+ * Returns:     nothing
+*/
+static void ReadStage(DocumentSource &Source, vector<TokenizerLane *> &Lanes, double &Seconds)
+{
+chrono::steady_clock::time_point Start = chrono::steady_clock::now();
+unsigned long Lane = 0;
+Document *Doc;
+
+   for (;;)
+   {
+      Doc = Lanes[Lane]->freedocs.Pop();
+      if (!Source.Next(Doc->text, Doc->docid, Doc->filename))
+         break;
+      Lanes[Lane]->docs.Push(Doc);
+      Lane = (Lane + 1) % Lanes.size();
+   }
+
+   // a NULL document tells each tokenizer to finish
+   for (unsigned long i = 0; i < Lanes.size(); i++)
+      Lanes[i]->docs.Push(NULL);
+   Seconds = SecondsSince(Start);
+}
+
+/* Name:  TokenizeStage
+ * Parameters:  Lane: this tokenizer's queues
+ *              Stopwords: the words never to count
+ *              Shared: the table to post into directly, or NULL to
+ *                      send batches to the inverter
+ * Purpose:     a tokenizer thread: scan each document and pass on its words
+ * Returns:     nothing
+*/
+static void TokenizeStage(TokenizerLane &Lane, const vector<string> &Stopwords,
+                          ConcurrentGlobalHashTable *Shared)
+{
+chrono::steady_clock::time_point Start = chrono::steady_clock::now();
+Tokenizer Tok(Stopwords, Lane.source, Lane.signatures, Lane.text);
+Document *Doc;
+TermBatch *Batch;
+
+   while ((Doc = Lane.docs.Pop()) != NULL)
+   {
+      Tok.Scan(Doc->text);
+      if (Shared != NULL)
+         Tok.Transfer(Doc->docid, *Shared);
+      else
+      {
+         Batch = Lane.freebatches.Pop();
+         Tok.Transfer(Doc->docid, *Batch);
+         Batch->filename.swap(Doc->filename);
+         Lane.batches.Push(Batch);
+      }
+      Lane.freedocs.Push(Doc);
+   }
+   Lane.batches.Push(NULL);
+   Lane.seconds = SecondsSince(Start);
+}
+
+/* Name:  PrintStages
+ * Parameters:  Lanes: the tokenizers' queues
+ *              ReadSeconds: how long the reader ran
+ *              InvertSeconds: how long the inverter ran, or a negative
+ *                             number if the tokenizers posted directly
+ * Purpose:     report how long each stage was busy or stalled and how
+ *              deep each queue ran.  The busiest stage is the bottleneck.
+ * Returns:     nothing
+*/
+static void PrintStages(vector<TokenizerLane *> &Lanes, const double ReadSeconds,
+                        const double InvertSeconds)
+{
+double Stalled;
+char Name[64];
+
+   // busy time is running time less the time stalled on a queue
+   cout << "Pipeline stage          busy     stalled" << endl;
+   Stalled = 0.0;
+   for (unsigned long i = 0; i < Lanes.size(); i++)
+      Stalled += Lanes[i]->freedocs.GetEmptySeconds() + Lanes[i]->docs.GetFullSeconds();
+   cout << "reader        " << fixed << setprecision(3)
+        << setw(12) << ReadSeconds - Stalled << setw(12) << Stalled << endl;
+   for (unsigned long i = 0; i < Lanes.size(); i++)
+   {
+      Stalled = Lanes[i]->docs.GetEmptySeconds() + Lanes[i]->freebatches.GetEmptySeconds()
+              + Lanes[i]->batches.GetFullSeconds() + Lanes[i]->freedocs.GetFullSeconds();
+      cout << "tokenizer " << setw(3) << i
+           << setw(12) << Lanes[i]->seconds - Stalled << setw(12) << Stalled << endl;
+   }
+   if (InvertSeconds >= 0.0)
+   {
+      Stalled = 0.0;
+      for (unsigned long i = 0; i < Lanes.size(); i++)
+         Stalled += Lanes[i]->batches.GetEmptySeconds() + Lanes[i]->freebatches.GetFullSeconds();
+      cout << "inverter      " << setw(12) << InvertSeconds - Stalled << setw(12) << Stalled << endl;
+   }
+
+   for (unsigned long i = 0; i < Lanes.size(); i++)
+   {
+      snprintf(Name, sizeof(Name), "read->tokenize %lu", i);
+      Lanes[i]->docs.PrintStats(cout, Name);
+      if (InvertSeconds >= 0.0)
+      {
+         snprintf(Name, sizeof(Name), "tokenize %lu->invert", i);
+         Lanes[i]->batches.PrintStats(cout, Name);
+      }
+   }
+}
+
+/* Name:  RunPipeline
+ * Parameters:  Source: the documents to index
+ *              Invert: receives the batches, on this thread
+ *              Stopwords: the words never to count
+ *              NumTokenizers: how many tokenizer threads to run
+ * Purpose:     index every document with a reader thread, NumTokenizers
+ *              tokenizer threads and the inverter, then report on
+ *              each stage
+ * Returns:     nothing
+*/
+void RunPipeline(DocumentSource &Source, Inverter &Invert,
+                 const vector<string> &Stopwords, const int NumTokenizers)
+{
+chrono::steady_clock::time_point Start = chrono::steady_clock::now();
+vector<TokenizerLane *> Lanes;
+vector<thread> Threads;
+double ReadSeconds = 0.0;
+double InvertSeconds;
+unsigned long Lane = 0;
+TermBatch *Batch;
+
+   for (int i = 0; i < NumTokenizers; i++)
+   {
+      Lanes.push_back(new TokenizerLane);
+      Lanes[i]->source = Invert.AddSource();
+      Lanes[i]->signatures = Invert.IsDeduplicating();
+      Lanes[i]->text = Invert.IsStoringText();
+   }
+
+   Threads.push_back(thread(ReadStage, ref(Source), ref(Lanes), ref(ReadSeconds)));
+   for (int i = 0; i < NumTokenizers; i++)
+      Threads.push_back(thread(TokenizeStage, ref(*Lanes[i]), cref(Stopwords),
+                               (ConcurrentGlobalHashTable *) NULL));
+
+   // the inverter: take the batches back in DocId order
+   while ((Batch = Lanes[Lane]->batches.Pop()) != NULL)
+   {
+      Invert.Add(*Batch);
+      Lanes[Lane]->freebatches.Push(Batch);
+      Lane = (Lane + 1) % Lanes.size();
+   }
+   InvertSeconds = SecondsSince(Start);
+
+   for (unsigned long i = 0; i < Threads.size(); i++)
+      Threads[i].join();
+
+   PrintStages(Lanes, ReadSeconds, InvertSeconds);
+   for (int i = 0; i < NumTokenizers; i++)
+      delete Lanes[i];
+}
+
+/* Name:  RunPipeline
+ * Parameters:  Source: the documents to index
+ *              GlobalHT: the shared table the tokenizers post into
+ *              Stopwords: the words never to count
+ *              NumTokenizers: how many tokenizer threads to run
+ * Purpose:     index every document with a reader thread and
+ *              NumTokenizers tokenizer threads that each post their
+ *              own documents, with no inverter in between
+ * Returns:     nothing
+*/
+void RunPipeline(DocumentSource &Source, ConcurrentGlobalHashTable &GlobalHT,
+                 const vector<string> &Stopwords, const int NumTokenizers)
+{
+vector<TokenizerLane *> Lanes;
+vector<thread> Threads;
+double ReadSeconds = 0.0;
+
+   for (int i = 0; i < NumTokenizers; i++)
+   {
+      Lanes.push_back(new TokenizerLane);
+      Lanes[i]->source = i;
+   }
+
+   Threads.push_back(thread(ReadStage, ref(Source), ref(Lanes), ref(ReadSeconds)));
+   for (int i = 0; i < NumTokenizers; i++)
+      Threads.push_back(thread(TokenizeStage, ref(*Lanes[i]), cref(Stopwords), &GlobalHT));
+
+   for (unsigned long i = 0; i < Threads.size(); i++)
+      Threads[i].join();
+
+   PrintStages(Lanes, ReadSeconds, -1.0);
+   for (int i = 0; i < NumTokenizers; i++)
+      delete Lanes[i];
+}
@@ -0,0 +1,47 @@
+/* Filename:  pipeline.h
+ * Date:      10/19/26
+ * Purpose:   The header file for the indexing stages.  A DocumentSource
+ *            reads the input directory; RunPipeline connects a reader
+ *            thread, several tokenizer threads and the inverter (on
+ *            the calling thread) with bounded lock-free queues, or
+ *            lets the tokenizers post into a ConcurrentGlobalHashTable
+ *            themselves.
+*/
+
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include <dirent.h>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "inverter.h"
+#include "concurrentglobalhashtable.h"
+
+using namespace std;
+
+class DocumentSource {
+public:
+   DocumentSource(DIR *InputDirPtr, const char *InputDirname, ofstream &Map);
+   bool Next (vector<char> &Buffer, int &DocId);  // false when no files are left
+   bool Next (vector<char> &Buffer, int &DocId, string &Filename);
+   bool Skip (const int NumDocs, const vector<string> &Expected);  // to resume
+   void Continue (const int NumDocs);   // number from NumDocs + 1, to append
+   void Rewind ();      // start over, without writing the map again
+   int GetNumDocs () const;
+private:
+   DocumentSource (const DocumentSource& ds);
+   DIR *dir;
+   string dirname;
+   ofstream &map;
+   bool writemap;
+   int numdocs;
+};
+
+void RunPipeline (DocumentSource &Source, Inverter &Invert,
+                  const vector<string> &Stopwords, const int NumTokenizers);
+void RunPipeline (DocumentSource &Source, ConcurrentGlobalHashTable &GlobalHT,
+                  const vector<string> &Stopwords, const int NumTokenizers);
+
+#endif
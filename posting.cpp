@@ -4,9 +4,9 @@
 //-------------------------------------------
 #include <iostream>
 #include <iomanip>
+#include <stdio.h>
 #include "posting.h"
 
-#define POST_INT_LENGTH 4
 #define POST_FLOAT_LENGTH 10
 #define POST_FLOAT_PRECISION 3
 
@@ -57,3 +57,19 @@ void Posting::Print(ofstream &Dout, const float IDF) const
    Dout << setw (POST_INT_LENGTH) << docid << " " 
         << setw (POST_FLOAT_LENGTH) << fixed << setprecision(POST_FLOAT_PRECISION) << rtf*IDF << endl;
 }
+
+// Same text as Print(Dout, IDF), into a buffer; returns its length
+int Posting::Format(char *Line, const int Size, const float IDF) const
+{
+   return snprintf(Line, Size, "%*d %*.*f\n", POST_INT_LENGTH, docid,
+                   POST_FLOAT_LENGTH, POST_FLOAT_PRECISION, rtf*IDF);
+}
+
+// Same text as Print(Dout, IDF), through a buffered writer
+void Posting::Write(OutputWriter &Out, const float IDF) const
+{
+   Out.PutInt(docid, POST_INT_LENGTH);
+   Out.Put(' ');
+   Out.PutFixed(rtf*IDF, POST_FLOAT_LENGTH, POST_FLOAT_PRECISION);
+   Out.Put('\n');
+}
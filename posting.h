@@ -2,9 +2,16 @@
 // Filename: posting.h
 // Class to implement a very simple Posting class
 //-----------------------------------------
+#ifndef POSTING_H
+#define POSTING_H
+
 #include <fstream>
+#include "outputwriter.h"
 using namespace std;
 
+#define POST_INT_LENGTH 4      // the docid's width in a post line
+#define POST_LINE_LENGTH 16   // if the docid and weight fit their widths
+
 class Posting
 {
 public:
@@ -22,8 +29,12 @@ public:
   void Print() const;
   void Print(ofstream &Dout) const;
   void Print(ofstream &Dout, const float IDF) const;
+  int Format(char *Line, const int Size, const float IDF) const;
+  void Write(OutputWriter &Out, const float IDF) const;
 
 private:
   int docid;
   float rtf;
 };
+
+#endif
@@ -0,0 +1,475 @@
+/* Filename:  postingcodec.cpp
+ * Date:      10/19/2026
+ * Purpose:   The implementation file for the posting block codecs.
+*/
+
+#include <string.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "postingcodec.h"
+
+using namespace std;
+
+/*-------------------------- Shared Helpers -------------------------------*/
+
+static void PutVarint(unsigned int Value, vector<char> &Out)
+{
+   while (Value >= 0x80)
+   {
+      Out.push_back((char) (Value | 0x80));
+      Value >>= 7;
+   }
+   Out.push_back((char) Value);
+}
+
+static unsigned int GetVarint(const char *&In)
+{
+unsigned int Value = 0;
+int Shift = 0;
+
+   while (*In & 0x80)
+   {
+      Value |= (unsigned int) (*In++ & 0x7F) << Shift;
+      Shift += 7;
+   }
+   return Value | (unsigned int) (unsigned char) *In++ << Shift;
+}
+
+// The bits needed to hold Value; 0 needs none
+static int BitWidth(const unsigned int Value)
+{
+   return (Value == 0 ? 0 : 32 - __builtin_clz(Value));
+}
+
+static unsigned int LowMask(const int Bits)
+{
+   return (Bits >= 32 ? ~0u : (1u << Bits) - 1);
+}
+
+/*-------------------------- Variable Byte --------------------------------*/
+
+static void EncodeVByte(const int *DocIds, const int Count, int Previous, vector<char> &Out)
+{
+   for (int k = 0; k < Count; k++)
+   {
+      PutVarint(DocIds[k] - Previous, Out);
+      Previous = DocIds[k];
+   }
+}
+
+static const char *DecodeVByte(const char *In, const int Count, int Previous, int *DocIds)
+{
+   for (int k = 0; k < Count; k++)
+   {
+      Previous += GetVarint(In);
+      DocIds[k] = Previous;
+   }
+   return In;
+}
+
+/*-------------------------- Group Varint ---------------------------------*/
+
+/* Name:  EncodeGroupVarint
+ * Parameters:  DocIds, Count: the block
+ *              Previous: the DocId before it
+ *              Out: receives the bytes
+ * Purpose:     write the gaps four at a time: a control byte holding
+ *              each one's length less one in two bits, then the gaps'
+ *              low bytes.  The decoder learns four lengths from one
+ *              byte instead of testing a flag in every byte.
+ * Returns:     nothing
+*/
+static void EncodeGroupVarint(const int *DocIds, const int Count, int Previous, vector<char> &Out)
+{
+   for (int k = 0; k < Count; k += 4)
+   {
+      unsigned long Control = Out.size();
+      unsigned char Lengths = 0;
+
+      Out.push_back(0);
+      for (int i = 0; i < 4 && k + i < Count; i++)
+      {
+         unsigned int Gap = DocIds[k + i] - Previous;
+         int Length = (BitWidth(Gap) + 7) / 8;
+         if (Length == 0)
+            Length = 1;
+         Lengths |= (Length - 1) << (2 * i);
+         for (int b = 0; b < Length; b++)
+            Out.push_back((char) (Gap >> (8 * b)));
+         Previous = DocIds[k + i];
+      }
+      Out[Control] = (char) Lengths;
+   }
+}
+
+static const char *DecodeGroupVarint(const char *In, const int Count, int Previous, int *DocIds)
+{
+   for (int k = 0; k < Count; k += 4)
+   {
+      unsigned char Lengths = (unsigned char) *In++;
+
+      for (int i = 0; i < 4 && k + i < Count; i++)
+      {
+         const unsigned char *Bytes = (const unsigned char *) In;
+         unsigned int Gap;
+         switch ((Lengths >> (2 * i)) & 3)
+         {
+            case 0:  Gap = Bytes[0];  break;
+            case 1:  Gap = Bytes[0] | Bytes[1] << 8;  break;
+            case 2:  Gap = Bytes[0] | Bytes[1] << 8 | Bytes[2] << 16;  break;
+            default: Gap = Bytes[0] | Bytes[1] << 8 | Bytes[2] << 16 | (unsigned int) Bytes[3] << 24;  break;
+         }
+         In += ((Lengths >> (2 * i)) & 3) + 1;
+         Previous += Gap;
+         DocIds[k + i] = Previous;
+      }
+   }
+   return In;
+}
+
+/*-------------------------- Bit Packing (PFor) ---------------------------*/
+
+// Values are packed in four lanes, value i in lane i % 4, so that each
+// 16-byte word holds a 32-bit word of every lane and SSE2 packs and
+// unpacks all four lanes with one shift.  A block of 128 values at Bits
+// bits takes 16 * Bits bytes.
+
+static void Pack(const unsigned int *Values, const int Bits, char *Out)
+{
+#ifdef __SSE2__
+__m128i Word = _mm_setzero_si128();
+int Shift = 0;
+
+   for (int j = 0; j < CODEC_BLOCK_POSTINGS / 4 && Bits > 0; j++)
+   {
+      __m128i Row = _mm_loadu_si128((const __m128i *) (Values + 4 * j));
+      Word = _mm_or_si128(Word, _mm_sll_epi32(Row, _mm_cvtsi32_si128(Shift)));
+      Shift += Bits;
+      if (Shift >= 32)
+      {
+         _mm_storeu_si128((__m128i *) Out, Word);
+         Out += 16;
+         Shift -= 32;
+         Word = _mm_srl_epi32(Row, _mm_cvtsi32_si128(Bits - Shift));
+      }
+   }
+#else
+   for (int Lane = 0; Lane < 4 && Bits > 0; Lane++)
+   {
+      unsigned int Word = 0;
+      int Shift = 0;
+      int w = 0;
+
+      for (int j = 0; j < CODEC_BLOCK_POSTINGS / 4; j++)
+      {
+         unsigned int Value = Values[4 * j + Lane];
+         Word |= Value << Shift;
+         Shift += Bits;
+         if (Shift >= 32)
+         {
+            memcpy(Out + 16 * w++ + 4 * Lane, &Word, 4);
+            Shift -= 32;
+            Word = (Shift > 0 ? Value >> (Bits - Shift) : 0);
+         }
+      }
+   }
+#endif
+}
+
+static void Unpack(const char *In, const int Bits, unsigned int *Values)
+{
+#ifdef __SSE2__
+__m128i Mask = _mm_set1_epi32((int) LowMask(Bits));
+__m128i Word = (Bits > 0 ? _mm_loadu_si128((const __m128i *) In) : _mm_setzero_si128());
+int Shift = 0;
+int w = 0;
+
+   for (int j = 0; j < CODEC_BLOCK_POSTINGS / 4; j++)
+   {
+      __m128i Row = _mm_srl_epi32(Word, _mm_cvtsi32_si128(Shift));
+      Shift += Bits;
+      if (Shift >= 32 && ++w < Bits)
+      {
+         Shift -= 32;
+         Word = _mm_loadu_si128((const __m128i *) (In + 16 * w));
+         Row = _mm_or_si128(Row, _mm_sll_epi32(Word, _mm_cvtsi32_si128(Bits - Shift)));
+      }
+      _mm_storeu_si128((__m128i *) (Values + 4 * j), _mm_and_si128(Row, Mask));
+   }
+#else
+unsigned int Mask = LowMask(Bits);
+
+   for (int Lane = 0; Lane < 4; Lane++)
+   {
+      unsigned int Word = 0;
+      int Shift = 0;
+      int w = 0;
+
+      if (Bits > 0)
+         memcpy(&Word, In + 4 * Lane, 4);
+      for (int j = 0; j < CODEC_BLOCK_POSTINGS / 4; j++)
+      {
+         unsigned int Value = (Shift < 32 ? Word >> Shift : 0);
+         Shift += Bits;
+         if (Shift >= 32 && ++w < Bits)
+         {
+            Shift -= 32;
+            memcpy(&Word, In + 16 * w + 4 * Lane, 4);
+            if (Shift > 0)
+               Value |= Word << (Bits - Shift);
+         }
+         Values[4 * j + Lane] = Value & Mask;
+      }
+   }
+#endif
+}
+
+// Turn a block of gaps into DocIds, four at a time
+static void PrefixSum(int *DocIds, const int Previous)
+{
+#ifdef __SSE2__
+__m128i Base = _mm_set1_epi32(Previous);
+
+   for (int j = 0; j < CODEC_BLOCK_POSTINGS / 4; j++)
+   {
+      __m128i Row = _mm_loadu_si128((const __m128i *) (DocIds + 4 * j));
+      Row = _mm_add_epi32(Row, _mm_slli_si128(Row, 4));
+      Row = _mm_add_epi32(Row, _mm_slli_si128(Row, 8));
+      Row = _mm_add_epi32(Row, Base);
+      _mm_storeu_si128((__m128i *) (DocIds + 4 * j), Row);
+      Base = _mm_shuffle_epi32(Row, 0xFF);
+   }
+#else
+int DocId = Previous;
+
+   for (int k = 0; k < CODEC_BLOCK_POSTINGS; k++)
+   {
+      DocId += DocIds[k];
+      DocIds[k] = DocId;
+   }
+#endif
+}
+
+/* Name:  EncodePFor
+ * Parameters:  DocIds, Count: the block
+ *              Previous: the DocId before it
+ *              Out: receives the bytes
+ * Purpose:     pack a full block's gaps at the width that makes the
+ *              block smallest: the gaps wider than that keep their low
+ *              bits in the packing and have the rest patched in after
+ *              it (a byte for the position, a varint for the high
+ *              bits), so one large gap does not widen every other.
+ *              A short last block is written as varints.
+ * Returns:     nothing
+*/
+static void EncodePFor(const int *DocIds, const int Count, const int Previous, vector<char> &Out)
+{
+unsigned int Gaps[CODEC_BLOCK_POSTINGS];
+unsigned int Lows[CODEC_BLOCK_POSTINGS];
+int Widths[33];
+int Bits = 0;
+long BestCost = -1;
+
+   if (Count < CODEC_BLOCK_POSTINGS)
+   {
+      EncodeVByte(DocIds, Count, Previous, Out);
+      return;
+   }
+
+   memset(Widths, 0, sizeof(Widths));
+   for (int k = 0; k < CODEC_BLOCK_POSTINGS; k++)
+   {
+      Gaps[k] = DocIds[k] - (k == 0 ? Previous : DocIds[k - 1]);
+      Widths[BitWidth(Gaps[k])]++;
+   }
+   for (int b = 0; b <= 32; b++)
+   {
+      long Cost = CODEC_BLOCK_POSTINGS * b;
+      for (int w = b + 1; w <= 32; w++)
+         Cost += Widths[w] * (8 + 8 * ((w - b + 6) / 7));
+      if (BestCost < 0 || Cost < BestCost)
+      {
+         BestCost = Cost;
+         Bits = b;
+      }
+   }
+
+   int NumExceptions = 0;
+   for (int k = 0; k < CODEC_BLOCK_POSTINGS; k++)
+   {
+      Lows[k] = Gaps[k] & LowMask(Bits);
+      if (BitWidth(Gaps[k]) > Bits)
+         NumExceptions++;
+   }
+   Out.push_back((char) Bits);
+   Out.push_back((char) NumExceptions);
+   unsigned long Packed = Out.size();
+   Out.resize(Packed + 16 * Bits);
+   Pack(Lows, Bits, Out.data() + Packed);
+   for (int k = 0; k < CODEC_BLOCK_POSTINGS; k++)
+      if (BitWidth(Gaps[k]) > Bits)
+      {
+         Out.push_back((char) k);
+         PutVarint(Gaps[k] >> Bits, Out);
+      }
+}
+
+static const char *DecodePFor(const char *In, const int Count, const int Previous, int *DocIds)
+{
+int Bits;
+int NumExceptions;
+
+   if (Count < CODEC_BLOCK_POSTINGS)
+      return DecodeVByte(In, Count, Previous, DocIds);
+
+   Bits = (unsigned char) *In++;
+   NumExceptions = (unsigned char) *In++;
+   Unpack(In, Bits, (unsigned int *) DocIds);
+   In += 16 * Bits;
+   for (int e = 0; e < NumExceptions; e++)
+   {
+      int k = (unsigned char) *In++;
+      DocIds[k] |= GetVarint(In) << Bits;
+   }
+   PrefixSum(DocIds, Previous);
+   return In;
+}
+
+/*-------------------------- Elias-Fano -----------------------------------*/
+
+/* Name:  EncodeEliasFano
+ * Parameters:  DocIds, Count: the block
+ *              Previous: the DocId before it
+ *              Out: receives the bytes
+ * Purpose:     write each DocId's offset past Previous as LowBits low
+ *              bits, packed, and a high part in unary: the k-th offset
+ *              sets bit (high part + k) of a bitmap.  LowBits is
+ *              log2(span / Count), so a block costs about
+ *              2 + log2(span / Count) bits per DocId however the gaps
+ *              are spread.
+ * Returns:     nothing
+*/
+static void EncodeEliasFano(const int *DocIds, const int Count, const int Previous, vector<char> &Out)
+{
+unsigned int Last = DocIds[Count - 1] - Previous - 1;
+unsigned long Buffer = 0;
+int Buffered = 0;
+int LowBits = 0;
+
+   while (((unsigned long) Count << (LowBits + 1)) <= (unsigned long) Last + 1)
+      LowBits++;
+   Out.push_back((char) LowBits);
+
+   for (int k = 0; k < Count && LowBits > 0; k++)
+   {
+      Buffer |= (unsigned long) ((DocIds[k] - Previous - 1) & LowMask(LowBits)) << Buffered;
+      Buffered += LowBits;
+      while (Buffered >= 8)
+      {
+         Out.push_back((char) Buffer);
+         Buffer >>= 8;
+         Buffered -= 8;
+      }
+   }
+   if (Buffered > 0)
+      Out.push_back((char) Buffer);
+
+   unsigned long Highs = Out.size();
+   Out.resize(Highs + ((Last >> LowBits) + Count + 7) / 8, 0);
+   for (int k = 0; k < Count; k++)
+   {
+      unsigned int Bit = ((unsigned int) (DocIds[k] - Previous - 1) >> LowBits) + k;
+      Out[Highs + Bit / 8] |= (char) (1 << (Bit % 8));
+   }
+}
+
+static const char *DecodeEliasFano(const char *In, const int Count, const int Previous, int *DocIds)
+{
+int LowBits = (unsigned char) *In++;
+unsigned long Buffer = 0;
+int Buffered = 0;
+int k = 0;
+
+   for (int i = 0; i < Count; i++)
+   {
+      while (Buffered < LowBits)
+      {
+         Buffer |= (unsigned long) (unsigned char) *In++ << Buffered;
+         Buffered += 8;
+      }
+      DocIds[i] = Buffer & LowMask(LowBits);
+      Buffer >>= LowBits;
+      Buffered -= LowBits;
+   }
+
+   for (unsigned int Byte = 0; ; Byte++)
+   {
+      unsigned int Bits = (unsigned char) In[Byte];
+      while (Bits != 0)
+      {
+         unsigned int High = Byte * 8 + __builtin_ctz(Bits) - k;
+         DocIds[k] = Previous + 1 + (int) ((High << LowBits) | DocIds[k]);
+         if (++k == Count)
+            return In + Byte + 1;
+         Bits &= Bits - 1;
+      }
+   }
+}
+
+/*-------------------------- PostingCodec ---------------------------------*/
+
+struct CodecEntry
+{
+   const char *name;
+   void (*encode) (const int *DocIds, const int Count, int Previous, vector<char> &Out);
+   const char *(*decode) (const char *In, const int Count, int Previous, int *DocIds);
+};
+
+static const CodecEntry Codecs[CODEC_COUNT] =
+{
+   { "vbyte",         EncodeVByte,        DecodeVByte },
+   { "group-varint",  EncodeGroupVarint,  DecodeGroupVarint },
+   { "pfor",          EncodePFor,         DecodePFor },
+   { "elias-fano",    EncodeEliasFano,    DecodeEliasFano }
+};
+
+/* Name:  Choose
+ * Parameters:  NumDocs: the length of a list
+ *              LastDocId: its last DocId
+ * Purpose:     pick a list's codec.  The shortest lists stay varints,
+ *              which cost little either way.  A list of one partial
+ *              block cannot be bit-packed, and Elias-Fano beats varints
+ *              on it unless the DocIds come in clusters.  Full blocks
+ *              are bit-packed, unless the list is so sparse that its
+ *              gaps are spread evenly and Elias-Fano does better.
+ *              Group varint never comes out smallest on these lists, so
+ *              it is only chosen by asking for it.
+ * Returns:     the codec
+*/
+CodecType PostingCodec::Choose(const int NumDocs, const int LastDocId)
+{
+   if (NumDocs < CODEC_SHORT_LIST)
+      return CODEC_VBYTE;
+   if (NumDocs < CODEC_BLOCK_POSTINGS || (long) LastDocId > (long) NumDocs * CODEC_SPARSE_GAP)
+      return CODEC_ELIAS_FANO;
+   return CODEC_PFOR;
+}
+
+const char *PostingCodec::GetName(const CodecType Codec)
+{
+   return Codecs[Codec].name;
+}
+
+void PostingCodec::Encode(const CodecType Codec, const int *DocIds, const int Count,
+                          const int Previous, vector<char> &Out)
+{
+   Codecs[Codec].encode(DocIds, Count, Previous, Out);
+}
+
+const char *PostingCodec::Decode(const CodecType Codec, const char *In, const int Count,
+                                 const int Previous, int *DocIds)
+{
+   return Codecs[Codec].decode(In, Count, Previous, DocIds);
+}
@@ -0,0 +1,56 @@
+/* Filename:  postingcodec.h
+ * Date:      10/19/26
+ * Purpose:   The header file for the codecs that pack a block's DocIds
+ *            in bpost.  Each codec turns up to BPOST_BLOCK_POSTINGS
+ *            increasing DocIds, after the last DocId of the block
+ *            before, into bytes and back:
+ *
+ *            CODEC_VBYTE         each gap as a varint, 7 bits a byte
+ *            CODEC_GROUP_VARINT  gaps in fours behind a control byte
+ *                                giving each one's length in bytes
+ *            CODEC_PFOR          a full block's gaps bit-packed at one
+ *                                width (SIMD-BP128 layout, four lanes),
+ *                                the few wider gaps patched after it;
+ *                                a short last block falls back to
+ *                                varints
+ *            CODEC_ELIAS_FANO    the DocIds themselves, low bits packed
+ *                                and high bits in unary, whose size
+ *                                depends only on the span of the block
+ *
+ *            A new codec is an entry in CodecType and a row in the
+ *            table in postingcodec.cpp.  Choose picks one per list by
+ *            its length and density, and bpost records the choice in
+ *            the list's directory entry.
+*/
+
+#ifndef POSTINGCODEC_H
+#define POSTINGCODEC_H
+
+#include <vector>
+
+#define CODEC_BLOCK_POSTINGS 128   // the most DocIds in one block
+#define CODEC_SHORT_LIST 32        // shorter lists keep plain varints
+#define CODEC_SPARSE_GAP 16        // a longer average gap is sparse
+
+using namespace std;
+
+enum CodecType
+{
+   CODEC_VBYTE = 0,
+   CODEC_GROUP_VARINT,
+   CODEC_PFOR,
+   CODEC_ELIAS_FANO,
+   CODEC_COUNT
+};
+
+class PostingCodec {
+public:
+   static CodecType Choose (const int NumDocs, const int LastDocId);
+   static const char *GetName (const CodecType Codec);
+   static void Encode (const CodecType Codec, const int *DocIds, const int Count,
+                       const int Previous, vector<char> &Out);
+   static const char *Decode (const CodecType Codec, const char *In, const int Count,
+                              const int Previous, int *DocIds);   // returns the end
+};
+
+#endif
@@ -0,0 +1,203 @@
+/* Filename:  query.cpp
+ * Date:      10/19/2026
+ * Purpose:   Search an index made by invert.
+ * To compile: g++ -O2 -pthread -o query query.cpp queryengine.cpp termtrie.cpp
+ *                 blockpost.cpp postingcodec.cpp
+ *                 impactquantizer.cpp docstore.cpp forwardindex.cpp
+ *                 hottier.cpp outputwriter.cpp segment.cpp ratelimiter.cpp
+ * To run:    ./query [--hot MB] [--all | --batch | --feedback] <indexdir> [words]
+ *            ./query --like <indexdir> <filename>
+ *            With no words, each line of standard input is a query.
+ *            With --all, only documents holding every word are ranked.
+ *            With --batch, every query on standard input is read first
+ *            and they are ranked together on all cores.
+ *            With --feedback, the words of the best results are added
+ *            to the query (the index needs --forward).
+ *            With --like, the documents most like the one indexed
+ *            from filename, as the map names it, are shown.
+ *            With --hot, the postings of the most searched terms are
+ *            kept decoded in up to MB megabytes; the access counts are
+ *            saved in <indexdir>/hotprofile on exit and loaded from it
+ *            on the next run, which starts with those terms hot.
+ *            A word may end in * (comput*), use * and ? anywhere
+ *            (c?t, h*se), give a range of terms (apple..apply), or
+ *            end in ~ or ~2 to allow one or two misspellings (recieve~).
+ *            Words that match nothing get a suggestion.  If the index
+ *            was made with --docstore, each result shows a snippet.
+ *            An index made or added to by invert --segments is searched
+ *            in its segments, and while invert is still writing them
+ *            each query on standard input picks up those flushed since.
+ *            --all needs bpost, so it is refused on an index with
+ *            segments; --batch ranks its queries one at a time there.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "queryengine.h"
+
+#define QUERY_RESULTS_NBR 10
+
+using namespace std;
+
+// Print a query's best documents, with suggestions for unknown words
+// and, if the index stores the documents, a snippet of each
+static void PrintResults(QueryEngine &Engine, const string Query, const vector<QueryResult> &Results)
+{
+vector<TrieMatch> Matches;
+istringstream Words(Query);
+string Word;
+string Suggestion;
+string Snippet;
+
+   cout << Results.size() << " results for: " << Query << endl;
+   while (Words >> Word)
+   {
+      Matches.clear();
+      Engine.ExpandTerm(Word, Matches);
+      if (Matches.empty() && Word.find_first_of("*?~.") == string::npos &&
+          Engine.Suggest(Word, Suggestion))
+         cout << "     " << Word << ": did you mean " << Suggestion << "?" << endl;
+   }
+   for (unsigned long r = 0; r < Results.size(); r++)
+   {
+      cout << setw(3) << r + 1 << "  " << setw(10) << fixed << setprecision(3)
+           << Results[r].score << "  " << Engine.GetFilename(Results[r].docid) << endl;
+      if (Engine.GetSnippet(Results[r].docid, Query, Snippet))
+         cout << "                 " << Snippet << endl;
+   }
+}
+
+// Run one query and print its best documents
+static void RunQuery(QueryEngine &Engine, const string Query, const bool All, const bool Feedback)
+{
+vector<QueryResult> Results;
+
+   if (All)
+      Engine.SearchAll(Query, QUERY_RESULTS_NBR, Results);
+   else if (Feedback)
+      Engine.SearchFeedback(Query, QUERY_RESULTS_NBR, Results);
+   else
+      Engine.Search(Query, QUERY_RESULTS_NBR, Results);
+   PrintResults(Engine, Query, Results);
+}
+
+int main(int argc, char **argv)
+{
+string Query;
+vector<string> Queries;
+vector< vector<QueryResult> > Results;
+vector<QueryResult> Similar;
+bool All = false;
+bool Batch = false;
+bool Feedback = false;
+bool Like = false;
+long HotMB = 0;
+int ArgIndex = 1;
+
+   if (ArgIndex + 1 < argc && strcmp(argv[ArgIndex], "--hot") == 0)
+   {
+      HotMB = atol(argv[ArgIndex + 1]);
+      ArgIndex += 2;
+   }
+   if (ArgIndex < argc && strcmp(argv[ArgIndex], "--all") == 0)
+   {
+      All = true;
+      ArgIndex++;
+   }
+   else if (ArgIndex < argc && strcmp(argv[ArgIndex], "--batch") == 0)
+   {
+      Batch = true;
+      ArgIndex++;
+   }
+   else if (ArgIndex < argc && strcmp(argv[ArgIndex], "--feedback") == 0)
+   {
+      Feedback = true;
+      ArgIndex++;
+   }
+   else if (ArgIndex < argc && strcmp(argv[ArgIndex], "--like") == 0)
+   {
+      Like = true;
+      ArgIndex++;
+   }
+   if (argc - ArgIndex < 1 || (Like && argc - ArgIndex != 2) || HotMB < 0)
+   {
+      fprintf (stderr, "Usage: %s [--hot MB] [--all | --batch | --feedback] <indexdir> [words]\n", argv[0]);
+      fprintf (stderr, "       %s --like <indexdir> <filename>\n", argv[0]);
+      return (1);
+   }
+
+   QueryEngine Engine(argv[ArgIndex]);
+   if (!Engine.IsOpen())
+      return (1);
+   if ((Feedback || Like) && !Engine.HasForwardIndex())
+   {
+      fprintf (stderr, "%s has no fwd; index it with --forward.\n", argv[ArgIndex]);
+      return (1);
+   }
+   if (All && Engine.Refresh() > 0)
+   {
+      fprintf (stderr, "%s has segments, which --all cannot search; leave it out.\n", argv[ArgIndex]);
+      return (1);
+   }
+   if (HotMB > 0)
+   {
+      Engine.StartHotTier(HotMB * 1048576);
+      Engine.GetHotTier().LoadProfile((string) argv[ArgIndex] + "/hotprofile");
+   }
+
+   if (Like)
+   {
+      int DocId = 0;
+      for (int d = 1; d <= Engine.GetNumDocs() && DocId == 0; d++)
+         if (Engine.GetFilename(d) == argv[ArgIndex + 1])
+            DocId = d;
+      if (DocId == 0)
+      {
+         fprintf (stderr, "%s is not in the index.\n", argv[ArgIndex + 1]);
+         return (1);
+      }
+      Engine.MoreLikeThis(DocId, QUERY_RESULTS_NBR, Similar);
+      cout << Similar.size() << " documents like: " << argv[ArgIndex + 1] << endl;
+      for (unsigned long r = 0; r < Similar.size(); r++)
+         cout << setw(3) << r + 1 << "  " << setw(10) << fixed << setprecision(3)
+              << Similar[r].score << "  " << Engine.GetFilename(Similar[r].docid) << endl;
+   }
+   else if (argc - ArgIndex > 1)
+   {
+      for (int i = ArgIndex + 1; i < argc; i++)
+         Query = Query + (i > ArgIndex + 1 ? " " : "") + argv[i];
+      RunQuery(Engine, Query, All, Feedback);
+   }
+   else if (Batch && Engine.Refresh() > 0)
+      while (getline(cin, Query))
+         RunQuery(Engine, Query, false, false);   // the batch reads only the printed index
+   else if (Batch)
+   {
+      while (getline(cin, Query))
+         Queries.push_back(Query);
+      Engine.SearchBatch(Queries, QUERY_RESULTS_NBR, 0, Results);
+      for (unsigned long q = 0; q < Queries.size(); q++)
+         PrintResults(Engine, Queries[q], Results[q]);
+   }
+   else
+      while (getline(cin, Query))
+      {
+         Engine.Refresh();   // segments flushed since the last query
+         RunQuery(Engine, Query, All, Feedback);
+      }
+
+   if (HotMB > 0)
+   {
+      Engine.GetHotTier().PrintReport();
+      if (!Engine.GetHotTier().SaveProfile((string) argv[ArgIndex] + "/hotprofile"))
+         fprintf (stderr, "Unable to write %s/hotprofile.\n", argv[ArgIndex]);
+   }
+   return (0);
+}
@@ -0,0 +1,1093 @@
+/* Filename:  queryengine.cpp
+ * Date:      10/19/2026
+ * Purpose:   The implementation file for the query engine.
+*/
+
+#include <ctype.h>
+#include <math.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <sstream>
+#include <thread>
+#include <unordered_map>
+
+#include "queryengine.h"
+#include "posting.h"
+
+using namespace std;
+
+// Whether a ranks before b: the higher score, or the lower DocId on a tie
+static bool Better(const QueryResult &a, const QueryResult &b)
+{
+   if (a.score != b.score)
+      return a.score > b.score;
+   return a.docid < b.docid;
+}
+
+/*-------------------------- Constructors/Destructors ----------------------*/
+
+/* Name:  QueryEngine
+ * Parameters:  IndexDirname: the output directory of invert
+ * Purpose:     load the map, the term trie and post, open docs and fwd
+ *              if they are there, and open any segments.  An index made
+ *              with invert --segments has only segments.
+ * Returns:     nothing
+*/
+QueryEngine::QueryEngine(const string IndexDirname)
+   : indexdirname(IndexDirname)
+{
+ifstream Map((IndexDirname + "/map").c_str());
+ifstream Post((IndexDirname + "/post").c_str(), ios::binary);
+struct stat Info;
+string Filename;
+bool Fixed;
+
+   open = false;
+   live = NULL;
+   generation = 0;
+   if (!Post.is_open() && stat((IndexDirname + "/segments").c_str(), &Info) == 0)
+   {
+      Refresh();
+      open = true;
+      return;
+   }
+   if (!Map.is_open() || !Post.is_open())
+   {
+      cerr << "Unable to open the index in " << IndexDirname << endl;
+      return;
+   }
+   if (!trie.Read(IndexDirname + "/trie"))
+   {
+      cerr << "Unable to read " << IndexDirname << "/trie" << endl;
+      return;
+   }
+
+   // a near-duplicate's line ends with a tab and the DocId it copies
+   while (getline(Map, Filename))
+      filenames.push_back(Filename.substr(0, Filename.find('\t')));
+
+   // with bpost, cursors read the postings as they are needed
+   if (!blockpost.Open(IndexDirname + "/bpost"))
+   {
+      post.assign(istreambuf_iterator<char>(Post), istreambuf_iterator<char>());
+      post.push_back('\0');   // so the last line always ends for strtol
+
+      // post lines are normally all the same length; otherwise index them
+      Fixed = ((post.size() - 1) % POST_LINE_LENGTH == 0);
+      for (unsigned long i = POST_LINE_LENGTH - 1; Fixed && i < post.size() - 1; i += POST_LINE_LENGTH)
+         Fixed = (post[i] == '\n');
+      if (!Fixed)
+      {
+         lines.push_back(0);
+         for (unsigned long i = 0; i + 1 < post.size(); i++)
+            if (post[i] == '\n')
+               lines.push_back(i + 1);
+      }
+   }
+
+   docstore.Open(IndexDirname + "/docs");
+
+   // fwd names terms by their place among the terms with postings
+   if (forward.Open(IndexDirname + "/fwd"))
+   {
+      vector<TrieMatch> Entries;
+      trie.Numbered(Entries);
+      for (unsigned long e = 0; e < Entries.size(); e++)
+         termsbyid.push_back(Entries[e].entry);
+      if (termsbyid.size() != forward.GetNumTerms())
+      {
+         cerr << IndexDirname << "/fwd does not match the trie; it is not used." << endl;
+         termsbyid.clear();
+      }
+   }
+   scores.assign(filenames.size() + 1, 0.0);
+   Refresh();
+   open = true;
+}
+
+QueryEngine::~QueryEngine()
+{
+   for (unsigned long s = 0; s < segments.size(); s++)
+      delete segments[s];
+}
+
+/*-------------------------- Accessors ------------------------------------*/
+
+bool QueryEngine::IsOpen() const
+{
+   return open;
+}
+
+/* Name:  Search
+ * Parameters:  Query: the words to look for
+ *              NumResults: how many documents to return
+ *              Results: receives the best documents, best first
+ * Purpose:     rank the documents containing any query term by the
+ *              sum of their post weights for the terms
+ * Returns:     nothing
+*/
+void QueryEngine::Search(const string Query, const int NumResults, vector<QueryResult> &Results)
+{
+istringstream Words(Query);
+vector<TrieMatch> Matches;
+string Word;
+
+   Results.clear();
+   if (live != NULL && (int) scores.size() <= GetNumDocs())
+      scores.resize(GetNumDocs() + 1, 0.0);
+   while (Words >> Word)
+   {
+      Matches.clear();
+      ExpandTerm(Word, Matches);
+      for (unsigned long m = 0; m < Matches.size(); m++)
+         AddPostings(Matches[m].entry, 1.0);
+      if (live != NULL || !segments.empty())
+         AddSegmentPostings(Word);
+   }
+
+   TopResults(NumResults, Results);
+}
+
+/* Name:  SearchAll
+ * Parameters:  Query: the words that must all be in a document
+ *              NumResults: how many documents to return
+ *              Results: receives the best documents, best first
+ * Purpose:     rank the documents containing every query word (any of
+ *              a wildcard's terms will do) by the sum of their weights.
+ *              The word with the fewest postings proposes a DocId and
+ *              every other word's cursors advance to it; a word that
+ *              overshoots proposes its own DocId instead.  Cursors skip
+ *              straight to the block that might hold the DocId, so
+ *              most of a common word's list is never decoded.  Needs
+ *              bpost; segments are not searched.
+ * Returns:     nothing
+*/
+void QueryEngine::SearchAll(const string Query, const int NumResults, vector<QueryResult> &Results)
+{
+istringstream Words(Query);
+vector<TrieMatch> Matches;
+vector< vector<PostingCursor> > Cursors;   // per word, one per term
+vector<long> Sizes;
+string Word;
+int Target = 0;
+unsigned long w = 0;
+
+   Results.clear();
+   if (!blockpost.IsOpen())
+   {
+      cerr << "Searching for every word needs bpost in the index." << endl;
+      return;
+   }
+   while (Words >> Word)
+   {
+      Matches.clear();
+      ExpandTerm(Word, Matches);
+      Cursors.push_back(vector<PostingCursor>(Matches.size()));
+      Sizes.push_back(0);
+      for (unsigned long m = 0; m < Matches.size(); m++)
+      {
+         blockpost.GetCursor(Matches[m].entry, Cursors.back()[m]);
+         Sizes.back() += Matches[m].entry.numdocs;
+      }
+   }
+   if (Cursors.empty())
+      return;
+
+   // the rarest word leads
+   vector<unsigned long> Order(Cursors.size());
+   for (unsigned long i = 0; i < Order.size(); i++)
+      Order[i] = i;
+   sort(Order.begin(), Order.end(), [&](unsigned long a, unsigned long b) { return Sizes[a] < Sizes[b]; });
+
+   // each word in turn moves to Target; once all agree it is a match
+   for (unsigned long Agreed = 0; Target != CURSOR_END; w = (w + 1) % Order.size())
+   {
+      int Lowest = CURSOR_END;
+      vector<PostingCursor> &Terms = Cursors[Order[w]];
+      for (unsigned long m = 0; m < Terms.size(); m++)
+      {
+         Terms[m].AdvanceTo(Target);
+         Lowest = min(Lowest, Terms[m].GetDocId());
+      }
+      if (Lowest != Target)
+      {
+         Target = Lowest;
+         Agreed = 0;
+      }
+      if (Target != CURSOR_END && ++Agreed == Order.size())
+      {
+         float Score = 0.0;
+         for (unsigned long i = 0; i < Cursors.size(); i++)
+            for (unsigned long m = 0; m < Cursors[i].size(); m++)
+               if (Cursors[i][m].GetDocId() == Target)
+                  Score += Cursors[i][m].Score();
+         if (Target >= 1 && Target < (int) scores.size())
+         {
+            touched.push_back(Target);
+            scores[Target] = Score;
+         }
+         Target++;
+         Agreed = 0;
+      }
+   }
+
+   TopResults(NumResults, Results);
+}
+
+/* Name:  SearchBatch
+ * Parameters:  Queries: the queries to rank, as Search takes them
+ *              NumResults: how many documents to return for each
+ *              NumThreads: the threads to rank them on, or 0 for one
+ *                          per core
+ *              Results: receives each query's best documents, in the
+ *                       order of Queries
+ * Purpose:     rank many queries at once.  Each query's words are
+ *              expanded, then the queries are ordered by the start of
+ *              their longest list, so queries sharing the list most
+ *              costly to read land in the same group.  The lists more
+ *              than one group needs are decoded first, once, by all
+ *              the threads, then the threads take groups of
+ *              QUERY_BATCH_GROUP in turn.  Scores are
+ *              the same sums as Search's, though a query of three or
+ *              more terms may add them in another order and so differ
+ *              in the last bit.  Only the printed index is read, not
+ *              the segments.
+ * Returns:     nothing
+*/
+void QueryEngine::SearchBatch(const vector<string> &Queries, const int NumResults, const int NumThreads,
+                              vector< vector<QueryResult> > &Results) const
+{
+vector< vector<TrieEntry> > Terms(Queries.size());
+vector<unsigned long> Keys(Queries.size(), 0);
+vector<int> Order(Queries.size());
+vector<TrieMatch> Matches;
+vector<thread> Threads;
+atomic<unsigned long> Next(0);
+atomic<unsigned long> NextList(0);
+map<unsigned long, pair<unsigned long, int> > Uses;   // a list's start, to the last group
+                                                      //    needing it and how many do
+vector<TrieEntry> SharedEntries;
+map<unsigned long, int> SharedIndex;   // a shared list's start, to its place in Shared
+vector<DecodedList> Shared;
+unsigned int Count = NumThreads > 0 ? NumThreads : max(1u, thread::hardware_concurrency());
+
+   Results.assign(Queries.size(), vector<QueryResult>());
+   for (unsigned long q = 0; q < Queries.size(); q++)
+   {
+      istringstream Words(Queries[q]);
+      string Word;
+      int Longest = 0;
+      while (Words >> Word)
+      {
+         Matches.clear();
+         ExpandTerm(Word, Matches);
+         for (unsigned long m = 0; m < Matches.size(); m++)
+         {
+            Terms[q].push_back(Matches[m].entry);
+            if (Matches[m].entry.numdocs > Longest)
+            {
+               Longest = Matches[m].entry.numdocs;
+               Keys[q] = Matches[m].entry.start;
+            }
+         }
+      }
+      Order[q] = q;
+   }
+   stable_sort(Order.begin(), Order.end(), [&](int a, int b) { return Keys[a] < Keys[b]; });
+
+   // the lists that more than one group reads
+   for (unsigned long First = 0; First < Order.size(); First += QUERY_BATCH_GROUP)
+      for (unsigned long k = First; k < min(First + QUERY_BATCH_GROUP, Order.size()); k++)
+         for (unsigned long t = 0; t < Terms[Order[k]].size(); t++)
+         {
+            const TrieEntry &Entry = Terms[Order[k]][t];
+            pair<unsigned long, int> &Use = Uses.insert(make_pair(Entry.start, make_pair(First, 0))).first->second;
+            if (Use.second > 0 && Use.first == First)
+               continue;
+            Use.first = First;
+            if (++Use.second == 2)
+            {
+               SharedIndex[Entry.start] = SharedEntries.size();
+               SharedEntries.push_back(Entry);
+            }
+         }
+   Shared.resize(SharedEntries.size());
+
+   for (unsigned int t = 0; t < Count; t++)
+      Threads.push_back(thread([&]()
+      {
+         unsigned long First;
+         while ((First = NextList.fetch_add(1)) < SharedEntries.size())
+            ReadPostings(SharedEntries[First], Shared[First].docids, Shared[First].weights);
+      }));
+   for (unsigned int t = 0; t < Count; t++)
+      Threads[t].join();
+   Threads.clear();
+
+   for (unsigned int t = 0; t < Count; t++)
+      Threads.push_back(thread([&]()
+      {
+         vector<float> Tile(QUERY_BATCH_TILE * QUERY_BATCH_GROUP, 0.0);
+         unsigned long First;
+         while ((First = Next.fetch_add(QUERY_BATCH_GROUP)) < Order.size())
+            SearchGroup(Terms, Order.data() + First, min((unsigned long) QUERY_BATCH_GROUP, Order.size() - First),
+                        NumResults, SharedIndex, Shared, Tile, Results);
+      }));
+   for (unsigned int t = 0; t < Count; t++)
+      Threads[t].join();
+}
+
+/* Name:  ExpandTerm
+ * Parameters:  Word: a query word, wildcard or range
+ *              Matches: receives the dictionary terms it stands for
+ * Purpose:     find the index's terms for one query word
+ * Returns:     nothing
+*/
+void QueryEngine::ExpandTerm(const string_view Word, vector<TrieMatch> &Matches) const
+{
+   ExpandIn(trie, Word, Matches);
+}
+
+/* Name:  Suggest
+ * Parameters:  Word: a query word that matched nothing
+ *              Suggestion: receives the term to offer instead
+ * Purpose:     find the term in the most documents within one edit of
+ *              the word, or failing that within QUERY_MAX_EDITS
+ * Returns:     false if there is none
+*/
+bool QueryEngine::Suggest(const string_view Word, string &Suggestion) const
+{
+string Term(Word);
+vector<TrieMatch> Matches;
+
+   for (unsigned long i = 0; i < Term.length(); i++)
+      Term[i] = tolower(Term[i]);
+
+   for (int Edits = 1; Edits <= QUERY_MAX_EDITS && Matches.empty(); Edits++)
+      trie.Fuzzy(Term, Edits, Matches);
+   if (Matches.empty())
+      return false;
+   Suggestion = Matches[0].term;
+   return true;
+}
+
+bool QueryEngine::HasDocStore() const
+{
+   return docstore.IsOpen();
+}
+
+/* Name:  GetSnippet
+ * Parameters:  DocId: a document in the results
+ *              Query: the query it was found for
+ *              Snippet: receives QUERY_SNIPPET_WORDS of its tokens, with
+ *                       the query's words in [brackets] and ... where
+ *                       tokens were left out
+ * Purpose:     find the stretch of the document's stored text holding
+ *              the most different query words (then the most matches),
+ *              trying a stretch a little before each match.  Only the
+ *              first QUERY_SNIPPET_TEXT bytes of a long document are
+ *              searched.
+ * Returns:     false if the index has no docs or the document is not
+ *              in it
+*/
+bool QueryEngine::GetSnippet(const int DocId, const string Query, string &Snippet)
+{
+istringstream Words(Query);
+vector<TrieMatch> Matches;
+unordered_map<string, int> Wanted;     // a term, to the query word it matches
+vector<string_view> Tokens;
+vector<int> Hits;                      // per token, its query word or -1
+vector<unsigned long> Places;          // the tokens that match
+string Text;
+string Word;
+unsigned long Best = 0;
+int BestWords = 0;
+int BestHits = 0;
+
+   Snippet.clear();
+   if (!docstore.Get(DocId, QUERY_SNIPPET_TEXT, Text))
+      return false;
+   if (Text.length() == QUERY_SNIPPET_TEXT && Text.rfind(' ') != string::npos)
+      Text.resize(Text.rfind(' '));   // not the token cut in two
+   for (int w = 0; Words >> Word && w < 64; w++)
+   {
+      Matches.clear();
+      ExpandTerm(Word, Matches);
+      for (unsigned long m = 0; m < Matches.size(); m++)
+         Wanted.emplace(Matches[m].term, w);
+   }
+
+   for (unsigned long i = 0; i < Text.length(); )
+   {
+      unsigned long End = Text.find(' ', i);
+      if (End == string::npos)
+         End = Text.length();
+      Tokens.push_back(string_view(Text).substr(i, End - i));
+      unordered_map<string, int>::const_iterator Found = Wanted.find(string(Tokens.back()));
+      Hits.push_back(Found == Wanted.end() ? -1 : Found->second);
+      if (Hits.back() >= 0)
+         Places.push_back(Tokens.size() - 1);
+      i = End + 1;
+   }
+
+   for (unsigned long p = 0; p < Places.size(); p++)
+   {
+      unsigned long Start = (Places[p] > QUERY_SNIPPET_LEAD ? Places[p] - QUERY_SNIPPET_LEAD : 0);
+      unsigned long Seen = 0;              // a bit per query word
+      int NumHits = 0;
+      for (unsigned long q = p; q < Places.size() && Places[q] < Start + QUERY_SNIPPET_WORDS; q++)
+      {
+         Seen |= 1ul << Hits[Places[q]];
+         NumHits++;
+      }
+      int NumWords = __builtin_popcountl(Seen);
+      if (NumWords > BestWords || (NumWords == BestWords && NumHits > BestHits))
+      {
+         Best = Start;
+         BestWords = NumWords;
+         BestHits = NumHits;
+      }
+   }
+
+   if (Best > 0)
+      Snippet = "...";
+   for (unsigned long t = Best; t < Tokens.size() && t < Best + QUERY_SNIPPET_WORDS; t++)
+   {
+      if (!Snippet.empty())
+         Snippet += ' ';
+      if (Hits[t] >= 0)
+         Snippet += "[" + string(Tokens[t]) + "]";
+      else
+         Snippet += Tokens[t];
+   }
+   if (Best + QUERY_SNIPPET_WORDS < Tokens.size())
+      Snippet += " ...";
+   return true;
+}
+
+/* Name:  StartHotTier
+ * Parameters:  MaxBytes: the most memory the hot postings may take
+ * Purpose:     start the hot tier over every term with postings, by id;
+ *              nothing is hot until it has counted some lookups or
+ *              loaded a profile
+ * Returns:     nothing
+*/
+void QueryEngine::StartHotTier(const unsigned long MaxBytes)
+{
+vector<TrieMatch> Entries;
+
+   trie.Numbered(Entries);
+   hot.Start(Entries, MaxBytes, ReadCold, this);
+}
+
+HotTier &QueryEngine::GetHotTier()
+{
+   return hot;
+}
+
+bool QueryEngine::HasForwardIndex() const
+{
+   return !termsbyid.empty();
+}
+
+/* Name:  MoreLikeThis
+ * Parameters:  DocId: the document to find others like
+ *              NumResults: how many documents to return
+ *              Results: receives the best documents, best first, not
+ *                       counting DocId itself
+ * Purpose:     search for the document's own vector from fwd.  Needs
+ *              fwd.
+ * Returns:     nothing
+*/
+void QueryEngine::MoreLikeThis(const int DocId, const int NumResults, vector<QueryResult> &Results)
+{
+vector<int> TermIds;
+vector<float> Weights;
+
+   Results.clear();
+   if (!HasForwardIndex())
+   {
+      cerr << "More like this needs fwd in the index." << endl;
+      return;
+   }
+   if (!forward.Get(DocId, TermIds, Weights))
+      return;
+   SearchVector(TermIds, Weights, NumResults + 1, Results);
+   for (unsigned long r = 0; r < Results.size(); r++)
+      if (Results[r].docid == DocId)
+      {
+         Results.erase(Results.begin() + r);
+         break;
+      }
+   if ((int) Results.size() > NumResults)
+      Results.resize(NumResults);
+}
+
+/* Name:  SearchFeedback
+ * Parameters:  Query: the words to look for
+ *              NumResults: how many documents to return
+ *              Results: receives the best documents, best first
+ * Purpose:     search, then search again for the query's terms and the
+ *              average vector of its best QUERY_FEEDBACK_DOCS
+ *              documents from fwd.  The query's own terms are given the
+ *              weight of the heaviest term in that average as well, so
+ *              they stay at the head of the vector.  Needs fwd.
+ * Returns:     nothing
+*/
+void QueryEngine::SearchFeedback(const string Query, const int NumResults, vector<QueryResult> &Results)
+{
+istringstream Words(Query);
+vector<TrieMatch> Matches;
+vector<QueryResult> Top;
+map<int, float> Sum;                   // a term's id, to its weight
+vector<int> DocTermIds;
+vector<float> DocWeights;
+vector<int> TermIds;
+vector<float> Weights;
+float Heaviest = 0.0;
+string Word;
+
+   Results.clear();
+   if (!HasForwardIndex())
+   {
+      cerr << "Relevance feedback needs fwd in the index." << endl;
+      return;
+   }
+   Search(Query, QUERY_FEEDBACK_DOCS, Top);
+   for (unsigned long r = 0; r < Top.size(); r++)
+   {
+      forward.Get(Top[r].docid, DocTermIds, DocWeights);
+      for (unsigned long k = 0; k < DocTermIds.size(); k++)
+         Heaviest = max(Heaviest, Sum[DocTermIds[k]] += DocWeights[k] / Top.size());
+   }
+   while (Words >> Word)
+   {
+      Matches.clear();
+      ExpandTerm(Word, Matches);
+      for (unsigned long m = 0; m < Matches.size(); m++)
+      {
+         int TermId = GetTermId(Matches[m].entry);
+         if (TermId >= 0)
+            Sum[TermId] += (Heaviest > 0.0 ? Heaviest : 1.0);
+      }
+   }
+
+   for (map<int, float>::const_iterator Term = Sum.begin(); Term != Sum.end(); Term++)
+   {
+      TermIds.push_back(Term->first);
+      Weights.push_back(Term->second);
+   }
+   SearchVector(TermIds, Weights, NumResults, Results);
+}
+
+/* Name:  Refresh
+ * Parameters:  none
+ * Purpose:     bring the segments in line with the manifest: open the
+ *              ones flushed or merged since the last look and close
+ *              the ones merged away.  A segment never changes once it
+ *              is in place, and one already open stays readable when
+ *              it is deleted; if one named vanishes before it can be
+ *              opened, a merge has replaced it, and the manifest is
+ *              read again.
+ * Returns:     how many segments are open
+*/
+int QueryEngine::Refresh()
+{
+vector<string> Names;
+vector<Segment*> Opened;
+bool Missing = true;
+
+   for (int Try = 0; Missing && Try < SEGMENT_OPEN_TRIES; Try++)
+   {
+      Segment::List(indexdirname + "/segments", Names);
+      Opened.assign(Names.size(), NULL);
+      Missing = false;
+      for (unsigned long n = 0; n < Names.size() && !Missing; n++)
+      {
+         vector<string>::iterator Found = find(segmentnames.begin(), segmentnames.end(), Names[n]);
+         if (Found != segmentnames.end())
+         {
+            Opened[n] = segments[Found - segmentnames.begin()];
+            continue;
+         }
+         Opened[n] = new Segment;
+         if (!Opened[n]->Open(indexdirname + "/segments/" + Names[n]))
+            Missing = true;
+      }
+      if (Missing)   // give back the ones just opened
+         for (unsigned long n = 0; n < Names.size(); n++)
+            if (Opened[n] != NULL &&
+                find(segments.begin(), segments.end(), Opened[n]) == segments.end())
+               delete Opened[n];
+   }
+   if (Missing)
+      return segments.size();   // keep what was open until the next look
+
+   for (unsigned long s = 0; s < segments.size(); s++)
+      if (find(Opened.begin(), Opened.end(), segments[s]) == Opened.end())
+         delete segments[s];
+   segments = Opened;
+   segmentnames = Names;
+   if ((int) scores.size() <= GetNumDocs())
+      scores.resize(GetNumDocs() + 1, 0.0);
+   return segments.size();
+}
+
+/* Name:  SetLiveSegment
+ * Parameters:  Live: the inverter's memory segment, or NULL
+ * Purpose:     search the documents not yet flushed as well
+ * Returns:     nothing
+*/
+void QueryEngine::SetLiveSegment(MemorySegment *Live)
+{
+   live = Live;
+   generation = (live == NULL ? 0 : live->GetGeneration());
+   Refresh();
+}
+
+string QueryEngine::GetFilename(const int DocId) const
+{
+   if (DocId >= 1 && DocId <= (int) filenames.size())
+      return filenames[DocId - 1];
+   for (unsigned long s = 0; s < segments.size(); s++)
+      if (DocId >= segments[s]->GetFirstDocId() &&
+          DocId < segments[s]->GetFirstDocId() + segments[s]->GetNumDocs())
+         return segments[s]->GetFilename(DocId);
+   return (live == NULL ? "" : live->GetFilename(DocId));
+}
+
+// The highest DocId in the index, its segments and the live segment
+int QueryEngine::GetNumDocs() const
+{
+int NumDocs = filenames.size();
+int Count;
+
+   for (unsigned long s = 0; s < segments.size(); s++)
+      NumDocs = max(NumDocs, segments[s]->GetFirstDocId() + segments[s]->GetNumDocs() - 1);
+   if (live != NULL && (Count = live->GetNumDocs()) > 0)
+      NumDocs = max(NumDocs, live->GetFirstDocId() + Count - 1);
+   return NumDocs;
+}
+
+/*-------------------------- Private Functions ----------------------------*/
+
+/* Name:  ExpandIn
+ * Parameters:  Trie: the index's trie or a segment's
+ *              Word: a query word, wildcard or range
+ *              Matches: receives the terms in Trie it stands for
+ * Purpose:     find the terms for one query word.  Plain words are
+ *              downcased as the tokenizer downcases them; word~ and
+ *              word~2 match the terms within one or two edits.
+ * Returns:     nothing
+*/
+void QueryEngine::ExpandIn(const TermTrie &Trie, const string_view Word, vector<TrieMatch> &Matches) const
+{
+string Term(Word);
+unsigned long Dots = Term.find("..");
+unsigned long Wild = Term.find_first_of("*?");
+unsigned long Tilde = Term.rfind('~');
+TrieEntry Entry;
+
+   if (all_of(Term.begin(), Term.end(), [](char c) { return isalnum(c) || c == '*' || c == '?' || c == '~'; }))
+      for (unsigned long i = 0; i < Term.length(); i++)
+         Term[i] = tolower(Term[i]);
+
+   if (Tilde != string::npos && Tilde > 0 && Wild == string::npos &&
+       (Tilde == Term.length() - 1 ||
+        (Tilde == Term.length() - 2 && Term[Tilde + 1] >= '1' && Term[Tilde + 1] <= '0' + QUERY_MAX_EDITS)))
+      Trie.Fuzzy(string_view(Term).substr(0, Tilde),
+                 Tilde == Term.length() - 1 ? 1 : Term[Tilde + 1] - '0', Matches);
+   else if (Dots != string::npos && Dots > 0)
+      Trie.Range(string_view(Term).substr(0, Dots), string_view(Term).substr(Dots + 2), Matches);
+   else if (Wild == Term.length() - 1 && Term[Wild] == '*')
+      Trie.Prefix(string_view(Term).substr(0, Wild), Matches);
+   else if (Wild != string::npos)
+      Trie.Wildcard(Term, Matches);
+   else if (Trie.Find(Term, Entry))
+      Matches.push_back(TrieMatch{Term, Entry, 0});
+}
+
+/* Name:  AddPostings
+ * Parameters:  Entry: a term's dictionary entry
+ *              Scale: what each weight is multiplied by
+ * Purpose:     add the weight of each of the term's postings to its
+ *              document's accumulator, reading a hot term's postings
+ *              where the hot tier keeps them
+ * Returns:     nothing
+*/
+void QueryEngine::AddPostings(const TrieEntry &Entry, const float Scale)
+{
+HotList List;
+const int *DocIds;
+const float *Weights;
+unsigned long Count;
+
+   if (hot.IsStarted() && hot.Find(Entry, List))
+   {
+      DocIds = List.docids;
+      Weights = List.weights;
+      Count = List.count;
+   }
+   else
+   {
+      ReadStoredPostings(Entry, listdocids, listweights);
+      DocIds = listdocids.data();
+      Weights = listweights.data();
+      Count = listdocids.size();
+   }
+   AddWeights(DocIds, Weights, Count, Scale);
+}
+
+/* Name:  AddSegmentPostings
+ * Parameters:  Word: a query word, wildcard or range
+ * Purpose:     add the postings of the word's terms in every segment
+ *              and, for a plain word, in the live segment.  A term's
+ *              rtfs are weighted with its IDF over everything searched.
+ *              If the live segment has been flushed since the last
+ *              look, Refresh opens the new segments first, so the
+ *              documents are found in one place or the other.  A
+ *              segment may be in the manifest a moment before the live
+ *              segment drops its documents, so the segments' postings
+ *              stop short of the first document still in memory.
+ * Returns:     nothing
+*/
+void QueryEngine::AddSegmentPostings(const string_view Word)
+{
+vector<TrieMatch> Matches;
+vector<int> DocIds;
+vector<float> RTFs;
+string Term(Word);
+int NumDocs;
+int Generation;
+int InMemory = INT_MAX;
+unsigned long Count;
+bool Found = false;
+
+   if (all_of(Term.begin(), Term.end(), [](char c) { return isalnum(c); }))
+      for (unsigned long i = 0; i < Term.length(); i++)
+         Term[i] = tolower(Term[i]);
+   if (live != NULL)
+   {
+      Found = live->Find(Term, DocIds, RTFs, Generation, InMemory);
+      if (Generation != generation)
+      {
+         generation = Generation;
+         Refresh();
+      }
+   }
+   NumDocs = GetNumDocs();
+
+   if (Found)
+      AddWeights(DocIds.data(), RTFs.data(), DocIds.size(),
+                 1000.0 * (1 + log((NumDocs * 1.0) / (GetDocFrequency(Term) * 1.0))));
+   for (unsigned long s = 0; s < segments.size(); s++)
+   {
+      Matches.clear();
+      ExpandIn(segments[s]->GetTrie(), Word, Matches);
+      for (unsigned long m = 0; m < Matches.size(); m++)
+      {
+         segments[s]->GetPostings(Matches[m].entry, DocIds, RTFs);
+         Count = lower_bound(DocIds.begin(), DocIds.end(), InMemory) - DocIds.begin();
+         AddWeights(DocIds.data(), RTFs.data(), Count,
+                    1000.0 * (1 + log((NumDocs * 1.0) / (GetDocFrequency(Matches[m].term) * 1.0))));
+      }
+   }
+}
+
+/* Name:  AddWeights
+ * Parameters:  DocIds: a term's DocIds
+ *              Weights: their weights
+ *              Count: how many there are
+ *              Scale: what each weight is multiplied by
+ * Purpose:     add each weight to its document's accumulator
+ * Returns:     nothing
+*/
+void QueryEngine::AddWeights(const int *DocIds, const float *Weights, const unsigned long Count, const float Scale)
+{
+int DocId;
+
+   for (unsigned long k = 0; k < Count; k++)
+   {
+      DocId = DocIds[k];
+      if (DocId < 1 || DocId >= (int) scores.size())
+         continue;
+      if (scores[DocId] == 0.0)
+         touched.push_back(DocId);
+      scores[DocId] += Weights[k] * Scale;
+   }
+}
+
+// The documents holding the term in the index, its segments and the live one
+int QueryEngine::GetDocFrequency(const string &Term) const
+{
+TrieEntry Entry;
+int Count = 0;
+
+   if (trie.Find(Term, Entry))
+      Count += Entry.numdocs;
+   for (unsigned long s = 0; s < segments.size(); s++)
+      if (segments[s]->GetTrie().Find(Term, Entry))
+         Count += Entry.numdocs;
+   if (live != NULL)
+      Count += live->GetNumDocs(Term);
+   return max(Count, 1);
+}
+
+/* Name:  ReadPostings
+ * Parameters:  Entry: a term's dictionary entry
+ *              DocIds: receives its DocIds, in order
+ *              Weights: receives their weights
+ * Purpose:     copy a term's postings from the hot tier, or read them
+ *              from bpost or post
+ * Returns:     nothing
+*/
+void QueryEngine::ReadPostings(const TrieEntry &Entry, vector<int> &DocIds, vector<float> &Weights) const
+{
+HotList List;
+
+   if (hot.IsStarted() && hot.Find(Entry, List))
+   {
+      DocIds.assign(List.docids, List.docids + List.count);
+      Weights.assign(List.weights, List.weights + List.count);
+   }
+   else
+      ReadStoredPostings(Entry, DocIds, Weights);
+}
+
+/* Name:  ReadStoredPostings
+ * Parameters:  Entry: a term's dictionary entry
+ *              DocIds: receives its DocIds, in order
+ *              Weights: receives their weights
+ * Purpose:     decode a term's postings from bpost, or parse them from
+ *              post
+ * Returns:     nothing
+*/
+void QueryEngine::ReadStoredPostings(const TrieEntry &Entry, vector<int> &DocIds, vector<float> &Weights) const
+{
+const char *Line;
+char *End;
+PostingCursor Cursor;
+
+   DocIds.clear();
+   Weights.clear();
+   if (blockpost.IsOpen())
+   {
+      blockpost.GetCursor(Entry, Cursor);
+      for (; Cursor.GetDocId() != CURSOR_END; Cursor.Next())
+      {
+         DocIds.push_back(Cursor.GetDocId());
+         Weights.push_back(Cursor.Score());
+      }
+      return;
+   }
+
+   for (unsigned long k = Entry.start; k < Entry.start + Entry.numdocs; k++)
+   {
+      if (lines.empty())
+         Line = post.data() + k * POST_LINE_LENGTH;
+      else if (k < lines.size())
+         Line = post.data() + lines[k];
+      else
+         break;
+      if (Line >= post.data() + post.size() - 1)
+         break;
+
+      DocIds.push_back(strtol(Line, &End, 10));
+      Weights.push_back(strtof(End, NULL));
+   }
+}
+
+// ReadStoredPostings for the hot tier, which knows the engine only as Engine
+void QueryEngine::ReadCold(const void *Engine, const TrieEntry &Entry, vector<int> &DocIds,
+                           vector<float> &Weights)
+{
+   ((const QueryEngine *) Engine)->ReadStoredPostings(Entry, DocIds, Weights);
+}
+
+/* Name:  SearchGroup
+ * Parameters:  Terms: every query's terms, as Search would add them
+ *              Group: the queries to rank together
+ *              Count: how many there are, at most QUERY_BATCH_GROUP
+ *              NumResults: how many documents to return for each
+ *              SharedIndex: the start of each list decoded for the
+ *                           whole batch, to its place in Shared
+ *              Shared: those lists
+ *              Tile: the thread's accumulators, all 0.0, and left so
+ *              Results: receives each query's best documents
+ * Purpose:     read each of the group's terms once, unless the batch
+ *              already has, and add it into the accumulators of every
+ *              query that has it.  A tile's
+ *              accumulators are QUERY_BATCH_GROUP floats per DocId, so
+ *              a term shared by several queries updates neighbouring
+ *              floats, and the whole tile stays in cache while every
+ *              term adds its postings for those DocIds.
+ * Returns:     nothing
+*/
+void QueryEngine::SearchGroup(const vector< vector<TrieEntry> > &Terms, const int *Group, const int Count,
+                              const int NumResults, const map<unsigned long, int> &SharedIndex,
+                              const vector<DecodedList> &Shared, vector<float> &Tile,
+                              vector< vector<QueryResult> > &Results) const
+{
+map<unsigned long, int> Index;         // a term's start, to its place below
+vector< vector<int> > Slots;           // per term, the queries adding it
+vector<const DecodedList *> Lists;     // per term, its postings
+vector<DecodedList> Own;               // the lists only this group reads
+vector<unsigned long> Positions;       // per term, its first posting not yet added
+vector< vector<int> > Touched(Count);  // per query, the DocIds scored in the tile
+unsigned long NumTerms = 0;
+int NumDocs = scores.size() - 1;
+
+   for (int q = 0; q < Count; q++)
+      NumTerms += Terms[Group[q]].size();
+   Own.reserve(NumTerms);   // so Lists may point into it
+   for (int q = 0; q < Count; q++)
+   {
+      const vector<TrieEntry> &Query = Terms[Group[q]];
+      for (unsigned long t = 0; t < Query.size(); t++)
+      {
+         map<unsigned long, int>::iterator Found = Index.find(Query[t].start);
+         if (Found == Index.end())
+         {
+            map<unsigned long, int>::const_iterator Decoded = SharedIndex.find(Query[t].start);
+            Found = Index.insert(make_pair(Query[t].start, (int) Slots.size())).first;
+            Slots.push_back(vector<int>());
+            if (Decoded != SharedIndex.end())
+               Lists.push_back(&Shared[Decoded->second]);
+            else
+            {
+               Own.push_back(DecodedList());
+               ReadPostings(Query[t], Own.back().docids, Own.back().weights);
+               Lists.push_back(&Own.back());
+            }
+         }
+         Slots[Found->second].push_back(q);
+      }
+      Results[Group[q]].clear();
+   }
+   Positions.assign(Slots.size(), 0);
+
+   for (int Low = 1; Low <= NumDocs; Low += QUERY_BATCH_TILE)
+   {
+      int High = min(Low + QUERY_BATCH_TILE, NumDocs + 1);
+      for (unsigned long t = 0; t < Slots.size(); t++)
+      {
+         const vector<int> &Queries = Slots[t];
+         const vector<int> &DocIds = Lists[t]->docids;
+         const vector<float> &Weights = Lists[t]->weights;
+         unsigned long k = Positions[t];
+         for (; k < DocIds.size() && DocIds[k] < High; k++)
+         {
+            if (DocIds[k] < Low)
+               continue;
+            float *Scores = Tile.data() + (DocIds[k] - Low) * QUERY_BATCH_GROUP;
+            for (unsigned long s = 0; s < Queries.size(); s++)
+            {
+               if (Scores[Queries[s]] == 0.0)
+                  Touched[Queries[s]].push_back(DocIds[k]);
+               Scores[Queries[s]] += Weights[k];
+            }
+         }
+         Positions[t] = k;
+      }
+
+      // offer the tile's scores to each query's heap of its best so far,
+      // whose top is the worst of them
+      for (int q = 0; q < Count; q++)
+      {
+         vector<QueryResult> &Best = Results[Group[q]];
+         for (unsigned long d = 0; d < Touched[q].size(); d++)
+         {
+            float &Score = Tile[(Touched[q][d] - Low) * QUERY_BATCH_GROUP + q];
+            QueryResult Candidate{Touched[q][d], Score};
+            Score = 0.0;
+            if ((int) Best.size() < NumResults)
+            {
+               Best.push_back(Candidate);
+               push_heap(Best.begin(), Best.end(), Better);
+            }
+            else if (NumResults > 0 && Better(Candidate, Best.front()))
+            {
+               pop_heap(Best.begin(), Best.end(), Better);
+               Best.back() = Candidate;
+               push_heap(Best.begin(), Best.end(), Better);
+            }
+         }
+         Touched[q].clear();
+      }
+   }
+   for (int q = 0; q < Count; q++)
+      sort_heap(Results[Group[q]].begin(), Results[Group[q]].end(), Better);
+}
+
+/* Name:  SearchVector
+ * Parameters:  TermIds: the terms of a vector from fwd, by id
+ *              Weights: their weights
+ *              NumResults: how many documents to return
+ *              Results: receives the best documents, best first
+ * Purpose:     rank the documents by their weights for the vector's
+ *              QUERY_FEEDBACK_TERMS heaviest terms, each term's
+ *              postings scaled by its share of the heaviest's weight
+ * Returns:     nothing
+*/
+void QueryEngine::SearchVector(const vector<int> &TermIds, const vector<float> &Weights, const int NumResults,
+                               vector<QueryResult> &Results)
+{
+vector<int> Order(TermIds.size());
+unsigned long Count = min((unsigned long) QUERY_FEEDBACK_TERMS, TermIds.size());
+
+   for (unsigned long k = 0; k < Order.size(); k++)
+      Order[k] = k;
+   partial_sort(Order.begin(), Order.begin() + Count, Order.end(), [&](int a, int b)
+   {
+      return Weights[a] != Weights[b] ? Weights[a] > Weights[b] : TermIds[a] < TermIds[b];
+   });
+   for (unsigned long k = 0; k < Count; k++)
+      if (TermIds[Order[k]] >= 0 && TermIds[Order[k]] < (int) termsbyid.size() && Weights[Order[k]] > 0.0)
+         AddPostings(termsbyid[TermIds[Order[k]]], Weights[Order[k]] / Weights[Order[0]]);
+
+   TopResults(NumResults, Results);
+}
+
+/* Name:  GetTermId
+ * Parameters:  Entry: a term's dictionary entry
+ * Purpose:     find the term's id in fwd, its place in start order
+ * Returns:     the id, or -1 if there is no fwd or no such term
+*/
+int QueryEngine::GetTermId(const TrieEntry &Entry) const
+{
+vector<TrieEntry>::const_iterator Found = lower_bound(termsbyid.begin(), termsbyid.end(), Entry,
+   [](const TrieEntry &a, const TrieEntry &b) { return a.start < b.start; });
+
+   if (Found == termsbyid.end() || Found->start != Entry.start || Entry.numdocs <= 0)
+      return -1;
+   return Found - termsbyid.begin();
+}
+
+/* Name:  TopResults
+ * Parameters:  NumResults: how many documents to return
+ *              Results: receives the best of the touched documents
+ * Purpose:     pick the best scores, then clear only the accumulators
+ *              this query used
+ * Returns:     nothing
+*/
+void QueryEngine::TopResults(const int NumResults, vector<QueryResult> &Results)
+{
+unsigned long Count;
+
+   for (unsigned long k = 0; k < touched.size(); k++)
+      Results.push_back(QueryResult{touched[k], scores[touched[k]]});
+   Count = min((unsigned long) NumResults, Results.size());
+   partial_sort(Results.begin(), Results.begin() + Count, Results.end(), Better);
+   Results.resize(Count);
+
+   for (unsigned long k = 0; k < touched.size(); k++)
+      scores[touched[k]] = 0.0;
+   touched.clear();
+}
@@ -0,0 +1,151 @@
+/* Filename:  queryengine.h
+ * Date:      10/19/26
+ * Purpose:   The header file for the query engine.  It loads an index
+ *            directory written by invert (map, post and the term trie)
+ *            and ranks documents by the summed post weights of the
+ *            query terms.  A term may be a wildcard (comput*, c?t,
+ *            h*se) or a range (apple..apply); it is expanded through
+ *            the trie and the postings of every matching term are
+ *            added into one set of accumulators.  A word ending in ~
+ *            (or ~2) also matches the terms one (or two) edits away.
+ *            When the index has bpost the postings are read through
+ *            cursors, and SearchAll finds the documents holding every
+ *            word by leaping each word's cursors to the next DocId the
+ *            others might share, skipping whole blocks.
+ *            SearchBatch ranks many queries as Search would, on several
+ *            threads.  Queries that share their longest list are put in
+ *            the same group of QUERY_BATCH_GROUP; a list that several
+ *            groups need is decoded once for the whole batch, the rest
+ *            once for the group that needs them, and the group's
+ *            accumulators interleave its queries per DocId, a tile of
+ *            QUERY_BATCH_TILE DocIds at a time, so one posting updates
+ *            a single cache line however many queries share it.
+ *            When the index has docs, GetSnippet shows the stretch of
+ *            QUERY_SNIPPET_WORDS tokens, in the first QUERY_SNIPPET_TEXT
+ *            bytes of a document, that holds the most of the query's
+ *            words.
+ *            When the index has fwd, MoreLikeThis ranks the documents
+ *            sharing the heaviest terms of one document, and
+ *            SearchFeedback adds to a query the heaviest terms of its
+ *            best QUERY_FEEDBACK_DOCS results (pseudo-relevance
+ *            feedback); either way the vector is cut to its
+ *            QUERY_FEEDBACK_TERMS heaviest terms, and each term's
+ *            postings count as much as its weight in the vector.
+ *            StartHotTier keeps the postings of the most searched terms
+ *            decoded in memory (see hottier.h); Search and SearchBatch
+ *            read those from there, and the rest from bpost or post.
+ *            Search also looks in the segments the manifest in
+ *            <indexdir>/segments names (see segment.h), which Refresh
+ *            keeps up with as they are flushed and merged, and in a
+ *            live MemorySegment shared with the same process.  A
+ *            segment's postings are weighted as invert weighs them,
+ *            1000 * rtf * (1 + log(N / df)), counting the term's
+ *            documents in the index, every segment and the live one.
+ *            An index made by invert --segments has only segments, and
+ *            one added to with --append has a printed index as well.
+*/
+
+#ifndef QUERYENGINE_H
+#define QUERYENGINE_H
+
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "blockpost.h"
+#include "docstore.h"
+#include "forwardindex.h"
+#include "hottier.h"
+#include "segment.h"
+#include "termtrie.h"
+
+#define QUERY_MAX_EDITS 2
+#define QUERY_BATCH_GROUP 16       // queries sharing one accumulator tile
+#define QUERY_BATCH_TILE 4096      // DocIds in an accumulator tile
+#define QUERY_SNIPPET_WORDS 24     // tokens in a snippet
+#define QUERY_SNIPPET_LEAD 4       // tokens shown before the first match
+#define QUERY_SNIPPET_TEXT 51200   // the most of a document searched for one
+#define QUERY_FEEDBACK_DOCS 10     // the results a query is expanded from
+#define QUERY_FEEDBACK_TERMS 20    // the terms of a feedback vector searched for
+
+using namespace std;
+
+struct QueryResult  // one ranked document
+{
+   int docid;
+   float score;
+};
+
+struct DecodedList  // a term's postings, read once for a batch or group
+{
+   vector<int> docids;
+   vector<float> weights;
+};
+
+class QueryEngine {
+public:
+   QueryEngine(const string IndexDirname);
+   ~QueryEngine();
+   bool IsOpen () const;
+   void Search (const string Query, const int NumResults, vector<QueryResult> &Results);
+   void SearchAll (const string Query, const int NumResults, vector<QueryResult> &Results);
+   void SearchBatch (const vector<string> &Queries, const int NumResults, const int NumThreads,
+                     vector< vector<QueryResult> > &Results) const;   // NumThreads 0 for all cores
+   void ExpandTerm (const string_view Word, vector<TrieMatch> &Matches) const;
+   bool Suggest (const string_view Word, string &Suggestion) const;
+   bool HasDocStore () const;
+   bool GetSnippet (const int DocId, const string Query, string &Snippet);
+   void StartHotTier (const unsigned long MaxBytes);
+   HotTier &GetHotTier ();
+   bool HasForwardIndex () const;
+   void MoreLikeThis (const int DocId, const int NumResults, vector<QueryResult> &Results);
+   void SearchFeedback (const string Query, const int NumResults, vector<QueryResult> &Results);
+   int Refresh ();                  // open new segments; returns how many are open
+   void SetLiveSegment (MemorySegment *Live);
+   string GetFilename (const int DocId) const;
+   int GetNumDocs () const;
+private:
+   QueryEngine (const QueryEngine& qe);
+   void ExpandIn (const TermTrie &Trie, const string_view Word, vector<TrieMatch> &Matches) const;
+   void AddPostings (const TrieEntry &Entry, const float Scale);
+   void AddSegmentPostings (const string_view Word);
+   void AddWeights (const int *DocIds, const float *Weights, const unsigned long Count, const float Scale);
+   int GetDocFrequency (const string &Term) const;
+   void ReadPostings (const TrieEntry &Entry, vector<int> &DocIds, vector<float> &Weights) const;
+   void ReadStoredPostings (const TrieEntry &Entry, vector<int> &DocIds, vector<float> &Weights) const;
+   static void ReadCold (const void *Engine, const TrieEntry &Entry, vector<int> &DocIds,
+                         vector<float> &Weights);   // for the hot tier
+   void SearchGroup (const vector< vector<TrieEntry> > &Terms, const int *Group, const int Count,
+                     const int NumResults, const map<unsigned long, int> &SharedIndex,
+                     const vector<DecodedList> &Shared, vector<float> &Tile,
+                     vector< vector<QueryResult> > &Results) const;
+   void SearchVector (const vector<int> &TermIds, const vector<float> &Weights, const int NumResults,
+                      vector<QueryResult> &Results);
+   int GetTermId (const TrieEntry &Entry) const;
+   void TopResults (const int NumResults, vector<QueryResult> &Results);
+   TermTrie trie;
+   BlockPost blockpost;             // if the index has bpost
+   DocStore docstore;               // if the index has docs
+   ForwardIndex forward;            // if the index has fwd
+   vector<TrieEntry> termsbyid;     // with fwd, every term with postings, by id
+   vector<string> filenames;        // by DocId - 1
+   vector<char> post;               // the whole post file, without bpost
+   vector<unsigned long> lines;     // where each post line begins, unless
+                                    //    they are all POST_LINE_LENGTH long
+   vector<float> scores;            // accumulators, by DocId
+   vector<int> touched;             // the DocIds with a score
+   vector<int> listdocids;          // the list AddPostings is adding
+   vector<float> listweights;
+   mutable HotTier hot;             // counts every lookup, even by const
+                                    //    searches; stopped before the
+                                    //    files it reads go
+   string indexdirname;
+   vector<Segment*> segments;       // as the manifest lists them, in DocId order
+   vector<string> segmentnames;
+   MemorySegment *live;             // if the inverter shares one
+   int generation;                  // of live, when segments were last refreshed
+   bool open;
+};
+
+#endif
@@ -0,0 +1,54 @@
+/* Filename:  ratelimiter.cpp
+ * Date:      10/19/2026
+ * Purpose:   The implementation file for the rate limiter.
+*/
+
+#include <thread>
+
+#include "ratelimiter.h"
+
+using namespace std;
+
+RateLimiter::RateLimiter(const unsigned long BytesPerSecond)
+{
+   rate = BytesPerSecond;
+   due = chrono::steady_clock::now();
+   bytes = 0;
+   waited = 0;
+}
+
+/* Name:  Take
+ * Parameters:  Bytes: what the caller is about to read or write
+ * Purpose:     move the deadline on by the time Bytes take at the rate,
+ *              from now if the caller has been idle, and sleep until
+ *              the caller is no more than RATE_BURST_MS ahead of it
+ * Returns:     nothing
+*/
+void RateLimiter::Take(const unsigned long Bytes)
+{
+chrono::steady_clock::time_point Now = chrono::steady_clock::now();
+chrono::steady_clock::time_point Wake;
+
+   bytes.fetch_add(Bytes, memory_order_relaxed);
+   if (rate == 0)
+      return;
+   {
+   lock_guard<mutex> Lock(lock);
+   due = max(due, Now) + chrono::microseconds(Bytes * 1000000 / rate);
+   Wake = due - chrono::milliseconds(RATE_BURST_MS);
+   }
+   if (Wake <= Now)
+      return;
+   this_thread::sleep_until(Wake);
+   waited.fetch_add(chrono::duration_cast<chrono::microseconds>(Wake - Now).count(), memory_order_relaxed);
+}
+
+unsigned long RateLimiter::GetBytes() const
+{
+   return bytes.load();
+}
+
+double RateLimiter::GetWaited() const
+{
+   return waited.load() / 1e6;
+}
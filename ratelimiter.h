@@ -0,0 +1,38 @@
+/* Filename:  ratelimiter.h
+ * Date:      10/19/26
+ * Purpose:   The header file for the rate limiter, which keeps
+ *            background I/O (segment compaction) to so many bytes a
+ *            second so it does not crowd out the reads of queries.
+ *            Take is called with the bytes about to be read or
+ *            written and sleeps until they fit: each call pushes a
+ *            deadline on by Bytes / rate, and the caller may run at
+ *            most RATE_BURST_MS ahead of it.
+*/
+
+#ifndef RATELIMITER_H
+#define RATELIMITER_H
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+
+#define RATE_BURST_MS 50           // the most a caller may run ahead of the rate
+
+using namespace std;
+
+class RateLimiter {
+public:
+   RateLimiter(const unsigned long BytesPerSecond);   // 0 for no limit
+   void Take (const unsigned long Bytes);
+   unsigned long GetBytes () const;   // taken so far
+   double GetWaited () const;         // seconds spent sleeping
+private:
+   RateLimiter (const RateLimiter& rl);
+   unsigned long rate;
+   mutex lock;
+   chrono::steady_clock::time_point due;   // when the bytes taken so far are paid for
+   atomic<unsigned long> bytes;
+   atomic<long> waited;               // in microseconds
+};
+
+#endif
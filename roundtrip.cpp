@@ -0,0 +1,1736 @@
+/* Filename:  roundtrip.cpp
+ * Date:      10/19/2026
+ * Purpose:   Round-trip checks for what the indexer writes and reads
+ *            back, on synthetic data: documents larger than the
+ *            per-document table expects reach dict and post in the
+ *            order the fixed-size table gave them, and the tokenizer
+ *            threads of the pipeline, through the inverter or the
+ *            concurrent table, write what one table fed serially does,
+ *            the document store included;
+ *            the sorted dictionary finds and walks every term; the term
+ *            trie's lookups, fuzzy ones included, match brute force over
+ *            its terms; copies of documents are left out of post and
+ *            named in the map, the same by every way of indexing, and
+ *            two passes write five-digit DocIds whole when fewer than
+ *            10000 documents are kept; a table checkpointed, loaded and
+ *            given the rest of the documents, or spilled to runs as it
+ *            goes, prints what one never stopped does; bpost's cursors
+ *            walk and skip through the same postings as post, decoding
+ *            only the blocks they land in, every posting codec decodes
+ *            what it encodes, and quantized impacts stay within a step
+ *            of the weights; reordering DocIds keeps every term's
+ *            documents and weights; the document store's compressor
+ *            and file give back every text; fwd holds each document's
+ *            postings, turned around; the hot tier keeps the most
+ *            searched lists that fit, as post has them, and a saved
+ *            profile brings the same set back; a live segment finds
+ *            the documents it has not flushed, and its segments hold
+ *            the rest, merged or not.
+ *            Each check prints ok or FAILED; the exit status is the
+ *            number that failed, so index.sh stops before indexing with
+ *            a broken build.
+ * To compile: g++ -O2 -pthread -o roundtrip roundtrip.cpp posting.cpp
+ *                 controlbytes.cpp termtable.cpp globalhashtable.cpp
+ *                 hashtable.cpp concurrentglobalhashtable.cpp
+ *                 deduplicator.cpp checkpointer.cpp memoryaccount.cpp
+ *                 outputwriter.cpp sorteddict.cpp termtrie.cpp
+ *                 postingcodec.cpp impactquantizer.cpp docstore.cpp
+ *                 forwardindex.cpp blockpost.cpp docreorderer.cpp
+ *                 tokenizer.cpp inverter.cpp pipeline.cpp segment.cpp
+ *                 ratelimiter.cpp hottier.cpp
+ * To run:    ./roundtrip
+*/
+
+#include <dirent.h>
+#include <fnmatch.h>
+#include <math.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "blockpost.h"
+#include "concurrentglobalhashtable.h"
+#include "deduplicator.h"
+#include "docreorderer.h"
+#include "docstore.h"
+#include "forwardindex.h"
+#include "hashtable.h"
+#include "hottier.h"
+#include "impactquantizer.h"
+#include "inverter.h"
+#include "pipeline.h"
+#include "postingcodec.h"
+#include "segment.h"
+#include "sorteddict.h"
+#include "termtable.h"
+#include "termtrie.h"
+#include "tokenizer.h"
+
+#define ROUNDTRIP_LOCAL_WORDS 3000   // LocalHT's expected words, as in invert.lex
+#define ROUNDTRIP_GLOBAL_WORDS 40000 // GlobalHT's expected words, as in invert.lex
+#define ROUNDTRIP_REPEATS 4          // each word's count, enough to be posted
+#define ROUNDTRIP_VOCABULARY 300     // distinct common words in the synthetic documents
+#define ROUNDTRIP_WORDS 20           // common words in a document
+#define ROUNDTRIP_DOCS 400           // documents for the tables and the pipeline
+#define ROUNDTRIP_RARE_WORDS 600     // words seen once per document, so never posted
+#define ROUNDTRIP_THREADS 3          // tokenizer threads in the pipeline
+#define ROUNDTRIP_SERIAL 0           // how CheckPipeline indexes the documents
+#define ROUNDTRIP_PIPELINE 1
+#define ROUNDTRIP_CONCURRENT 2
+#define ROUNDTRIP_TWO_PASS 3
+#define ROUNDTRIP_ORIGINALS 60       // distinct documents for the dedup check
+#define ROUNDTRIP_COPIES 20          // and copies of them, words shuffled
+#define ROUNDTRIP_MAX_DOCID 10040    // DocIds for the two-pass check, past four digits
+#define ROUNDTRIP_SKIPPED 150        // every 150th left out, as duplicates are
+#define ROUNDTRIP_SPILL_DOCS 70      // documents posted between spills
+#define ROUNDTRIP_TARGETS 20         // AdvanceTo calls on each bpost list
+#define ROUNDTRIP_BPOST_REPEATS 3    // the documents posted again, for lists of several blocks
+#define ROUNDTRIP_CODEC_LISTS 200    // random lists per codec
+#define ROUNDTRIP_SDICT_TERMS 500    // terms in the synthetic sorted dictionary
+#define ROUNDTRIP_TRIE_TERMS 2000    // terms in the synthetic trie
+#define ROUNDTRIP_PATTERNS 300       // lookups of each kind
+#define ROUNDTRIP_SEGMENT_DOCS 50    // documents flushed to each segment
+
+using namespace std;
+
+struct RoundTripDoc   // one document's words and their rtfs
+{
+   vector<string> tokens;
+   vector<float> rtfs;
+};
+
+struct RoundTripPost  // post read back, the hot tier's cold tier
+{
+   vector<int> docids;
+   vector<float> weights;
+};
+
+typedef map<string, pair< vector<int>, vector<float> > > ExpectedLists;   // by term
+
+// The tables and the pipeline print their statistics on cout, which
+// main turns off; the outcomes of the checks go here
+static ostream Out(cout.rdbuf());
+static int Failures = 0;
+
+// Print a check's outcome and count it if it failed
+static void Report(const string Check, const bool Passed)
+{
+   Out << (Passed ? "ok      " : "FAILED  ") << Check << endl;
+   if (!Passed)
+      Failures++;
+}
+
+// Read a whole file, or nothing if it is not there
+static string ReadFile(const string Filename)
+{
+ifstream In(Filename.c_str(), ios::binary);
+
+   return string(istreambuf_iterator<char>(In), istreambuf_iterator<char>());
+}
+
+/* Name:  MakeDocuments
+ * Parameters:  Docs: receives ROUNDTRIP_DOCS documents
+ * Purpose:     give each document ROUNDTRIP_WORDS distinct words, the
+ *              low-numbered ones more often, with random rtfs
+ * Returns:     nothing
+*/
+static void MakeDocuments(vector<RoundTripDoc> &Docs)
+{
+mt19937 Random(11);
+
+   Docs.resize(ROUNDTRIP_DOCS);
+   for (int d = 0; d < ROUNDTRIP_DOCS; d++)
+   {
+      vector<bool> Seen(ROUNDTRIP_VOCABULARY, false);
+      while (Docs[d].tokens.size() < ROUNDTRIP_WORDS)
+      {
+         int w = (Random() % ROUNDTRIP_VOCABULARY) * (Random() % ROUNDTRIP_VOCABULARY) / ROUNDTRIP_VOCABULARY;
+         if (Seen[w])
+            continue;
+         Seen[w] = true;
+         Docs[d].tokens.push_back("word" + to_string(w));
+         Docs[d].rtfs.push_back((Random() % 1000 + 1) / 1000.0);
+      }
+   }
+}
+
+/* Name:  PostDocuments
+ * Parameters:  GlobalHT: the table to post to
+ *              Docs: the documents
+ *              First: the first to post (from 0)
+ *              Last: one after the last
+ * Purpose:     insert the documents' words
+ * Returns:     nothing
+*/
+static void PostDocuments(GlobalHashTable &GlobalHT, const vector<RoundTripDoc> &Docs,
+                          const int First, const int Last)
+{
+   for (int d = First; d < Last; d++)
+      for (unsigned long k = 0; k < Docs[d].tokens.size(); k++)
+         GlobalHT.Insert(Docs[d].tokens[k], d + 1, Docs[d].rtfs[k]);
+}
+
+/* Name:  FixedSlotOrder
+ * Parameters:  Words: a document's distinct words, in first-seen order
+ *              NumSlots: the size of the table
+ * Purpose:     place the words as the original fixed-size table did,
+ *              by string hash and linear probing, and list them in slot
+ *              order, the order TransferData sent them in
+ * Returns:     the words in slot order
+*/
+static vector<string> FixedSlotOrder(const vector<string> &Words, const unsigned long NumSlots)
+{
+vector<long> Slots(NumSlots, -1);
+vector<string> Ordered;
+unsigned long Index;
+
+   for (unsigned long w = 0; w < Words.size() && w < NumSlots; w++)
+   {
+      Index = ControlBytes::Hash(Words[w]) % NumSlots;
+      while (Slots[Index] != -1)
+         Index = (Index + 1) % NumSlots;
+      Slots[Index] = w;
+   }
+   for (unsigned long i = 0; i < NumSlots; i++)
+      if (Slots[i] != -1)
+         Ordered.push_back(Words[Slots[i]]);
+   return Ordered;
+}
+
+/* Name:  CheckLargeDocuments
+ * Parameters:  Dirname: where to write the files
+ * Purpose:     count documents of up to one fewer distinct words than
+ *              LocalHT has slots through LocalHT, and check dict and
+ *              post against a table given the same words in the fixed
+ *              table's slot order; then check that a document with more
+ *              words than slots keeps every one of them
+ * Returns:     nothing
+*/
+static void CheckLargeDocuments(const string Dirname)
+{
+mt19937 Random(7);
+vector< vector<string> > Docs;
+vector<string> Ordered;
+unsigned long NumSlots = ROUNDTRIP_LOCAL_WORDS * 3;
+unsigned long Sizes[] = { 20, 5000, 2000, 5000, NumSlots - 1, 6000, 5000 };
+int Used, Collisions, Lookups;
+string Dict;
+string Post;
+
+   for (unsigned long d = 0; d < sizeof(Sizes) / sizeof(Sizes[0]); d++)
+   {
+      vector<bool> Seen(NumSlots + 4000, false);
+      Docs.push_back(vector<string>());
+      while (Docs.back().size() < Sizes[d])
+      {
+         unsigned long w = Random() % Seen.size();
+         if (!Seen[w])
+         {
+            Seen[w] = true;
+            Docs.back().push_back("word" + to_string(w));
+         }
+      }
+   }
+
+   {
+   TermTable LocalTerms(ROUNDTRIP_GLOBAL_WORDS);
+   TermTable Terms(ROUNDTRIP_GLOBAL_WORDS);
+   HashTable LocalHT(ROUNDTRIP_LOCAL_WORDS, LocalTerms);
+   GlobalHashTable GlobalHT(ROUNDTRIP_GLOBAL_WORDS, Terms);
+   for (unsigned long d = 0; d < Docs.size(); d++)
+   {
+      for (int r = 0; r < ROUNDTRIP_REPEATS; r++)
+         for (unsigned long w = 0; w < Docs[d].size(); w++)
+            LocalHT.Insert(Docs[d][w]);
+      LocalHT.TransferData(d + 1, GlobalHT);
+      LocalHT.Reset();
+   }
+   GlobalHT.PrintDictPost(Dirname + "/dict", Dirname + "/post", Docs.size());
+   Dict = ReadFile(Dirname + "/dict");
+   Post = ReadFile(Dirname + "/post");
+   }
+
+   {
+   TermTable Terms(ROUNDTRIP_GLOBAL_WORDS);
+   GlobalHashTable GlobalHT(ROUNDTRIP_GLOBAL_WORDS, Terms);
+   for (unsigned long d = 0; d < Docs.size(); d++)
+   {
+      Ordered = FixedSlotOrder(Docs[d], NumSlots);
+      for (unsigned long w = 0; w < Ordered.size(); w++)
+         GlobalHT.Insert(Terms.Intern(Ordered[w]), d + 1,
+                         (ROUNDTRIP_REPEATS * (1.0)) / (Docs[d].size() * (1.0)));
+   }
+   GlobalHT.PrintDictPost(Dirname + "/dict", Dirname + "/post", Docs.size());
+   Report("large documents in fixed-table order", !Dict.empty() && ReadFile(Dirname + "/dict") == Dict &&
+                                                  ReadFile(Dirname + "/post") == Post);
+   }
+   unlink((Dirname + "/dict").c_str());
+   unlink((Dirname + "/post").c_str());
+
+   {
+   TermTable LocalTerms(ROUNDTRIP_GLOBAL_WORDS);
+   HashTable LocalHT(ROUNDTRIP_LOCAL_WORDS, LocalTerms);
+   for (unsigned long w = 0; w < NumSlots + 1000; w++)
+      LocalHT.Insert("word" + to_string(w));
+   LocalHT.GetUsage(Used, Collisions, Lookups);
+   Report("more words than slots", Used == (int) NumSlots + 1000 &&
+                                   LocalHT.GetData(LocalTerms.Find("word0")) == 1 &&
+                                   LocalHT.GetData(LocalTerms.Find("word" + to_string(NumSlots + 999))) == 1);
+   }
+}
+
+/* Name:  CheckSortedDict
+ * Parameters:  Dirname: where to write the files
+ *              Docs: the documents to post
+ * Purpose:     write random terms sharing prefixes with SortedDictWriter,
+ *              find every one, walk them all and Seek to terms that are
+ *              and are not there; then post the documents into a table
+ *              printing a sorted dictionary and check that each term's
+ *              lines in post hold its documents
+ * Returns:     nothing
+*/
+static void CheckSortedDict(const string Dirname, const vector<RoundTripDoc> &Docs)
+{
+mt19937 Random(17);
+map<string, int> Terms;
+map<string, vector<int> > Expected;
+vector<string> Lines;
+vector<string> Sorted;
+vector<int> DocIds;
+string Term;
+string Probe;
+string Line;
+int NumDocs;
+unsigned long Start;
+unsigned long Total = 0;
+bool Passed;
+
+   while (Terms.size() < ROUNDTRIP_SDICT_TERMS)
+   {
+      Term.clear();
+      for (int c = 1 + Random() % 12; c > 0; c--)
+         Term += "abcz"[Random() % 4];
+      Terms[Term] = 1 + Random() % 50;
+   }
+
+   {
+   SortedDictWriter Writer(Dirname + "/sdict");
+   for (map<string, int>::iterator t = Terms.begin(); t != Terms.end(); t++)
+   {
+      Writer.Add(t->first, t->second);
+      Sorted.push_back(t->first);
+   }
+   Passed = Writer.Close();
+   }
+   SortedDict Reader(Dirname + "/sdict");
+   Passed = Passed && Reader.IsOpen() && Reader.GetNumTerms() == Terms.size();
+   for (map<string, int>::iterator t = Terms.begin(); t != Terms.end() && Passed; t++)
+   {
+      Passed = Reader.Find(t->first, NumDocs, Start) && NumDocs == t->second && Start == Total &&
+               !Reader.Find(t->first + "y", NumDocs, Start);
+      Total += t->second;
+   }
+   Reader.Rewind();
+   for (unsigned long t = 0; t < Sorted.size() && Passed; t++)
+      Passed = Reader.Next(Term, NumDocs, Start) && Term == Sorted[t];
+   Passed = Passed && !Reader.Next(Term, NumDocs, Start);
+   for (int p = 0; p < 200 && Passed; p++)
+   {
+      Probe.clear();
+      for (int c = Random() % 8; c > 0; c--)
+         Probe += "abcdz"[Random() % 5];
+      vector<string>::iterator After = lower_bound(Sorted.begin(), Sorted.end(), Probe);
+      Reader.Seek(Probe);
+      if (After == Sorted.end())
+         Passed = !Reader.Next(Term, NumDocs, Start);
+      else
+         Passed = Reader.Next(Term, NumDocs, Start) && Term == *After &&
+                  (After + 1 == Sorted.end() || (Reader.Next(Term, NumDocs, Start) && Term == *(After + 1)));
+   }
+   Report("sorted dictionary find, seek and next", Passed);
+
+   for (unsigned long d = 0; d < Docs.size(); d++)
+      for (unsigned long k = 0; k < Docs[d].tokens.size(); k++)
+         Expected[Docs[d].tokens[k]].push_back(d + 1);
+   {
+   TermTable Terms(ROUNDTRIP_VOCABULARY);
+   GlobalHashTable GlobalHT(ROUNDTRIP_VOCABULARY, Terms);
+   GlobalHT.SortDictionary();
+   PostDocuments(GlobalHT, Docs, 0, Docs.size());
+   GlobalHT.PrintDictPost(Dirname + "/sdict", Dirname + "/post", Docs.size());
+   }
+   ifstream Post((Dirname + "/post").c_str());
+   while (getline(Post, Line))
+      Lines.push_back(Line);
+   SortedDict Table(Dirname + "/sdict");
+   Passed = Table.IsOpen() && Table.GetNumTerms() == Expected.size();
+   for (map<string, vector<int> >::iterator t = Expected.begin(); t != Expected.end() && Passed; t++)
+   {
+      Passed = Table.Next(Term, NumDocs, Start) && Term == t->first && NumDocs == (int) t->second.size() &&
+               Start + NumDocs <= Lines.size();
+      DocIds.clear();
+      for (int k = 0; k < NumDocs && Passed; k++)
+         DocIds.push_back(atoi(Lines[Start + k].c_str()));
+      Passed = Passed && DocIds == t->second;
+   }
+   Report("sorted dictionary of a table", Passed);
+   unlink((Dirname + "/sdict").c_str());
+   unlink((Dirname + "/post").c_str());
+}
+
+/* Name:  SameMatches
+ * Parameters:  Matches: what a trie lookup found
+ *              Terms: every term with its entry, in order
+ *              Wanted: which of Terms the lookup should find
+ * Purpose:     compare a lookup's terms, entries and distances with
+ *              brute force
+ * Returns:     true if they are the same, in the same order
+*/
+static bool SameMatches(const vector<TrieMatch> &Matches, const vector<TrieMatch> &Terms,
+                        const vector<bool> &Wanted)
+{
+unsigned long m = 0;
+
+   for (unsigned long t = 0; t < Terms.size(); t++)
+      if (Wanted[t])
+      {
+         if (m == Matches.size() || Matches[m].term != Terms[t].term ||
+             Matches[m].entry.numdocs != Terms[t].entry.numdocs ||
+             Matches[m].entry.start != Terms[t].entry.start ||
+             Matches[m].distance != Terms[t].distance)
+            return false;
+         m++;
+      }
+   return m == Matches.size();
+}
+
+/* Name:  RandomTerm
+ * Parameters:  Random: the generator
+ *              Alphabet: the bytes to draw from
+ *              MaxLength: the longest term
+ * Purpose:     make a term of 0 to MaxLength bytes
+ * Returns:     the term
+*/
+static string RandomTerm(mt19937 &Random, const string Alphabet, const int MaxLength)
+{
+string Term;
+
+   for (int c = Random() % (MaxLength + 1); c > 0; c--)
+      Term += Alphabet[Random() % Alphabet.length()];
+   return Term;
+}
+
+/* Name:  EditDistance
+ * Parameters:  a, b: two terms
+ * Purpose:     count the fewest insertions, deletions and substitutions
+ *              that turn a into b
+ * Returns:     the count
+*/
+static int EditDistance(const string &a, const string &b)
+{
+vector<int> Row(b.length() + 1);
+vector<int> Next(b.length() + 1);
+
+   for (unsigned long j = 0; j <= b.length(); j++)
+      Row[j] = j;
+   for (unsigned long i = 1; i <= a.length(); i++)
+   {
+      Next[0] = i;
+      for (unsigned long j = 1; j <= b.length(); j++)
+         Next[j] = min(min(Row[j] + 1, Next[j - 1] + 1), Row[j - 1] + (a[i - 1] != b[j - 1]));
+      Row.swap(Next);
+   }
+   return Row[b.length()];
+}
+
+/* Name:  CheckTrie
+ * Parameters:  Dirname: where to write the trie
+ * Purpose:     build a trie of random terms sharing prefixes, write and
+ *              read it back, and check exact, prefix, wildcard, range and
+ *              fuzzy lookups against scans over the terms
+ * Returns:     nothing
+*/
+static void CheckTrie(const string Dirname)
+{
+mt19937 Random(23);
+set<string> Unique;
+vector<TrieMatch> Terms;
+vector<string_view> Views;
+vector<TrieEntry> Entries;
+vector<TrieMatch> Matches;
+vector<bool> Wanted;
+TermTrie Built;
+TermTrie Trie;
+TrieEntry Entry;
+unsigned long Start = 0;
+bool Passed[5] = {true, true, true, true, true};
+
+   while (Unique.size() < ROUNDTRIP_TRIE_TERMS)
+      Unique.insert(RandomTerm(Random, "abcz", 12));
+   Unique.erase("");
+   for (set<string>::iterator t = Unique.begin(); t != Unique.end(); t++)
+   {
+      Terms.push_back(TrieMatch{*t, TrieEntry{(int) (1 + Random() % 50), Start}, 0});
+      Start += Terms.back().entry.numdocs;
+   }
+   for (unsigned long t = 0; t < Terms.size(); t++)
+   {
+      Views.push_back(Terms[t].term);
+      Entries.push_back(Terms[t].entry);
+   }
+   Built.Build(Views, Entries);
+   Passed[0] = Built.Write(Dirname + "/trie") && Trie.Read(Dirname + "/trie") &&
+               Trie.GetNumTerms() == Terms.size();
+   unlink((Dirname + "/trie").c_str());
+
+   for (unsigned long t = 0; t < Terms.size() && Passed[0]; t++)
+      Passed[0] = Trie.Find(Terms[t].term, Entry) && Entry.numdocs == Terms[t].entry.numdocs &&
+                  Entry.start == Terms[t].entry.start && !Trie.Find(Terms[t].term + "y", Entry);
+   Report("trie find", Passed[0]);
+
+   for (int p = 0; p < ROUNDTRIP_PATTERNS; p++)
+   {
+      string Prefix = RandomTerm(Random, "abcdz", 4);
+      string Pattern = RandomTerm(Random, "abcz*?", 8);
+      string Low = RandomTerm(Random, "abcdz", 5);
+      string High = RandomTerm(Random, "abcdz", 5);
+      if (High < Low)
+         swap(Low, High);
+
+      Wanted.assign(Terms.size(), false);
+      for (unsigned long t = 0; t < Terms.size(); t++)
+         Wanted[t] = Terms[t].term.compare(0, Prefix.length(), Prefix) == 0;
+      Matches.clear();
+      Trie.Prefix(Prefix, Matches);
+      Passed[1] = Passed[1] && SameMatches(Matches, Terms, Wanted);
+
+      for (unsigned long t = 0; t < Terms.size(); t++)
+         Wanted[t] = fnmatch(Pattern.c_str(), Terms[t].term.c_str(), 0) == 0;
+      Matches.clear();
+      Trie.Wildcard(Pattern, Matches);
+      Passed[2] = Passed[2] && SameMatches(Matches, Terms, Wanted);
+
+      for (unsigned long t = 0; t < Terms.size(); t++)
+         Wanted[t] = Terms[t].term >= Low && Terms[t].term <= High;
+      Matches.clear();
+      Trie.Range(Low, High, Matches);
+      Passed[3] = Passed[3] && SameMatches(Matches, Terms, Wanted);
+
+      // fuzzy matches come most documents first; compare them in term
+      // order with each term's distance from the word
+      int MaxDistance = 1 + p % 2;
+      vector<TrieMatch> Near(Terms);
+      for (unsigned long t = 0; t < Terms.size(); t++)
+      {
+         Near[t].distance = EditDistance(Prefix, Terms[t].term);
+         Wanted[t] = Near[t].distance <= MaxDistance;
+      }
+      Matches.clear();
+      Trie.Fuzzy(Prefix, MaxDistance, Matches);
+      for (unsigned long m = 1; m < Matches.size(); m++)
+         Passed[4] = Passed[4] && Matches[m - 1].entry.numdocs >= Matches[m].entry.numdocs;
+      sort(Matches.begin(), Matches.end(), [](const TrieMatch &a, const TrieMatch &b)
+           { return a.term < b.term; });
+      Passed[4] = Passed[4] && SameMatches(Matches, Near, Wanted);
+   }
+   Report("trie prefix", Passed[1]);
+   Report("trie wildcard", Passed[2]);
+   Report("trie range", Passed[3]);
+   Report("trie fuzzy", Passed[4]);
+}
+
+/* Name:  CheckTwoPassDocIds
+ * Parameters:  Dirname: where to write the files
+ * Purpose:     post DocIds past 9999, leaving some out so fewer than
+ *              10000 documents are kept, as --dedup does; check that two
+ *              passes, which map post when its lines are all
+ *              POST_LINE_LENGTH bytes, write what one pass does
+ * Returns:     nothing
+*/
+static void CheckTwoPassDocIds(const string Dirname)
+{
+string Dict;
+string Post;
+int NumKept = 0;
+bool Passed;
+
+   for (int Pass = 0; Pass <= 1; Pass++)
+   {
+      TermTable Terms(ROUNDTRIP_VOCABULARY);
+      GlobalHashTable GlobalHT(ROUNDTRIP_VOCABULARY, Terms);
+      if (Pass > 0)
+         GlobalHT.StartFirstPass();
+      for (int Repeat = (Pass > 0 ? 2 : 1); Repeat > 0; Repeat--)
+      {
+         NumKept = 0;
+         for (int DocId = 1; DocId <= ROUNDTRIP_MAX_DOCID; DocId++)
+            if (DocId % ROUNDTRIP_SKIPPED != 0)
+            {
+               NumKept++;
+               for (int w = 0; w < ROUNDTRIP_WORDS; w++)
+                  if ((DocId + w) % (w + 2) == 0)
+                     GlobalHT.Insert("word" + to_string(w), DocId, 1.0 / (w + 1));
+            }
+         if (Repeat == 2)
+            GlobalHT.StartSecondPass(Dirname + "/post", NumKept, ROUNDTRIP_MAX_DOCID);
+      }
+      GlobalHT.PrintDictPost(Dirname + "/dict", Dirname + "/post", NumKept);
+      if (Pass == 0)
+      {
+         Dict = ReadFile(Dirname + "/dict");
+         Post = ReadFile(Dirname + "/post");
+      }
+   }
+   Passed = NumKept < 10000 && Post.find("\n" + to_string(ROUNDTRIP_MAX_DOCID) + " ") != string::npos &&
+            ReadFile(Dirname + "/dict") == Dict && ReadFile(Dirname + "/post") == Post;
+   Report("two passes with five-digit DocIds", Passed);
+   unlink((Dirname + "/dict").c_str());
+   unlink((Dirname + "/post").c_str());
+}
+
+/* Name:  CheckTables
+ * Parameters:  Dirname: where to write the files
+ *              Docs: the documents to post
+ * Purpose:     print dict and post for the documents posted straight
+ *              through, then check that a table checkpointed halfway,
+ *              loaded into a new table and given the rest, and a table
+ *              spilled to runs every ROUNDTRIP_SPILL_DOCS documents,
+ *              print the same files, and that a cut-off checkpoint is
+ *              refused
+ * Returns:     nothing
+*/
+static void CheckTables(const string Dirname, const vector<RoundTripDoc> &Docs)
+{
+string Dict;
+string Post;
+string Checkpoint;
+int Half = Docs.size() / 2;
+int NumDocs = 0;
+bool Passed;
+
+   {
+   TermTable Terms(ROUNDTRIP_VOCABULARY);
+   GlobalHashTable GlobalHT(ROUNDTRIP_VOCABULARY, Terms);
+   PostDocuments(GlobalHT, Docs, 0, Docs.size());
+   GlobalHT.PrintDictPost(Dirname + "/dict", Dirname + "/post", Docs.size());
+   Dict = ReadFile(Dirname + "/dict");
+   Post = ReadFile(Dirname + "/post");
+   }
+
+   {
+   TermTable Terms(ROUNDTRIP_VOCABULARY);
+   GlobalHashTable GlobalHT(ROUNDTRIP_VOCABULARY, Terms);
+   PostDocuments(GlobalHT, Docs, 0, Half);
+   Passed = GlobalHT.Save(Dirname + "/checkpoint", Half);
+   }
+   {
+   TermTable Terms(ROUNDTRIP_VOCABULARY);
+   GlobalHashTable GlobalHT(ROUNDTRIP_VOCABULARY, Terms);
+   Passed = Passed && GlobalHT.Load(Dirname + "/checkpoint", NumDocs) && NumDocs == Half;
+   PostDocuments(GlobalHT, Docs, Half, Docs.size());
+   GlobalHT.PrintDictPost(Dirname + "/dict", Dirname + "/post", Docs.size());
+   Report("checkpoint save and load", Passed && !Dict.empty() && ReadFile(Dirname + "/dict") == Dict &&
+                                      ReadFile(Dirname + "/post") == Post);
+   }
+
+   Checkpoint = ReadFile(Dirname + "/checkpoint");
+   {
+   ofstream Cut((Dirname + "/checkpoint").c_str(), ios::binary);
+   Cut << Checkpoint.substr(0, Checkpoint.length() / 2);
+   }
+   {
+   TermTable Terms(ROUNDTRIP_VOCABULARY);
+   GlobalHashTable GlobalHT(ROUNDTRIP_VOCABULARY, Terms);
+   Report("cut-off checkpoint refused", !GlobalHT.Load(Dirname + "/checkpoint", NumDocs));
+   }
+   unlink((Dirname + "/checkpoint").c_str());
+
+   {
+   TermTable Terms(ROUNDTRIP_VOCABULARY);
+   GlobalHashTable GlobalHT(ROUNDTRIP_VOCABULARY, Terms);
+   Passed = true;
+   for (int d = 0; d < (int) Docs.size(); d += ROUNDTRIP_SPILL_DOCS)
+   {
+      PostDocuments(GlobalHT, Docs, d, min(d + ROUNDTRIP_SPILL_DOCS, (int) Docs.size()));
+      if (d + ROUNDTRIP_SPILL_DOCS < (int) Docs.size())
+         Passed = Passed && GlobalHT.Spill(Dirname + "/run." + to_string(GlobalHT.GetNumRuns()));
+   }
+   GlobalHT.PrintDictPost(Dirname + "/dict", Dirname + "/post", Docs.size());
+   Report("spilled runs merged", Passed && GlobalHT.GetNumRuns() > 1 && ReadFile(Dirname + "/dict") == Dict &&
+                                 ReadFile(Dirname + "/post") == Post);
+   for (unsigned int r = 0; r < GlobalHT.GetNumRuns(); r++)
+      unlink((Dirname + "/run." + to_string(r)).c_str());
+   }
+   unlink((Dirname + "/dict").c_str());
+   unlink((Dirname + "/post").c_str());
+}
+
+/* Name:  PrintIndex
+ * Parameters:  Dirname: where to write dict, post and trie
+ *              Docs: the documents to post
+ * Purpose:     write the files a query reads for the documents
+ * Returns:     nothing
+*/
+static void PrintIndex(const string Dirname, const vector<RoundTripDoc> &Docs)
+{
+TermTable Terms(ROUNDTRIP_VOCABULARY);
+GlobalHashTable GlobalHT(ROUNDTRIP_VOCABULARY, Terms);
+
+   PostDocuments(GlobalHT, Docs, 0, Docs.size());
+   GlobalHT.PrintDictPost(Dirname + "/dict", Dirname + "/post", Docs.size());
+   GlobalHT.PrintTrie(Dirname + "/trie");
+}
+
+/* Name:  ReadPostLines
+ * Parameters:  Filename: a post file
+ *              DocIds, Weights: receive each line's DocId and weight
+ * Purpose:     read post back
+ * Returns:     nothing
+*/
+static void ReadPostLines(const string Filename, vector<int> &DocIds, vector<float> &Weights)
+{
+ifstream Post(Filename.c_str());
+int DocId;
+float Weight;
+
+   while (Post >> DocId >> Weight)
+   {
+      DocIds.push_back(DocId);
+      Weights.push_back(Weight);
+   }
+}
+
+/* Name:  CheckCodecs
+ * Parameters:  none
+ * Purpose:     encode random lists of every length up to a block, dense
+ *              and sparse, after a random previous DocId, with every
+ *              codec, and decode them again
+ * Returns:     nothing
+*/
+static void CheckCodecs()
+{
+mt19937 Random(3);
+vector<char> Packed;
+vector<int> DocIds;
+vector<int> Decoded;
+int Previous;
+bool Passed;
+
+   for (int Codec = 0; Codec < CODEC_COUNT; Codec++)
+   {
+      Passed = true;
+      for (int l = 0; l < ROUNDTRIP_CODEC_LISTS && Passed; l++)
+      {
+         int Count = 1 + (l < CODEC_BLOCK_POSTINGS ? l : Random() % CODEC_BLOCK_POSTINGS);
+         int MaxGap = (l % 3 == 0 ? 2 : l % 3 == 1 ? 40 : 100000);
+         Previous = (l % 2 == 0 ? 0 : Random() % 1000000);
+         DocIds.clear();
+         for (int k = 0, DocId = Previous; k < Count; k++)
+            DocIds.push_back(DocId += 1 + Random() % MaxGap);
+         Packed.clear();
+         PostingCodec::Encode((CodecType) Codec, DocIds.data(), Count, Previous, Packed);
+         Packed.resize(Packed.size() + 16, 0);   // a decoder may look past the end
+         Decoded.assign(Count, 0);
+         const char *End = PostingCodec::Decode((CodecType) Codec, Packed.data(), Count, Previous,
+                                                Decoded.data());
+         Passed = (Decoded == DocIds && End == Packed.data() + Packed.size() - 16);
+      }
+      Report(string("codec ") + PostingCodec::GetName((CodecType) Codec), Passed);
+   }
+}
+
+/* Name:  CheckBlockPost
+ * Parameters:  Dirname: where to write the files
+ *              Docs: the documents to post, ROUNDTRIP_BPOST_REPEATS times
+ * Purpose:     build bpost from an index's post and trie; walk every
+ *              list with Next against post's lines, and from fresh
+ *              cursors AdvanceTo random DocIds against a scan of them,
+ *              a jump to the last posting decoding no block between
+ * Returns:     nothing
+*/
+static void CheckBlockPost(const string Dirname, const vector<RoundTripDoc> &Docs)
+{
+mt19937 Random(31);
+vector<RoundTripDoc> Many;
+vector<TrieMatch> Entries;
+vector<int> DocIds;
+vector<float> Weights;
+TermTrie Trie;
+BlockPost Blocks;
+PostingCursor Cursor;
+bool Walked;
+bool Skipped = true;
+bool Lazy = true;
+unsigned long Multiblock = 0;
+
+   for (int r = 0; r < ROUNDTRIP_BPOST_REPEATS; r++)
+      Many.insert(Many.end(), Docs.begin(), Docs.end());
+   PrintIndex(Dirname, Many);
+   ReadPostLines(Dirname + "/post", DocIds, Weights);
+   Walked = Trie.Read(Dirname + "/trie") && BlockPost::Build(Dirname, IMPACT_FLOAT, false) &&
+            Blocks.Open(Dirname + "/bpost");
+   Trie.Prefix("", Entries);
+   for (unsigned long e = 0; e < Entries.size() && Walked; e++)
+   {
+      const TrieEntry &Entry = Entries[e].entry;
+      Walked = Blocks.GetCursor(Entry, Cursor) && Cursor.GetNumDocs() == Entry.numdocs;
+      for (int k = 0; k < Entry.numdocs && Walked; k++)
+      {
+         Walked = Cursor.GetDocId() == DocIds[Entry.start + k] &&
+                  fabs(Cursor.Score() - Weights[Entry.start + k]) < 0.001;
+         Cursor.Next();
+      }
+      Walked = Walked && Cursor.GetDocId() == CURSOR_END;
+
+      vector<int>::iterator First = DocIds.begin() + Entry.start;
+      vector<int>::iterator Last = First + Entry.numdocs;
+      for (int t = 0; t < ROUNDTRIP_TARGETS && Walked; t++)
+      {
+         int Target = 1 + Random() % (Many.size() + 1);
+         vector<int>::iterator At = lower_bound(First, Last, Target);
+         Blocks.GetCursor(Entry, Cursor);
+         Cursor.AdvanceTo(Target);
+         Skipped = Skipped && Cursor.GetDocId() == (At == Last ? CURSOR_END : *At) &&
+                   (At == Last || fabs(Cursor.Score() - Weights[At - DocIds.begin()]) < 0.001);
+      }
+      if (Entry.numdocs > 2 * BPOST_BLOCK_POSTINGS)
+      {
+         Multiblock++;
+         Blocks.GetCursor(Entry, Cursor);
+         Cursor.AdvanceTo(*(Last - 1));
+         Lazy = Lazy && Cursor.GetDocId() == *(Last - 1) && Cursor.GetBlocksDecoded() <= 2;
+      }
+   }
+   Report("bpost lists and post", Walked && !Entries.empty());
+   Report("bpost AdvanceTo", Walked && Skipped);
+   Report("bpost decodes only blocks reached", Walked && Lazy && Multiblock > 0);
+   unlink((Dirname + "/dict").c_str());
+   unlink((Dirname + "/post").c_str());
+   unlink((Dirname + "/trie").c_str());
+   unlink((Dirname + "/bpost").c_str());
+}
+
+/* Name:  WithinStep
+ * Parameters:  Weight: a weight
+ *              Impact: what it came back as through an impact
+ *              Quantizer: the scale used
+ *              Logarithmic: whether the steps are logarithmic
+ *              Low, High: the scale's smallest and largest weights
+ * Purpose:     tell whether Impact is within one step of Weight
+ * Returns:     true if it is
+*/
+static bool WithinStep(const float Weight, const float Impact, const ImpactQuantizer &Quantizer,
+                       const bool Logarithmic, const float Low, const float High)
+{
+   if (Logarithmic)
+      return fabs(log(Impact) - log(Weight)) <= (log(High) - log(Low)) / (Quantizer.GetMaxImpact() - 1) + 1e-4;
+   return fabs(Impact - Weight) <= High / Quantizer.GetMaxImpact() + 1e-3;
+}
+
+/* Name:  CheckImpacts
+ * Parameters:  Dirname: where to write the files
+ *              Docs: the documents to post
+ * Purpose:     quantize random weights at 8 and 16 bits, linear and
+ *              logarithmic, checking that impacts keep the weights'
+ *              order and come back within a step; then build bpost with
+ *              each kind and walk it against post's lines
+ * Returns:     nothing
+*/
+static void CheckImpacts(const string Dirname, const vector<RoundTripDoc> &Docs)
+{
+mt19937 Random(37);
+vector<TrieMatch> Entries;
+vector<int> DocIds;
+vector<float> Weights;
+TermTrie Trie;
+PostingCursor Cursor;
+int Bits[2] = {IMPACT_BITS_SMALL, IMPACT_BITS_LARGE};
+float Low = 10.0;
+float High = 20000.0;
+bool Passed;
+
+   for (int b = 0; b < 2; b++)
+      for (int Logarithmic = 0; Logarithmic <= 1; Logarithmic++)
+      {
+         ImpactQuantizer Quantizer(Bits[b], Logarithmic, Low, High);
+         vector<float> Sample;
+         for (int k = 0; k < 1000; k++)
+            Sample.push_back(Low * pow(High / Low, (Random() % 100001) / 100000.0));
+         sort(Sample.begin(), Sample.end());
+         Passed = Quantizer.Quantize(0.0) == 0 && Quantizer.Dequantize(0) == 0.0 &&
+                  Quantizer.Quantize(High) == Quantizer.GetMaxImpact() &&
+                  Quantizer.GetMaxImpact() == (1u << Bits[b]) - 1;
+         for (unsigned long k = 0; k < Sample.size() && Passed; k++)
+            Passed = Quantizer.Quantize(Sample[k]) >= 1 &&
+                     (k == 0 || Quantizer.Quantize(Sample[k - 1]) <= Quantizer.Quantize(Sample[k])) &&
+                     WithinStep(Sample[k], Quantizer.Dequantize(Quantizer.Quantize(Sample[k])), Quantizer,
+                                Logarithmic, Low, High);
+         Report(to_string(Bits[b]) + "-bit " + (Logarithmic ? "log" : "linear") + " impacts", Passed);
+      }
+
+   PrintIndex(Dirname, Docs);
+   ReadPostLines(Dirname + "/post", DocIds, Weights);
+   Passed = Trie.Read(Dirname + "/trie") && !Weights.empty();
+   Trie.Prefix("", Entries);
+   Low = *min_element(Weights.begin(), Weights.end());
+   High = *max_element(Weights.begin(), Weights.end());
+   for (int b = 0; b < 2 && Passed; b++)
+      for (int Logarithmic = 0; Logarithmic <= 1 && Passed; Logarithmic++)
+      {
+         BlockPost Blocks;
+         ImpactQuantizer Quantizer(Bits[b], Logarithmic, Low, High);
+         Passed = BlockPost::Build(Dirname, Bits[b], Logarithmic) && Blocks.Open(Dirname + "/bpost") &&
+                  Blocks.GetImpactBits() == Bits[b];
+         for (unsigned long e = 0; e < Entries.size() && Passed; e++)
+         {
+            Passed = Blocks.GetCursor(Entries[e].entry, Cursor);
+            for (unsigned long k = Entries[e].entry.start; Passed && Cursor.GetDocId() != CURSOR_END; k++)
+            {
+               Passed = Cursor.GetDocId() == DocIds[k] &&
+                        WithinStep(Weights[k], Cursor.Score(), Quantizer, Logarithmic, Low, High);
+               Cursor.Next();
+            }
+         }
+      }
+   Report("bpost impacts and post", Passed);
+   unlink((Dirname + "/dict").c_str());
+   unlink((Dirname + "/post").c_str());
+   unlink((Dirname + "/trie").c_str());
+   unlink((Dirname + "/bpost").c_str());
+}
+
+/* Name:  CheckReorder
+ * Parameters:  Dirname: where to write the files
+ *              Docs: the documents to post
+ * Purpose:     reorder an index's DocIds and check that map lists the
+ *              same files, that each term's list is still in DocId
+ *              order, and that it holds the same files with the same
+ *              weights as before
+ * Returns:     nothing
+*/
+static void CheckReorder(const string Dirname, const vector<RoundTripDoc> &Docs)
+{
+vector<TrieMatch> Entries;
+vector<string> Before;
+vector<string> After;
+vector<int> OldIds;
+vector<int> NewIds;
+vector<float> OldWeights;
+vector<float> NewWeights;
+string Line;
+TermTrie Trie;
+bool Passed;
+
+   PrintIndex(Dirname, Docs);
+   {
+   ofstream Map((Dirname + "/map").c_str());
+   for (unsigned long d = 0; d < Docs.size(); d++)
+   {
+      Before.push_back("doc" + to_string(1000 + (d * 7919) % Docs.size()));
+      Map << Before.back() << "\n";
+   }
+   }
+   ReadPostLines(Dirname + "/post", OldIds, OldWeights);
+
+   DocReorderer Reorderer(Dirname);
+   Passed = Reorderer.Load();
+   if (Passed)
+   {
+      Reorderer.Reorder();
+      Passed = Reorderer.Rewrite();
+   }
+   ReadPostLines(Dirname + "/post", NewIds, NewWeights);
+   ifstream Map((Dirname + "/map").c_str());
+   while (getline(Map, Line))
+      After.push_back(Line);
+   Passed = Passed && Trie.Read(Dirname + "/trie") && After.size() == Before.size() &&
+            NewIds.size() == OldIds.size() && After != Before &&
+            is_permutation(After.begin(), After.end(), Before.begin());
+
+   Trie.Prefix("", Entries);
+   for (unsigned long e = 0; e < Entries.size() && Passed; e++)
+   {
+      vector<pair<string, float> > Old;
+      vector<pair<string, float> > New;
+      for (unsigned long k = Entries[e].entry.start; k < Entries[e].entry.start + Entries[e].entry.numdocs; k++)
+      {
+         Old.push_back(make_pair(Before[OldIds[k] - 1], OldWeights[k]));
+         New.push_back(make_pair(After[NewIds[k] - 1], NewWeights[k]));
+         Passed = Passed && (k == Entries[e].entry.start || NewIds[k - 1] < NewIds[k]);
+      }
+      sort(Old.begin(), Old.end());
+      sort(New.begin(), New.end());
+      Passed = Passed && Old == New;
+   }
+   Report("reorder keeps each term's documents", Passed && !Entries.empty());
+   unlink((Dirname + "/dict").c_str());
+   unlink((Dirname + "/post").c_str());
+   unlink((Dirname + "/trie").c_str());
+   unlink((Dirname + "/map").c_str());
+}
+
+/* Name:  CheckDocStore
+ * Parameters:  Dirname: where to write a store
+ * Purpose:     compress and decompress text that repeats, text that
+ *              does not and nothing at all, then write a store with
+ *              short documents, empty ones and one running over several
+ *              blocks, and read each document and the start of each
+ *              back
+ * Returns:     nothing
+*/
+static void CheckDocStore(const string Dirname)
+{
+mt19937 Random(5);
+vector<string> Texts;
+vector<char> Packed;
+vector<char> Unpacked;
+vector<char> Text;
+DocStore Writer;
+DocStore Reader;
+string Read;
+bool Passed = true;
+
+   Texts.push_back("");
+   Texts.push_back("abc");
+   Texts.push_back(string(10000, 'a'));
+   Texts.push_back(string());
+   for (int r = 0; r < 500; r++)
+      Texts.back() += "the quick brown fox " + to_string(r % 7) + " ";
+   Texts.push_back(string());
+   for (int r = 0; r < 20000; r++)
+      Texts.back() += (char) (Random() % 256);
+   for (unsigned long t = 0; t < Texts.size() && Passed; t++)
+   {
+      Packed.clear();
+      DocStore::Compress(Texts[t].data(), Texts[t].size(), Packed);
+      Unpacked.assign(Texts[t].size(), 0);
+      Passed = DocStore::Decompress(Packed.data(), Packed.size(), Unpacked.data(), Unpacked.size()) &&
+               string(Unpacked.begin(), Unpacked.end()) == Texts[t];
+   }
+   Report("docstore compressor", Passed);
+
+   Texts.clear();
+   for (int d = 0; d < 300; d++)
+   {
+      string Doc;
+      for (int w = Random() % (d == 150 ? 30000 : 60); w > 0; w--)
+         Doc += "word" + to_string(Random() % ROUNDTRIP_VOCABULARY) + " ";
+      Texts.push_back(Doc);
+   }
+   Passed = Writer.Create(Dirname + "/docs");
+   for (unsigned long d = 0; d < Texts.size() && Passed; d++)
+   {
+      Text.assign(Texts[d].begin(), Texts[d].end());
+      Writer.Add(d + 1, Text);
+   }
+   Passed = Passed && Writer.Finish() && Reader.Open(Dirname + "/docs") &&
+            Reader.GetNumDocs() == (int) Texts.size();
+   for (unsigned long d = 0; d < Texts.size() && Passed; d++)
+      Passed = Reader.Get(d + 1, Read) && Read == Texts[d] &&
+               Reader.Get(d + 1, 100, Read) && Read == Texts[d].substr(0, 100);
+   unlink((Dirname + "/docs").c_str());
+   Report("docstore file", Passed);
+}
+
+/* Name:  CheckForward
+ * Parameters:  Dirname: where to write the files
+ *              Docs: the documents to post
+ * Purpose:     build fwd from an index and check that each document's
+ *              record holds the terms whose lists name it, by their
+ *              place among the terms with postings in start order, with
+ *              their weights to within a 16-bit log impact.  The trie is
+ *              given terms without postings, which share the next
+ *              term's start, and these must take no id.
+ * Returns:     nothing
+*/
+static void CheckForward(const string Dirname, const vector<RoundTripDoc> &Docs)
+{
+vector<TrieMatch> Entries;
+vector<string_view> Terms;
+vector<TrieEntry> TermEntries;
+vector<int> DocIds;
+vector<float> Weights;
+vector<vector<int> > ExpectedIds(Docs.size() + 1);
+vector<vector<float> > ExpectedWeights(Docs.size() + 1);
+vector<int> TermIds;
+vector<float> Found;
+ForwardIndex Forward;
+TermTrie Trie;
+TermTrie Padded;
+float Low;
+float High;
+bool Passed;
+
+   PrintIndex(Dirname, Docs);
+   {
+   ofstream Map((Dirname + "/map").c_str());
+   for (unsigned long d = 0; d < Docs.size(); d++)
+      Map << "doc" << d << "\n";
+   }
+   ReadPostLines(Dirname + "/post", DocIds, Weights);
+   Passed = Trie.Read(Dirname + "/trie") && !Weights.empty();
+   Trie.Prefix("", Entries);
+   for (unsigned long e = 0, Count = Entries.size(); e < Count; e += 7)
+      Entries.push_back(TrieMatch{Entries[e].term + "~", TrieEntry{0, Entries[e].entry.start}, 0});
+   sort(Entries.begin(), Entries.end(), [](const TrieMatch &a, const TrieMatch &b)
+   {
+      return a.term < b.term;
+   });
+   for (unsigned long e = 0; e < Entries.size(); e++)
+   {
+      Terms.push_back(Entries[e].term);
+      TermEntries.push_back(Entries[e].entry);
+   }
+   Padded.Build(Terms, TermEntries);
+   Passed = Passed && Padded.Write(Dirname + "/trie") && ForwardIndex::Build(Dirname) &&
+            Forward.Open(Dirname + "/fwd") && Forward.GetNumDocs() == (int) Docs.size();
+
+   // ids by hand, in start order, where the padding shares starts
+   Entries.erase(remove_if(Entries.begin(), Entries.end(),
+                           [](const TrieMatch &m) { return m.entry.numdocs <= 0; }), Entries.end());
+   sort(Entries.begin(), Entries.end(), [](const TrieMatch &a, const TrieMatch &b)
+   {
+      return a.entry.start < b.entry.start;
+   });
+   Passed = Passed && Forward.GetNumTerms() == Entries.size();
+   for (unsigned long e = 0; e < Entries.size(); e++)
+      for (unsigned long k = Entries[e].entry.start; k < Entries[e].entry.start + Entries[e].entry.numdocs; k++)
+      {
+         ExpectedIds[DocIds[k]].push_back(e);
+         ExpectedWeights[DocIds[k]].push_back(Weights[k]);
+      }
+
+   Low = *min_element(Weights.begin(), Weights.end());
+   High = *max_element(Weights.begin(), Weights.end());
+   ImpactQuantizer Quantizer(FORWARD_IMPACT_BITS, true, Low, High);
+   for (int d = 1; d <= (int) Docs.size() && Passed; d++)
+   {
+      Passed = Forward.Get(d, TermIds, Found) && TermIds == ExpectedIds[d] &&
+               Found.size() == ExpectedWeights[d].size();
+      for (unsigned long t = 0; t < Found.size() && Passed; t++)
+         Passed = WithinStep(ExpectedWeights[d][t], Found[t], Quantizer, true, Low, High);
+   }
+   Report("fwd and post", Passed);
+   unlink((Dirname + "/dict").c_str());
+   unlink((Dirname + "/post").c_str());
+   unlink((Dirname + "/trie").c_str());
+   unlink((Dirname + "/map").c_str());
+   unlink((Dirname + "/fwd").c_str());
+}
+
+/* Name:  ReadPost
+ * Parameters:  Source: the RoundTripPost to read
+ *              Entry: a term's entry
+ *              DocIds, Weights: receive its postings
+ * Purpose:     read a term's postings for the hot tier
+ * Returns:     nothing
+*/
+static void ReadPost(const void *Source, const TrieEntry &Entry, vector<int> &DocIds, vector<float> &Weights)
+{
+const RoundTripPost *Post = (const RoundTripPost *) Source;
+
+   DocIds.assign(Post->docids.begin() + Entry.start, Post->docids.begin() + Entry.start + Entry.numdocs);
+   Weights.assign(Post->weights.begin() + Entry.start, Post->weights.begin() + Entry.start + Entry.numdocs);
+}
+
+/* Name:  IsHot
+ * Parameters:  Hot: the hot tier
+ *              Entry: a term's entry
+ *              Post: post read back
+ * Purpose:     look the term up, which counts an access, and check that
+ *              a hot list is the term's postings in post
+ * Returns:     true if the term is hot and its list is right
+*/
+static bool IsHot(HotTier &Hot, const TrieEntry &Entry, const RoundTripPost &Post)
+{
+HotList List;
+
+   if (!Hot.Find(Entry, List) || List.count != Entry.numdocs)
+      return false;
+   for (int k = 0; k < List.count; k++)
+      if (List.docids[k] != Post.docids[Entry.start + k] || List.weights[k] != Post.weights[Entry.start + k])
+         return false;
+   return true;
+}
+
+/* Name:  CheckHotTier
+ * Parameters:  Dirname: where to write the files
+ *              Docs: the documents to post
+ * Purpose:     search one term often, a second less, a third once, and
+ *              check that a budget for the first two makes them hot,
+ *              with their lists as post has them, and leaves the third
+ *              cold; that a byte less leaves only the first; and that
+ *              a saved profile makes the same two hot in a new tier
+ * Returns:     nothing
+*/
+static void CheckHotTier(const string Dirname, const vector<RoundTripDoc> &Docs)
+{
+vector<TrieMatch> Entries;
+RoundTripPost Post;
+TermTrie Trie;
+unsigned long Budget;
+bool Passed;
+
+   PrintIndex(Dirname, Docs);
+   ReadPostLines(Dirname + "/post", Post.docids, Post.weights);
+   Passed = Trie.Read(Dirname + "/trie");
+   Trie.Numbered(Entries);
+   Passed = Passed && Entries.size() >= 3;
+   if (!Passed)
+   {
+      Report("hot tier and post", false);
+      return;
+   }
+   const TrieEntry &Often = Entries[0].entry;
+   const TrieEntry &Less = Entries[Entries.size() / 2].entry;
+   const TrieEntry &Once = Entries.back().entry;
+   Budget = 8ul * (Often.numdocs + Less.numdocs);
+
+   for (unsigned long MaxBytes = Budget - 1; MaxBytes <= Budget; MaxBytes++)
+   {
+      HotTier Hot;
+      HotList List;
+      Hot.Start(Entries, MaxBytes, ReadPost, &Post);
+      for (int k = 0; k < 64; k++)
+         Passed = Passed && !(k < 16 && Hot.Find(Less, List)) && !Hot.Find(Often, List);
+      Passed = Passed && !Hot.Find(Once, List);
+      Hot.Rebalance();
+      Passed = Passed && IsHot(Hot, Often, Post) && IsHot(Hot, Less, Post) == (MaxBytes == Budget) &&
+               !Hot.Find(Once, List);
+      if (MaxBytes == Budget)
+         Passed = Passed && Hot.SaveProfile(Dirname + "/hotprofile");
+   }
+   Report("hot tier and post", Passed);
+
+   HotTier Loaded;
+   Loaded.Start(Entries, Budget, ReadPost, &Post);
+   Passed = Loaded.LoadProfile(Dirname + "/hotprofile") && IsHot(Loaded, Often, Post) &&
+            IsHot(Loaded, Less, Post) && !IsHot(Loaded, Once, Post);
+   Report("hot tier from a profile", Passed);
+   unlink((Dirname + "/dict").c_str());
+   unlink((Dirname + "/post").c_str());
+   unlink((Dirname + "/trie").c_str());
+   unlink((Dirname + "/hotprofile").c_str());
+}
+
+/* Name:  CheckSegments
+ * Parameters:  Dirname: a directory of segments
+ *              Expected: every term's DocIds and rtfs
+ *              NumDocs: the documents, named doc1, doc2, ...
+ * Purpose:     read every term's list from the segments the manifest
+ *              names, in order, and compare them with those expected
+ * Returns:     false if a list or a filename differs
+*/
+static bool CheckSegments(const string Dirname, const ExpectedLists &Expected, const int NumDocs)
+{
+vector<string> Names;
+vector<Segment*> Segments;
+vector<TrieMatch> Matches;
+vector<int> DocIds;
+vector<float> RTFs;
+ExpectedLists Found;
+int Next = 1;
+bool Passed = true;
+
+   Segment::List(Dirname, Names);
+   for (unsigned long n = 0; n < Names.size(); n++)
+   {
+      Segments.push_back(new Segment);
+      Passed = Passed && Segments.back()->Open(Dirname + "/" + Names[n]) &&
+               Segments.back()->GetFirstDocId() == Next;
+      Next += Segments.back()->GetNumDocs();
+   }
+   Passed = Passed && Next == NumDocs + 1;
+   for (unsigned long s = 0; s < Segments.size() && Passed; s++)
+   {
+      Matches.clear();
+      Segments[s]->GetTrie().Prefix("", Matches);
+      for (unsigned long m = 0; m < Matches.size(); m++)
+      {
+         Segments[s]->GetPostings(Matches[m].entry, DocIds, RTFs);
+         Found[Matches[m].term].first.insert(Found[Matches[m].term].first.end(), DocIds.begin(), DocIds.end());
+         Found[Matches[m].term].second.insert(Found[Matches[m].term].second.end(), RTFs.begin(), RTFs.end());
+      }
+      for (int d = 0; d < Segments[s]->GetNumDocs() && Passed; d++)
+      {
+         int DocId = Segments[s]->GetFirstDocId() + d;
+         Passed = (Segments[s]->GetFilename(DocId) == "doc" + to_string(DocId));
+      }
+   }
+   for (unsigned long s = 0; s < Segments.size(); s++)
+      delete Segments[s];
+   return Passed && Found == Expected;
+}
+
+/* Name:  CheckLiveSegment
+ * Parameters:  Dirname: where to write the segments
+ *              Docs: the documents to add
+ * Purpose:     add the documents to a live segment, flushing every
+ *              ROUNDTRIP_SEGMENT_DOCS but the last few, and check that
+ *              the segments hold the flushed ones and the live segment
+ *              finds the rest; then flush those too and check again
+ * Returns:     nothing
+*/
+static void CheckLiveSegment(const string Dirname, const vector<RoundTripDoc> &Docs)
+{
+ExpectedLists OnDisk;
+ExpectedLists InMemory;
+ExpectedLists Expected;
+vector<string_view> Terms;
+vector<int> DocIds;
+vector<float> RTFs;
+int Held = Docs.size() - ROUNDTRIP_SEGMENT_DOCS / 2;
+int Flushed = Held - Held % ROUNDTRIP_SEGMENT_DOCS;
+int Generation;
+int FirstDocId;
+bool Passed = true;
+
+   for (int d = 0; d < Held; d++)
+      for (unsigned long k = 0; k < Docs[d].tokens.size(); k++)
+      {
+         ExpectedLists &Lists = (d < Flushed ? OnDisk : InMemory);
+         Lists[Docs[d].tokens[k]].first.push_back(d + 1);
+         Lists[Docs[d].tokens[k]].second.push_back(Docs[d].rtfs[k]);
+         Expected[Docs[d].tokens[k]].first.push_back(d + 1);
+         Expected[Docs[d].tokens[k]].second.push_back(Docs[d].rtfs[k]);
+      }
+
+   {
+   MemorySegment Live(Dirname + "/segments", 3600);
+   for (int d = 0; d < Held && Passed; d++)
+   {
+      Terms.assign(Docs[d].tokens.begin(), Docs[d].tokens.end());
+      Live.Add(d + 1, "doc" + to_string(d + 1), Terms, Docs[d].rtfs);
+      if ((d + 1) % ROUNDTRIP_SEGMENT_DOCS == 0)
+         Passed = Live.Flush();
+   }
+   Passed = Passed && Live.GetGeneration() == Flushed / ROUNDTRIP_SEGMENT_DOCS &&
+            Live.GetFirstDocId() == Flushed + 1 && Live.GetNumDocs() == Held - Flushed &&
+            Live.GetFilename(Held) == "doc" + to_string(Held) && Live.GetFilename(Flushed) == "";
+   for (ExpectedLists::const_iterator e = Expected.begin(); e != Expected.end() && Passed; e++)
+   {
+      ExpectedLists::const_iterator Kept = InMemory.find(e->first);
+      Passed = Live.Find(e->first, DocIds, RTFs, Generation, FirstDocId) == (Kept != InMemory.end()) &&
+               FirstDocId == Flushed + 1 && Live.GetNumDocs(e->first) == (int) DocIds.size() &&
+               (Kept == InMemory.end() || (DocIds == Kept->second.first && RTFs == Kept->second.second));
+   }
+   Report("live segment finds what is not flushed", Passed);
+   Passed = CheckSegments(Dirname + "/segments", OnDisk, Flushed) && Live.Flush() && Live.GetNumDocs() == 0 &&
+            CheckSegments(Dirname + "/segments", Expected, Held);
+   Report("live segment flushed", Passed);
+   }
+   Segment::Remove(Dirname + "/segments");
+}
+
+/* Name:  CheckSegmentMerge
+ * Parameters:  Dirname: where to write the segments
+ *              Docs: the documents to add
+ * Purpose:     flush the documents as small segments and check them,
+ *              then merge the segments until no tier is full and check
+ *              them again
+ * Returns:     nothing
+*/
+static void CheckSegmentMerge(const string Dirname, const vector<RoundTripDoc> &Docs)
+{
+ExpectedLists Expected;
+vector<string_view> Terms;
+vector<string> Names;
+bool Passed = true;
+int Merges = 0;
+
+   for (unsigned long d = 0; d < Docs.size(); d++)
+      for (unsigned long k = 0; k < Docs[d].tokens.size(); k++)
+      {
+         Expected[Docs[d].tokens[k]].first.push_back(d + 1);
+         Expected[Docs[d].tokens[k]].second.push_back(Docs[d].rtfs[k]);
+      }
+
+   {
+   MemorySegment Writer(Dirname + "/segments", 3600);
+   for (unsigned long d = 0; d < Docs.size() && Passed; d++)
+   {
+      Terms.assign(Docs[d].tokens.begin(), Docs[d].tokens.end());
+      Writer.Add(d + 1, "doc" + to_string(d + 1), Terms, Docs[d].rtfs);
+      if ((d + 1) % ROUNDTRIP_SEGMENT_DOCS == 0)
+         Passed = Writer.Flush();
+   }
+   Passed = Passed && Writer.Flush();
+   Report("segments flushed", Passed && CheckSegments(Dirname + "/segments", Expected, Docs.size()));
+   while (Writer.Compact())
+      Merges++;
+   }
+   Segment::List(Dirname + "/segments", Names);
+   Report("segments merged", Merges > 0 && Names.size() < Docs.size() / ROUNDTRIP_SEGMENT_DOCS &&
+                             CheckSegments(Dirname + "/segments", Expected, Docs.size()));
+   Segment::Remove(Dirname + "/segments");
+}
+
+/* Name:  Scan
+ * Parameters:  Buffer: a whole document, ending in two NUL bytes
+ * Purpose:     stand in for the flex scanner in invert.lex, which
+ *              roundtrip does not link: each word between spaces is
+ *              counted as the scanner counts a plain word
+ * Returns:     nothing
+*/
+void Tokenizer::Scan (vector<char> &Buffer)
+{
+unsigned long Start = 0;
+
+   for (unsigned long i = 0; i < Buffer.size(); i++)
+      if (Buffer[i] == ' ' || Buffer[i] == '\0')
+      {
+         if (i > Start)
+            Downcase(Buffer.data() + Start, i - Start);
+         Start = i + 1;
+      }
+}
+
+/* Name:  IndexSerially
+ * Parameters:  Source: the documents
+ *              Invert: the inverter to post them with
+ *              Stopwords: the words never to count
+ * Purpose:     index the documents with one tokenizer on this thread
+ * Returns:     nothing
+*/
+static void IndexSerially(DocumentSource &Source, Inverter &Invert, const vector<string> &Stopwords)
+{
+Tokenizer Tok(Stopwords, Invert.AddSource(), Invert.IsDeduplicating(), Invert.IsStoringText());
+vector<char> Buffer;
+TermBatch Batch;
+int DocId;
+
+   while (Source.Next(Buffer, DocId))
+   {
+      Tok.Scan(Buffer);
+      Tok.Transfer(DocId, Batch);
+      Invert.Add(Batch);
+   }
+}
+
+/* Name:  MakeDocumentFiles
+ * Parameters:  Dirname: the directory to write the documents to
+ *              Docs: receives each document's words, by filename
+ * Purpose:     write ROUNDTRIP_DOCS documents of common words, each
+ *              ROUNDTRIP_REPEATS times and some capitalized, stopwords
+ *              and rare words seen once.  Together they hold more words
+ *              than a tokenizer keeps before it is cut back.
+ * Returns:     nothing
+*/
+static void MakeDocumentFiles(const string Dirname, map<string, vector<string> > &Docs)
+{
+mt19937 Random(13);
+string Filename;
+string Word;
+
+   mkdir(Dirname.c_str(), 0755);
+   for (int d = 0; d < ROUNDTRIP_DOCS; d++)
+   {
+      Filename = "doc" + to_string(1000 + (d * 7919) % ROUNDTRIP_DOCS);
+      vector<string> &Words = Docs[Filename];
+      ofstream Doc((Dirname + "/" + Filename).c_str());
+      for (int r = 0; r < ROUNDTRIP_REPEATS; r++)
+      {
+         for (int w = 0; w < ROUNDTRIP_WORDS; w++)
+         {
+            Word = "word" + to_string((d * 31 + w * w) % ROUNDTRIP_VOCABULARY);
+            Words.push_back(w % 5 == 0 ? "Cap" + Word : Word);
+         }
+         Words.push_back("the");
+         Words.push_back("The");
+      }
+      for (int w = 0; w < ROUNDTRIP_RARE_WORDS; w++)
+         Words.push_back("rare" + to_string(Random() % 1000000));
+      for (unsigned long w = 0; w < Words.size(); w++)
+         Doc << Words[w] << " ";
+   }
+}
+
+/* Name:  CheckPipeline
+ * Parameters:  Dirname: where to write the documents and files
+ * Purpose:     index documents serially through a tokenizer and the
+ *              inverter, through the pipeline's tokenizer threads and
+ *              through those threads posting into the concurrent table,
+ *              and check them against one table fed the same words
+ *              directly, which never cuts its terms back; the inverter's
+ *              runs store the documents, which must hold their tokens
+ * Returns:     nothing
+*/
+static void CheckPipeline(const string Dirname)
+{
+map<string, vector<string> > Docs;
+vector<string> Stopwords;
+vector<string> Filenames;
+string Filename;
+string Dict;
+string Post;
+string Map;
+string Trie;
+string Store;
+string Text;
+string Expected;
+int DocId;
+bool Passed[ROUNDTRIP_CONCURRENT + 1];
+bool Stored;
+
+   Stopwords.push_back("the");
+   MakeDocumentFiles(Dirname + "/docs", Docs);
+
+   for (int Mode = ROUNDTRIP_SERIAL; Mode <= ROUNDTRIP_CONCURRENT; Mode++)
+   {
+      TermTable Terms(ROUNDTRIP_VOCABULARY);
+      GlobalHashTable GlobalHT(ROUNDTRIP_VOCABULARY, Terms);
+      ConcurrentGlobalHashTable SharedHT(ROUNDTRIP_VOCABULARY);
+      Inverter Invert(GlobalHT, Terms);
+      DocStore Writer;
+      DIR *InputDirPtr = opendir((Dirname + "/docs").c_str());
+      ofstream MapFile((Dirname + "/map").c_str());
+      DocumentSource Source(InputDirPtr, (Dirname + "/docs").c_str(), MapFile);
+      if (Mode != ROUNDTRIP_CONCURRENT && Writer.Create(Dirname + "/store"))
+         Invert.SetDocStore(&Writer);
+      if (Mode == ROUNDTRIP_PIPELINE)
+         RunPipeline(Source, Invert, Stopwords, ROUNDTRIP_THREADS);
+      else if (Mode == ROUNDTRIP_CONCURRENT)
+         RunPipeline(Source, SharedHT, Stopwords, ROUNDTRIP_THREADS);
+      else
+         IndexSerially(Source, Invert, Stopwords);
+      closedir(InputDirPtr);
+      MapFile.close();
+      if (Mode == ROUNDTRIP_CONCURRENT)
+      {
+         SharedHT.PrintDictPost(Dirname + "/dict", Dirname + "/post", Source.GetNumDocs());
+         SharedHT.PrintTrie(Dirname + "/trie");
+      }
+      else
+      {
+         GlobalHT.PrintDictPost(Dirname + "/dict", Dirname + "/post", Source.GetNumDocs());
+         GlobalHT.PrintTrie(Dirname + "/trie");
+         Writer.Finish();
+      }
+      if (Mode == ROUNDTRIP_SERIAL)
+      {
+         Dict = ReadFile(Dirname + "/dict");
+         Post = ReadFile(Dirname + "/post");
+         Map = ReadFile(Dirname + "/map");
+         Trie = ReadFile(Dirname + "/trie");
+         Store = ReadFile(Dirname + "/store");
+      }
+      Passed[Mode] = ReadFile(Dirname + "/dict") == Dict && ReadFile(Dirname + "/post") == Post &&
+                     ReadFile(Dirname + "/map") == Map && ReadFile(Dirname + "/trie") == Trie &&
+                     (Mode == ROUNDTRIP_CONCURRENT || ReadFile(Dirname + "/store") == Store);
+   }
+
+   {
+   TermTable LocalTerms(ROUNDTRIP_VOCABULARY);
+   TermTable Terms(ROUNDTRIP_VOCABULARY);
+   HashTable LocalHT(ROUNDTRIP_LOCAL_WORDS, LocalTerms);
+   GlobalHashTable GlobalHT(ROUNDTRIP_VOCABULARY, Terms);
+   DocStore Reader;
+   ifstream MapFile((Dirname + "/map").c_str());
+   Stored = Reader.Open(Dirname + "/store") && Reader.GetNumDocs() == ROUNDTRIP_DOCS;
+   DocId = 0;
+   while (getline(MapFile, Filename))
+   {
+      vector<string> &Words = Docs[Filename];
+      Expected.clear();
+      for (unsigned long w = 0; w < Words.size(); w++)
+      {
+         string Word = Words[w];
+         for (unsigned long c = 0; c < Word.length(); c++)
+            Word[c] = tolower(Word[c]);
+         if (Word != "the")
+            LocalHT.Insert(Word);
+         Expected += (w > 0 ? " " : "") + Word;
+      }
+      LocalHT.TransferData(++DocId, GlobalHT);
+      LocalHT.Reset();
+      Stored = Stored && Reader.Get(DocId, Text) && Text == Expected;
+   }
+   GlobalHT.PrintDictPost(Dirname + "/dict", Dirname + "/post", DocId);
+   Report("serial tokenizer", !Dict.empty() && DocId == ROUNDTRIP_DOCS && ReadFile(Dirname + "/dict") == Dict &&
+                              ReadFile(Dirname + "/post") == Post);
+   Report("pipeline threads and serial", Passed[ROUNDTRIP_PIPELINE]);
+   Report("concurrent table and serial", Passed[ROUNDTRIP_CONCURRENT]);
+   Report("docstore holds each document's tokens", Stored);
+   }
+
+   for (map<string, vector<string> >::iterator d = Docs.begin(); d != Docs.end(); d++)
+      unlink((Dirname + "/docs/" + d->first).c_str());
+   rmdir((Dirname + "/docs").c_str());
+   unlink((Dirname + "/dict").c_str());
+   unlink((Dirname + "/post").c_str());
+   unlink((Dirname + "/map").c_str());
+   unlink((Dirname + "/trie").c_str());
+   unlink((Dirname + "/store").c_str());
+}
+
+/* Name:  CheckDedup
+ * Parameters:  Dirname: where to write the documents and files
+ * Purpose:     index documents, some of them others' words shuffled,
+ *              leaving out near-duplicates, serially, through the
+ *              pipeline and in two passes; check that each copy's map
+ *              line names the first of its words, and that dict and
+ *              post are those of a table fed only the documents kept
+ * Returns:     nothing
+*/
+static void CheckDedup(const string Dirname)
+{
+mt19937 Random(29);
+map<string, vector<string> > Docs;
+map<string, int> Group;              // which original each file has the words of
+map<int, int> FirstDocId;            // and the first DocId with those words
+vector<string> Stopwords;
+vector<string> Words;
+string Filename;
+string Line;
+string Dict;
+string Post;
+string Map;
+string Expected;
+int DocId;
+int NumCopies = 0;
+int Modes[3] = {ROUNDTRIP_SERIAL, ROUNDTRIP_PIPELINE, ROUNDTRIP_TWO_PASS};
+bool Passed[3];
+
+   mkdir((Dirname + "/docs").c_str(), 0755);
+   for (int d = 0; d < ROUNDTRIP_ORIGINALS + ROUNDTRIP_COPIES; d++)
+   {
+      Filename = "doc" + to_string(1000 + (d * 7919) % (ROUNDTRIP_ORIGINALS + ROUNDTRIP_COPIES));
+      Group[Filename] = (d < ROUNDTRIP_ORIGINALS ? d : Random() % ROUNDTRIP_ORIGINALS);
+      if (d < ROUNDTRIP_ORIGINALS)
+         for (int w = 0; w < 2 * ROUNDTRIP_WORDS; w++)
+            Docs[Filename].insert(Docs[Filename].end(), ROUNDTRIP_REPEATS,
+                                  "word" + to_string(Random() % ROUNDTRIP_VOCABULARY));
+      else
+      {
+         Docs[Filename] = Docs["doc" + to_string(1000 + (Group[Filename] * 7919) %
+                                                 (ROUNDTRIP_ORIGINALS + ROUNDTRIP_COPIES))];
+         shuffle(Docs[Filename].begin(), Docs[Filename].end(), Random);
+      }
+      ofstream Doc((Dirname + "/docs/" + Filename).c_str());
+      for (unsigned long w = 0; w < Docs[Filename].size(); w++)
+         Doc << Docs[Filename][w] << " ";
+   }
+
+   for (int m = 0; m < 3; m++)
+   {
+      TermTable Terms(ROUNDTRIP_VOCABULARY);
+      GlobalHashTable GlobalHT(ROUNDTRIP_VOCABULARY, Terms);
+      Inverter Invert(GlobalHT, Terms);
+      Deduplicator Duplicates;
+      DIR *InputDirPtr = opendir((Dirname + "/docs").c_str());
+      ofstream MapFile((Dirname + "/map").c_str());
+      DocumentSource Source(InputDirPtr, (Dirname + "/docs").c_str(), MapFile);
+      Invert.SetDeduplicator(&Duplicates);
+      if (Modes[m] == ROUNDTRIP_TWO_PASS)
+         GlobalHT.StartFirstPass();
+      if (Modes[m] == ROUNDTRIP_PIPELINE)
+         RunPipeline(Source, Invert, Stopwords, ROUNDTRIP_THREADS);
+      else
+         IndexSerially(Source, Invert, Stopwords);
+      if (Modes[m] == ROUNDTRIP_TWO_PASS)
+      {
+         GlobalHT.StartSecondPass(Dirname + "/post", Source.GetNumDocs() - Duplicates.GetNumDuplicates(),
+                                  Source.GetNumDocs());
+         Source.Rewind();
+         IndexSerially(Source, Invert, Stopwords);
+      }
+      closedir(InputDirPtr);
+      MapFile.close();
+      Duplicates.RewriteMap(Dirname + "/map");
+      GlobalHT.PrintDictPost(Dirname + "/dict", Dirname + "/post",
+                             Source.GetNumDocs() - Duplicates.GetNumDuplicates());
+      if (m == 0)
+      {
+         Dict = ReadFile(Dirname + "/dict");
+         Post = ReadFile(Dirname + "/post");
+         Map = ReadFile(Dirname + "/map");
+         NumCopies = Duplicates.GetNumDuplicates();
+      }
+      Passed[m] = ReadFile(Dirname + "/dict") == Dict && ReadFile(Dirname + "/post") == Post &&
+                  ReadFile(Dirname + "/map") == Map && Duplicates.GetNumDuplicates() == NumCopies;
+   }
+
+   {
+   TermTable LocalTerms(ROUNDTRIP_VOCABULARY);
+   TermTable Terms(ROUNDTRIP_VOCABULARY);
+   HashTable LocalHT(ROUNDTRIP_LOCAL_WORDS, LocalTerms);
+   GlobalHashTable GlobalHT(ROUNDTRIP_VOCABULARY, Terms);
+   ifstream MapFile((Dirname + "/map").c_str());
+   DocId = 0;
+   while (getline(MapFile, Line))
+   {
+      DocId++;
+      Filename = Line.substr(0, Line.find('\t'));
+      if (FirstDocId.count(Group[Filename]) == 0)
+      {
+         FirstDocId[Group[Filename]] = DocId;
+         for (unsigned long w = 0; w < Docs[Filename].size(); w++)
+            LocalHT.Insert(Docs[Filename][w]);
+         LocalHT.TransferData(DocId, GlobalHT);
+         LocalHT.Reset();
+         Expected += Filename + "\n";
+      }
+      else
+         Expected += Filename + "\t" + to_string(FirstDocId[Group[Filename]]) + "\n";
+   }
+   GlobalHT.PrintDictPost(Dirname + "/dict", Dirname + "/post", FirstDocId.size());
+   Report("dedup leaves out copies", NumCopies == ROUNDTRIP_COPIES && Map == Expected &&
+                                     ReadFile(Dirname + "/dict") == Dict && ReadFile(Dirname + "/post") == Post);
+   Report("dedup pipeline and serial", Passed[1]);
+   Report("dedup two passes and one", Passed[2]);
+   }
+
+   for (map<string, vector<string> >::iterator d = Docs.begin(); d != Docs.end(); d++)
+      unlink((Dirname + "/docs/" + d->first).c_str());
+   rmdir((Dirname + "/docs").c_str());
+   unlink((Dirname + "/dict").c_str());
+   unlink((Dirname + "/post").c_str());
+   unlink((Dirname + "/map").c_str());
+}
+
+int main()
+{
+string Dirname = "roundtrip." + to_string(getpid());
+vector<RoundTripDoc> Docs;
+ofstream Quiet("/dev/null");
+streambuf *Screen;
+
+   if (mkdir(Dirname.c_str(), 0755) != 0)
+   {
+      perror(Dirname.c_str());
+      return (1);
+   }
+   Screen = cout.rdbuf(Quiet.rdbuf());
+   MakeDocuments(Docs);
+   CheckLargeDocuments(Dirname);
+   CheckPipeline(Dirname);
+   CheckSortedDict(Dirname, Docs);
+   CheckTrie(Dirname);
+   CheckDedup(Dirname);
+   CheckTwoPassDocIds(Dirname);
+   CheckTables(Dirname, Docs);
+   CheckCodecs();
+   CheckBlockPost(Dirname, Docs);
+   CheckImpacts(Dirname, Docs);
+   CheckReorder(Dirname, Docs);
+   CheckDocStore(Dirname);
+   CheckForward(Dirname, Docs);
+   CheckHotTier(Dirname, Docs);
+   CheckLiveSegment(Dirname, Docs);
+   CheckSegmentMerge(Dirname, Docs);
+   rmdir(Dirname.c_str());
+   Out << (Failures == 0 ? "All round trips passed." : to_string(Failures) + " round trips FAILED.") << endl;
+   cout.rdbuf(Screen);
+   return Failures;
+}
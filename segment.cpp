@@ -0,0 +1,955 @@
+/* Filename:  segment.cpp
+ * Date:      10/19/2026
+ * Purpose:   The implementation file for near-real-time segments.
+*/
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <climits>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+
+#include "outputwriter.h"
+#include "postingcodec.h"
+#include "segment.h"
+
+using namespace std;
+
+// Read a number of the given type from anywhere in the file
+template <class T>
+static T GetRaw(const char *Where)
+{
+T Value;
+
+   memcpy(&Value, Where, sizeof(T));
+   return Value;
+}
+
+static double SecondsSince(const chrono::steady_clock::time_point Start)
+{
+   return chrono::duration<double>(chrono::steady_clock::now() - Start).count();
+}
+
+/* Name:  WriteSegment
+ * Parameters:  Dirname: the segment to write
+ *              FirstDocId: its first document
+ *              Filenames: its documents' filenames, from FirstDocId
+ *              Terms: its terms, in any order
+ *              DocIds: each term's DocIds, increasing
+ *              RTFs: and their relative term frequencies
+ * Purpose:     write a memory segment's terms, in order
+ * Returns:     false if a file could not be written
+*/
+static bool WriteSegment(const string Dirname, const int FirstDocId, const vector<string> &Filenames,
+                         const deque<string> &Terms, const vector< vector<int> > &DocIds,
+                         const vector< vector<float> > &RTFs)
+{
+vector<int> Order(Terms.size());
+SegmentWriter Writer(NULL);
+
+   for (unsigned long t = 0; t < Order.size(); t++)
+      Order[t] = t;
+   sort(Order.begin(), Order.end(), [&](int a, int b) { return Terms[a] < Terms[b]; });
+
+   if (!Writer.Start(Dirname, FirstDocId, Filenames.size()))
+      return false;
+   for (unsigned long k = 0; k < Order.size(); k++)
+      Writer.Add(Terms[Order[k]], DocIds[Order[k]], RTFs[Order[k]]);
+   return Writer.Finish(Filenames);
+}
+
+/* Name:  MergeSegments
+ * Parameters:  Inputs: neighbouring segments, in DocId order
+ *              Dirname: the segment to write
+ *              Limiter: what the reads and writes are paced by
+ *              Stopping: set to give the merge up
+ * Purpose:     write one segment holding every input's documents.  The
+ *              inputs' terms are walked together in order; a term's
+ *              lists are simply joined, as the inputs' DocIds follow
+ *              one another.
+ * Returns:     false if it could not be written or was given up
+*/
+static bool MergeSegments(const vector<Segment*> &Inputs, const string Dirname, RateLimiter *Limiter,
+                          const atomic<bool> &Stopping)
+{
+vector< vector<TrieMatch> > Terms(Inputs.size());
+vector<unsigned long> Next(Inputs.size(), 0);
+vector<string> Filenames;
+vector<int> DocIds;
+vector<float> RTFs;
+vector<int> PartDocIds;
+vector<float> PartRTFs;
+SegmentWriter Writer(Limiter);
+int FirstDocId = Inputs[0]->GetFirstDocId();
+
+   for (unsigned long i = 0; i < Inputs.size(); i++)
+   {
+      Inputs[i]->GetTrie().Prefix("", Terms[i]);
+      while (FirstDocId + (int) Filenames.size() < Inputs[i]->GetFirstDocId())
+         Filenames.push_back("");
+      for (int d = 0; d < Inputs[i]->GetNumDocs(); d++)
+         Filenames.push_back(Inputs[i]->GetFilename(Inputs[i]->GetFirstDocId() + d));
+   }
+   if (!Writer.Start(Dirname, FirstDocId, Filenames.size()))
+      return false;
+
+   while (!Stopping.load(memory_order_relaxed))
+   {
+      const string *Least = NULL;
+      for (unsigned long i = 0; i < Inputs.size(); i++)
+         if (Next[i] < Terms[i].size() && (Least == NULL || Terms[i][Next[i]].term < *Least))
+            Least = &Terms[i][Next[i]].term;
+      if (Least == NULL)
+         return Writer.Finish(Filenames);
+
+      string Term = *Least;
+      DocIds.clear();
+      RTFs.clear();
+      for (unsigned long i = 0; i < Inputs.size(); i++)
+         if (Next[i] < Terms[i].size() && Terms[i][Next[i]].term == Term)
+         {
+            unsigned long Bytes = Inputs[i]->GetPostings(Terms[i][Next[i]++].entry, PartDocIds, PartRTFs);
+            if (Limiter != NULL)
+               Limiter->Take(Bytes);
+            DocIds.insert(DocIds.end(), PartDocIds.begin(), PartDocIds.end());
+            RTFs.insert(RTFs.end(), PartRTFs.begin(), PartRTFs.end());
+         }
+      Writer.Add(Term, DocIds, RTFs);
+   }
+   return false;   // the writer abandons the segment
+}
+
+/* Name:  WriteManifest
+ * Parameters:  Dirname: a directory of segments
+ *              Names: the live segments, in DocId order
+ * Purpose:     write the manifest beside the old one, then rename it
+ *              over it, so a reader sees one or the other
+ * Returns:     false if it could not be written
+*/
+static bool WriteManifest(const string Dirname, const vector<string> &Names)
+{
+string Filename = Dirname + "/manifest";
+ofstream Manifest((Filename + ".new").c_str());
+
+   for (unsigned long n = 0; n < Names.size(); n++)
+      Manifest << Names[n] << '\n';
+   Manifest.close();
+   if (Manifest.fail() || rename((Filename + ".new").c_str(), Filename.c_str()) != 0)
+   {
+      perror(Filename.c_str());
+      return false;
+   }
+   return true;
+}
+
+// Delete one segment's files and its directory
+static bool RemoveSegment(const string Dirname)
+{
+const char *Files[] = {"postings", "trie", "map"};
+
+   for (int f = 0; f < 3; f++)
+      unlink((Dirname + "/" + Files[f]).c_str());
+   return rmdir(Dirname.c_str()) == 0;
+}
+
+/* Name:  ReadHeader
+ * Parameters:  Dirname: a segment
+ *              FirstDocId: receives its first document
+ *              NumDocs: receives how many it holds
+ * Purpose:     read the header of the segment's postings
+ * Returns:     false if it is missing or not a segment
+*/
+static bool ReadHeader(const string Dirname, int &FirstDocId, int &NumDocs)
+{
+ifstream Postings((Dirname + "/postings").c_str(), ios::binary);
+char Header[SEGMENT_HEADER_LENGTH];
+
+   if (!Postings.read(Header, SEGMENT_HEADER_LENGTH) || memcmp(Header, SEGMENT_MAGIC, SEGMENT_MAGIC_LENGTH) != 0)
+      return false;
+   FirstDocId = GetRaw<int>(Header + SEGMENT_MAGIC_LENGTH);
+   NumDocs = GetRaw<int>(Header + SEGMENT_MAGIC_LENGTH + 4);
+   return true;
+}
+
+// Delete what a run that stopped left beside the manifest: segments not
+// yet named in it, ones merged away but not deleted, and hidden ones
+static void RemoveUnlisted(const string Dirname, const vector<string> &Names)
+{
+DIR *Dir = opendir(Dirname.c_str());
+struct dirent *Entry;
+
+   if (Dir == NULL)
+      return;
+   while ((Entry = readdir(Dir)) != NULL)
+   {
+      string Name = Entry->d_name;
+      if (Name != "." && Name != ".." && Name != "manifest" &&
+          find(Names.begin(), Names.end(), Name) == Names.end())
+         if (unlink((Dirname + "/" + Name).c_str()) != 0)   // manifest.new, or else a segment
+            RemoveSegment(Dirname + "/" + Name);
+   }
+   closedir(Dir);
+}
+
+/*-------------------------- SegmentWriter --------------------------------*/
+
+SegmentWriter::SegmentWriter(RateLimiter *Limiter)
+{
+   limiter = Limiter;
+   firstdocid = 0;
+   fd = -1;
+   out = NULL;
+   offset = 0;
+}
+
+SegmentWriter::~SegmentWriter()
+{
+   Abandon();
+}
+
+/* Name:  Start
+ * Parameters:  Dirname: the segment to write
+ *              FirstDocId: its first document
+ *              NumDocs: how many it holds
+ * Purpose:     make the segment under a hidden name beside Dirname and
+ *              write the postings header
+ * Returns:     false if it could not be made
+*/
+bool SegmentWriter::Start(const string Dirname, const int FirstDocId, const int NumDocs)
+{
+unsigned long Slash = Dirname.rfind('/');
+char Header[SEGMENT_HEADER_LENGTH];
+
+   Abandon();
+   dirname = Dirname;
+   hidden = (Slash == string::npos ? "." + Dirname
+                                   : Dirname.substr(0, Slash + 1) + "." + Dirname.substr(Slash + 1));
+   if (mkdir(hidden.c_str(), 0755) != 0 ||
+       (fd = open((hidden + "/postings").c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644)) < 0)
+   {
+      perror(hidden.c_str());
+      rmdir(hidden.c_str());
+      hidden.clear();
+      return false;
+   }
+   out = new OutputWriter(fd);
+   memcpy(Header, SEGMENT_MAGIC, SEGMENT_MAGIC_LENGTH);
+   memcpy(Header + SEGMENT_MAGIC_LENGTH, &FirstDocId, 4);
+   memcpy(Header + SEGMENT_MAGIC_LENGTH + 4, &NumDocs, 4);
+   out->Put(string_view(Header, SEGMENT_HEADER_LENGTH));
+   offset = SEGMENT_HEADER_LENGTH;
+   firstdocid = FirstDocId;
+   terms.clear();
+   entries.clear();
+   return true;
+}
+
+/* Name:  Add
+ * Parameters:  Term: the next term, after every one added before
+ *              DocIds: its DocIds, increasing, from the first DocId on
+ *              RTFs: their relative term frequencies
+ * Purpose:     write the term's list and note its trie entry
+ * Returns:     nothing
+*/
+void SegmentWriter::Add(const string_view Term, const vector<int> &DocIds, const vector<float> &RTFs)
+{
+   if (out == NULL)
+      return;
+   list.assign((const char *) RTFs.data(), (const char *) (RTFs.data() + RTFs.size()));
+   PostingCodec::Encode(CODEC_VBYTE, DocIds.data(), DocIds.size(), firstdocid - 1, list);
+   terms.push_back(string(Term));
+   entries.push_back(TrieEntry{(int) DocIds.size(), offset});
+   if (limiter != NULL)
+      limiter->Take(list.size());
+   out->Put(string_view(list.data(), list.size()));
+   offset += list.size();
+}
+
+/* Name:  Finish
+ * Parameters:  Filenames: the segment's documents' filenames, in order
+ * Purpose:     finish the postings, write the trie and map, and rename
+ *              the segment into place
+ * Returns:     false if a file could not be written
+*/
+bool SegmentWriter::Finish(const vector<string> &Filenames)
+{
+vector<string_view> Terms(terms.begin(), terms.end());
+TermTrie Trie;
+bool Written;
+
+   if (out == NULL)
+      return false;
+   Written = out->Flush();
+   delete out;
+   out = NULL;
+   Written = (close(fd) == 0) && Written;
+   fd = -1;
+
+   Trie.Build(Terms, entries);
+   Written = Written && Trie.Write(hidden + "/trie");
+   ofstream Map((hidden + "/map").c_str());
+   for (unsigned long d = 0; d < Filenames.size(); d++)
+      Map << Filenames[d] << '\n';
+   Map.close();
+   Written = Written && !Map.fail();
+
+   if (!Written || rename(hidden.c_str(), dirname.c_str()) != 0)
+   {
+      perror(dirname.c_str());
+      Abandon();
+      return false;
+   }
+   hidden.clear();
+   return true;
+}
+
+// Delete a segment that was started but not finished
+void SegmentWriter::Abandon()
+{
+   if (out != NULL)
+   {
+      delete out;
+      out = NULL;
+   }
+   if (fd >= 0)
+   {
+      close(fd);
+      fd = -1;
+   }
+   if (!hidden.empty())
+   {
+      RemoveSegment(hidden);
+      hidden.clear();
+   }
+}
+
+/*-------------------------- Segment --------------------------------------*/
+
+Segment::Segment()
+{
+   data = NULL;
+   length = 0;
+   firstdocid = 0;
+   numdocs = 0;
+}
+
+Segment::~Segment()
+{
+   if (data != NULL)
+      munmap(data, length);
+}
+
+/* Name:  Open
+ * Parameters:  Dirname: a segment directory
+ * Purpose:     read its trie and map and map its postings
+ * Returns:     false if it is missing or not a segment
+*/
+bool Segment::Open(const string Dirname)
+{
+ifstream Map((Dirname + "/map").c_str());
+string Filename;
+struct stat Info;
+void *Region;
+int Fd;
+
+   if (!Map.is_open() || !trie.Read(Dirname + "/trie"))
+      return false;
+   if ((Fd = open((Dirname + "/postings").c_str(), O_RDONLY)) < 0)
+      return false;
+   if (fstat(Fd, &Info) != 0 || Info.st_size < SEGMENT_HEADER_LENGTH ||
+       (Region = mmap(NULL, Info.st_size, PROT_READ, MAP_SHARED, Fd, 0)) == MAP_FAILED)
+   {
+      close(Fd);
+      return false;
+   }
+   close(Fd);
+
+   data = (char *) Region;
+   length = Info.st_size;
+   if (memcmp(data, SEGMENT_MAGIC, SEGMENT_MAGIC_LENGTH) != 0)
+   {
+      munmap(data, length);
+      data = NULL;
+      return false;
+   }
+   firstdocid = GetRaw<int>(data + SEGMENT_MAGIC_LENGTH);
+   numdocs = GetRaw<int>(data + SEGMENT_MAGIC_LENGTH + 4);
+   while (getline(Map, Filename))
+      filenames.push_back(Filename);
+   return true;
+}
+
+const TermTrie &Segment::GetTrie() const
+{
+   return trie;
+}
+
+/* Name:  GetPostings
+ * Parameters:  Entry: a term's entry in the segment's trie
+ *              DocIds: receives its DocIds, in order
+ *              RTFs: receives their relative term frequencies
+ * Purpose:     decode a term's list
+ * Returns:     the bytes of the list
+*/
+unsigned long Segment::GetPostings(const TrieEntry &Entry, vector<int> &DocIds, vector<float> &RTFs) const
+{
+   DocIds.clear();
+   RTFs.clear();
+   if (data == NULL || Entry.numdocs <= 0 || Entry.start + 4ul * Entry.numdocs > length)
+      return 0;
+   DocIds.resize(Entry.numdocs);
+   RTFs.resize(Entry.numdocs);
+   memcpy(RTFs.data(), data + Entry.start, 4ul * Entry.numdocs);
+   return PostingCodec::Decode(CODEC_VBYTE, data + Entry.start + 4ul * Entry.numdocs, Entry.numdocs,
+                               firstdocid - 1, DocIds.data()) - (data + Entry.start);
+}
+
+int Segment::GetFirstDocId() const
+{
+   return firstdocid;
+}
+
+int Segment::GetNumDocs() const
+{
+   return numdocs;
+}
+
+string Segment::GetFilename(const int DocId) const
+{
+   if (DocId < firstdocid || DocId - firstdocid >= (int) filenames.size())
+      return "";
+   return filenames[DocId - firstdocid];
+}
+
+/* Name:  List
+ * Parameters:  Dirname: a directory of segments
+ *              Names: receives the live segments' names, in DocId order
+ * Purpose:     read the manifest
+ * Returns:     nothing
+*/
+void Segment::List(const string Dirname, vector<string> &Names)
+{
+ifstream Manifest((Dirname + "/manifest").c_str());
+string Name;
+
+   Names.clear();
+   while (getline(Manifest, Name))
+      if (!Name.empty())
+         Names.push_back(Name);
+}
+
+/* Name:  GetTier
+ * Parameters:  NumDocs: a segment's documents
+ * Purpose:     find the segment's tier: 0 up to SEGMENT_TIER_BASE
+ *              documents, and one more for each SEGMENT_TIER_FACTOR
+ *              times as many
+ * Returns:     the tier
+*/
+int Segment::GetTier(const int NumDocs)
+{
+long Most = SEGMENT_TIER_BASE;
+int Tier = 0;
+
+   for (; NumDocs > Most; Most *= SEGMENT_TIER_FACTOR)
+      Tier++;
+   return Tier;
+}
+
+/* Name:  Remove
+ * Parameters:  Dirname: a directory of segments
+ * Purpose:     delete the manifest and every segment, finished or not,
+ *              and the directory
+ * Returns:     false if something could not be deleted
+*/
+bool Segment::Remove(const string Dirname)
+{
+DIR *Dir = opendir(Dirname.c_str());
+struct dirent *Entry;
+bool Removed = true;
+
+   if (Dir == NULL)
+      return true;
+   while ((Entry = readdir(Dir)) != NULL)
+   {
+      string Name = Entry->d_name;
+      if (Name == "." || Name == "..")
+         continue;
+      if (unlink((Dirname + "/" + Name).c_str()) != 0)   // the manifest, or else a segment
+         Removed = RemoveSegment(Dirname + "/" + Name) && Removed;
+   }
+   closedir(Dir);
+   return (rmdir(Dirname.c_str()) == 0) && Removed;
+}
+
+/*-------------------------- MemorySegment --------------------------------*/
+
+/* Name:  MemorySegment
+ * Parameters:  Dirname: where the segments are flushed
+ *              MaxSeconds: the longest a document waits to be frozen
+ * Purpose:     an empty segment, the directory for the flushed ones, so
+ *              a query engine can open it before the first, and the
+ *              thread that writes them.  If the directory has a
+ *              manifest, the segments it names are carried on from:
+ *              new ones are added after them, and merged with them.
+ * Returns:     nothing
+*/
+MemorySegment::MemorySegment(const string Dirname, const int MaxSeconds)
+   : dirname(Dirname)
+{
+int FirstDocId;
+
+   maxseconds = MaxSeconds;
+   parts.push_back(new Part);
+   parts.back()->firstdocid = 0;
+   generation = 0;
+   flushes = 0;
+   flushseconds = 0.0;
+   failed = false;
+   lastname = 0;
+   limiter = NULL;
+   stopping = false;
+   draining = false;
+   merges = 0;
+   mergeseconds = 0.0;
+   lastdocid = 0;
+   mkdir(dirname.c_str(), 0755);
+   Segment::List(dirname, manifest);
+   sizes.assign(manifest.size(), 0);
+   for (unsigned long n = 0; n < manifest.size(); n++)
+   {
+      if (!ReadHeader(dirname + "/" + manifest[n], FirstDocId, sizes[n]))
+         cerr << "Unable to read the segment " << dirname << "/" << manifest[n] << endl;
+      else
+         lastdocid = max(lastdocid, FirstDocId + sizes[n] - 1);
+      lastname = max(lastname, atoi(manifest[n].c_str()));
+   }
+   RemoveUnlisted(dirname, manifest);
+   flusher = thread(&MemorySegment::RunFlushes, this);
+}
+
+MemorySegment::~MemorySegment()
+{
+   Stop();
+   for (unsigned long p = 0; p < parts.size(); p++)
+      delete parts[p];
+   delete limiter;
+}
+
+/* Name:  Add
+ * Parameters:  DocId: the next document
+ *              Filename: its name in the map
+ *              Terms: the words posted for it
+ *              RTFs: their relative term frequencies
+ * Purpose:     add a document, searchable as soon as this returns, then
+ *              freeze the growing part for the flush thread if it holds
+ *              SEGMENT_MAX_DOCS documents or its first came MaxSeconds
+ *              ago.  A term already in the part is found by its view,
+ *              and a new one is copied once, into the part's terms.
+ * Returns:     nothing
+*/
+void MemorySegment::Add(const int DocId, const string &Filename, const vector<string_view> &Terms,
+                        const vector<float> &RTFs)
+{
+lock_guard<mutex> Lock(lock);
+Part *Growing = parts.back();
+
+   if (Growing->filenames.empty())
+   {
+      Growing->firstdocid = DocId;
+      started = chrono::steady_clock::now();
+   }
+   while (Growing->firstdocid + (int) Growing->filenames.size() < DocId)
+      Growing->filenames.push_back("");   // never expected, but keeps the DocIds in line
+   Growing->filenames.push_back(Filename);
+   for (unsigned long t = 0; t < Terms.size(); t++)
+   {
+      unordered_map<string_view, int>::iterator Found = Growing->lists.find(Terms[t]);
+      if (Found == Growing->lists.end())
+      {
+         Growing->terms.emplace_back(Terms[t]);
+         Found = Growing->lists.emplace(Growing->terms.back(), (int) Growing->docids.size()).first;
+         Growing->docids.push_back(vector<int>());
+         Growing->rtfs.push_back(vector<float>());
+      }
+      Growing->docids[Found->second].push_back(DocId);
+      Growing->rtfs[Found->second].push_back(RTFs[t]);
+   }
+   if ((int) Growing->filenames.size() >= SEGMENT_MAX_DOCS || SecondsSince(started) >= maxseconds)
+      Freeze();
+}
+
+/* Name:  Flush
+ * Parameters:  none
+ * Purpose:     freeze the documents so far and wait until the flush
+ *              thread has written every frozen part, or has failed to
+ * Returns:     false if a part could not be written; it is kept, and
+ *              tried again
+*/
+bool MemorySegment::Flush()
+{
+unique_lock<mutex> Lock(lock);
+
+   if (stopping)
+      return false;
+   Freeze();
+   failed = false;
+   flushed.wait(Lock, [this]() { return parts.size() == 1 || failed || stopping.load(); });
+   return parts.size() == 1;
+}
+
+/* Name:  StartCompaction
+ * Parameters:  BytesPerSecond: the most the merges may read and write
+ *                              a second, or 0 for no limit
+ * Purpose:     start the thread that merges the segments, looking at
+ *              the manifest every SEGMENT_COMPACT_MS
+ * Returns:     nothing
+*/
+void MemorySegment::StartCompaction(const unsigned long BytesPerSecond)
+{
+   if (limiter != NULL)
+      return;
+   limiter = new RateLimiter(BytesPerSecond);
+   compactor = thread(&MemorySegment::RunCompaction, this);
+}
+
+/* Name:  Compact
+ * Parameters:  none
+ * Purpose:     find the oldest SEGMENT_TIER_FACTOR neighbouring
+ *              segments of one tier and merge them.  The merge reads
+ *              and writes outside both locks, so flushes and readers
+ *              go on meanwhile; flushes only add to the end of the
+ *              manifest, so the neighbours are still together when the
+ *              merged segment replaces them.  The old segments are
+ *              deleted once the manifest no longer names them; a
+ *              reader that has them open can still read them.
+ * Returns:     false if there was nothing to merge or the merge failed
+*/
+bool MemorySegment::Compact()
+{
+chrono::steady_clock::time_point Start = chrono::steady_clock::now();
+vector<string> Names;
+vector<int> Sizes;
+vector<Segment*> Inputs;
+unsigned long First = 0;
+unsigned long Run = 0;
+int NumDocs = 0;
+char Name[32];
+bool Merged = true;
+
+   {
+   lock_guard<mutex> Lock(manifestlock);
+   Names = manifest;
+   Sizes = sizes;
+   }
+   for (unsigned long n = 0; n < Names.size() && Run < SEGMENT_TIER_FACTOR; n++)
+      if (Run > 0 && Segment::GetTier(Sizes[n]) == Segment::GetTier(Sizes[First]))
+         Run++;
+      else
+      {
+         First = n;
+         Run = 1;
+      }
+   if (Run < SEGMENT_TIER_FACTOR)
+      return false;
+
+   for (unsigned long r = 0; r < Run && Merged; r++)
+   {
+      Inputs.push_back(new Segment);
+      Merged = Inputs.back()->Open(dirname + "/" + Names[First + r]);
+      NumDocs += Sizes[First + r];
+   }
+   if (Merged)
+   {
+      lock_guard<mutex> Lock(manifestlock);
+      snprintf(Name, sizeof(Name), "%0*d", SEGMENT_NAME_DIGITS, ++lastname);
+   }
+   Merged = Merged && MergeSegments(Inputs, dirname + "/" + Name, limiter, stopping);
+   for (unsigned long r = 0; r < Inputs.size(); r++)
+      delete Inputs[r];
+   if (!Merged)
+      return false;
+
+   {
+   lock_guard<mutex> Lock(manifestlock);
+   unsigned long Place = find(manifest.begin(), manifest.end(), Names[First]) - manifest.begin();
+   manifest.erase(manifest.begin() + Place, manifest.begin() + Place + Run);
+   manifest.insert(manifest.begin() + Place, Name);
+   sizes.erase(sizes.begin() + Place, sizes.begin() + Place + Run);
+   sizes.insert(sizes.begin() + Place, NumDocs);
+   Merged = WriteManifest(dirname, manifest);
+   }
+   {
+   lock_guard<mutex> Lock(lock);
+   generation++;
+   }
+   if (Merged)
+      for (unsigned long r = 0; r < Run; r++)
+         RemoveSegment(dirname + "/" + Names[First + r]);
+   merges++;
+   mergeseconds += SecondsSince(Start);
+   return Merged;
+}
+
+/* Name:  Finish
+ * Parameters:  none
+ * Purpose:     flush what is left in memory, let the compaction
+ *              thread make the merges that are then due, so a run
+ *              shorter than its look at the manifest leaves no full
+ *              tier behind, stop flushing, then print how many segments
+ *              were flushed and merged and the time it took
+ * Returns:     false if the last documents could not be written
+*/
+bool MemorySegment::Finish()
+{
+unsigned long Left;
+bool Flushed = Flush();
+
+   {
+   lock_guard<mutex> Lock(waiting);
+   draining = true;
+   }
+   wake.notify_all();
+   if (compactor.joinable())
+      compactor.join();
+   Stop();
+   {
+   lock_guard<mutex> Lock(manifestlock);
+   Left = manifest.size();
+   }
+   cout << "Segments flushed: " << flushes << " in " << fixed << setprecision(3)
+        << flushseconds << " s" << endl;
+   if (limiter != NULL)
+      cout << "Segments merged: " << merges << " in " << mergeseconds << " s, "
+           << setprecision(1) << limiter->GetBytes() / 1048576.0 << " MB read and written, "
+           << setprecision(3) << limiter->GetWaited() << " s held back; "
+           << Left << " segments left" << endl;
+   return Flushed;
+}
+
+/* Name:  Find
+ * Parameters:  Term: a term, exactly as it was indexed
+ *              DocIds: receives its DocIds in the segment, in order
+ *              RTFs: receives their relative term frequencies
+ *              Generation: receives the manifest's changes so far, so
+ *                          a reader knows when to look at it again
+ *              FirstDocId: receives the first document held in memory;
+ *                          a segment flushed meanwhile repeats those
+ *                          from it on
+ * Purpose:     copy a term's postings in the frozen parts and the
+ *              growing one out from under the lock
+ * Returns:     false if no part has the term
+*/
+bool MemorySegment::Find(const string_view Term, vector<int> &DocIds, vector<float> &RTFs,
+                         int &Generation, int &FirstDocId) const
+{
+lock_guard<mutex> Lock(lock);
+unordered_map<string_view, int>::const_iterator Found;
+
+   Generation = generation;
+   FirstDocId = (parts[0]->filenames.empty() ? INT_MAX : parts[0]->firstdocid);
+   DocIds.clear();
+   RTFs.clear();
+   for (unsigned long p = 0; p < parts.size(); p++)
+      if ((Found = parts[p]->lists.find(Term)) != parts[p]->lists.end())
+      {
+         DocIds.insert(DocIds.end(), parts[p]->docids[Found->second].begin(), parts[p]->docids[Found->second].end());
+         RTFs.insert(RTFs.end(), parts[p]->rtfs[Found->second].begin(), parts[p]->rtfs[Found->second].end());
+      }
+   return !DocIds.empty();
+}
+
+int MemorySegment::GetGeneration() const
+{
+lock_guard<mutex> Lock(lock);
+
+   return generation;
+}
+
+// The last document flushed, or the last in the manifest it was opened with
+int MemorySegment::GetLastDocId() const
+{
+lock_guard<mutex> Lock(lock);
+
+   return lastdocid;
+}
+
+int MemorySegment::GetFirstDocId() const
+{
+lock_guard<mutex> Lock(lock);
+
+   return parts[0]->firstdocid;
+}
+
+// The documents held in memory, from the first DocId to the last
+int MemorySegment::GetNumDocs() const
+{
+lock_guard<mutex> Lock(lock);
+const Part *Last = parts.back();
+
+   if (Last->filenames.empty() && parts.size() > 1)
+      Last = parts[parts.size() - 2];
+   if (Last->filenames.empty())
+      return 0;
+   return Last->firstdocid + Last->filenames.size() - parts[0]->firstdocid;
+}
+
+int MemorySegment::GetNumDocs(const string_view Term) const
+{
+lock_guard<mutex> Lock(lock);
+unordered_map<string_view, int>::const_iterator Found;
+int Count = 0;
+
+   for (unsigned long p = 0; p < parts.size(); p++)
+      if ((Found = parts[p]->lists.find(Term)) != parts[p]->lists.end())
+         Count += parts[p]->docids[Found->second].size();
+   return Count;
+}
+
+string MemorySegment::GetFilename(const int DocId) const
+{
+lock_guard<mutex> Lock(lock);
+
+   for (unsigned long p = 0; p < parts.size(); p++)
+      if (DocId >= parts[p]->firstdocid && DocId - parts[p]->firstdocid < (int) parts[p]->filenames.size())
+         return parts[p]->filenames[DocId - parts[p]->firstdocid];
+   return "";
+}
+
+/*-------------------------- Private Functions ----------------------------*/
+
+/* Name:  Freeze
+ * Parameters:  none
+ * Purpose:     with the lock held, hand the growing part, if it has
+ *              documents, to the flush thread and start an empty one
+ * Returns:     nothing
+*/
+void MemorySegment::Freeze()
+{
+   if (parts.back()->filenames.empty())
+      return;
+   parts.push_back(new Part);
+   parts.back()->firstdocid = 0;
+   due.notify_one();
+}
+
+/* Name:  AddToManifest
+ * Parameters:  Name: a segment just flushed
+ *              NumDocs: its documents
+ * Purpose:     add the segment to the end of the manifest
+ * Returns:     false if the manifest could not be written; it is left
+ *              as it was
+*/
+bool MemorySegment::AddToManifest(const string Name, const int NumDocs)
+{
+lock_guard<mutex> Lock(manifestlock);
+
+   manifest.push_back(Name);
+   sizes.push_back(NumDocs);
+   if (WriteManifest(dirname, manifest))
+      return true;
+   manifest.pop_back();
+   sizes.pop_back();
+   return false;
+}
+
+// Stop the flush and compaction threads, letting a merge under way be given up
+void MemorySegment::Stop()
+{
+   {
+   lock_guard<mutex> Lock(waiting);
+   stopping = true;
+   }
+   {
+   lock_guard<mutex> Lock(lock);   // so the flush thread is waiting or sees it
+   }
+   wake.notify_all();
+   due.notify_all();
+   flushed.notify_all();
+   if (flusher.joinable())
+      flusher.join();
+   if (compactor.joinable())
+      compactor.join();
+}
+
+/* Name:  RunFlushes
+ * Parameters:  none
+ * Purpose:     the flush thread: write the oldest frozen part as the
+ *              next segment, outside the lock so the inverter and the
+ *              readers go on, then add it to the manifest.  Only then is
+ *              the generation bumped and the part dropped, together, so
+ *              a reader finds the documents in memory until it can find
+ *              them on disk.  A part that fails is kept and tried again
+ *              after SEGMENT_RETRY_MS.
+ * Returns:     nothing
+*/
+void MemorySegment::RunFlushes()
+{
+unique_lock<mutex> Lock(lock);
+chrono::steady_clock::time_point Start;
+Part *Frozen;
+char Name[32];
+bool Written;
+
+   while (true)
+   {
+      due.wait(Lock, [this]() { return stopping.load() || parts.size() > 1; });
+      if (stopping)
+         return;
+      Frozen = parts[0];
+      Lock.unlock();
+
+      Start = chrono::steady_clock::now();
+      {
+      lock_guard<mutex> Names(manifestlock);
+      snprintf(Name, sizeof(Name), "%0*d", SEGMENT_NAME_DIGITS, ++lastname);
+      }
+      Written = WriteSegment(dirname + "/" + Name, Frozen->firstdocid, Frozen->filenames, Frozen->terms,
+                             Frozen->docids, Frozen->rtfs);
+      if (Written && !AddToManifest(Name, Frozen->filenames.size()))
+      {
+         RemoveSegment(dirname + "/" + Name);
+         Written = false;
+      }
+
+      Lock.lock();
+      if (Written)
+      {
+         generation++;
+         flushes++;
+         lastdocid = Frozen->firstdocid + Frozen->filenames.size() - 1;
+         parts.erase(parts.begin());
+         delete Frozen;
+      }
+      failed = !Written;
+      flushseconds += SecondsSince(Start);
+      flushed.notify_all();
+      if (!Written)
+         due.wait_for(Lock, chrono::milliseconds(SEGMENT_RETRY_MS), [this]() { return stopping.load(); });
+   }
+}
+
+// The compaction thread: merge while a tier is full, every SEGMENT_COMPACT_MS,
+// and once more when told to drain
+void MemorySegment::RunCompaction()
+{
+unique_lock<mutex> Lock(waiting);
+bool Draining = false;
+
+   while (!stopping && !Draining)
+   {
+      Draining = wake.wait_for(Lock, chrono::milliseconds(SEGMENT_COMPACT_MS),
+                               [this]() { return stopping.load() || draining; }) && !stopping;
+      Lock.unlock();
+      while (!stopping && Compact())
+         ;
+      Lock.lock();
+   }
+}
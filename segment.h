@@ -0,0 +1,188 @@
+/* Filename:  segment.h
+ * Date:      10/19/26
+ * Purpose:   The header file for segments.  When invert runs with
+ *            --segments, the index is a log of segments rather than one
+ *            dict and post: the inverter gives each document's
+ *            postings to a MemorySegment, which a query
+ *            engine in the same process can search at once.  Every so
+ *            many seconds (or SEGMENT_MAX_DOCS documents) the documents
+ *            so far are frozen and a fresh part started; a flush thread
+ *            writes the frozen part to an immutable on-disk Segment in
+ *            <outdir>/segments, which a query engine in any process
+ *            picks up with Refresh, so a document is searchable within
+ *            seconds of being read rather than once the whole index is
+ *            printed.  A frozen part stays searchable in memory until
+ *            the manifest names its segment, and one that cannot be
+ *            written is kept and tried again every SEGMENT_RETRY_MS, so
+ *            the inverter never waits on the disk.  Finish flushes the
+ *            last documents, and the segments are left as the index;
+ *            invert --append opens a MemorySegment on the same
+ *            manifest and adds the new documents after them.
+ *            A segment keeps relative term frequencies rather than
+ *            weights; the IDF is worked out when it is searched, from
+ *            everything searched with it.
+ *            The segments are a log: the manifest names the live ones,
+ *            in DocId order, and is replaced whole (written beside it
+ *            and renamed), so a reader sees every document exactly
+ *            once.  A flush adds a segment to the end; a background
+ *            thread merges SEGMENT_TIER_FACTOR neighbouring segments
+ *            of the same tier (a tier's segments hold up to
+ *            SEGMENT_TIER_FACTOR times the documents of the tier
+ *            below, from SEGMENT_TIER_BASE) into one of the next,
+ *            so a reader never has more than a few segments per tier
+ *            to search.  The merge's reads and writes go through a
+ *            RateLimiter, so compaction cannot take the disk from the
+ *            queries.
+ *
+ *            A segment is a directory, written under a hidden name and
+ *            renamed into place, so a reader never sees half of one:
+ *            map       its documents' filenames, from its first DocId
+ *            trie      a term trie (see termtrie.h) whose entries give
+ *                      each term's numdocs and the offset of its list
+ *            postings  "SEGMENT1", first DocId (4), numdocs (4),
+ *                      then per term its rtfs (4-byte floats) and its
+ *                      DocIds as varint gaps
+*/
+
+#ifndef SEGMENT_H
+#define SEGMENT_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "outputwriter.h"
+#include "ratelimiter.h"
+#include "termtrie.h"
+
+#define SEGMENT_MAGIC "SEGMENT1"
+#define SEGMENT_MAGIC_LENGTH 8
+#define SEGMENT_HEADER_LENGTH 16
+#define SEGMENT_MAX_DOCS 50000     // a memory segment is flushed at this size
+#define SEGMENT_NAME_DIGITS 6      // segments are numbered 000001, 000002, ...
+#define SEGMENT_TIER_FACTOR 4      // segments merged at once, and the growth from tier to tier
+#define SEGMENT_TIER_BASE 1000     // the most documents in a segment of tier 0
+#define SEGMENT_COMPACT_MS 500     // between the compaction thread's looks at the manifest
+#define SEGMENT_COMPACT_MB 16      // MB a second compaction may read and write, unless told
+#define SEGMENT_OPEN_TRIES 3       // manifest reads when a merge removes a segment meanwhile
+#define SEGMENT_RETRY_MS 1000      // between tries at writing a part that failed
+
+using namespace std;
+
+class Segment {
+public:
+   Segment();
+   ~Segment();
+   bool Open (const string Dirname);
+   const TermTrie &GetTrie () const;
+   unsigned long GetPostings (const TrieEntry &Entry, vector<int> &DocIds,
+                              vector<float> &RTFs) const;   // returns the bytes read
+   int GetFirstDocId () const;
+   int GetNumDocs () const;
+   string GetFilename (const int DocId) const;
+   static void List (const string Dirname, vector<string> &Names);   // from the manifest, in order
+   static int GetTier (const int NumDocs);
+   static bool Remove (const string Dirname);   // every segment, and the directory
+private:
+   Segment (const Segment& s);
+   TermTrie trie;
+   char *data;                      // postings, mapped
+   unsigned long length;
+   vector<string> filenames;
+   int firstdocid;
+   int numdocs;
+};
+
+class SegmentWriter {  // writes a segment a term at a time, in term order
+public:
+   SegmentWriter(RateLimiter *Limiter);   // Limiter NULL for none
+   ~SegmentWriter();                // abandons a segment not finished
+   bool Start (const string Dirname, const int FirstDocId, const int NumDocs);
+   void Add (const string_view Term, const vector<int> &DocIds, const vector<float> &RTFs);
+   bool Finish (const vector<string> &Filenames);   // renames it into place
+private:
+   SegmentWriter (const SegmentWriter& sw);
+   void Abandon ();
+   RateLimiter *limiter;
+   string dirname;
+   string hidden;                   // where it is written
+   int firstdocid;
+   int fd;
+   OutputWriter *out;
+   vector<string> terms;
+   vector<TrieEntry> entries;
+   vector<char> list;
+   unsigned long offset;
+};
+
+class MemorySegment {
+public:
+   MemorySegment(const string Dirname, const int MaxSeconds);
+   ~MemorySegment();                // stops flushing and compaction; what is
+                                    //    not flushed is dropped
+   void Add (const int DocId, const string &Filename, const vector<string_view> &Terms,
+             const vector<float> &RTFs);   // freezes the documents when they are due
+   bool Flush ();                   // freeze them now and wait until written
+   void StartCompaction (const unsigned long BytesPerSecond);   // 0 for no limit
+   bool Compact ();                 // one merge, if a tier is full
+   bool Finish ();                  // flush the rest, merge what is due,
+                                    //    stop, and print what was done
+   bool Find (const string_view Term, vector<int> &DocIds, vector<float> &RTFs,
+              int &Generation, int &FirstDocId) const;
+   int GetGeneration () const;      // the manifest's changes so far
+   int GetLastDocId () const;       // the last document flushed
+   int GetFirstDocId () const;
+   int GetNumDocs () const;
+   int GetNumDocs (const string_view Term) const;   // its document frequency
+   string GetFilename (const int DocId) const;
+private:
+   MemorySegment (const MemorySegment& ms);
+   struct Part  // documents not yet in a segment: the growing ones, or frozen
+   {
+      unordered_map<string_view, int> lists;   // a term, in terms, to its place below
+      deque<string> terms;          // never moved, so lists can point into them
+      vector< vector<int> > docids;
+      vector< vector<float> > rtfs;
+      vector<string> filenames;
+      int firstdocid;
+   };
+   void Freeze ();
+   bool AddToManifest (const string Name, const int NumDocs);
+   void Stop ();
+   void RunFlushes ();
+   void RunCompaction ();
+   mutable mutex lock;              // the parts against the readers
+   string dirname;
+   int maxseconds;
+   vector<Part*> parts;             // frozen ones, oldest first, then the growing one
+   chrono::steady_clock::time_point started;   // when the growing part's first document came
+   int generation;
+   int lastdocid;                   // the last document in the manifest
+   int flushes;
+   double flushseconds;             // spent writing parts
+   bool failed;                     // the last write of a part
+   thread flusher;
+   condition_variable due;          // a part is frozen, or stopping
+   condition_variable flushed;      // a write is done
+   mutex manifestlock;              // flushes and merges, against each other
+   vector<string> manifest;         // the live segments, in DocId order
+   vector<int> sizes;               // and their documents
+   int lastname;                    // the number of the newest segment
+   RateLimiter *limiter;            // for compaction, once started
+   thread compactor;
+   mutex waiting;
+   condition_variable wake;
+   atomic<bool> stopping;
+   bool draining;                   // merge what is due, then stop
+   int merges;
+   double mergeseconds;             // spent merging, sleeps included
+};
+
+#endif
@@ -0,0 +1,316 @@
+/* Filename:  sorteddict.cpp
+ * Date:      10/19/2026
+ * Purpose:   The implementation file for the sorted, front-coded
+ *            dictionary writer and reader.
+*/
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+
+#include "sorteddict.h"
+
+using namespace std;
+
+/*-------------------------- SortedDictWriter -----------------------------*/
+
+/* Name:  SortedDictWriter
+ * Parameters:  Filename: the dictionary file to create
+ * Purpose:     start a sorted dictionary
+ * Returns:     nothing
+*/
+SortedDictWriter::SortedDictWriter(const string Filename)
+{
+   out = NULL;
+   if ((fd = open(Filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644)) < 0)
+      perror(Filename.c_str());
+   else
+   {
+      out = new OutputWriter(fd);
+      out->Put(string_view(SDICT_MAGIC, SDICT_MAGIC_LENGTH));
+   }
+   offset = SDICT_MAGIC_LENGTH;
+   start = 0;
+   numterms = 0;
+}
+
+/* Name:  ~SortedDictWriter
+ * Parameters:  none
+ * Purpose:     finish the file if Close has not been called
+ * Returns:     nothing
+*/
+SortedDictWriter::~SortedDictWriter()
+{
+   Close();
+}
+
+/* Name:  Add
+ * Parameters:  Term: the next term, greater than every term before it
+ *              NumDocs: the term's document count (its lines in post)
+ * Purpose:     append a term, front-coded against the one before it
+ * Returns:     nothing
+*/
+void SortedDictWriter::Add(const string_view Term, const int NumDocs)
+{
+unsigned long Shared = 0;
+
+   if (out == NULL)
+      return;
+
+   // every block begins with a whole term and its first line in post
+   if (numterms % SDICT_BLOCK_TERMS == 0)
+   {
+      blockoffsets.push_back(offset);
+      PutVarint(start);
+      previous.clear();
+   }
+
+   while (Shared < previous.length() && Shared < Term.length() &&
+          previous[Shared] == Term[Shared])
+      Shared++;
+   PutVarint(Shared);
+   PutVarint(Term.length() - Shared);
+   out->Put(Term.substr(Shared));
+   offset += Term.length() - Shared;
+   PutVarint(NumDocs);
+
+   previous = Term;
+   start += NumDocs;
+   numterms++;
+}
+
+/* Name:  Close
+ * Parameters:  none
+ * Purpose:     write the block offsets and the trailer, and close the file
+ * Returns:     false if the file could not be written
+*/
+bool SortedDictWriter::Close()
+{
+unsigned long TableOffset = offset;
+unsigned int NumBlocks = blockoffsets.size();
+bool Written;
+
+   if (out == NULL)
+      return false;
+
+   for (unsigned long i = 0; i < blockoffsets.size(); i++)
+      out->Put(string_view((const char *) &blockoffsets[i], sizeof(unsigned long)));
+   out->Put(string_view((const char *) &TableOffset, sizeof(unsigned long)));
+   out->Put(string_view((const char *) &numterms, sizeof(unsigned int)));
+   out->Put(string_view((const char *) &NumBlocks, sizeof(unsigned int)));
+
+   Written = out->Flush();
+   delete out;
+   out = NULL;
+   close(fd);
+   return Written;
+}
+
+// Write Value 7 bits at a time, low bits first; the high bit means more
+void SortedDictWriter::PutVarint(unsigned long Value)
+{
+   while (Value >= 0x80)
+   {
+      out->Put((char) (Value | 0x80));
+      Value >>= 7;
+      offset++;
+   }
+   out->Put((char) Value);
+   offset++;
+}
+
+/*-------------------------- SortedDict -----------------------------------*/
+
+/* Name:  SortedDict
+ * Parameters:  Filename: a dictionary made by SortedDictWriter
+ * Purpose:     load the dictionary and index the first term of each block
+ * Returns:     nothing
+*/
+SortedDict::SortedDict(const string Filename)
+{
+ifstream In(Filename.c_str(), ios::binary);
+unsigned long TableOffset;
+unsigned int NumBlocks;
+unsigned long Trailer;
+
+   open = false;
+   numterms = 0;
+   pending = false;
+   data.assign(istreambuf_iterator<char>(In), istreambuf_iterator<char>());
+   if (data.size() < SDICT_MAGIC_LENGTH + SDICT_TRAILER_LENGTH ||
+       memcmp(data.data(), SDICT_MAGIC, SDICT_MAGIC_LENGTH) != 0)
+   {
+      cerr << Filename << " is not a sorted dictionary.\n";
+      return;
+   }
+
+   Trailer = data.size() - SDICT_TRAILER_LENGTH;
+   memcpy(&TableOffset, data.data() + Trailer, sizeof(unsigned long));
+   memcpy(&numterms, data.data() + Trailer + 8, sizeof(unsigned int));
+   memcpy(&NumBlocks, data.data() + Trailer + 12, sizeof(unsigned int));
+   if (TableOffset + NumBlocks * sizeof(unsigned long) != Trailer)
+   {
+      cerr << Filename << " is damaged.\n";
+      return;
+   }
+
+   blockoffsets.resize(NumBlocks);
+   memcpy(blockoffsets.data(), data.data() + TableOffset, NumBlocks * sizeof(unsigned long));
+   blockoffsets.push_back(TableOffset);   // so block b ends where b + 1 begins
+
+   for (unsigned long b = 0; b < NumBlocks; b++)
+   {
+      StartBlock(b);
+      DecodeNext();
+      firstterms.push_back(term);
+   }
+   open = true;
+   Rewind();
+}
+
+bool SortedDict::IsOpen() const
+{
+   return open;
+}
+
+unsigned int SortedDict::GetNumTerms() const
+{
+   return numterms;
+}
+
+/* Name:  Find
+ * Parameters:  Term: the term to look up
+ *              NumDocs, Start: receive its document count and first
+ *                              line in post
+ * Purpose:     look a term up: a binary search over the blocks, then
+ *              a scan of at most one block.  Moves the cursor.
+ * Returns:     true if the term is in the dictionary
+*/
+bool SortedDict::Find(const string_view Term, int &NumDocs, unsigned long &Start)
+{
+string Found;
+
+   Seek(Term);
+   return Next(Found, NumDocs, Start) && Found == Term;
+}
+
+/* Name:  Seek
+ * Parameters:  Term: where to start
+ * Purpose:     move the cursor so Next returns the first term >= Term;
+ *              e.g. Seek to a prefix and call Next while the terms
+ *              still begin with it
+ * Returns:     nothing
+*/
+void SortedDict::Seek(const string_view Term)
+{
+vector<string>::const_iterator After;
+
+   pending = false;
+   if (firstterms.empty())
+      return;
+
+   // the last block whose first term is <= Term
+   After = upper_bound(firstterms.begin(), firstterms.end(), Term,
+                       [](const string_view a, const string &b) { return a < string_view(b); });
+   StartBlock(After == firstterms.begin() ? 0 : After - firstterms.begin() - 1);
+   while (DecodeNext())
+      if (string_view(term) >= Term)
+      {
+         pending = true;
+         return;
+      }
+}
+
+// Go back to the first term
+void SortedDict::Rewind()
+{
+   pending = false;
+   if (!firstterms.empty())
+      StartBlock(0);
+}
+
+/* Name:  Next
+ * Parameters:  Term, NumDocs, Start: receive the next term and its entry
+ * Purpose:     read the dictionary in order, e.g. to merge two indexes
+ * Returns:     false after the last term
+*/
+bool SortedDict::Next(string &Term, int &NumDocs, unsigned long &Start)
+{
+   if (pending)
+      pending = false;
+   else if (firstterms.empty() || !DecodeNext())
+      return false;
+
+   Term = term;
+   NumDocs = numdocs;
+   Start = start;
+   return true;
+}
+
+/*-------------------------- Private Functions ----------------------------*/
+
+// Read a varint at Position, and move Position past it
+unsigned long SortedDict::GetVarint(unsigned long &Position) const
+{
+unsigned long Value = 0;
+int Shift = 0;
+
+   while (Position < data.size() && (data[Position] & 0x80))
+   {
+      Value |= (unsigned long) (data[Position] & 0x7F) << Shift;
+      Shift += 7;
+      Position++;
+   }
+   if (Position < data.size())
+      Value |= (unsigned long) (unsigned char) data[Position] << Shift;
+   Position++;
+   return Value;
+}
+
+// Put the cursor at the start of a block
+void SortedDict::StartBlock(const unsigned long Block)
+{
+   block = Block;
+   position = blockoffsets[Block];
+   end = blockoffsets[Block + 1];
+   nextstart = GetVarint(position);
+   term.clear();
+}
+
+/* Name:  DecodeNext
+ * Parameters:  none
+ * Purpose:     decode the term after the cursor, going on to the next
+ *              block at the end of this one
+ * Returns:     false at the end of the dictionary
+*/
+bool SortedDict::DecodeNext()
+{
+unsigned long Shared;
+unsigned long Length;
+
+   if (position >= end)
+   {
+      if (block + 2 >= blockoffsets.size())
+         return false;
+      StartBlock(block + 1);
+   }
+
+   Shared = GetVarint(position);
+   Length = GetVarint(position);
+   if (Shared > term.length() || position + Length > end)
+   {
+      position = end;   // damaged; stop here
+      return false;
+   }
+   term.resize(Shared);
+   term.append(data.data() + position, Length);
+   position += Length;
+   numdocs = GetVarint(position);
+   start = nextstart;
+   nextstart += numdocs;
+   return true;
+}
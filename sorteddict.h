@@ -0,0 +1,86 @@
+/* Filename:  sorteddict.h
+ * Date:      10/19/26
+ * Purpose:   The header file for the sorted dictionary.  The terms are
+ *            written in byte order, front-coded in blocks of
+ *            SDICT_BLOCK_TERMS: the first term of a block is stored
+ *            whole and each later one as the length it shares with the
+ *            term before it plus the rest.  Each term carries its
+ *            numdocs; its first line in post is the running total, so
+ *            only each block's first start is stored.
+ *
+ *            "FCDICT1\n"
+ *            block:   start  (term: shared  suffixlength  suffix  numdocs)*
+ *            the offset of every block           (8 bytes each)
+ *            trailer: table offset (8), numterms (4), numblocks (4)
+ *
+ *            start, shared, suffixlength and numdocs are varints.
+ *            SortedDict reads the file back, keeping only each block's
+ *            first term in its index: a lookup is a binary search over
+ *            the blocks and a scan of one block, and Seek/Next walk the
+ *            terms in order for range scans and merges.
+*/
+
+#ifndef SORTEDDICT_H
+#define SORTEDDICT_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "outputwriter.h"
+
+#define SDICT_BLOCK_TERMS 16
+#define SDICT_MAGIC "FCDICT1\n"
+#define SDICT_MAGIC_LENGTH 8
+#define SDICT_TRAILER_LENGTH 16
+
+using namespace std;
+
+class SortedDictWriter {
+public:
+   SortedDictWriter(const string Filename);
+   ~SortedDictWriter();
+   void Add (const string_view Term, const int NumDocs);  // in increasing order
+   bool Close ();                  // write the block table; false on error
+private:
+   SortedDictWriter (const SortedDictWriter& sdw);
+   void PutVarint (unsigned long Value);
+   int fd;
+   OutputWriter *out;
+   string previous;                 // the last term added
+   vector<unsigned long> blockoffsets;
+   unsigned long offset;            // bytes written so far
+   unsigned long start;             // the next term's first line in post
+   unsigned int numterms;
+};
+
+class SortedDict {
+public:
+   SortedDict(const string Filename);
+   bool IsOpen () const;
+   unsigned int GetNumTerms () const;
+   bool Find (const string_view Term, int &NumDocs, unsigned long &Start);
+   void Seek (const string_view Term);   // Next returns the first term >= Term
+   void Rewind ();
+   bool Next (string &Term, int &NumDocs, unsigned long &Start);
+private:
+   unsigned long GetVarint (unsigned long &Position) const;
+   void StartBlock (const unsigned long Block);
+   bool DecodeNext ();
+   vector<char> data;               // the whole file
+   vector<string> firstterms;       // the sparse index: each block's first term
+   vector<unsigned long> blockoffsets;
+   unsigned int numterms;
+   bool open;
+   // the cursor
+   unsigned long block;             // the block being read
+   unsigned long position;          // the next byte to decode
+   unsigned long end;               // the end of the block
+   string term;                     // the term just decoded
+   int numdocs;
+   unsigned long start;
+   unsigned long nextstart;
+   bool pending;                    // Seek found a term Next has not returned
+};
+
+#endif
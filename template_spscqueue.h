@@ -0,0 +1,246 @@
+//-----------------------------------------------------------------
+// File:  template_spscqueue.h
+// Purpose:  The header file for a bounded lock-free queue with a
+//           single producer thread and a single consumer thread.
+//           It is a ring of slots with an atomic head and tail, so
+//           neither side ever takes a lock.  It also keeps the
+//           statistics used to find the slow stage of a pipeline:
+//           how deep the queue runs and how long each side waited.
+//-----------------------------------------------------------------
+
+#ifndef TEMPLATE_SPSCQUEUE_H
+#define TEMPLATE_SPSCQUEUE_H
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <thread>
+using namespace std;
+
+#define SPSC_CACHE_LINE 64
+
+template <class T>	// template to provide run-time class for Item
+class SpscQueue
+{
+public:
+// constructors and destructors
+   SpscQueue(const unsigned long Capacity);  // rounded up to a power of 2
+   ~SpscQueue();
+
+// queue operations
+   bool TryPush (const T Item);    // producer only; false if full
+   bool TryPop (T &Item);          // consumer only; false if empty
+   void Push (const T Item);       // producer only; waits while full
+   T Pop ();                       // consumer only; waits while empty
+
+   unsigned long GetDepth() const;
+   double GetFullSeconds() const;   // time the producer spent stalled
+   double GetEmptySeconds() const;  // time the consumer spent stalled
+   void PrintStats(ostream &Out, const char *Name) const;
+
+private:
+   SpscQueue (const SpscQueue& Q);   // never copied
+   T *items;
+   unsigned long mask;               // capacity - 1
+
+   // each side's index on its own cache line, so they do not share
+   alignas(SPSC_CACHE_LINE) atomic<unsigned long> head;   // next to pop
+   alignas(SPSC_CACHE_LINE) atomic<unsigned long> tail;   // next to push
+
+   // producer-side statistics
+   alignas(SPSC_CACHE_LINE) unsigned long pushes;
+   unsigned long depthsum;           // depth seen at each push
+   unsigned long maxdepth;
+   unsigned long fullwaits;          // pushes that found the queue full
+   double fullseconds;
+
+   // consumer-side statistics
+   alignas(SPSC_CACHE_LINE) unsigned long emptywaits;  // pops that found it empty
+   double emptyseconds;
+};
+
+//-----------------------------------------------------------------
+// The method definitions of a template live with its declaration
+//-----------------------------------------------------------------
+
+// ------------------------ constructors and destructors ----------------
+
+//-----------------------------------------------------------------
+// Function Name:  The constructor
+// Parameters:  Capacity - the most items the queue holds
+// Return Value: none
+// Purpose:  Initialize the queue to empty
+//-----------------------------------------------------------------
+template <class T>
+SpscQueue<T>::SpscQueue(const unsigned long Capacity)
+{
+unsigned long Size = 1;
+
+   while (Size < Capacity)
+      Size = Size * 2;
+   items = new T[Size];
+   mask = Size - 1;
+   head = 0;
+   tail = 0;
+   pushes = 0;
+   depthsum = 0;
+   maxdepth = 0;
+   fullwaits = 0;
+   fullseconds = 0.0;
+   emptywaits = 0;
+   emptyseconds = 0.0;
+}
+
+//-----------------------------------------------------------------
+// Function Name:  The destructor
+// Parameters:  none
+// Return Value: none
+// Purpose:  Free the slots; the items themselves belong to the caller
+//-----------------------------------------------------------------
+template <class T>
+SpscQueue<T>::~SpscQueue()
+{
+   delete [] items;
+}
+
+// ----------------------- queue operations ------------------------------
+
+//-----------------------------------------------------------------
+// Function Name:  TryPush
+// Parameters:  Item - input - the item to be added
+// Return Value: false if the queue is full
+// Purpose:  Add an item at the tail without waiting
+//-----------------------------------------------------------------
+template <class T>
+bool SpscQueue<T>::TryPush (const T Item)
+{
+unsigned long Tail = tail.load(memory_order_relaxed);
+unsigned long Depth = Tail - head.load(memory_order_acquire);
+
+   if (Depth > mask)
+      return false;
+
+   items[Tail & mask] = Item;
+   tail.store(Tail + 1, memory_order_release);
+
+   pushes++;
+   depthsum += Depth + 1;
+   if (Depth + 1 > maxdepth)
+      maxdepth = Depth + 1;
+   return true;
+}
+
+//-----------------------------------------------------------------
+// Function Name:  TryPop
+// Parameters:  Item - output - the item removed
+// Return Value: false if the queue is empty
+// Purpose:  Remove the item at the head without waiting
+//-----------------------------------------------------------------
+template <class T>
+bool SpscQueue<T>::TryPop (T &Item)
+{
+unsigned long Head = head.load(memory_order_relaxed);
+
+   if (Head == tail.load(memory_order_acquire))
+      return false;
+
+   Item = items[Head & mask];
+   head.store(Head + 1, memory_order_release);
+   return true;
+}
+
+//-----------------------------------------------------------------
+// Function Name:  Push
+// Parameters:  Item - input - the item to be added
+// Return Value: none
+// Purpose:  Add an item, yielding the processor while the queue
+//           is full and counting the time spent stalled.
+//-----------------------------------------------------------------
+template <class T>
+void SpscQueue<T>::Push (const T Item)
+{
+   if (TryPush(Item))
+      return;
+
+   chrono::steady_clock::time_point Start = chrono::steady_clock::now();
+   while (!TryPush(Item))
+      this_thread::yield();
+   fullwaits++;
+   fullseconds += chrono::duration<double>(chrono::steady_clock::now() - Start).count();
+}
+
+//-----------------------------------------------------------------
+// Function Name:  Pop
+// Parameters:  none
+// Return Value: the item removed
+// Purpose:  Remove the item at the head, yielding the processor
+//           while the queue is empty and counting the time stalled.
+//-----------------------------------------------------------------
+template <class T>
+T SpscQueue<T>::Pop ()
+{
+T Item;
+
+   if (TryPop(Item))
+      return Item;
+
+   chrono::steady_clock::time_point Start = chrono::steady_clock::now();
+   while (!TryPop(Item))
+      this_thread::yield();
+   emptywaits++;
+   emptyseconds += chrono::duration<double>(chrono::steady_clock::now() - Start).count();
+   return Item;
+}
+
+//-----------------------------------------------------------------
+// Function Name:  GetDepth
+// Parameters:  none
+// Return Value: the number of items waiting (approximate while
+//               the other side is running)
+// Purpose:  Report how full the queue is
+//-----------------------------------------------------------------
+template <class T>
+unsigned long SpscQueue<T>::GetDepth() const
+{
+   return tail.load(memory_order_acquire) - head.load(memory_order_acquire);
+}
+
+//-----------------------------------------------------------------
+// Function Name:  GetFullSeconds, GetEmptySeconds
+// Parameters:  none
+// Return Value: seconds spent waiting in Push / in Pop
+// Purpose:  Report the stall time on each side of the queue
+//-----------------------------------------------------------------
+template <class T>
+double SpscQueue<T>::GetFullSeconds() const
+{
+   return fullseconds;
+}
+
+template <class T>
+double SpscQueue<T>::GetEmptySeconds() const
+{
+   return emptyseconds;
+}
+
+//-----------------------------------------------------------------
+// Function Name:  PrintStats
+// Parameters:  Out - where to print
+//              Name - the label for this queue
+// Return Value: none
+// Purpose:  Print the depth and stall statistics.  Only call once
+//           both threads are finished with the queue.
+//-----------------------------------------------------------------
+template <class T>
+void SpscQueue<T>::PrintStats(ostream &Out, const char *Name) const
+{
+   Out << setw(20) << Name
+       << "  depth mean " << setw(6) << fixed << setprecision(2)
+       << (pushes > 0 ? (depthsum * 1.0) / pushes : 0.0)
+       << " max " << setw(4) << maxdepth << "/" << mask + 1
+       << "  full " << setw(6) << fullwaits << " (" << setprecision(3) << fullseconds << "s)"
+       << "  empty " << setw(6) << emptywaits << " (" << emptyseconds << "s)" << endl;
+}
+
+#endif
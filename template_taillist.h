@@ -7,7 +7,11 @@
 //	     stored in the node.
 //-----------------------------------------------------------------
 
+#ifndef TEMPLATE_TAILLIST_H
+#define TEMPLATE_TAILLIST_H
+
 #include <fstream>
+#include "outputwriter.h"
 using namespace std;
 
 template <class T>	// template to provide run-time class for Item
@@ -25,15 +29,19 @@ public:
    void AddToEnd (const T Item);
    void AddSorted (const T Item);
    void Delete(const T Item);
+   void Clear();
 
    bool IsEmpty() const;
    void Print() const;
    void Print(ofstream &Dout) const;
    void Print(ofstream &Dout, const float IDF) const;
+   void Write(OutputWriter &Out, const float IDF) const;
    void Write(const char Filename[]) const;
+   void WriteItems(OutputWriter &Out) const;
 
    T Get(int index) const;
    int GetSize() const;
+   static unsigned long GetNodeBytes();
 
 private:
    struct Node;
@@ -92,15 +100,7 @@ List<T>::List(const List &Other)
 template <class T>
 List<T>::~List()
 {
-NodePtr Temp;
-
-   // loop through whole list deleting nodes
-   while (Head != NULL)
-   {
-      Temp = Head;
-      Head = Head->Next;
-      delete Temp;
-   }
+   Clear();
 }
 
 // ----------------------- list operations ------------------------------
@@ -127,6 +127,27 @@ NodePtr Curr = Other.Head;        // the current node in the original list
    }
 };     
 
+//-----------------------------------------------------------------
+// Function Name:  Clear
+// Parameters:  none
+// Return Value: none
+// Purpose:  Delete all the nodes in the list, leaving it empty
+//-----------------------------------------------------------------
+template <class T>
+void List<T>::Clear()
+{
+NodePtr Temp;
+
+   // loop through whole list deleting nodes
+   while (Head != NULL)
+   {
+      Temp = Head;
+      Head = Head->Next;
+      delete Temp;
+   }
+   Tail = NULL;
+}
+
 //-----------------------------------------------------------------
 // Function Name:  IsEmpty
 // Parameters:  none
@@ -287,6 +308,43 @@ NodePtr Temp = Head;
    }
 }
 
+//-----------------------------------------------------------------
+// Function Name:  Write
+// Parameters:  Out:  The writer to write to
+//              IDF:  passed on to each item
+// Return Value: none
+// Purpose:  Write the same text Print(Dout, IDF) prints to Out.
+//-----------------------------------------------------------------
+template <class T>
+void List<T>::Write(OutputWriter &Out, const float IDF) const
+{
+NodePtr Temp = Head;
+   // loop through whole list writing nodes
+   while (Temp != NULL)
+   {
+      (Temp->Item).Write(Out, IDF);
+      Temp = Temp->Next;
+   }
+}
+
+//-----------------------------------------------------------------
+// Function Name:  WriteItems
+// Parameters:  Out:  The writer to write to
+// Return Value: none
+// Purpose:  Write the bytes of each item as they are in memory, for
+//           a checkpoint (T must be plain data).
+//-----------------------------------------------------------------
+template <class T>
+void List<T>::WriteItems(OutputWriter &Out) const
+{
+NodePtr Temp = Head;
+   while (Temp != NULL)
+   {
+      Out.Put(string_view((const char *) &(Temp->Item), sizeof(T)));
+      Temp = Temp->Next;
+   }
+}
+
 //-----------------------------------------------------------------
 //-----------------------------------------------------------------
 // Function Name:  Delete
@@ -395,6 +453,21 @@ int List<T>::GetSize() const
    return size;
 }
 
+//-----------------------------------------------------------------
+// Function Name:  GetNodeBytes
+// Parameters:  none
+// Return Value: the heap bytes one node takes
+// Purpose:  Size a node as the heap hands it out: its bytes plus the
+//           allocator's 8-byte header, rounded up to 16, at least 32.
+//-----------------------------------------------------------------
+template <class T>
+unsigned long List<T>::GetNodeBytes()
+{
+unsigned long Bytes = (sizeof(Node) + 8 + 15) / 16 * 16;
+
+   return (Bytes < 32 ? 32 : Bytes);
+}
+
 // ----------------------- private methods ------------------------------
 
 //-----------------------------------------------------------------
@@ -420,3 +493,4 @@ void List<T>::Find (const T Item, NodePtr &Curr, NodePtr &Prev) const
    }
 }
 
+#endif
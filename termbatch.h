@@ -0,0 +1,47 @@
+/* Filename:  termbatch.h
+ * Date:      10/19/26
+ * Purpose:   The per-document hand-off from a Tokenizer to the Inverter:
+ *            the weighted words to post, keyed by the tokenizer's own
+ *            term ids, plus the text of any of those words the tokenizer
+ *            has not sent before so the inverter can map them to global
+ *            ids (only words that are posted ever reach the inverter),
+ *            the document's tokens when there is a document store, and
+ *            its filename.
+*/
+
+#ifndef TERMBATCH_H
+#define TERMBATCH_H
+
+#include <string>
+#include <vector>
+
+using namespace std;
+
+struct TermBatch
+{
+   int source;                      // the tokenizer that made the batch
+   int docid;
+   vector<unsigned int> termids;    // tokenizer term ids of the words to post
+   vector<float> rtfs;              // and their relative term frequencies
+   unsigned long signature;         // the SimHash of the counts, if asked for
+   unsigned long localmemory;       // the bytes the tokenizer's tables hold
+   bool restart;                    // the tokenizer's ids start again from this batch
+   vector<unsigned int> newids;     // its ids for words the inverter has not seen
+   vector<char> newterms;           // and their text
+   vector<unsigned int> newlengths;
+   vector<char> text;               // the document's tokens, if it is stored
+   string filename;                 // as in the map
+
+   void Clear()
+   {
+      termids.clear();
+      rtfs.clear();
+      restart = false;
+      newids.clear();
+      newterms.clear();
+      newlengths.clear();
+      text.clear();
+   }
+};
+
+#endif
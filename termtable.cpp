@@ -0,0 +1,261 @@
+/* Filename:  termtable.cpp
+ * Date:      10/19/2026
+ * Purpose:   The implementation file for the table of interned terms.
+*/
+
+#include <assert.h>
+#include <string.h>
+#include <iostream>
+
+#include "termtable.h"
+
+using namespace std;
+
+/*-------------------------- Constructors/Destructors ----------------------*/
+
+/* Name:  TermTable
+ * Parameters:  NumTerms: the number of distinct terms expected;
+ *              the table grows if there turn out to be more
+ * Purpose:     allocate an empty term table
+ * Returns:     nothing
+*/
+TermTable::TermTable(const unsigned long NumTerms) : ctrl(NumTerms * 3)
+{
+   size = NumTerms * 3;   // we want the hash table to be 2/3 empty
+   if((hashtable = new unsigned int[size]) == NULL)
+      cout << "Out of memory at TermTable::TermTable(unsigned long)" << endl;
+   assert( hashtable != 0 );
+   terms.reserve(NumTerms);
+   arenaused = 0;
+   arenasize = 0;
+   arenabytes = 0;
+   collisions = 0;
+   lookups = 0;
+}
+
+/* Name:  ~TermTable
+ * Parameters:  none
+ * Purpose:     deallocate the table and the term strings
+ * Returns:     nothing
+*/
+TermTable::~TermTable()
+{
+   delete [] hashtable;
+   for (unsigned long i = 0; i < arena.size(); i++)
+      delete [] arena[i];
+}
+
+/*-------------------------- Accessors ------------------------------------*/
+
+/* Name: Intern
+ * Parameters:  Token: the term to look up
+ * Purpose:     find the id of a term, giving it the next id (and a copy
+ *              in the arena) the first time it is seen.  This is the
+ *              only place a token is hashed or copied; everything after
+ *              works from the id and the stored hash.
+ * Returns:     the term id
+*/
+unsigned int TermTable::Intern(const string_view Token)
+{
+unsigned long Hash = ControlBytes::Hash(Token);
+unsigned long Index;
+unsigned int TermId;
+
+   Index = Probe(Token, Hash);
+   if (!ctrl.IsEmpty(Index))
+      return hashtable[Index];
+
+   // a new term; make room first so the table stays 2/3 empty
+   if ((terms.size() + 1) * 3 > size)
+   {
+      Grow();
+      Index = Probe(Token, Hash);
+   }
+
+   TermEntry Entry;
+   Entry.text = Store(Token);
+   Entry.length = Token.length();
+   Entry.hash = Hash;
+   TermId = terms.size();
+   terms.push_back(Entry);
+
+   hashtable[Index] = TermId;
+   ctrl.Set(Index, Hash);
+   return TermId;
+}
+
+/* Name: Find
+ * Parameters:  Token: the term to look up
+ * Purpose:     find the id of a term without adding it
+ * Returns:     the term id, or TERM_NONE if it has never been seen
+*/
+unsigned int TermTable::Find(const string_view Token)
+{
+unsigned long Index;
+
+   lookups++;
+   Index = Probe(Token, ControlBytes::Hash(Token));
+   if (ctrl.IsEmpty(Index))
+      return TERM_NONE;
+   return hashtable[Index];
+}
+
+/* Name: GetToken
+ * Parameters:  TermId: an id returned by Intern
+ * Purpose:     recover the term's text
+ * Returns:     a view of the term in the arena, valid for the
+ *              life of the table
+*/
+string_view TermTable::GetToken(const unsigned int TermId) const
+{
+   return string_view(terms[TermId].text, terms[TermId].length);
+}
+
+/* Name: GetHash
+ * Parameters:  TermId: an id returned by Intern
+ * Purpose:     return the term's full hash, as computed by ControlBytes::Hash
+ * Returns:     the hash
+*/
+unsigned long TermTable::GetHash(const unsigned int TermId) const
+{
+   return terms[TermId].hash;
+}
+
+/* Name: GetNumTerms
+ * Parameters:  none
+ * Purpose:     the number of terms interned so far; ids run 0..n-1
+ * Returns:     the number of terms
+*/
+unsigned int TermTable::GetNumTerms() const
+{
+   return terms.size();
+}
+
+/* Name: Truncate
+ * Parameters:  NumTerms: the number of ids to keep
+ * Purpose:     drop every term from id NumTerms on.  The terms kept are
+ *              copied into a fresh arena and the old blocks freed; the
+ *              slots stay as large as they have grown.
+ * Returns:     nothing
+*/
+void TermTable::Truncate(const unsigned int NumTerms)
+{
+vector<char *> Old;
+unsigned long Index;
+
+   if (NumTerms >= terms.size())
+      return;
+   terms.resize(NumTerms);
+   Old.swap(arena);
+   arenaused = 0;
+   arenasize = 0;
+   arenabytes = 0;
+   ctrl.Reset();
+
+   for (unsigned int TermId = 0; TermId < terms.size(); TermId++)
+   {
+      terms[TermId].text = Store(string_view(terms[TermId].text, terms[TermId].length));
+      Index = ctrl.Find(terms[TermId].hash,
+                        [](unsigned long) { return false; },
+                        collisions);
+      hashtable[Index] = TermId;
+      ctrl.Set(Index, terms[TermId].hash);
+   }
+
+   for (unsigned long i = 0; i < Old.size(); i++)
+      delete [] Old[i];
+}
+
+/* Name: GetUsage
+ * Parameters:	None
+ * Purpose:	return the number of terms, collisions and lookups
+ * Return:	nothing
+*/
+void TermTable::GetUsage(int &Used, int &Collisions, int &Lookups) const
+{
+   Used = terms.size();
+   Collisions = collisions;
+   Lookups = lookups;
+}
+
+/* Name:  GetMemory
+ * Parameters:  none
+ * Purpose:     add up the arena blocks, the id entries and the slots
+ *              with their control bytes
+ * Returns:     the bytes held
+*/
+unsigned long TermTable::GetMemory() const
+{
+   return arenabytes + terms.capacity() * sizeof(TermEntry) + arena.capacity() * sizeof(char *) +
+          size * (sizeof(unsigned int) + 1);
+}
+
+/*-------------------------- Private Functions ----------------------------*/
+
+/* Name:  Probe
+ * Parameters:  Token: the term to be located
+ *              Hash: the term's hash
+ * Purpose:     return the slot holding the term, or the free slot
+ *              in which to store it
+ * Returns:     the slot index
+*/
+unsigned long TermTable::Probe(const string_view Token, const unsigned long Hash)
+{
+   return ctrl.Find(Hash,
+                    [&](unsigned long Index) {
+                       const TermEntry &Entry = terms[hashtable[Index]];
+                       return Entry.hash == Hash && Entry.length == Token.length() &&
+                              memcmp(Entry.text, Token.data(), Entry.length) == 0; },
+                    collisions);
+}
+
+/* Name:  Store
+ * Parameters:  Token: the term to copy
+ * Purpose:     append the term's bytes to the arena.  Blocks are never
+ *              moved or freed, so the copy stays put for good.
+ * Returns:     a pointer to the copy
+*/
+const char *TermTable::Store(const string_view Token)
+{
+char *Text;
+
+   if (arena.empty() || arenaused + Token.length() > arenasize)
+   {
+      arenasize = Token.length() > TERM_ARENA_BLOCK ? Token.length() : TERM_ARENA_BLOCK;
+      arena.push_back(new char[arenasize]);
+      arenaused = 0;
+      arenabytes += arenasize;
+   }
+   Text = arena.back() + arenaused;
+   memcpy(Text, Token.data(), Token.length());
+   arenaused += Token.length();
+   return Text;
+}
+
+/* Name:  Grow
+ * Parameters:  none
+ * Purpose:     double the table and put every term back using its
+ *              stored hash; the ids do not change
+ * Returns:     nothing
+*/
+void TermTable::Grow()
+{
+unsigned long Index;
+
+   delete [] hashtable;
+   size = size * 2;
+   if((hashtable = new unsigned int[size]) == NULL)
+      cout << "Out of memory at TermTable::Grow()" << endl;
+   assert( hashtable != 0 );
+   ctrl.Resize(size);
+
+   // ids are distinct, so each one just goes into the first free slot
+   for (unsigned int TermId = 0; TermId < terms.size(); TermId++)
+   {
+      Index = ctrl.Find(terms[TermId].hash,
+                        [](unsigned long) { return false; },
+                        collisions);
+      hashtable[Index] = TermId;
+      ctrl.Set(Index, terms[TermId].hash);
+   }
+}
@@ -0,0 +1,60 @@
+/* Filename:  termtable.h
+ * Date:      10/19/26
+ * Purpose:   The header file for the term table, which interns every
+ *            token seen.  Each distinct string is copied once into an
+ *            append-only arena and gets a stable 32-bit term id; the
+ *            table remembers the full hash of each term so the count
+ *            and global tables can be keyed by id and never rehash
+ *            or compare strings.  A table that takes every token seen
+ *            can be cut back to its first few ids between documents.
+*/
+
+#ifndef TERMTABLE_H
+#define TERMTABLE_H
+
+#include <string_view>
+#include <vector>
+
+#include "controlbytes.h"
+
+#define TERM_NONE 0xFFFFFFFF
+#define TERM_ARENA_BLOCK 65536
+
+using namespace std;
+
+class TermTable {
+public:
+   TermTable(const unsigned long NumTerms);     // constructor of the term table
+   ~TermTable();                                // destructor
+   unsigned int Intern (const string_view Token); // the id of Token, added if new
+   unsigned int Find (const string_view Token);   // the id of Token or TERM_NONE
+   string_view GetToken (const unsigned int TermId) const;
+   unsigned long GetHash (const unsigned int TermId) const;
+   unsigned int GetNumTerms () const;
+   void Truncate (const unsigned int NumTerms);   // keep only the first NumTerms ids
+   void GetUsage (int &Used, int &Collisions, int &Lookups) const;
+   unsigned long GetMemory () const;   // bytes held for strings, ids and slots
+private:
+   TermTable (const TermTable& tt);             // ids are global; never copied
+   struct TermEntry  // what the table knows about each term id
+   {
+      const char *text;             // the term's bytes in the arena
+      unsigned int length;
+      unsigned long hash;
+   };
+   unsigned long Probe (const string_view Token, const unsigned long Hash);
+   const char *Store (const string_view Token);
+   void Grow ();
+   vector<TermEntry> terms;         // indexed by term id
+   vector<char *> arena;            // the blocks holding the term strings
+   unsigned long arenaused;         // bytes used in the last block
+   unsigned long arenasize;         // bytes in the last block
+   unsigned long arenabytes;        // bytes in all the blocks
+   unsigned int *hashtable;         // slot -> term id
+   ControlBytes ctrl;               // one hash tag per slot, for probing
+   unsigned long size;              // the hashtable size
+   unsigned long collisions;
+   unsigned long lookups;
+};
+
+#endif
@@ -0,0 +1,478 @@
+/* Filename:  termtrie.cpp
+ * Date:      10/19/2026
+ * Purpose:   The implementation file for the term trie.
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+#include "termtrie.h"
+
+using namespace std;
+
+/*-------------------------- Wildcard patterns ----------------------------*/
+
+// A wildcard pattern is run as a set of positions in the pattern (an
+// NFA): '?' takes any byte, '*' any run of bytes.  Adding the position
+// after every '*' reached lets a star match nothing.
+static void Close(const string_view Pattern, vector<unsigned int> &States)
+{
+   for (unsigned long k = 0; k < States.size(); k++)
+      if (States[k] < Pattern.length() && Pattern[States[k]] == '*' &&
+          (k + 1 == States.size() || States[k + 1] != States[k] + 1))
+         States.insert(States.begin() + k + 1, States[k] + 1);
+}
+
+// The positions reached from States by reading Byte, in order
+static void Step(const string_view Pattern, const vector<unsigned int> &States,
+                 const char Byte, vector<unsigned int> &Next)
+{
+   Next.clear();
+   for (unsigned long k = 0; k < States.size(); k++)
+   {
+      unsigned int p = States[k];
+      if (p >= Pattern.length())
+         continue;
+      unsigned int Reached = p + 1;
+      if (Pattern[p] == '*')
+         Reached = p;
+      else if (Pattern[p] != '?' && Pattern[p] != Byte)
+         continue;
+      if (Next.empty() || Next.back() < Reached)
+         Next.push_back(Reached);
+   }
+   Close(Pattern, Next);
+}
+
+/*-------------------------- Constructors/Destructors ----------------------*/
+
+/* Name:  TermTrie
+ * Parameters:  none
+ * Purpose:     an empty trie, to Build or Read
+ * Returns:     nothing
+*/
+TermTrie::TermTrie()
+{
+   nodes.push_back(TrieNode{0, 0, TRIE_NONE});
+}
+
+/*-------------------------- Accessors ------------------------------------*/
+
+/* Name:  Build
+ * Parameters:  Terms: the distinct terms, in byte order
+ *              Entries: each term's dictionary entry
+ * Purpose:     build the trie for a dictionary
+ * Returns:     nothing
+*/
+void TermTrie::Build(const vector<string_view> &Terms, const vector<TrieEntry> &Entries)
+{
+   nodes.clear();
+   edges.clear();
+   labels.clear();
+   entries = Entries;
+   BuildNode(Terms, 0, Terms.size(), 0);
+}
+
+/* Name:  Write
+ * Parameters:  Filename: the file to create
+ * Purpose:     save the trie
+ * Returns:     false if the file could not be written
+*/
+bool TermTrie::Write(const string Filename) const
+{
+ofstream Out(Filename.c_str(), ios::binary);
+unsigned int Counts[4] = { (unsigned int) nodes.size(), (unsigned int) edges.size(),
+                           (unsigned int) labels.size(), (unsigned int) entries.size() };
+
+   Out.write(TRIE_MAGIC, TRIE_MAGIC_LENGTH);
+   Out.write((const char *) Counts, sizeof(Counts));
+   Out.write((const char *) nodes.data(), nodes.size() * sizeof(TrieNode));
+   Out.write((const char *) edges.data(), edges.size() * sizeof(TrieEdge));
+   Out.write(labels.data(), labels.size());
+   Out.write((const char *) entries.data(), entries.size() * sizeof(TrieEntry));
+   Out.close();
+   return !Out.fail();
+}
+
+/* Name:  Read
+ * Parameters:  Filename: a trie made by Write
+ * Purpose:     load a trie
+ * Returns:     false if the file is missing or is not a trie
+*/
+bool TermTrie::Read(const string Filename)
+{
+ifstream In(Filename.c_str(), ios::binary);
+vector<char> Data((istreambuf_iterator<char>(In)), istreambuf_iterator<char>());
+unsigned int Counts[4];
+unsigned long Offset = TRIE_MAGIC_LENGTH + sizeof(Counts);
+
+   if (Data.size() < Offset || memcmp(Data.data(), TRIE_MAGIC, TRIE_MAGIC_LENGTH) != 0)
+      return false;
+   memcpy(Counts, Data.data() + TRIE_MAGIC_LENGTH, sizeof(Counts));
+   if (Counts[0] == 0 || Data.size() != Offset + Counts[0] * sizeof(TrieNode)
+                         + Counts[1] * sizeof(TrieEdge) + Counts[2]
+                         + Counts[3] * sizeof(TrieEntry))
+      return false;
+
+   nodes.resize(Counts[0]);
+   memcpy(nodes.data(), Data.data() + Offset, Counts[0] * sizeof(TrieNode));
+   Offset += Counts[0] * sizeof(TrieNode);
+   edges.resize(Counts[1]);
+   memcpy(edges.data(), Data.data() + Offset, Counts[1] * sizeof(TrieEdge));
+   Offset += Counts[1] * sizeof(TrieEdge);
+   labels.assign(Data.begin() + Offset, Data.begin() + Offset + Counts[2]);
+   Offset += Counts[2];
+   entries.resize(Counts[3]);
+   memcpy(entries.data(), Data.data() + Offset, Counts[3] * sizeof(TrieEntry));
+   return true;
+}
+
+unsigned int TermTrie::GetNumTerms() const
+{
+   return entries.size();
+}
+
+/* Name:  Find
+ * Parameters:  Term: the term to look up
+ *              Entry: receives its dictionary entry
+ * Purpose:     exact lookup
+ * Returns:     true if the term is in the dictionary
+*/
+bool TermTrie::Find(const string_view Term, TrieEntry &Entry) const
+{
+unsigned int Node = 0;
+unsigned long Position = 0;
+int Edge;
+
+   while (Position < Term.length())
+   {
+      if ((Edge = FindEdge(Node, Term[Position])) < 0)
+         return false;
+      string_view Label = GetLabel(edges[Edge]);
+      if (Term.substr(Position, Label.length()) != Label)
+         return false;
+      Position += Label.length();
+      Node = edges[Edge].child;
+   }
+   if (nodes[Node].term == TRIE_NONE)
+      return false;
+   Entry = entries[nodes[Node].term];
+   return true;
+}
+
+/* Name:  Prefix
+ * Parameters:  Prefix: the start every match must have
+ *              Matches: receives the terms, in order
+ * Purpose:     enumerate the terms that begin with Prefix
+ * Returns:     nothing
+*/
+void TermTrie::Prefix(const string_view Prefix, vector<TrieMatch> &Matches) const
+{
+unsigned int Node = 0;
+unsigned long Position = 0;
+string Path;
+int Edge;
+
+   // the prefix may end part way along an edge
+   while (Position < Prefix.length())
+   {
+      if ((Edge = FindEdge(Node, Prefix[Position])) < 0)
+         return;
+      string_view Label = GetLabel(edges[Edge]);
+      string_view Rest = Prefix.substr(Position);
+      if (Label.substr(0, Rest.length()) != Rest.substr(0, Label.length()))
+         return;
+      Path.append(Label);
+      Position += Label.length();
+      Node = edges[Edge].child;
+   }
+   Collect(Node, Path, Matches);
+}
+
+/* Name:  Wildcard
+ * Parameters:  Pattern: a term where ? stands for any byte and * for
+ *                       any run of bytes
+ *              Matches: receives the matching terms, in order
+ * Purpose:     enumerate the terms matching a pattern.  A subtree is
+ *              left as soon as no part of the pattern can match it, so
+ *              e.g. comput*r never looks outside "comput".
+ * Returns:     nothing
+*/
+void TermTrie::Wildcard(const string_view Pattern, vector<TrieMatch> &Matches) const
+{
+vector<unsigned int> States(1, 0);
+string Path;
+
+   Close(Pattern, States);
+   MatchWildcard(0, Path, Pattern, States, Matches);
+}
+
+/* Name:  Range
+ * Parameters:  Low, High: the first and last terms wanted
+ *              Matches: receives the terms, in order
+ * Purpose:     enumerate the terms from Low to High inclusive
+ * Returns:     nothing
+*/
+void TermTrie::Range(const string_view Low, const string_view High, vector<TrieMatch> &Matches) const
+{
+string Path;
+
+   CollectRange(0, Path, Low, High, Matches);
+}
+
+/* Name:  Fuzzy
+ * Parameters:  Word: the word to match, perhaps misspelled
+ *              MaxDistance: the most insertions, deletions and
+ *                           substitutions allowed (1 or 2 in practice)
+ *              Matches: receives the terms within MaxDistance of Word,
+ *                       most documents first
+ * Purpose:     approximate lookup.  Walking the trie carries one row
+ *              of the edit distance table per byte of the path, which
+ *              is a Levenshtein automaton run against every term at
+ *              once; once a row's smallest entry is over MaxDistance no
+ *              term below can match and the subtree is skipped.
+ * Returns:     nothing
+*/
+void TermTrie::Fuzzy(const string_view Word, const int MaxDistance, vector<TrieMatch> &Matches) const
+{
+vector<int> Rows(Word.length() + 1);
+unsigned long First = Matches.size();
+string Path;
+
+   for (unsigned long j = 0; j <= Word.length(); j++)
+      Rows[j] = j;
+   MatchFuzzy(0, Path, Word, MaxDistance, Rows, Matches);
+
+   sort(Matches.begin() + First, Matches.end(), [](const TrieMatch &a, const TrieMatch &b)
+   {
+      if (a.entry.numdocs != b.entry.numdocs)
+         return a.entry.numdocs > b.entry.numdocs;
+      if (a.distance != b.distance)
+         return a.distance < b.distance;
+      return a.term < b.term;
+   });
+}
+
+/* Name:  Numbered
+ * Parameters:  Matches: receives the terms
+ * Purpose:     list every term with postings in start order, the order
+ *              of their lists in post; a term's place in the list is
+ *              its id in bpost and fwd.  Terms without postings are
+ *              left out, so no two share a start.
+ * Returns:     nothing
+*/
+void TermTrie::Numbered(vector<TrieMatch> &Matches) const
+{
+unsigned long First = Matches.size();
+
+   Prefix("", Matches);
+   Matches.erase(remove_if(Matches.begin() + First, Matches.end(),
+                           [](const TrieMatch &m) { return m.entry.numdocs <= 0; }), Matches.end());
+   sort(Matches.begin() + First, Matches.end(), [](const TrieMatch &a, const TrieMatch &b)
+   {
+      return a.entry.start < b.entry.start;
+   });
+}
+
+/*-------------------------- Private Functions ----------------------------*/
+
+/* Name:  BuildNode
+ * Parameters:  Terms: all of the terms, sorted
+ *              First, Last: the terms below this node, First up to Last
+ *              Depth: the length of the prefix they share
+ * Purpose:     add the node for a group of terms and, first, its subtrees.
+ *              A child's terms are contiguous and, being sorted, share
+ *              whatever prefix the first and last of them share.
+ * Returns:     the node's index
+*/
+unsigned int TermTrie::BuildNode(const vector<string_view> &Terms, unsigned long First,
+                                 const unsigned long Last, const unsigned long Depth)
+{
+unsigned int Node = nodes.size();
+vector<TrieEdge> Edges;
+
+   nodes.push_back(TrieNode{0, 0, TRIE_NONE});
+   if (First < Last && Terms[First].length() == Depth)
+      nodes[Node].term = First++;
+
+   while (First < Last)
+   {
+      unsigned long Group = First + 1;
+      while (Group < Last && Terms[Group][Depth] == Terms[First][Depth])
+         Group++;
+
+      unsigned long Common = Depth + 1;
+      while (Common < Terms[First].length() && Common < Terms[Group - 1].length() &&
+             Terms[First][Common] == Terms[Group - 1][Common])
+         Common++;
+
+      TrieEdge Edge;
+      Edge.label = labels.size();
+      Edge.length = Common - Depth;
+      labels.insert(labels.end(), Terms[First].begin() + Depth, Terms[First].begin() + Common);
+      Edge.child = BuildNode(Terms, First, Group, Common);
+      Edges.push_back(Edge);
+      First = Group;
+   }
+
+   nodes[Node].firstedge = edges.size();
+   nodes[Node].numedges = Edges.size();
+   edges.insert(edges.end(), Edges.begin(), Edges.end());
+   return Node;
+}
+
+// The edge out of Node whose label begins with Byte, or -1
+int TermTrie::FindEdge(const unsigned int Node, const char Byte) const
+{
+int Low = nodes[Node].firstedge;
+int High = Low + nodes[Node].numedges - 1;
+
+   // the edges are in byte order
+   while (Low <= High)
+   {
+      int Middle = (Low + High) / 2;
+      unsigned char First = labels[edges[Middle].label];
+      if (First == (unsigned char) Byte)
+         return Middle;
+      if (First < (unsigned char) Byte)
+         Low = Middle + 1;
+      else
+         High = Middle - 1;
+   }
+   return -1;
+}
+
+string_view TermTrie::GetLabel(const TrieEdge &Edge) const
+{
+   return string_view(labels.data() + Edge.label, Edge.length);
+}
+
+// Add every term at or below Node; Path is the text leading to Node
+void TermTrie::Collect(const unsigned int Node, string &Path, vector<TrieMatch> &Matches) const
+{
+const TrieNode &Here = nodes[Node];
+
+   if (Here.term != TRIE_NONE)
+      Matches.push_back(TrieMatch{Path, entries[Here.term], 0});
+   for (unsigned int e = Here.firstedge; e < Here.firstedge + Here.numedges; e++)
+   {
+      unsigned long Length = Path.length();
+      Path.append(GetLabel(edges[e]));
+      Collect(edges[e].child, Path, Matches);
+      Path.resize(Length);
+   }
+}
+
+// Add the terms below Node that the pattern can still match from States
+void TermTrie::MatchWildcard(const unsigned int Node, string &Path, const string_view Pattern,
+                             const vector<unsigned int> &States, vector<TrieMatch> &Matches) const
+{
+const TrieNode &Here = nodes[Node];
+vector<unsigned int> Current;
+vector<unsigned int> Next;
+
+   if (Here.term != TRIE_NONE && !States.empty() && States.back() == Pattern.length())
+      Matches.push_back(TrieMatch{Path, entries[Here.term], 0});
+
+   for (unsigned int e = Here.firstedge; e < Here.firstedge + Here.numedges; e++)
+   {
+      string_view Label = GetLabel(edges[e]);
+      Current = States;
+      for (unsigned long k = 0; k < Label.length() && !Current.empty(); k++)
+      {
+         Step(Pattern, Current, Label[k], Next);
+         Current.swap(Next);
+      }
+      if (Current.empty())
+         continue;
+
+      unsigned long Length = Path.length();
+      Path.append(Label);
+      MatchWildcard(edges[e].child, Path, Pattern, Current, Matches);
+      Path.resize(Length);
+   }
+}
+
+// Add the terms below Node from Low to High.  Every term below a node
+// begins with its path, so a subtree whose path is above High ends
+// the walk and one whose path is below Low, and not a prefix of it,
+// can be skipped.
+void TermTrie::CollectRange(const unsigned int Node, string &Path, const string_view Low,
+                            const string_view High, vector<TrieMatch> &Matches) const
+{
+const TrieNode &Here = nodes[Node];
+
+   if (Here.term != TRIE_NONE && string_view(Path) >= Low && string_view(Path) <= High)
+      Matches.push_back(TrieMatch{Path, entries[Here.term], 0});
+
+   for (unsigned int e = Here.firstedge; e < Here.firstedge + Here.numedges; e++)
+   {
+      unsigned long Length = Path.length();
+      Path.append(GetLabel(edges[e]));
+      if (string_view(Path) > High)
+      {
+         Path.resize(Length);
+         return;
+      }
+      if (string_view(Path) >= Low || Low.substr(0, Path.length()) == string_view(Path))
+         CollectRange(edges[e].child, Path, Low, High, Matches);
+      Path.resize(Length);
+   }
+}
+
+// Add the terms below Node within MaxDistance of Word.  Rows holds one
+// row of the edit distance table per byte of Path, row d at d * (|Word|
+// + 1); row d only needs columns d - MaxDistance to d + MaxDistance,
+// the rest being over MaxDistance whatever the bytes.
+void TermTrie::MatchFuzzy(const unsigned int Node, string &Path, const string_view Word,
+                          const int MaxDistance, vector<int> &Rows, vector<TrieMatch> &Matches) const
+{
+const TrieNode &Here = nodes[Node];
+const long Width = Word.length() + 1;
+const long Depth = Path.length();
+int Distance = Rows[Depth * Width + Width - 1];
+int Smallest;
+
+   if (Here.term != TRIE_NONE && Distance <= MaxDistance)
+      Matches.push_back(TrieMatch{Path, entries[Here.term], Distance});
+
+   for (unsigned int e = Here.firstedge; e < Here.firstedge + Here.numedges; e++)
+   {
+      string_view Label = GetLabel(edges[e]);
+      if ((long) Rows.size() < (Depth + (long) Label.length() + 1) * Width)
+         Rows.resize((Depth + Label.length() + 1) * Width);
+
+      Smallest = 0;
+      long i = Depth;
+      for (unsigned long k = 0; k < Label.length() && Smallest <= MaxDistance; k++)
+      {
+         const int *Row = &Rows[i * Width];
+         int *Next = &Rows[(i + 1) * Width];
+         long First = max(1L, i + 1 - MaxDistance);
+         long Last = min(Width - 1, i + 1 + MaxDistance);
+
+         Next[0] = i + 1;
+         if (First > 1)
+            Next[First - 1] = MaxDistance + 1;
+         Smallest = (First == 1 ? Next[0] : MaxDistance + 1);
+         for (long j = First; j <= Last; j++)
+         {
+            Next[j] = min(min(Row[j], Next[j - 1]) + 1, Row[j - 1] + (Word[j - 1] != Label[k]));
+            Smallest = min(Smallest, Next[j]);
+         }
+         for (long j = Last + 1; j < Width; j++)
+            Next[j] = MaxDistance + 1;
+         i++;
+      }
+      if (Smallest > MaxDistance)
+         continue;
+
+      Path.append(Label);
+      MatchFuzzy(edges[e].child, Path, Word, MaxDistance, Rows, Matches);
+      Path.resize(Depth);
+   }
+}
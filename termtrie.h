@@ -0,0 +1,88 @@
+/* Filename:  termtrie.h
+ * Date:      10/19/26
+ * Purpose:   The header file for the term trie, a compact radix trie
+ *            from each term to its dictionary entry (numdocs and first
+ *            line in post).  Edges carry whole runs of bytes, so there
+ *            are fewer than two nodes per term, and every node's edges
+ *            are contiguous and in byte order, so a walk meets the
+ *            terms in sorted order.  Exact, prefix, wildcard (* and ?)
+ *            and range lookups only visit subtrees that can still
+ *            match, so their cost follows the number of terms found;
+ *            fuzzy lookups likewise leave a subtree once every prefix
+ *            below it is too far from the word.
+ *
+ *            The file is the arrays as they are in memory:
+ *            "TERMTRIE", numnodes, numedges, labelbytes, numterms
+ *            (4 bytes each), then the nodes, edges, labels and entries.
+*/
+
+#ifndef TERMTRIE_H
+#define TERMTRIE_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#define TRIE_MAGIC "TERMTRIE"
+#define TRIE_MAGIC_LENGTH 8
+#define TRIE_NONE -1
+
+using namespace std;
+
+struct TrieEntry  // a term's dictionary entry
+{
+   int numdocs;
+   unsigned long start;             // its first line in post
+};
+
+struct TrieMatch  // a term found by a lookup
+{
+   string term;
+   TrieEntry entry;
+   int distance;                    // edit distance from the word, for Fuzzy
+};
+
+class TermTrie {
+public:
+   TermTrie();
+   void Build (const vector<string_view> &Terms, const vector<TrieEntry> &Entries);  // Terms sorted
+   bool Write (const string Filename) const;
+   bool Read (const string Filename);
+   unsigned int GetNumTerms () const;
+   bool Find (const string_view Term, TrieEntry &Entry) const;
+   void Prefix (const string_view Prefix, vector<TrieMatch> &Matches) const;
+   void Wildcard (const string_view Pattern, vector<TrieMatch> &Matches) const;
+   void Range (const string_view Low, const string_view High, vector<TrieMatch> &Matches) const;
+   void Fuzzy (const string_view Word, const int MaxDistance, vector<TrieMatch> &Matches) const;
+   void Numbered (vector<TrieMatch> &Matches) const;   // terms with postings, by id
+protected:
+   struct TrieNode
+   {
+      unsigned int firstedge;
+      unsigned int numedges;
+      int term;                     // index into entries, or TRIE_NONE
+   };
+   struct TrieEdge
+   {
+      unsigned int label;           // offset of the edge's bytes in labels
+      unsigned int length;
+      unsigned int child;
+   };
+   unsigned int BuildNode (const vector<string_view> &Terms, unsigned long First,
+                           const unsigned long Last, const unsigned long Depth);
+   int FindEdge (const unsigned int Node, const char Byte) const;
+   string_view GetLabel (const TrieEdge &Edge) const;
+   void Collect (const unsigned int Node, string &Path, vector<TrieMatch> &Matches) const;
+   void MatchWildcard (const unsigned int Node, string &Path, const string_view Pattern,
+                       const vector<unsigned int> &States, vector<TrieMatch> &Matches) const;
+   void CollectRange (const unsigned int Node, string &Path, const string_view Low,
+                      const string_view High, vector<TrieMatch> &Matches) const;
+   void MatchFuzzy (const unsigned int Node, string &Path, const string_view Word,
+                    const int MaxDistance, vector<int> &Rows, vector<TrieMatch> &Matches) const;
+   vector<TrieNode> nodes;          // node 0 is the root
+   vector<TrieEdge> edges;
+   vector<char> labels;
+   vector<TrieEntry> entries;       // in term order
+};
+
+#endif
@@ -0,0 +1,209 @@
+/* Filename:  tokenizer.cpp
+ * Date:      10/19/2026
+ * Purpose:   The implementation file for the tokenizer.  Scan, which
+ *            drives the flex scanner, is in invert.lex.
+*/
+
+#include <stdio.h>
+#include <sys/stat.h>
+#include <iostream>
+
+#include "tokenizer.h"
+
+#define LOCAL_WORDS_NBR 3000
+#define TOKENIZER_TERMS_NBR 40000
+#define STOPLIST_WORDS_NBR 523 
+
+using namespace std;
+
+/*-------------------------- Constructors/Destructors ----------------------*/
+
+/* Name:  Tokenizer
+ * Parameters:  Stopwords: the words never to count
+ *              Source: the number the inverter knows this tokenizer by
+ *              Signatures: whether the inverter wants each document's
+ *                          SimHash, to find near-duplicates
+ * Purpose:     set up the tables for counting documents
+ * Returns:     nothing
+*/
+Tokenizer::Tokenizer(const vector<string> &Stopwords, const int Source, const bool Signatures,
+                     const bool KeepText)
+   : terms(TOKENIZER_TERMS_NBR), localht(LOCAL_WORDS_NBR, terms),
+     stoplist(STOPLIST_WORDS_NBR * 3, terms)
+{
+   for (unsigned long i = 0; i < Stopwords.size(); i++)
+      stoplist.Insert(Stopwords[i]);
+   numstopterms = terms.GetNumTerms();
+   restart = false;
+   source = Source;
+   signatures = Signatures;
+   keeptext = KeepText;
+   inscript = false;
+}
+
+/* Name:  ~Tokenizer
+ * Parameters:  none
+ * Purpose:     nothing to free beyond the member tables
+ * Returns:     nothing
+*/
+Tokenizer::~Tokenizer()
+{
+}
+
+/*-------------------------- Accessors ------------------------------------*/
+
+/* Name:  Transfer
+ * Parameters:  DocId: the document just scanned
+ *              Batch: receives the document's words
+ * Purpose:     fill the batch for the inverter, along with the text of
+ *              each posted word it has not been sent before, then get
+ *              ready for the next document
+ * Returns:     nothing
+*/
+void Tokenizer::Transfer(const int DocId, TermBatch &Batch)
+{
+   Batch.Clear();
+   Batch.source = source;
+   Batch.restart = restart;
+   Batch.signature = (signatures ? localht.SimHash() : 0);
+   Batch.localmemory = GetMemory();
+   localht.TransferData(DocId, Batch);
+   restart = false;
+   Batch.text.swap(text);
+
+   sent.resize(terms.GetNumTerms(), false);
+   for (unsigned long i = 0; i < Batch.termids.size(); i++)
+      if (!sent[Batch.termids[i]])
+      {
+         string_view Token = terms.GetToken(Batch.termids[i]);
+         sent[Batch.termids[i]] = true;
+         Batch.newids.push_back(Batch.termids[i]);
+         Batch.newterms.insert(Batch.newterms.end(), Token.begin(), Token.end());
+         Batch.newlengths.push_back(Token.length());
+      }
+
+   localht.Reset();
+   if (localht.Recycle(numstopterms))
+   {
+      sent.clear();
+      restart = true;
+   }
+}
+
+/* Name:  Transfer
+ * Parameters:  DocId: the document just scanned
+ *              GlobalHT: the shared table to post the words into
+ * Purpose:     post the document's words straight from this thread,
+ *              then get ready for the next document
+ * Returns:     nothing
+*/
+void Tokenizer::Transfer(const int DocId, ConcurrentGlobalHashTable &GlobalHT)
+{
+   localht.TransferData(DocId, GlobalHT);
+   localht.Reset();
+   localht.Recycle(numstopterms);
+}
+
+/* Name:  GetMemory
+ * Parameters:  none
+ * Purpose:     add up this tokenizer's term table, the current
+ *              document's counts (as large as the document made them)
+ *              and the stoplist
+ * Returns:     the bytes held
+*/
+unsigned long Tokenizer::GetMemory() const
+{
+   return terms.GetMemory() + localht.GetMemory() + stoplist.GetMemory();
+}
+
+// The token is hashed once, when it is interned; the stoplist check
+// and the count both work from its id, and nothing is allocated
+// unless the token has never been seen before.
+void Tokenizer::Insert (const char *Token, const int Length)
+{
+unsigned int TermId = terms.Intern(string_view(Token, Length));
+
+   if (keeptext)
+   {
+      if (!text.empty())
+         text.push_back(' ');
+      text.insert(text.end(), Token, Token + Length);
+   }
+   if (!IsCommon(TermId))
+      localht.Insert(TermId);
+}
+
+void Tokenizer::Downcase (char *Token, const int Length)
+{
+   // run over characters in yytext, downcasing
+   for (int i = 0; i < Length; i++)
+       if (('A' <= Token[i]) && ('Z' >= Token[i]))
+          Token[i] = 'a' + Token[i] - 'A'; 
+   Insert (Token, Length);
+}
+
+void Tokenizer::StartScript ()
+{
+   inscript = true;
+}
+
+void Tokenizer::EndScript ()
+{
+   inscript = false;
+}
+
+bool Tokenizer::InScript () const
+{
+   return inscript;
+}
+
+/* Name:  ReadFile
+ * Parameters:  Filename: the document to read
+ *              Buffer: receives the whole file
+ * Purpose:     load a document for Scan.  flex scans the buffer in
+ *              place and needs it to end with two NUL bytes.
+ * Returns:     false if the file could not be read
+*/
+bool Tokenizer::ReadFile (const char *Filename, vector<char> &Buffer)
+{
+FILE *In;
+struct stat Info;
+size_t Length = 0;
+
+   if ((In = fopen(Filename, "r")) == NULL)
+      return false;
+
+   // one spare byte, so a file of the expected size ends the loop at once
+   if (fstat(fileno(In), &Info) == 0 && Info.st_size > 0)
+      Buffer.resize(Info.st_size + 3);
+   else
+      Buffer.resize(4096 + 2);
+
+   // files can change size under us; read until EOF regardless
+   for (;;)
+   {
+      Length += fread(Buffer.data() + Length, 1, Buffer.size() - 2 - Length, In);
+      if (Length < Buffer.size() - 2)
+         break;
+      Buffer.resize(Buffer.size() * 2);
+   }
+   fclose(In);
+
+   Buffer.resize(Length + 2);
+   Buffer[Length] = '\0';
+   Buffer[Length + 1] = '\0';
+   return true;
+}
+
+/*-------------------------- Private Functions ----------------------------*/
+
+bool Tokenizer::IsCommon(const unsigned int TermId)
+{
+
+   if(stoplist.GetData(TermId) == 1)
+   {
+      return true;
+   }
+
+   return false;
+}
@@ -0,0 +1,56 @@
+/* Filename:  tokenizer.h
+ * Date:      10/19/26
+ * Purpose:   The header file for a tokenizer: the state the scanner
+ *            actions work on while reading one document at a time.
+ *            Each tokenizer interns into its own TermTable, so several
+ *            can run on separate threads; Transfer hands the counts to
+ *            the inverter as a TermBatch, with the text of only the
+ *            words posted for the first time.  Most distinct tokens are
+ *            never posted, so once the table holds HASHTABLE_RECYCLE_TERMS
+ *            words it is cut back to the stopwords between documents.
+*/
+
+#ifndef TOKENIZER_H
+#define TOKENIZER_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "hashtable.h"
+#include "termbatch.h"
+
+using namespace std;
+
+class Tokenizer {
+public:
+   Tokenizer(const vector<string> &Stopwords, const int Source, const bool Signatures,
+             const bool KeepText);
+   ~Tokenizer();
+   void Scan (vector<char> &Buffer);   // run the scanner (in invert.lex)
+   void Transfer (const int DocId, TermBatch &Batch);
+   void Transfer (const int DocId, ConcurrentGlobalHashTable &GlobalHT);
+   void Insert (const char *Token, const int Length);
+   void Downcase (char *Token, const int Length);
+   void StartScript ();
+   void EndScript ();
+   bool InScript () const;
+   static bool ReadFile (const char *Filename, vector<char> &Buffer);
+   unsigned long GetMemory () const;   // bytes held by the tables
+private:
+   Tokenizer (const Tokenizer& tok);   // owns its tables; never copied
+   bool IsCommon (const unsigned int TermId);
+   TermTable terms;                 // this tokenizer's interned words
+   HashTable localht;               // the counts for the current document
+   HashTable stoplist;
+   unsigned int numstopterms;       // the stopwords' ids come first
+   vector<bool> sent;               // per term id, whether the inverter has its text
+   bool restart;                    // the table was cut back since the last batch
+   int source;                      // which tokenizer this is
+   bool signatures;                 // put each document's SimHash in its batch
+   bool keeptext;                   // and its tokens, separated by spaces
+   vector<char> text;               // the current document's tokens
+   bool inscript;
+};
+
+#endif